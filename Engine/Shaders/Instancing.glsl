@@ -0,0 +1,15 @@
+struct InstanceData {
+    mat4 modelViewProjectionMatrix;
+    vec4 worldMatrixS;
+    vec4 worldMatrixT;
+    vec4 worldMatrixR;
+    vec4 localViewOrigin;
+    vec4 constantColor;
+};
+
+// Per-instance data of the instanced draw is indexed by gl_InstanceID
+layout(std140) uniform InstanceDataBlock {
+    InstanceData instanceData[MAX_INSTANCES];
+};
+
+#define INSTANCE_DATA instanceData[gl_InstanceID]
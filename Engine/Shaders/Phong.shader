@@ -30,6 +30,7 @@ shader "Lit/Phong" {
     generatePerforatedVersion
     generatePremulAlphaVersion
     generateGpuSkinningVersion
+    generateInstancingVersion
 
     ambientLitVersion "PhongAmbientLit.shader"
     directLitVersion "PhongDirectLit.shader"
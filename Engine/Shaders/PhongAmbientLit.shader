@@ -5,6 +5,7 @@ shader "Lit/PhongAmbientLit" {
     generatePerforatedVersion
     generatePremulAlphaVersion
     generateGpuSkinningVersion
+    generateInstancingVersion
 
     glsl_vp {
         #define LEGACY_PHONG_LIGHTING
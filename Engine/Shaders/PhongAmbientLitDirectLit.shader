@@ -5,6 +5,7 @@ shader "Lit/PhongAmbientLitDirectLit" {
     generatePerforatedVersion
     generatePremulAlphaVersion
     generateGpuSkinningVersion
+    generateInstancingVersion
     generateParallelShadowVersion
     generateSpotShadowVersion
     generatePointShadowVersion
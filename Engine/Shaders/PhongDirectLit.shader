@@ -5,6 +5,7 @@ shader "Lit/PhongDirectLit" {
     generatePerforatedVersion
     generatePremulAlphaVersion
     generateGpuSkinningVersion
+    generateInstancingVersion
     generateParallelShadowVersion
     generateSpotShadowVersion
     generatePointShadowVersion
@@ -21,6 +21,10 @@ in vec4 in_weightValue : WEIGHT_VALUE;
 	uniform vec2 invJointsMapSize;
 	uniform int jointIndexOffsetCurr;
 	uniform int jointIndexOffsetPrev;
+#elif defined(USE_UNIFORM_BUFFER)
+    layout(std140) uniform JointsBlock {
+        vec4 joints[MAX_SHADER_JOINTSX3];   // 4x3 matrix
+    };
 #else
     uniform vec4 joints[MAX_SHADER_JOINTSX3];   // 4x3 matrix
 #endif
@@ -23,6 +23,10 @@ in vec4 in_weightValue1 : WEIGHT_VALUE1;
 	uniform vec2 invJointsMapSize;
 	uniform int jointIndexOffsetCurr;
 	uniform int jointIndexOffsetPrev;
+#elif defined(USE_UNIFORM_BUFFER)
+    layout(std140) uniform JointsBlock {
+        vec4 joints[MAX_SHADER_JOINTSX3];   // 4x3 matrix
+    };
 #else
     uniform vec4 joints[MAX_SHADER_JOINTSX3];   // 4x3 matrix
 #endif
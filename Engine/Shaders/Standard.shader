@@ -30,6 +30,7 @@ shader "Lit/Standard" {
     generatePerforatedVersion
     generatePremulAlphaVersion
     generateGpuSkinningVersion
+    generateInstancingVersion
 
     ambientLitVersion "StandardAmbientLit.shader"
     directLitVersion "StandardDirectLit.shader"
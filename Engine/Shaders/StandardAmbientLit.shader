@@ -5,6 +5,7 @@ shader "Lit/StandardAmbientLit" {
     generatePerforatedVersion
     generatePremulAlphaVersion
     generateGpuSkinningVersion
+    generateInstancingVersion
 
     glsl_vp {
         #define STANDARD_METALLIC_LIGHTING
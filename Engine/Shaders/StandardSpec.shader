@@ -30,6 +30,7 @@ shader "Lit/StandardSpec" {
     generatePerforatedVersion
     generatePremulAlphaVersion
     generateGpuSkinningVersion
+    generateInstancingVersion
 
     ambientLitVersion "StandardSpecAmbientLit.shader"
     directLitVersion "StandardSpecDirectLit.shader"
@@ -5,6 +5,7 @@ shader "Lit/StandardSpecAmbientLit" {
     generatePerforatedVersion
     generatePremulAlphaVersion
     generateGpuSkinningVersion
+    generateInstancingVersion
 
     glsl_vp {
         #define STANDARD_SPECULAR_LIGHTING
@@ -1,6 +1,7 @@
 shader "depth" {
 	generatePerforatedVersion
 	generateGpuSkinningVersion
+	generateInstancingVersion
 
 	glsl_vp {
 		$include "depth.vp"
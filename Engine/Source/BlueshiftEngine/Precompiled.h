@@ -289,6 +289,8 @@ struct is_assignable_all : static_all_of<std::is_assignable<T, Ts>::value...> {}
 
 #define CURRENT_FUNC                __FUNCTION__
 
+#define BE_THREAD_LOCAL             __declspec(thread)
+
 #define PATHSEPERATOR_STR           "\\"
 #define PATHSEPERATOR_CHAR          '\\'
 
@@ -372,6 +374,8 @@ struct is_assignable_all : static_all_of<std::is_assignable<T, Ts>::value...> {}
 
 #define CURRENT_FUNC                __func__
 
+#define BE_THREAD_LOCAL             __thread
+
 #define PATHSEPERATOR_STR           "/"
 #define PATHSEPERATOR_CHAR          '/'
 
@@ -20,6 +20,8 @@ BE_NAMESPACE_BEGIN
 CmdArgs     Engine::args;
 Str         Engine::baseDir;
 Str         Engine::searchPath;
+streamOutFunc_t Engine::logFunc = nullptr;
+streamOutFunc_t Engine::errorFunc = nullptr;
 
 static streamOutFunc_t logFuncPtr = nullptr;
 static streamOutFunc_t errFuncPtr = nullptr;
@@ -51,10 +53,22 @@ void Engine::InitBase(const char *baseDir, bool forceGenericSIMD, const streamOu
 
     PlatformTime::Init();
 
+    taskScheduler.Init();
+
+    asyncLoader.Init();
+
+    profiler.Init();
+
     Math::Init();
 }
 
 void Engine::ShutdownBase() {
+    profiler.Shutdown();
+
+    asyncLoader.Shutdown();
+
+    taskScheduler.Shutdown();
+
     PlatformTime::Shutdown();
     
     SIMD::Shutdown();
@@ -98,6 +112,8 @@ void Engine::Init(const InitParms *initParms) {
     Engine::baseDir = initParms->baseDir;
     Engine::searchPath = initParms->searchPath;
     Engine::args = initParms->args;
+    Engine::logFunc = initParms->logFunc;
+    Engine::errorFunc = initParms->errorFunc;
 
     Platform::Init();
 
@@ -110,9 +126,17 @@ void Engine::Init(const InitParms *initParms) {
     RegisterEngineObjects();
 
     LuaVM::Init();
+
+    prefabManager.Init();
+
+    BinaryMap::Init();
 }
 
 void Engine::Shutdown() {
+    BinaryMap::Shutdown();
+
+    prefabManager.Shutdown();
+
     LuaVM::Shutdown();
 
     common.Shutdown();
@@ -408,6 +408,7 @@ void ComCamera::Render() {
 void ComCamera::UpdateVisuals() {
     if (spriteHandle == -1) {
         spriteHandle = renderWorld->AddEntity(&sprite);
+        GetGameWorld()->OnRenderEntityAdded(GetEntity(), spriteHandle);
     } else {
         renderWorld->UpdateEntity(spriteHandle, &sprite);
     }
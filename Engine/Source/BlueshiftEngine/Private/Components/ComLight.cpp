@@ -308,6 +308,7 @@ void ComLight::UpdateVisuals() {
 
     if (spriteHandle == -1) {
         spriteHandle = renderWorld->AddEntity(&sprite);
+        GetGameWorld()->OnRenderEntityAdded(GetEntity(), spriteHandle);
     } else {
         renderWorld->UpdateEntity(spriteHandle, &sprite);
     }
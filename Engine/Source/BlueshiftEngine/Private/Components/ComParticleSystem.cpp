@@ -700,6 +700,7 @@ void ComParticleSystem::Pause() {
 void ComParticleSystem::UpdateVisuals() {
     if (spriteHandle == -1) {
         spriteHandle = renderWorld->AddEntity(&sprite);
+        GetGameWorld()->OnRenderEntityAdded(GetEntity(), spriteHandle);
     } else {
         renderWorld->UpdateEntity(spriteHandle, &sprite);
     }
@@ -159,6 +159,7 @@ const AABB ComReflectionProbe::GetAABB() {
 void ComReflectionProbe::UpdateVisuals() {
     if (sphereHandle == -1) {
         sphereHandle = renderWorld->AddEntity(&sphere);
+        GetGameWorld()->OnRenderEntityAdded(GetEntity(), sphereHandle);
     } else {
         renderWorld->UpdateEntity(sphereHandle, &sphere);
     }
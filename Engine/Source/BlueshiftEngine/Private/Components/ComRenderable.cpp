@@ -138,6 +138,7 @@ void ComRenderable::UpdateVisuals() {
 
     if (sceneEntityHandle == -1) {
         sceneEntityHandle = renderWorld->AddEntity(&sceneEntity);
+        GetGameWorld()->OnRenderEntityAdded(GetEntity(), sceneEntityHandle);
     } else {
         renderWorld->UpdateEntity(sceneEntityHandle, &sceneEntity);
     }
@@ -25,9 +25,14 @@
 #include "Asset/GuidMapper.h"
 #include "Core/JointPose.h"
 #include "Simd/Simd.h"
+#include "Core/CVars.h"
 
 BE_NAMESPACE_BEGIN
 
+static CVar anim_lodDistance(L"anim_lodDistance", L"0", CVar::Float, L"distance beyond which animations are updated every anim_lodUpdateInterval frames, 0 to disable");
+static CVar anim_lodUpdateInterval(L"anim_lodUpdateInterval", L"2", CVar::Integer, L"number of frames between animation updates of the distant entities");
+static CVar anim_offscreenUpdateInterval(L"anim_offscreenUpdateInterval", L"8", CVar::Integer, L"number of frames between animation updates of the off-screen entities, 0 to stop updating");
+
 OBJECT_DECLARATION("Skinned Mesh Renderer", ComSkinnedMeshRenderer, ComMeshRenderer)
 BEGIN_EVENTS(ComSkinnedMeshRenderer)
 END_EVENTS
@@ -53,6 +58,9 @@ ComSkinnedMeshRenderer::ComSkinnedMeshRenderer() {
 
     jointMats = nullptr;
 
+    lastViewCount = 0;
+    animationUpdateQueued = false;
+
     Connect(&Properties::SIG_PropertyChanged, this, (SignalCallback)&ComSkinnedMeshRenderer::PropertyChanged);
 }
 
@@ -68,6 +76,11 @@ bool ComSkinnedMeshRenderer::IsConflictComponent(const MetaObject &componentClas
 }
 
 void ComSkinnedMeshRenderer::Purge(bool chainPurge) {
+    if (animationUpdateQueued && GetGameWorld()) {
+        GetGameWorld()->CancelAnimationUpdate(this);
+        animationUpdateQueued = false;
+    }
+
     if (jointMats) {
         Mem_AlignedFree(jointMats);
         jointMats = nullptr;
@@ -285,7 +298,11 @@ void ComSkinnedMeshRenderer::Update() {
         animator.UpdateFrame(GetEntity(), GetGameWorld()->GetPrevTime(), GetGameWorld()->GetTime());
     }
 
-    UpdateVisuals();
+    // Animation is computed with the other entities in parallel, and published before rendering
+    if (!animationUpdateQueued) {
+        GetGameWorld()->QueueAnimationUpdate(this);
+        animationUpdateQueued = true;
+    }
 }
 
 void ComSkinnedMeshRenderer::UpdateVisuals() {
@@ -295,14 +312,35 @@ void ComSkinnedMeshRenderer::UpdateVisuals() {
 }
 
 void ComSkinnedMeshRenderer::UpdateAnimation(int currentTime) {
-    if (animationType == AnimationControllerType) {
-        animator.ComputeFrame(currentTime);
+    ComputeAnimation(currentTime);
 
-        BE1::Mat3x4 *jointMats = animator.GetFrame();
+    PublishAnimation();
+}
 
-        // Modify jointMats for IK here !
+int ComSkinnedMeshRenderer::GetAnimationUpdateInterval() {
+    const SceneEntity *renderEntity = sceneEntityHandle != -1 ? renderWorld->GetEntity(sceneEntityHandle) : nullptr;
+    if (!renderEntity) {
+        return 1;
+    }
 
-        sceneEntity.joints = jointMats;
+    // Render entity is registered to the views (including shadow casting) since the last update
+    bool visible = renderEntity->viewCount != lastViewCount;
+    lastViewCount = renderEntity->viewCount;
+
+    if (!visible) {
+        return Max(anim_offscreenUpdateInterval.GetInteger(), 0);
+    }
+
+    if (anim_lodDistance.GetFloat() > 0.0f && renderEntity->viewDistance > anim_lodDistance.GetFloat()) {
+        return Max(anim_lodUpdateInterval.GetInteger(), 1);
+    }
+
+    return 1;
+}
+
+void ComSkinnedMeshRenderer::ComputeAnimation(int currentTime) {
+    if (animationType == AnimationControllerType) {
+        animator.ComputeFrame(currentTime);
 
         // Get AABB from animator
         animator.ComputeAABB(currentTime);
@@ -325,6 +363,16 @@ void ComSkinnedMeshRenderer::UpdateAnimation(int currentTime) {
             sceneEntity.aabb = referenceMesh->GetAABB();
         }
     }
+}
+
+void ComSkinnedMeshRenderer::PublishAnimation() {
+    if (animationType == AnimationControllerType) {
+        BE1::Mat3x4 *jointMats = animator.GetFrame();
+
+        // Modify jointMats for IK here !
+
+        sceneEntity.joints = jointMats;
+    }
 
     ComRenderable::UpdateVisuals();
 }
@@ -0,0 +1,239 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Platform/PlatformTime.h"
+#include "Core/AsyncLoader.h"
+#include "Core/Profiler.h"
+
+BE_NAMESPACE_BEGIN
+
+CVar AsyncLoader::fs_asyncLoad(L"fs_asyncLoad", L"0", CVar::Bool | CVar::Archive, L"load textures, meshes and sounds asynchronously");
+CVar AsyncLoader::fs_asyncFinalizeTime(L"fs_asyncFinalizeTime", L"4", CVar::Float, L"time budget in milliseconds to finalize async loaded resources per frame");
+
+AsyncLoader                 asyncLoader;
+
+// Higher priority first, and then earlier request first
+bool AsyncLoader::CompareRequest(const AsyncLoadRequest *a, const AsyncLoadRequest *b) {
+    if (a->GetPriority() != b->GetPriority()) {
+        return a->GetPriority() < b->GetPriority();
+    }
+    return a->sequence > b->sequence;
+}
+
+// Loader threads load the queued request of the highest priority one by one,
+// and sleep while there is nothing to load.
+void AsyncLoader::LoaderThreadProc(void *data) {
+    AsyncLoader *loader = (AsyncLoader *)data;
+
+    PlatformMutex::Lock(loader->mutex);
+
+    while (1) {
+        // Queued requests can be taken by Complete() or CancelAll()
+        AsyncLoadRequest *request = loader->PopQueuedRequest();
+        if (!request) {
+            if (loader->terminate) {
+                break;
+            }
+            PlatformCondition::Wait(loader->queuedCondition, loader->mutex);
+            continue;
+        }
+
+        request->state = AsyncLoadRequest::Loading;
+        loader->numLoadingRequests++;
+
+        PlatformMutex::Unlock(loader->mutex);
+
+        {
+            BE_PROFILE_CPU_SCOPE("AsyncLoadRequest::Load");
+            request->Load();
+        }
+
+        PlatformMutex::Lock(loader->mutex);
+
+        request->state = AsyncLoadRequest::Loaded;
+        loader->loadedRequests.Append(request);
+        loader->numLoadingRequests--;
+        PlatformCondition::Broadcast(loader->loadedCondition);
+    }
+
+    PlatformMutex::Unlock(loader->mutex);
+}
+
+void AsyncLoader::Init() {
+    mutex = PlatformMutex::Create();
+    queuedCondition = PlatformCondition::Create();
+    loadedCondition = PlatformCondition::Create();
+    terminate = false;
+
+    for (int i = 0; i < NumLoaderThreads; i++) {
+        PlatformThread *thread = PlatformThread::Create(LoaderThreadProc, (void *)this, 0);
+        threads.Append(thread);
+    }
+}
+
+void AsyncLoader::Shutdown() {
+    if (!mutex) {
+        return;
+    }
+
+    CancelAll();
+
+    // Wake up the loader threads to terminate
+    PlatformMutex::Lock(mutex);
+    terminate = true;
+    PlatformCondition::Broadcast(queuedCondition);
+    PlatformMutex::Unlock(mutex);
+
+    for (int i = 0; i < threads.Count(); i++) {
+        PlatformThread::Wait(threads[i]);
+    }
+    threads.Clear();
+
+    PlatformCondition::Delete(loadedCondition);
+    PlatformCondition::Delete(queuedCondition);
+    PlatformMutex::Delete(mutex);
+    mutex = nullptr;
+}
+
+bool AsyncLoader::IsEnabled() const {
+    return mutex && fs_asyncLoad.GetBool();
+}
+
+void AsyncLoader::AddRequest(AsyncLoadRequest *request, int priority) {
+    PlatformMutex::Lock(mutex);
+
+    request->priority = priority;
+    request->sequence = nextSequence++;
+    request->state = AsyncLoadRequest::Queued;
+
+    queuedRequests.Append(request);
+    std::push_heap(queuedRequests.Ptr(), queuedRequests.Ptr() + queuedRequests.Count(), CompareRequest);
+
+    PlatformCondition::Signal(queuedCondition);
+
+    PlatformMutex::Unlock(mutex);
+}
+
+AsyncLoadRequest *AsyncLoader::PopQueuedRequest() {
+    if (queuedRequests.IsEmpty()) {
+        return nullptr;
+    }
+
+    std::pop_heap(queuedRequests.Ptr(), queuedRequests.Ptr() + queuedRequests.Count(), CompareRequest);
+    return queuedRequests.TakeLast();
+}
+
+void AsyncLoader::RemoveQueuedRequest(AsyncLoadRequest *request) {
+    queuedRequests.Remove(request);
+    std::make_heap(queuedRequests.Ptr(), queuedRequests.Ptr() + queuedRequests.Count(), CompareRequest);
+}
+
+void AsyncLoader::FinalizeRequest(AsyncLoadRequest *request) {
+    BE_PROFILE_CPU_SCOPE("AsyncLoadRequest::Finalize");
+
+    request->Finalize();
+    delete request;
+}
+
+void AsyncLoader::Complete(AsyncLoadRequest *request) {
+    PlatformMutex::Lock(mutex);
+
+    if (request->state == AsyncLoadRequest::Queued) {
+        // Not started yet, load it on the calling thread
+        RemoveQueuedRequest(request);
+        request->state = AsyncLoadRequest::Loading;
+
+        PlatformMutex::Unlock(mutex);
+
+        request->Load();
+
+        PlatformMutex::Lock(mutex);
+        request->state = AsyncLoadRequest::Loaded;
+    } else {
+        while (request->state != AsyncLoadRequest::Loaded) {
+            PlatformCondition::Wait(loadedCondition, mutex);
+        }
+        loadedRequests.Remove(request);
+    }
+
+    PlatformMutex::Unlock(mutex);
+
+    FinalizeRequest(request);
+}
+
+AsyncLoadRequest *AsyncLoader::TakeLoadedRequest() {
+    PlatformMutex::Lock(mutex);
+
+    AsyncLoadRequest *request = nullptr;
+    int requestIndex = -1;
+
+    for (int i = 0; i < loadedRequests.Count(); i++) {
+        if (!request || CompareRequest(request, loadedRequests[i])) {
+            request = loadedRequests[i];
+            requestIndex = i;
+        }
+    }
+
+    if (request) {
+        loadedRequests.RemoveIndexFast(requestIndex);
+    }
+
+    PlatformMutex::Unlock(mutex);
+
+    return request;
+}
+
+void AsyncLoader::Update() {
+    if (!mutex) {
+        return;
+    }
+
+    // PlatformTime::Seconds() is a float, which is too coarse for a few milliseconds after a long uptime
+    const double startTime = PlatformTime::Microseconds() * 0.000001;
+    const double budget = fs_asyncFinalizeTime.GetFloat() * 0.001;
+
+    // Requests are taken one by one, because finalizing can complete other requests
+    while (AsyncLoadRequest *request = TakeLoadedRequest()) {
+        FinalizeRequest(request);
+
+        if (PlatformTime::Microseconds() * 0.000001 - startTime > budget) {
+            break;
+        }
+    }
+}
+
+void AsyncLoader::CancelAll() {
+    if (!mutex) {
+        return;
+    }
+
+    PlatformMutex::Lock(mutex);
+
+    Array<AsyncLoadRequest *> requests;
+    requests.Swap(queuedRequests);
+
+    while (numLoadingRequests > 0) {
+        PlatformCondition::Wait(loadedCondition, mutex);
+    }
+
+    requests.AppendList(loadedRequests);
+    loadedRequests.Clear();
+
+    PlatformMutex::Unlock(mutex);
+
+    requests.DeleteContents(true);
+}
+
+BE_NAMESPACE_END
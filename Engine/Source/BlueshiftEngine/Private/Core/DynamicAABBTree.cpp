@@ -16,6 +16,10 @@
 #include "Core/DynamicAABBTree.h"
 #include "Core/Heap.h"
 
+#if defined(__X86__)
+#include "Simd/SSE/sse.h"
+#endif
+
 BE_NAMESPACE_BEGIN
 
 const int32_t   DEFAULT_CAPACITY            = 16;
@@ -24,11 +28,17 @@ const float     DISPLACEMENT_MULTIPLIER     = 2.0f;
 DynamicAABBTree::DynamicAABBTree() {
     nodeCapacity = DEFAULT_CAPACITY;
     nodes = (Node *)Mem_Alloc(nodeCapacity * sizeof(nodes[0]));
+    wideNodes = nullptr;
+    wideNodeRefitStamps = nullptr;
+    wideNodeCapacity = 0;
+    wideNodeRefitStamp = 0;
     Purge();
 }
 
 DynamicAABBTree::~DynamicAABBTree() {
     Mem_Free(nodes);
+    Mem_AlignedFree(wideNodes);
+    Mem_Free(wideNodeRefitStamps);
 }
 
 void DynamicAABBTree::Purge(bool clearNodes) {
@@ -52,6 +62,8 @@ void DynamicAABBTree::Purge(bool clearNodes) {
     freeList = 0;
     root = -1;
     insertionCount = 0;
+    wideNodesValid = false;
+    dirtyWideNodes.Clear();
 }
 
 // Allocated a node from the pool. Grow the pool if necessary.
@@ -171,6 +183,8 @@ bool DynamicAABBTree::MoveProxy(int32_t proxyId, const AABB &aabb, float expansi
 void DynamicAABBTree::InsertLeaf(int32_t leaf) {
     insertionCount++;
 
+    MarkWideNodesDirty(leaf);
+
     if (root == -1) {
         root = leaf;
         nodes[root].parent = -1;
@@ -303,6 +317,8 @@ void DynamicAABBTree::RemoveLeaf(int32_t leaf) {
         nodes[sibling].parent = grandParent;
         FreeNode(parent);
 
+        MarkWideNodesDirty(grandParent);
+
         // Adjust ancestor bounds.
         int32_t index = grandParent;
         while (index != -1) {
@@ -392,6 +408,9 @@ int32_t DynamicAABBTree::Balance(int32_t iA) {
             C->height = 1 + Max(A->height, G->height);
         }
 
+        // A is a child of C now, so refitting from A covers C and its ancestors
+        MarkWideNodesDirty(iA);
+
         return iC;
     }
 
@@ -442,6 +461,8 @@ int32_t DynamicAABBTree::Balance(int32_t iA) {
             B->height = 1 + Max(A->height, E->height);
         }
 
+        MarkWideNodesDirty(iA);
+
         return iB;
     }
 
@@ -614,6 +635,8 @@ void DynamicAABBTree::RebuildBottomUp() {
         return;
     }
 
+    InvalidateWideNodes();
+
     int32_t *nodeIndexes = (int32_t *)Mem_Alloc(nodeCount * sizeof(int32_t));
     int32_t count = 0;
 
@@ -676,8 +699,261 @@ void DynamicAABBTree::RebuildBottomUp() {
     Mem_Free(nodeIndexes);
 
     Validate();
+
+    BuildWideNodes();
+}
+
+void DynamicAABBTree::MarkWideNodesDirty(int32_t nodeId) {
+    // Everything is going to be rebuilt anyway
+    if (!wideNodesValid) {
+        return;
+    }
+
+    dirtyWideNodes.Append(nodeId);
+}
+
+void DynamicAABBTree::BuildWideNodes() {
+    if (wideNodesValid && wideNodeCapacity >= nodeCapacity) {
+        RefitDirtyWideNodes();
+        return;
+    }
+
+    if (wideNodeCapacity < nodeCapacity) {
+        Mem_AlignedFree(wideNodes);
+        Mem_Free(wideNodeRefitStamps);
+        wideNodeCapacity = nodeCapacity;
+        wideNodes = (WideNode *)Mem_Alloc16(wideNodeCapacity * sizeof(wideNodes[0]));
+        wideNodeRefitStamps = (uint32_t *)Mem_Alloc(wideNodeCapacity * sizeof(wideNodeRefitStamps[0]));
+        memset(wideNodeRefitStamps, 0, wideNodeCapacity * sizeof(wideNodeRefitStamps[0]));
+    }
+
+    // Every internal binary node has a wide node of the same index, so the query can start from any node.
+    for (int32_t nodeId = 0; nodeId < nodeCapacity; nodeId++) {
+        if (nodes[nodeId].height <= 0) {
+            // free node or leaf
+            continue;
+        }
+
+        RefitWideNode(nodeId);
+    }
+
+    dirtyWideNodes.Clear();
+    wideNodesValid = true;
+}
+
+void DynamicAABBTree::RefitDirtyWideNodes() {
+    if (dirtyWideNodes.Count() == 0) {
+        return;
+    }
+
+    if (++wideNodeRefitStamp == 0) {
+        memset(wideNodeRefitStamps, 0, wideNodeCapacity * sizeof(wideNodeRefitStamps[0]));
+        wideNodeRefitStamp = 1;
+    }
+
+    // A wide node depends on the children and grandchildren of its binary node,
+    // so the wide nodes of the modified node and all of its ancestors are refitted.
+    for (int i = 0; i < dirtyWideNodes.Count(); i++) {
+        int32_t nodeId = dirtyWideNodes[i];
+
+        while (nodeId != -1) {
+            const Node *node = nodes + nodeId;
+            if (node->height < 0) {
+                // freed after being marked
+                break;
+            }
+
+            if (wideNodeRefitStamps[nodeId] == wideNodeRefitStamp) {
+                // The rest of the path is already refitted
+                break;
+            }
+            wideNodeRefitStamps[nodeId] = wideNodeRefitStamp;
+
+            if (node->height > 0) {
+                RefitWideNode(nodeId);
+            }
+
+            nodeId = node->parent;
+        }
+    }
+
+    dirtyWideNodes.Clear();
+}
+
+void DynamicAABBTree::RefitWideNode(int32_t nodeId) {
+    const Node *node = nodes + nodeId;
+
+    int32_t children[4];
+    int numChildren = 0;
+
+    const int32_t childIds[2] = { node->child1, node->child2 };
+    for (int i = 0; i < 2; i++) {
+        const Node *child = nodes + childIds[i];
+        if (child->IsLeaf()) {
+            children[numChildren++] = childIds[i];
+        } else {
+            children[numChildren++] = child->child1;
+            children[numChildren++] = child->child2;
+        }
+    }
+
+    WideNode *wideNode = wideNodes + nodeId;
+
+    for (int i = 0; i < 4; i++) {
+        if (i < numChildren) {
+            const AABB &aabb = nodes[children[i]].aabb;
+            wideNode->bounds[0][i] = aabb[0].x;
+            wideNode->bounds[1][i] = aabb[0].y;
+            wideNode->bounds[2][i] = aabb[0].z;
+            wideNode->bounds[3][i] = aabb[1].x;
+            wideNode->bounds[4][i] = aabb[1].y;
+            wideNode->bounds[5][i] = aabb[1].z;
+            wideNode->children[i] = children[i];
+        } else {
+            for (int j = 0; j < 6; j++) {
+                wideNode->bounds[j][i] = 0.0f;
+            }
+            wideNode->children[i] = -1;
+        }
+    }
 }
 
+void DynamicAABBTree::FrustumToPlanes(const Frustum &frustum, Plane planes[6]) {
+    const Vec3 &origin = frustum.GetOrigin();
+    const Vec3 &forward = frustum.GetAxis()[0];
+
+    Vec3 points[8];
+    frustum.ToPoints(points);
+
+    // near/far planes
+    planes[0].SetNormal(-forward);
+    planes[0].FitThroughPoint(origin + forward * frustum.GetNearDistance());
+    planes[1].SetNormal(forward);
+    planes[1].FitThroughPoint(origin + forward * frustum.GetFarDistance());
+
+    // side planes pass through the frustum origin and the far points
+    planes[2].SetFromPoints(origin, points[4], points[7]);
+    planes[3].SetFromPoints(origin, points[5], points[6]);
+    planes[4].SetFromPoints(origin, points[4], points[5]);
+    planes[5].SetFromPoints(origin, points[7], points[6]);
+
+    Vec3 center = origin + forward * ((frustum.GetNearDistance() + frustum.GetFarDistance()) * 0.5f);
+
+    for (int i = 2; i < 6; i++) {
+        if (planes[i].Distance(center) > 0.0f) {
+            planes[i].Flip();
+        }
+    }
+}
+
+#if defined(__X86__)
+
+int DynamicAABBTree::CullWideNode(const WideNode &wideNode, const Plane planes[6], int planeMask, int childPlaneMasks[4]) {
+    const ssef bmin[3] = { ssef(wideNode.bounds[0]), ssef(wideNode.bounds[1]), ssef(wideNode.bounds[2]) };
+    const ssef bmax[3] = { ssef(wideNode.bounds[3]), ssef(wideNode.bounds[4]), ssef(wideNode.bounds[5]) };
+
+    int outsideMask = 0;
+    int insideMasks[6] = { 0, 0, 0, 0, 0, 0 };
+
+    for (int planeIndex = 0; planeIndex < 6; planeIndex++) {
+        if (!(planeMask & BIT(planeIndex))) {
+            continue;
+        }
+
+        const Plane &plane = planes[planeIndex];
+
+        // Nearest and farthest corners of each box with respect to the plane normal
+        const ssef &nearX = plane.a > 0.0f ? bmin[0] : bmax[0];
+        const ssef &nearY = plane.b > 0.0f ? bmin[1] : bmax[1];
+        const ssef &nearZ = plane.c > 0.0f ? bmin[2] : bmax[2];
+        const ssef &farX = plane.a > 0.0f ? bmax[0] : bmin[0];
+        const ssef &farY = plane.b > 0.0f ? bmax[1] : bmin[1];
+        const ssef &farZ = plane.c > 0.0f ? bmax[2] : bmin[2];
+
+        const ssef a(plane.a);
+        const ssef b(plane.b);
+        const ssef c(plane.c);
+        const ssef d(plane.d);
+
+        ssef nearDist = a * nearX + b * nearY + c * nearZ + d;
+        ssef farDist = a * farX + b * farY + c * farZ + d;
+
+        outsideMask |= (int)movemask(nearDist > ssef(0.0f));
+        insideMasks[planeIndex] = (int)movemask(farDist < ssef(0.0f));
+    }
+
+    int validMask = 0;
+    for (int i = 0; i < 4; i++) {
+        if (wideNode.children[i] != -1) {
+            validMask |= BIT(i);
+        }
+    }
+
+    int visibleMask = validMask & ~outsideMask;
+
+    for (int i = 0; i < 4; i++) {
+        int childPlaneMask = planeMask;
+        for (int planeIndex = 0; planeIndex < 6; planeIndex++) {
+            if (insideMasks[planeIndex] & BIT(i)) {
+                childPlaneMask &= ~BIT(planeIndex);
+            }
+        }
+        childPlaneMasks[i] = childPlaneMask;
+    }
+
+    return visibleMask;
+}
+
+#else
+
+int DynamicAABBTree::CullWideNode(const WideNode &wideNode, const Plane planes[6], int planeMask, int childPlaneMasks[4]) {
+    int visibleMask = 0;
+
+    for (int i = 0; i < 4; i++) {
+        childPlaneMasks[i] = planeMask;
+
+        if (wideNode.children[i] == -1) {
+            continue;
+        }
+
+        bool outside = false;
+
+        for (int planeIndex = 0; planeIndex < 6; planeIndex++) {
+            if (!(planeMask & BIT(planeIndex))) {
+                continue;
+            }
+
+            const Plane &plane = planes[planeIndex];
+
+            float nearDist = plane.d;
+            float farDist = plane.d;
+            for (int axis = 0; axis < 3; axis++) {
+                float n = plane[axis];
+                float bmin = wideNode.bounds[axis][i];
+                float bmax = wideNode.bounds[axis + 3][i];
+                nearDist += n * (n > 0.0f ? bmin : bmax);
+                farDist += n * (n > 0.0f ? bmax : bmin);
+            }
+
+            if (nearDist > 0.0f) {
+                outside = true;
+                break;
+            }
+            if (farDist < 0.0f) {
+                childPlaneMasks[i] &= ~BIT(planeIndex);
+            }
+        }
+
+        if (!outside) {
+            visibleMask |= BIT(i);
+        }
+    }
+
+    return visibleMask;
+}
+
+#endif
+
 #pragma optimize("", off)
 
 BE_NAMESPACE_END
@@ -0,0 +1,447 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Platform/PlatformTime.h"
+#ifdef USE_NULL_RHI
+#include "RHI/RHINull.h"
+#else
+#include "RHI/RHIOpenGL.h"
+#endif
+#include "Core/Cmds.h"
+#include "Core/Task.h"
+#include "Core/Profiler.h"
+#include "File/FileSystem.h"
+
+BE_NAMESPACE_BEGIN
+
+Profiler                    profiler;
+
+struct ProfilerCpuEvent {
+    const char *            name;               ///< nullptr for the end events
+    uint64_t                time;               ///< in microseconds
+};
+
+// Written only by the owner thread, and read by the main thread in SyncFrame().
+class ProfilerThreadInfo {
+public:
+    int                     index;
+    char                    name[32];
+
+    ProfilerCpuEvent        events[Profiler::MaxCpuEventsPerThread];
+    PlatformAtomic          writeIndex;         ///< Published after the event is written
+
+    // Owned by the main thread
+    uint32_t                readIndex;
+    int                     openDepth;
+    ProfilerCpuEvent        openEvents[Profiler::MaxCpuMarkerDepth];
+};
+
+static BE_THREAD_LOCAL ProfilerThreadInfo *currentThreadInfo = nullptr;
+
+void Profiler::Init() {
+    cmdSystem.AddCommand(L"profileCapture", Cmd_ProfileCapture);
+
+    threadMutex = PlatformMutex::Create();
+
+    numThreadInfos = 0;
+}
+
+void Profiler::Shutdown() {
+    cmdSystem.RemoveCommand(L"profileCapture");
+
+    capturing = false;
+
+    FreeGpuQueries();
+
+    for (int i = 0; i < numThreadInfos.GetValue(); i++) {
+        delete threadInfos[i];
+    }
+    numThreadInfos = 0;
+
+    PlatformMutex::Delete(threadMutex);
+    threadMutex = nullptr;
+}
+
+ProfilerThreadInfo *Profiler::GetThreadInfo() {
+    if (currentThreadInfo) {
+        return currentThreadInfo;
+    }
+
+    PlatformMutex::Lock(threadMutex);
+
+    int index = numThreadInfos.GetValue();
+    if (index >= MaxThreads) {
+        PlatformMutex::Unlock(threadMutex);
+        return nullptr;
+    }
+
+    ProfilerThreadInfo *threadInfo = new ProfilerThreadInfo;
+    threadInfo->index = index;
+    threadInfo->writeIndex = 0;
+    threadInfo->readIndex = 0;
+    threadInfo->openDepth = 0;
+
+    int taskThreadIndex = TaskScheduler::ThreadIndex();
+    if (taskThreadIndex == 0) {
+        Str::snPrintf(threadInfo->name, sizeof(threadInfo->name), "Main Thread");
+    } else if (taskThreadIndex > 0) {
+        Str::snPrintf(threadInfo->name, sizeof(threadInfo->name), "Task Thread %i", taskThreadIndex);
+    } else {
+        Str::snPrintf(threadInfo->name, sizeof(threadInfo->name), "Thread %i", index);
+    }
+
+    threadInfos[index] = threadInfo;
+    // Publish the thread info after it is initialized
+    numThreadInfos.Add(1);
+
+    PlatformMutex::Unlock(threadMutex);
+
+    currentThreadInfo = threadInfo;
+    return threadInfo;
+}
+
+void Profiler::BeginCpuMarker(const char *name) {
+    ProfilerThreadInfo *threadInfo = GetThreadInfo();
+    if (!threadInfo) {
+        return;
+    }
+
+    uint32_t index = (uint32_t)threadInfo->writeIndex.GetValue();
+    ProfilerCpuEvent &event = threadInfo->events[index & (MaxCpuEventsPerThread - 1)];
+    event.name = name;
+    event.time = PlatformTime::Microseconds();
+
+    threadInfo->writeIndex.Add(1);
+}
+
+void Profiler::EndCpuMarker() {
+    ProfilerThreadInfo *threadInfo = GetThreadInfo();
+    if (!threadInfo) {
+        return;
+    }
+
+    uint32_t index = (uint32_t)threadInfo->writeIndex.GetValue();
+    ProfilerCpuEvent &event = threadInfo->events[index & (MaxCpuEventsPerThread - 1)];
+    event.name = nullptr;
+    event.time = PlatformTime::Microseconds();
+
+    threadInfo->writeIndex.Add(1);
+}
+
+void Profiler::CollectCpuEvents(ProfilerThreadInfo *threadInfo) {
+    uint32_t writeIndex = (uint32_t)threadInfo->writeIndex.GetValue();
+
+    if (writeIndex - threadInfo->readIndex > MaxCpuEventsPerThread) {
+        // Ring buffer is overflowed. The oldest events are lost.
+        threadInfo->readIndex = writeIndex - MaxCpuEventsPerThread;
+        threadInfo->openDepth = 0;
+    }
+
+    for (uint32_t i = threadInfo->readIndex; i != writeIndex; i++) {
+        const ProfilerCpuEvent &event = threadInfo->events[i & (MaxCpuEventsPerThread - 1)];
+
+        if (event.name) {
+            if (threadInfo->openDepth < MaxCpuMarkerDepth) {
+                threadInfo->openEvents[threadInfo->openDepth] = event;
+            }
+            threadInfo->openDepth++;
+        } else if (threadInfo->openDepth > 0) {
+            threadInfo->openDepth--;
+
+            // Ignore the end events of the markers began before the capture
+            if (threadInfo->openDepth < MaxCpuMarkerDepth) {
+                const ProfilerCpuEvent &beginEvent = threadInfo->openEvents[threadInfo->openDepth];
+
+                CapturedEvent &capturedEvent = capturedEvents.Alloc();
+                capturedEvent.name = beginEvent.name;
+                capturedEvent.threadIndex = threadInfo->index;
+                capturedEvent.startTime = beginEvent.time;
+                capturedEvent.duration = event.time - beginEvent.time;
+            }
+        }
+    }
+
+    threadInfo->readIndex = writeIndex;
+}
+
+void Profiler::CreateGpuQueries() {
+    if (gpuQueriesCreated || !rhi.SupportsTimestampQuery()) {
+        return;
+    }
+
+    gpuFrames = new GpuFrame[GpuFrameLatency];
+
+    for (int frameIndex = 0; frameIndex < GpuFrameLatency; frameIndex++) {
+        GpuFrame &gpuFrame = gpuFrames[frameIndex];
+        gpuFrame.cpuTime = 0;
+        gpuFrame.numMarkers = 0;
+        gpuFrame.disjoint = false;
+
+        for (int markerIndex = 0; markerIndex < MaxGpuMarkersPerFrame; markerIndex++) {
+            gpuFrame.markers[markerIndex].beginQueryHandle = rhi.CreateQuery();
+            gpuFrame.markers[markerIndex].endQueryHandle = rhi.CreateQuery();
+        }
+    }
+
+    gpuFrameIndex = 0;
+    gpuMarkerDepth = 0;
+    gpuQueriesCreated = true;
+}
+
+void Profiler::FreeGpuQueries() {
+    if (!gpuQueriesCreated) {
+        return;
+    }
+
+    for (int frameIndex = 0; frameIndex < GpuFrameLatency; frameIndex++) {
+        GpuFrame &gpuFrame = gpuFrames[frameIndex];
+
+        for (int markerIndex = 0; markerIndex < MaxGpuMarkersPerFrame; markerIndex++) {
+            rhi.DeleteQuery(gpuFrame.markers[markerIndex].beginQueryHandle);
+            rhi.DeleteQuery(gpuFrame.markers[markerIndex].endQueryHandle);
+        }
+    }
+
+    delete [] gpuFrames;
+    gpuFrames = nullptr;
+
+    gpuQueriesCreated = false;
+}
+
+void Profiler::BeginGpuMarker(const char *name) {
+    if (!gpuQueriesCreated) {
+        return;
+    }
+
+    GpuFrame &gpuFrame = gpuFrames[gpuFrameIndex];
+
+    if (gpuMarkerDepth >= MaxCpuMarkerDepth) {
+        gpuMarkerDepth++;
+        return;
+    }
+
+    if (gpuFrame.numMarkers >= MaxGpuMarkersPerFrame) {
+        // -1 means the marker is dropped
+        gpuMarkerStack[gpuMarkerDepth++] = -1;
+        return;
+    }
+
+    if (gpuFrame.numMarkers == 0) {
+        gpuFrame.cpuTime = PlatformTime::Microseconds();
+    }
+
+    int markerIndex = gpuFrame.numMarkers++;
+    GpuMarker &marker = gpuFrame.markers[markerIndex];
+    marker.name = name;
+    marker.ended = false;
+
+    rhi.QueryTimestamp(marker.beginQueryHandle);
+
+    gpuMarkerStack[gpuMarkerDepth++] = markerIndex;
+}
+
+void Profiler::EndGpuMarker() {
+    if (!gpuQueriesCreated || gpuMarkerDepth == 0) {
+        return;
+    }
+
+    gpuMarkerDepth--;
+
+    if (gpuMarkerDepth >= MaxCpuMarkerDepth) {
+        return;
+    }
+
+    int markerIndex = gpuMarkerStack[gpuMarkerDepth];
+    if (markerIndex < 0) {
+        return;
+    }
+
+    GpuMarker &marker = gpuFrames[gpuFrameIndex].markers[markerIndex];
+    marker.ended = true;
+
+    rhi.QueryTimestamp(marker.endQueryHandle);
+}
+
+void Profiler::CollectGpuMarkers(GpuFrame &gpuFrame) {
+    if (gpuFrame.disjoint) {
+        // Discard the samples of the frame
+        gpuFrame.numMarkers = 0;
+        gpuFrame.disjoint = false;
+        return;
+    }
+
+    if (gpuFrame.numMarkers == 0) {
+        return;
+    }
+
+    // GPU clock is not related to CPU clock, so GPU timeline is aligned to the CPU time when the first marker is issued.
+    uint64_t baseTimestamp = rhi.QueryTimestampResult(gpuFrame.markers[0].beginQueryHandle);
+
+    for (int markerIndex = 0; markerIndex < gpuFrame.numMarkers; markerIndex++) {
+        const GpuMarker &marker = gpuFrame.markers[markerIndex];
+        if (!marker.ended) {
+            continue;
+        }
+
+        uint64_t beginTimestamp = rhi.QueryTimestampResult(marker.beginQueryHandle);
+        uint64_t endTimestamp = rhi.QueryTimestampResult(marker.endQueryHandle);
+
+        CapturedEvent &capturedEvent = capturedEvents.Alloc();
+        capturedEvent.name = marker.name;
+        capturedEvent.threadIndex = -1;
+        capturedEvent.startTime = gpuFrame.cpuTime + (beginTimestamp - baseTimestamp) / 1000;
+        capturedEvent.duration = endTimestamp > beginTimestamp ? (endTimestamp - beginTimestamp) / 1000 : 0;
+    }
+
+    gpuFrame.numMarkers = 0;
+}
+
+void Profiler::StartCapture(int numFrames, const char *filename) {
+    if (capturing) {
+        BE_WARNLOG(L"Profiler::StartCapture: already capturing\n");
+        return;
+    }
+
+    captureFramesLeft = Max(numFrames, 1);
+    captureFilename = filename;
+    capturedEvents.Clear();
+
+    // Skip the events recorded before
+    for (int i = 0; i < numThreadInfos.GetValue(); i++) {
+        ProfilerThreadInfo *threadInfo = threadInfos[i];
+        threadInfo->readIndex = (uint32_t)threadInfo->writeIndex.GetValue();
+        threadInfo->openDepth = 0;
+    }
+
+    CreateGpuQueries();
+
+    capturing = true;
+
+    BE_LOG(L"Profiler: capturing %i frames...\n", captureFramesLeft);
+}
+
+void Profiler::StopCapture() {
+    if (!capturing) {
+        return;
+    }
+
+    capturing = false;
+
+    for (int i = 0; i < numThreadInfos.GetValue(); i++) {
+        CollectCpuEvents(threadInfos[i]);
+    }
+
+    if (gpuQueriesCreated) {
+        if (rhi.QueryTimerDisjoint()) {
+            for (int i = 0; i < GpuFrameLatency; i++) {
+                gpuFrames[i].disjoint = true;
+            }
+        }
+
+        // Wait for the GPU frames in flight from the oldest one
+        for (int i = 1; i <= GpuFrameLatency; i++) {
+            CollectGpuMarkers(gpuFrames[(gpuFrameIndex + i) % GpuFrameLatency]);
+        }
+
+        FreeGpuQueries();
+    }
+
+    WriteChromeTrace(captureFilename);
+
+    capturedEvents.Clear();
+}
+
+void Profiler::SyncFrame() {
+    if (!capturing) {
+        return;
+    }
+
+    for (int i = 0; i < numThreadInfos.GetValue(); i++) {
+        CollectCpuEvents(threadInfos[i]);
+    }
+
+    if (gpuQueriesCreated) {
+        // Markers which are not ended in this frame are dropped
+        gpuMarkerDepth = 0;
+
+        // Timestamps of the frames in flight are invalid if the GPU timer was disjoint since the last check
+        if (rhi.QueryTimerDisjoint()) {
+            for (int i = 0; i < GpuFrameLatency; i++) {
+                gpuFrames[i].disjoint = true;
+            }
+        }
+
+        gpuFrameIndex = (gpuFrameIndex + 1) % GpuFrameLatency;
+
+        // Oldest frame is reused for the next frame, so resolve it first
+        CollectGpuMarkers(gpuFrames[gpuFrameIndex]);
+    }
+
+    if (--captureFramesLeft <= 0) {
+        StopCapture();
+    }
+}
+
+void Profiler::WriteChromeTrace(const char *filename) const {
+    File *file = fileSystem.OpenFileWrite(filename);
+    if (!file) {
+        BE_WARNLOG(L"Profiler::WriteChromeTrace: failed to open file '%hs'\n", filename);
+        return;
+    }
+
+    file->Printf("{\"traceEvents\":[\n");
+
+    // Thread names
+    file->Printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"GPU\"}}");
+    for (int i = 0; i < numThreadInfos.GetValue(); i++) {
+        file->Printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%i,\"args\":{\"name\":\"%s\"}}", threadInfos[i]->index + 1, threadInfos[i]->name);
+    }
+
+    for (int i = 0; i < capturedEvents.Count(); i++) {
+        const CapturedEvent &event = capturedEvents[i];
+
+        // tid 0 is used for the GPU
+        file->Printf(",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%llu,\"dur\":%llu}",
+            event.name, event.threadIndex + 1, (unsigned long long)event.startTime, (unsigned long long)event.duration);
+    }
+
+    file->Printf("\n]}\n");
+
+    fileSystem.CloseFile(file);
+
+    BE_LOG(L"Profiler: %i events written to '%hs'\n", capturedEvents.Count(), filename);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Profiler::Cmd_ProfileCapture(const CmdArgs &args) {
+    if (args.Argc() < 2) {
+        BE_LOG(L"profileCapture <numFrames> [filename]\n");
+        return;
+    }
+
+    int numFrames = wcstol(args.Argv(1), nullptr, 10);
+
+    Str filename;
+    if (args.Argc() > 2) {
+        filename = WStr::ToStr(args.Argv(2));
+    } else {
+        filename = "Profile/capture.json";
+    }
+
+    profiler.StartCapture(numFrames, filename);
+}
+
+BE_NAMESPACE_END
@@ -617,6 +617,12 @@ bool Properties::SetVa(const char *name, ...) {
     return true;
 }
 
+void Properties::SetRaw(const char *name, const Variant &value, int numElements) {
+    Property &prop = propertyHashMap[name];
+    prop.value = value;
+    prop.numElements = numElements;
+}
+
 const Json::Value Properties::Deserialize() const {
     Array<const PropertySpec *> pspecs;
     Json::Value node;
@@ -15,146 +15,387 @@
 #include "Precompiled.h"
 #include "Platform/PlatformProcess.h"
 #include "Core/Task.h"
+#include <atomic>
 
 BE_NAMESPACE_BEGIN
 
+TaskScheduler           taskScheduler;
+
+static BE_THREAD_LOCAL int currentThreadIndex = -1;
+
+// Chase-Lev work-stealing deque with fixed capacity.
+// Only the owner thread calls Push/Pop, any other thread can call Steal.
+class TaskDeque {
+public:
+    enum { Mask = TaskScheduler::MaxTasksPerThread - 1 };
+
+    TaskDeque() : top(0), bottom(0) {}
+
+    bool                    Push(const Task &task);
+    bool                    Pop(Task &task);
+    bool                    Steal(Task &task);
+
+private:
+    std::atomic<int64_t>    top;
+    char                    pad0[64 - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t>    bottom;
+    char                    pad1[64 - sizeof(std::atomic<int64_t>)];
+    Task                    tasks[TaskScheduler::MaxTasksPerThread];
+};
+
+bool TaskDeque::Push(const Task &task) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t > Mask) {
+        return false;
+    }
+
+    tasks[b & Mask] = task;
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+bool TaskDeque::Pop(Task &task) {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // Deque was empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    task = tasks[b & Mask];
+
+    if (t == b) {
+        // Last task in the deque. Race against thieves
+        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+bool TaskDeque::Steal(Task &task) {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+
+    if (t >= b) {
+        return false;
+    }
+
+    Task stolenTask = tasks[t & Mask];
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return false;
+    }
+    task = stolenTask;
+    return true;
+}
+
+static void SpinLock(PlatformAtomic &lock) {
+    while (CompareExchange(lock, 1, 0) != 0) {
+        PlatformProcess::Sleep(0);
+    }
+}
+
+static void SpinUnlock(PlatformAtomic &lock) {
+    CompareExchange(lock, 0, 1);
+}
+
+struct TaskThreadParms {
+    TaskScheduler *         scheduler;
+    int                     threadIndex;
+};
+
 void TaskScheduler_ThreadProc(void *param);
 
-TaskScheduler::TaskScheduler(int numThreads) {
+void TaskScheduler::Init(int numWorkerThreads) {
+    if (numWorkerThreads < 0) {
+        // Get thread count as number of logical processors except main thread
+        numWorkerThreads = PlatformProcess::NumberOfLogicalProcessors() - 1;
+    }
+    Clamp(numWorkerThreads, 0, (int)MaxThreads - 1);
+
+    numThreads = numWorkerThreads + 1;
+    deques = new TaskDeque[numThreads];
+
     numActiveTasks = 0;
+    numQueuedTasks = 0;
+    numSleepingThreads = 0;
     terminate = false;
-    
-    taskMutex = PlatformMutex::Create();
-    taskCondition = PlatformCondition::Create();
 
-    finishMutex = PlatformMutex::Create();
-    finishCondition = PlatformCondition::Create();
+    sharedTaskMutex = PlatformMutex::Create();
 
-#ifdef    __WIN32__
-    if (numThreads < 0) {
-        // Get thread count as number of logical processors
-        numThreads = PlatformProcess::NumberOfLogicalProcessors();
-    }
-#endif
+    sleepMutex = PlatformMutex::Create();
+    sleepCondition = PlatformCondition::Create();
 
-    for (int i = 0; i < numThreads; i++) {
-        PlatformThread *thread = PlatformThread::Create(TaskScheduler_ThreadProc, (void *)this, 0);
+    // Calling thread is the main thread
+    currentThreadIndex = 0;
+
+    for (int i = 1; i < numThreads; i++) {
+        TaskThreadParms *parms = new TaskThreadParms;
+        parms->scheduler = this;
+        parms->threadIndex = i;
+
+        PlatformThread *thread = PlatformThread::Create(TaskScheduler_ThreadProc, (void *)parms, 0);
         threads.Append(thread);
     }
+
+    BE_LOG(L"Task scheduler initialized with %i worker threads\n", numWorkerThreads);
 }
 
-TaskScheduler::~TaskScheduler() {
-    if (threads.Count() == 0) {
+void TaskScheduler::Shutdown() {
+    if (!deques) {
         return;
     }
 
-    // task 중단 flag 를 켜고 모든 task thread 들을 깨운다.
-    PlatformMutex::Lock(taskMutex);
+    WaitFinish();
+
+    // terminate flag 를 켜고 모든 worker thread 들을 깨운다.
+    PlatformMutex::Lock(sleepMutex);
     terminate = true;
-    PlatformCondition::Broadcast(taskCondition);
-    PlatformMutex::Unlock(taskMutex);
+    PlatformCondition::Broadcast(sleepCondition);
+    PlatformMutex::Unlock(sleepMutex);
 
     // thread 가 모두 종료될 때까지 대기
     for (int i = 0; i < threads.Count(); i++) {
         PlatformThread::Wait(threads[i]);
     }
+    threads.Clear();
 
-    PlatformCondition::Delete(taskCondition);
-    PlatformMutex::Delete(taskMutex);
+    PlatformCondition::Delete(sleepCondition);
+    PlatformMutex::Delete(sleepMutex);
 
-    PlatformCondition::Delete(finishCondition);
-    PlatformMutex::Delete(finishMutex);
+    PlatformMutex::Delete(sharedTaskMutex);
+    sharedTasks.Clear();
+
+    delete [] deques;
+    deques = nullptr;
+
+    numThreads = 0;
+
+    currentThreadIndex = -1;
 }
 
-void TaskScheduler::LockTask() {
-    PlatformMutex::Lock(taskMutex);
+int TaskScheduler::ThreadIndex() {
+    return currentThreadIndex;
 }
 
-void TaskScheduler::UnlockTask() {
-    PlatformMutex::Unlock(taskMutex);
+void TaskScheduler::PushTask(const Task &task) {
+    numQueuedTasks++;
+
+    int threadIndex = currentThreadIndex;
+    if (threadIndex >= 0 && deques[threadIndex].Push(task)) {
+        return;
+    }
+
+    // Threads not owned by the scheduler or overflowed tasks go to the shared list
+    PlatformMutex::Lock(sharedTaskMutex);
+    sharedTasks.Append(task);
+    PlatformMutex::Unlock(sharedTaskMutex);
 }
 
-void TaskScheduler::AddTask(taskFunction_t function, void *data) {
-    // task 추가를 위해 lock
-    PlatformMutex::Lock(taskMutex);
+bool TaskScheduler::PopTask(int threadIndex, Task &task) {
+    if (numQueuedTasks <= 0) {
+        return false;
+    }
+
+    // Pop from the bottom of own deque first
+    if (threadIndex >= 0 && deques[threadIndex].Pop(task)) {
+        numQueuedTasks--;
+        return true;
+    }
+
+    if (!sharedTasks.IsEmpty()) {
+        bool found = false;
+        PlatformMutex::Lock(sharedTaskMutex);
+        if (!sharedTasks.IsEmpty()) {
+            task = sharedTasks.TakeLast();
+            found = true;
+        }
+        PlatformMutex::Unlock(sharedTaskMutex);
+
+        if (found) {
+            numQueuedTasks--;
+            return true;
+        }
+    }
 
+    // Steal from the top of other deques starting from the next thread
+    for (int i = 1; i < numThreads; i++) {
+        int victimIndex = (Max(threadIndex, 0) + i) % numThreads;
+        if (deques[victimIndex].Steal(task)) {
+            numQueuedTasks--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::ExecuteTask(const Task &task) {
+    task.function(task.data);
+
+    if (task.counter) {
+        DecrementCounter(task.counter);
+    }
+
+    numActiveTasks--;
+}
+
+void TaskScheduler::DecrementCounter(TaskCounter *counter) {
+    Array<Task> readyTasks;
+
+    // Counter can be destroyed by the waiting thread as soon as the lock is released.
+    SpinLock(counter->lock);
+    if (counter->value.Sub(1) == 0 && !counter->dependentTasks.IsEmpty()) {
+        readyTasks.Swap(counter->dependentTasks);
+    }
+    SpinUnlock(counter->lock);
+
+    if (readyTasks.Count() > 0) {
+        for (int i = 0; i < readyTasks.Count(); i++) {
+            PushTask(readyTasks[i]);
+        }
+        WakeUpWorkers(readyTasks.Count());
+    }
+}
+
+void TaskScheduler::WakeUpWorkers(int numTasks) {
+    // Sleeping workers wait for this to change, so a wake-up between their last pop and the wait is never lost
+    wakeUpCount++;
+
+    if (numSleepingThreads > 0) {
+        PlatformMutex::Lock(sleepMutex);
+        if (numTasks > 1) {
+            PlatformCondition::Broadcast(sleepCondition);
+        } else {
+            PlatformCondition::Signal(sleepCondition);
+        }
+        PlatformMutex::Unlock(sleepMutex);
+    }
+}
+
+void TaskScheduler::AddTask(taskFunction_t function, void *data, TaskCounter *counter) {
     Task task;
     task.function = function;
     task.data = data;
-    if (taskList.size() >= MaxTasks) {
-        BE_FATALERROR(L"too many tasks generated");
+    task.counter = counter;
+
+    AddTasks(1, &task, counter);
+}
+
+void TaskScheduler::AddTasks(int numTasks, const Task *tasks, TaskCounter *counter) {
+    if (numTasks <= 0) {
+        return;
     }
-    taskList.push_back(task);
-    numActiveTasks++;
 
-    // task 추가를 기다리는 thread 들에게 모두 신호한 후 unlock (?모두?)
-    PlatformCondition::Broadcast(taskCondition);
-    PlatformMutex::Unlock(taskMutex);
+    if (counter) {
+        counter->value.Add(numTasks);
+    }
+    numActiveTasks.Add(numTasks);
+
+    for (int i = 0; i < numTasks; i++) {
+        Task task = tasks[i];
+        task.counter = counter;
+
+        PushTask(task);
+    }
+
+    WakeUpWorkers(numTasks);
 }
 
-void TaskScheduler::WaitFinish() {
-    // finish 신호를 기다린다.
-    PlatformMutex::Lock(finishMutex);
-    // 신호를 받자마자 다시 task 가 추가될 수도 있으므로 loop 를 돈다.
-    while (numActiveTasks > 0) {
-        PlatformCondition::Wait(finishCondition, finishMutex);
+void TaskScheduler::AddTaskAfter(TaskCounter *dependency, taskFunction_t function, void *data, TaskCounter *counter) {
+    Task task;
+    task.function = function;
+    task.data = data;
+    task.counter = counter;
+
+    // Count the task as active from now on, so that waiting on counter includes it
+    if (counter) {
+        counter->value++;
     }
-    PlatformMutex::Unlock(finishMutex);
+    numActiveTasks++;
+
+    SpinLock(dependency->lock);
+    if (dependency->value > 0) {
+        dependency->dependentTasks.Append(task);
+        SpinUnlock(dependency->lock);
+        return;
+    }
+    SpinUnlock(dependency->lock);
+
+    PushTask(task);
+    WakeUpWorkers(1);
 }
 
-bool TaskScheduler::TimedWaitFinish(int ms) {
-    bool ret = true;
-    // finish 신호를 일정 시간동안 기다린다.
-    PlatformMutex::Lock(finishMutex);
-    // 신호를 받자마자 다시 task 가 추가될 수도 있으므로 loop 를 돈다.
-    while (numActiveTasks > 0 && ret == true) {
-        ret = PlatformCondition::TimedWait(finishCondition, finishMutex, ms);
+void TaskScheduler::WaitForCounter(const TaskCounter *counter) {
+    int threadIndex = currentThreadIndex;
+
+    while (1) {
+        // Counter must not be touched by DecrementCounter() any more
+        if (counter->value == 0 && CompareExchange(const_cast<TaskCounter *>(counter)->lock, 0, 0) == 0) {
+            break;
+        }
+
+        Task task;
+        if (threadIndex >= 0 && PopTask(threadIndex, task)) {
+            ExecuteTask(task);
+        } else {
+            PlatformProcess::Sleep(0);
+        }
     }
-    PlatformMutex::Unlock(finishMutex);
-    return ret;
 }
 
-void TaskScheduler_ThreadProc(void *param) {
-    /*int cpuid = GetCpuInfo()->cpuid;
-    if (cpuid & CPUID_FTZ) {
-        _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+void TaskScheduler::WaitFinish() {
+    int threadIndex = currentThreadIndex;
+
+    while (numActiveTasks > 0) {
+        Task task;
+        if (threadIndex >= 0 && PopTask(threadIndex, task)) {
+            ExecuteTask(task);
+        } else {
+            PlatformProcess::Sleep(0);
+        }
     }
+}
 
-    if (cpuid & CPUID_DAZ) {
-        _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
-    }*/
+void TaskScheduler_ThreadProc(void *param) {
+    TaskThreadParms *parms = (TaskThreadParms *)param;
+    TaskScheduler *ts = parms->scheduler;
+    int threadIndex = parms->threadIndex;
+    delete parms;
 
-    TaskScheduler *ts = (TaskScheduler *)param;
+    currentThreadIndex = threadIndex;
 
     while (1) {
-        PlatformMutex::Lock(ts->taskMutex);
+        int64_t lastWakeUpCount = ts->wakeUpCount;
+
+        Task task;
+        if (ts->PopTask(threadIndex, task)) {
+            ts->ExecuteTask(task);
+            continue;
+        }
+
         // 처리할 task 가 생길 때까지 wait
-        while (ts->taskList.empty() && !ts->terminate) { // ?if?
-            PlatformCondition::Wait(ts->taskCondition, ts->taskMutex);
+        PlatformMutex::Lock(ts->sleepMutex);
+        ts->numSleepingThreads++;
+        while (ts->wakeUpCount == lastWakeUpCount && !ts->terminate) {
+            PlatformCondition::Wait(ts->sleepCondition, ts->sleepMutex);
         }
+        ts->numSleepingThreads--;
+        PlatformMutex::Unlock(ts->sleepMutex);
 
         // 종료 중이라면 exit
         if (ts->terminate) {
-            PlatformMutex::Unlock(ts->taskMutex);
             break;
         }
-
-        // task 를 앞에서부터 받아온다
-        Task task = ts->taskList.front();
-        ts->taskList.pop_front();
-        PlatformMutex::Unlock(ts->taskMutex);
-
-        task.function(task.data);
-
-        // task function 이 끝나면 numActiveTask 를 줄인다. (다른 쓰레드와 공유된 변수이므로 atomic 연산)
-        atomic_add(&ts->numActiveTasks, -1);
-        // 실행 중인 task 가 한개도 없으면 finish 신호를 보낸다.
-        if (ts->numActiveTasks == 0) {
-            PlatformMutex::Lock(ts->finishMutex);
-            PlatformCondition::Broadcast(ts->finishCondition);
-            PlatformMutex::Unlock(ts->finishMutex);
-        }
     }
+
+    currentThreadIndex = -1;
 }
 
 BE_NAMESPACE_END
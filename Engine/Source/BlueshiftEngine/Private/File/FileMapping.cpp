@@ -93,10 +93,14 @@ bool FileMapping::Open(const TCHAR *filename) {
     size = fs.st_size;
 
     data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
-    if (data == NULL) {
+    if (data == MAP_FAILED) {
         BE_ERRLOG(L"_FileMapping::Open: Could not map %ls to memory\n", towcs(filename));
+        data = NULL;
+        size = 0;
+        close(fd);
         return false;
     }
+    hFile = fd;
 
     // close fd is error 
     //if (close(fd) != 0) {
@@ -159,11 +163,16 @@ void FileMapping::Close() {
         BE_ERRLOG(L"_FileMapping::Close: unable to unmap memory\n");
     }
     close(hFile);
+    hFile = -1;
 #elif defined(__WIN32__)
     UnmapViewOfFile(data);
     CloseHandle(hMapping);
     CloseHandle(hFile);
+    hMapping = NULL;
+    hFile = INVALID_HANDLE_VALUE;
 #endif
+    data = NULL;
+    size = 0;
 }
 
 BE_NAMESPACE_END
@@ -17,7 +17,9 @@
 #include "Core/CVars.h"
 #include "Core/Cmds.h"
 #include "Platform/PlatformProcess.h"
+#include "Platform/PlatformThread.h"
 #include "File/FileSystem.h"
+#include "File/FileMapping.h"
 #include "minizip/zip.h"
 #include "minizip/unzip.h"
 
@@ -43,10 +45,13 @@ struct ZipEntry {
     uLong                   unzOffset;
 };
 
+// Each opened file in the archive reads through its own unzFile handle, so files can be read from multiple threads at once.
+// Handles are pooled to avoid parsing the central directory on every open.
 struct ZipArchive {
     char                    name[MaxRelativePath];
     char                    fullPath[MaxAbsolutePath];
-    unzFile                 unzArchive;
+    PlatformMutex *         handleMutex;
+    Array<unzFile>          freeHandles;        ///< Handles not used by any opened file
     int                     numEntries;
     Array<ZipEntry *>       entryList;
     HashIndex               entryHash;
@@ -67,7 +72,10 @@ void FileSystem::ClearSearchPath() {
         if (s->archive) {
             s->archive->entryList.DeleteContents(true);
             s->archive->entryHash.Free();
-            unzClose(s->archive->unzArchive);
+            for (int i = 0; i < s->archive->freeHandles.Count(); i++) {
+                unzClose(s->archive->freeHandles[i]);
+            }
+            PlatformMutex::Delete(s->archive->handleMutex);
             delete s->archive;
         } else if (s->pathname) {
             delete[] s->pathname;
@@ -101,24 +109,43 @@ void FileSystem::SetSearchPath(const char *multiplePath) {
     }
 }
 
+// Search paths are normalized once here, so that joining them with the file names is enough
+// for PlatformFile to resolve the files on every access without touching the base path.
+static Str NormalizeSearchPath(const char *path) {
+    Str normalizedPath = path;
+#if defined(__ANDROID__)
+    // Asset paths are always prefixed with the base path
+    normalizedPath = normalizedPath.ToRelativePath(PlatformFile::GetBasePath());
+#else
+    // Absolute paths are passed through by PlatformFile. Relative ones are relative to the working directory.
+    if (FileSystem::IsRelativePath(path)) {
+        normalizedPath = normalizedPath.ToAbsolutePath(PlatformFile::Cwd());
+    }
+#endif
+    normalizedPath.CleanPath();
+    return normalizedPath;
+}
+
 void FileSystem::AddSearchPath(const char *path) {
     if (!path || !path[0]) {
         return;
     }
 
+    Str normalizedPath = NormalizeSearchPath(path);
+
     SearchPath *search = new SearchPath;
     search->pathname = new char[MaxAbsolutePath];
-    strcpy(search->pathname, path);
+    Str::Copynz(search->pathname, normalizedPath, MaxAbsolutePath);
     search->archive = nullptr;
     search->next = searchPath;
     searchPath = search;
 
     // path 의 zip 파일들을 searchpath 에 추가
     Array<FileInfo> files;
-    int num = PlatformFile::ListFiles(ToRelativePath(path), "*.zip", false, false, files);
+    int num = PlatformFile::ListFiles(ToRelativePath(normalizedPath), "*.zip", false, false, files);
 
     for (int i = 0; i < num; i++) {
-        AddSearchPath_ZIP(path, files[i].relativePath);
+        AddSearchPath_ZIP(normalizedPath, files[i].relativePath);
     }
 }
 
@@ -204,19 +231,27 @@ void _fill_fopen_filefunc(zlib_filefunc_def* pzlib_filefunc_def)
     pzlib_filefunc_def->opaque = nullptr;
 }
 
-void FileSystem::AddSearchPath_ZIP(const char *path, const char *filename) {		
-    char fullpath[MaxAbsolutePath];
-    fileSystem.MakeFullPath(fullpath, sizeof(fullpath), path, "", filename);
-    
-    unz_global_info z_global_info;
+static unzFile OpenZipHandle(const char *fullpath) {
 #if defined(__ANDROID__) 
     zlib_filefunc_def zlib_filefunc32_def;
     _fill_fopen_filefunc(&zlib_filefunc32_def);
-    unzFile z_file = unzOpen2(ToRelativePath(fullpath), &zlib_filefunc32_def);
+    return unzOpen2(fileSystem.ToRelativePath(fullpath), &zlib_filefunc32_def);
 #else
-    unzFile z_file = unzOpen(fullpath);
+    return unzOpen(fullpath);
 #endif
+}
+
+void FileSystem::AddSearchPath_ZIP(const char *path, const char *filename) {		
+    char fullpath[MaxAbsolutePath];
+    fileSystem.MakeFullPath(fullpath, sizeof(fullpath), path, "", filename);
+    
+    unz_global_info z_global_info;
+    unzFile z_file = OpenZipHandle(fullpath);
+    if (!z_file) {
+        return;
+    }
     if (unzGetGlobalInfo(z_file, &z_global_info) != UNZ_OK) {
+        unzClose(z_file);
         return;
     }
 
@@ -225,7 +260,7 @@ void FileSystem::AddSearchPath_ZIP(const char *path, const char *filename) {
     strcpy(archive->fullPath, fullpath);
     strcpy(archive->name, filename);
 
-    archive->unzArchive = z_file;
+    archive->handleMutex = PlatformMutex::Create();
     archive->numEntries = (int)z_global_info.number_entry;
     
     archive->entryList.Resize((int)z_global_info.number_entry);
@@ -255,12 +290,47 @@ void FileSystem::AddSearchPath_ZIP(const char *path, const char *filename) {
         unzGoToNextFile(z_file);
     }
 
+    archive->freeHandles.Append(z_file);
+
     SearchPath *search = new SearchPath;
     search->archive = archive;
     search->next = searchPath;
     searchPath = search;
 }
 
+int FileSystem::FindZipEntry(const ZipArchive *archive, const char *filename) {
+    Str entryFilename = filename;
+    Str::ConvertPathSeperator(entryFilename, PATHSEPERATOR_CHAR);
+
+    int hash = archive->entryHash.GenerateHash(entryFilename, false);
+    for (int i = archive->entryHash.First(hash); i != -1; i = archive->entryHash.Next(i)) {
+        if (!Str::Icmp(archive->entryList[i]->name, entryFilename)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void *FileSystem::AcquireZipHandle(ZipArchive *archive) {
+    PlatformMutex::Lock(archive->handleMutex);
+    if (archive->freeHandles.Count() > 0) {
+        unzFile z_file = archive->freeHandles[archive->freeHandles.Count() - 1];
+        archive->freeHandles.RemoveIndex(archive->freeHandles.Count() - 1);
+        PlatformMutex::Unlock(archive->handleMutex);
+        return z_file;
+    }
+    PlatformMutex::Unlock(archive->handleMutex);
+
+    // All the handles are in use, open another one
+    return OpenZipHandle(archive->fullPath);
+}
+
+void FileSystem::ReleaseZipHandle(ZipArchive *archive, void *handle) {
+    PlatformMutex::Lock(archive->handleMutex);
+    archive->freeHandles.Append(handle);
+    PlatformMutex::Unlock(archive->handleMutex);
+}
+
 void FileSystem::Init(const char *baseDir) {
     SetBaseDir(baseDir);
 
@@ -568,35 +638,29 @@ File *FileSystem::OpenFileRead(const char *filename, bool useSearchPath, size_t
         return nullptr;
     }
     
-    Str basePathOld = PlatformFile::GetBasePath();
-    
     File *resultFile = nullptr;
     
     for (SearchPath *s = searchPath; s; s = s->next) {
         if (s->archive) {
             ZipArchive *archive = s->archive;
-            ZipEntry *entry;
 
-            Str entryFilename = filename;
-            Str::ConvertPathSeperator(entryFilename, PATHSEPERATOR_CHAR);
+            int entryIndex = FindZipEntry(archive, filename);
+            if (entryIndex != -1) {
+                const ZipEntry *entry = archive->entryList[entryIndex];
 
-            int hash = archive->entryHash.GenerateHash(entryFilename, false);
-            int	i;
-            for (i = archive->entryHash.First(hash); i != -1; i = archive->entryHash.Next(i)) {
-                if (!Str::Icmp(archive->entryList[i]->name, entryFilename)) {
-                    entry = archive->entryList[i];
-                    break;
-                }
-            }
-                        
-            if (i != -1) {
                 if (fs_debug.GetBool()) {
                     BE_LOG(L"FileSystem::OpenFileRead: %hs (found in '%hs')\n", filename, archive->name);
                 }
 
-                unzSetOffset(archive->unzArchive, entry->unzOffset);
-                unzOpenCurrentFile(archive->unzArchive);
-                FileInZip *file = new FileInZip(filename, (void *)archive->unzArchive);
+                unzFile z_file = AcquireZipHandle(archive);
+                if (!z_file) {
+                    BE_WARNLOG(L"FileSystem::OpenFileRead: failed to open archive '%hs'\n", archive->fullPath);
+                    break;
+                }
+
+                unzSetOffset(z_file, entry->unzOffset);
+                unzOpenCurrentFile(z_file);
+                FileInZip *file = new FileInZip(filename, archive, (void *)z_file);
 
                 if (fileSize) {
                     file->size = *fileSize = entry->uncompressedSize;
@@ -606,9 +670,11 @@ File *FileSystem::OpenFileRead(const char *filename, bool useSearchPath, size_t
                 break;
             }
         } else {
-            PlatformFile::SetBasePath(s->pathname);
+            // Resolve the path here instead of changing the global base path, so that it can be called from any thread
+            Str path = s->pathname;
+            path.AppendPath(filename);
 
-            PlatformFile *pf = PlatformFile::OpenFileRead(filename);
+            PlatformFile *pf = PlatformFile::OpenFileRead(path);
             if (pf) {
                 if (fs_debug.GetBool()) {
                     BE_LOG(L"FileSystem::OpenFileRead: %hs (found in '%hs')\n", filename, s->pathname);
@@ -625,8 +691,6 @@ File *FileSystem::OpenFileRead(const char *filename, bool useSearchPath, size_t
             }
         }
     }
-    
-    PlatformFile::SetBasePath(basePathOld);
 
     return resultFile;
 }
@@ -778,6 +842,38 @@ void FileSystem::FreeFile(void *buffer) const {
     Mem_Free(buffer);
 }
 
+bool FileSystem::MapFile(const char *filename, bool searchDirs, FileMapping &fileMapping) {
+    if (PlatformFile::FileExists(filename)) {
+        return fileMapping.Open(PlatformFile::NormalizeFilename(filename));
+    }
+
+    if (!searchDirs) {
+        return false;
+    }
+
+    for (SearchPath *s = searchPath; s; s = s->next) {
+        if (s->archive) {
+            // Compressed entries can't be mapped, so stop searching if the archive has the file
+            if (FindZipEntry(s->archive, filename) != -1) {
+                return false;
+            }
+        } else {
+            Str path = s->pathname;
+            path.AppendPath(filename);
+
+            if (PlatformFile::FileExists(path)) {
+                if (fs_debug.GetBool()) {
+                    BE_LOG(L"FileSystem::MapFile: %hs (found in '%hs')\n", filename, s->pathname);
+                }
+
+                return fileMapping.Open(PlatformFile::NormalizeFilename(path));
+            }
+        }
+    }
+
+    return false;
+}
+
 void FileSystem::WriteFile(const char *filename, const void *buffer, int size) {
     if (!filename || !buffer) {
         BE_FATALERROR(L"FileSystem::WriteFile: nullptr parameter");
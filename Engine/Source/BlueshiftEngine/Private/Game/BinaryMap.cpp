@@ -0,0 +1,809 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Render/Render.h"
+#include "Components/Component.h"
+#include "Components/ComScript.h"
+#include "Game/Entity.h"
+#include "Game/MapRenderSettings.h"
+#include "Game/BinaryMap.h"
+#include "Game/PropertyCodec.h"
+#include "Core/Cmds.h"
+#include "File/FileSystem.h"
+#include "Platform/PlatformTime.h"
+
+BE_NAMESPACE_BEGIN
+
+#define BMAP_IDENT          MAKE_FOURCC('B', 'M', 'A', 'P')
+#define BMAP_VERSION        2
+
+#define BMAP_BATCH_SIZE     256     // maximum number of entities in a batch
+
+#pragma pack(1)
+
+struct BMapHeader {
+    int32_t         ident;
+    int32_t         version;
+    int32_t         mapVersion;
+    uint32_t        sourceSize;     // size of the source JSON map file
+    int64_t         sourceTime;     // time stamp of the source JSON map file
+    int32_t         numStrings;
+    uint32_t        stringsOffset;
+    uint32_t        stringsSize;
+    int32_t         numLayouts;
+    uint32_t        layoutsOffset;
+    uint32_t        layoutsSize;
+    int32_t         numMeshes;
+    uint32_t        meshesOffset;
+    int32_t         numAudioClips;
+    uint32_t        audioClipsOffset;
+    uint32_t        settingsOffset;
+    uint32_t        settingsSize;
+    int32_t         numEntities;
+    int32_t         numBatches;
+    uint32_t        batchesOffset;
+};
+
+struct BMapLayout {
+    int32_t         classNameIndex;
+    Guid            scriptGuid;
+    int32_t         numProperties;
+};
+
+struct BMapLayoutProperty {
+    int32_t         nameIndex;
+    int32_t         type;
+    int32_t         isArray;
+};
+
+struct BMapBatch {
+    int32_t         numEntities;
+    uint32_t        size;           // size of the entities following this
+};
+
+#pragma pack()
+
+CVar BinaryMap::map_useCooked(L"map_useCooked", L"1", CVar::Bool, L"load the cooked binary map if it is up to date");
+
+//-------------------------------------------------------------------------------------------------
+// Cook
+//-------------------------------------------------------------------------------------------------
+
+// Strings are written as the index of the string table
+class BinaryMapWriter : public PropertyWriter {
+public:
+    int                     AddString(const char *str);
+    int                     AddLayout(const Object *object, const Array<const PropertySpec *> &pspecs);
+    static void             AddPrefetchGuid(const Guid &guid, Array<Guid> &guids, HashTable<Guid, int> &guidHash);
+
+    virtual void            WriteString(Array<byte> &out, const char *str) override;
+
+    void                    WriteObject(const Object *object, const Guid &guid, Array<byte> &out);
+    bool                    WriteEntity(const Json::Value &entityValue, Array<byte> &out);
+
+    Array<byte>             stringData;
+    int                     numStrings = 0;
+    StrHashMap<int>         stringHash;
+
+    Array<byte>             layoutData;
+    int                     numLayouts = 0;
+    StrHashMap<int>         layoutHash;
+
+    Array<Guid>             meshGuids;
+    HashTable<Guid, int>    meshHash;
+
+    Array<Guid>             audioClipGuids;
+    HashTable<Guid, int>    audioClipHash;
+};
+
+int BinaryMapWriter::AddString(const char *str) {
+    const auto *entry = stringHash.Get(str);
+    if (entry) {
+        return entry->second;
+    }
+
+    WriteBytes(stringData, str, (int)strlen(str) + 1);
+
+    stringHash.Set(str, numStrings);
+    return numStrings++;
+}
+
+void BinaryMapWriter::WriteString(Array<byte> &out, const char *str) {
+    Write(out, (int32_t)AddString(str));
+}
+
+// Objects of the same class with the same property specs share the layout
+int BinaryMapWriter::AddLayout(const Object *object, const Array<const PropertySpec *> &pspecs) {
+    Guid scriptGuid = Guid::zero;
+    if (object->IsTypeOf(ComScript::metaObject)) {
+        scriptGuid = object->props->Get("script").As<Guid>();
+    }
+
+    Str key = object->ClassName();
+    key += ":";
+    key += scriptGuid.ToString();
+
+    for (int i = 0; i < pspecs.Count(); i++) {
+        key += va(";%s:%i:%i", pspecs[i]->GetName(), (int)pspecs[i]->GetType(), (pspecs[i]->GetFlags() & PropertySpec::IsArray) ? 1 : 0);
+    }
+
+    const auto *entry = layoutHash.Get(key);
+    if (entry) {
+        return entry->second;
+    }
+
+    BMapLayout layout;
+    layout.classNameIndex = AddString(object->ClassName());
+    layout.scriptGuid = scriptGuid;
+    layout.numProperties = pspecs.Count();
+    Write(layoutData, layout);
+
+    for (int i = 0; i < pspecs.Count(); i++) {
+        BMapLayoutProperty layoutProperty;
+        layoutProperty.nameIndex = AddString(pspecs[i]->GetName());
+        layoutProperty.type = pspecs[i]->GetType();
+        layoutProperty.isArray = (pspecs[i]->GetFlags() & PropertySpec::IsArray) ? 1 : 0;
+        Write(layoutData, layoutProperty);
+    }
+
+    layoutHash.Set(key, numLayouts);
+    return numLayouts++;
+}
+
+void BinaryMapWriter::AddPrefetchGuid(const Guid &guid, Array<Guid> &guids, HashTable<Guid, int> &guidHash) {
+    if (!guid.IsZero() && !guidHash.Get(guid)) {
+        int index = guids.Append(guid);
+        guidHash.Set(guid, index);
+    }
+}
+
+// Object is written as the layout index, GUID and the property values in the order of the layout properties.
+// Strings are written as the string table index, and arrays are written as the number of elements followed by the elements.
+void BinaryMapWriter::WriteObject(const Object *object, const Guid &guid, Array<byte> &out) {
+    Array<const PropertySpec *> allSpecs;
+    object->GetPropertySpecList(allSpecs);
+
+    Array<const PropertySpec *> pspecs;
+    for (int i = 0; i < allSpecs.Count(); i++) {
+        if (!(allSpecs[i]->GetFlags() & PropertySpec::SkipSerialization)) {
+            pspecs.Append(allSpecs[i]);
+        }
+    }
+
+    Write(out, (int32_t)AddLayout(object, pspecs));
+    Write(out, guid);
+
+    for (int i = 0; i < pspecs.Count(); i++) {
+        const PropertySpec *spec = pspecs[i];
+        const Str name = spec->GetName();
+        const bool isArray = (spec->GetFlags() & PropertySpec::IsArray) ? true : false;
+
+        int numElements = 1;
+        if (isArray) {
+            numElements = object->props->NumElements(name);
+            Write(out, (int32_t)numElements);
+        }
+
+        for (int elementIndex = 0; elementIndex < numElements; elementIndex++) {
+            Variant value;
+            object->props->Get(isArray ? name + va("[%d]", elementIndex) : name, value, true);
+
+            WriteValue(out, spec->GetType(), value);
+
+            // Collect meshes and audio clips to prefetch like the JSON map loading
+            if (spec->GetType() == PropertySpec::ObjectType) {
+                if (!Str::Cmp(spec->GetName(), "mesh")) {
+                    AddPrefetchGuid(value.As<Guid>(), meshGuids, meshHash);
+                } else if (!Str::Cmp(spec->GetName(), "audioClip")) {
+                    AddPrefetchGuid(value.As<Guid>(), audioClipGuids, audioClipHash);
+                }
+            }
+        }
+    }
+}
+
+bool BinaryMapWriter::WriteEntity(const Json::Value &entityValue, Array<byte> &out) {
+    const char *classname = entityValue["classname"].asCString();
+    if (Str::Cmp(classname, Entity::metaObject.ClassName()) != 0) {
+        BE_WARNLOG(L"Unknown classname '%hs'\n", classname);
+        return false;
+    }
+
+    // Objects are created with the temporary GUIDs, because the map can be loaded in the game world
+    Json::Value tempEntityValue = entityValue;
+
+    Guid entityGuid = Guid::ParseString(entityValue.get("guid", Guid::zero.ToString()).asCString());
+    if (entityGuid.IsZero()) {
+        entityGuid = Guid::CreateGuid();
+    }
+    tempEntityValue["guid"] = Guid::zero.ToString();
+
+    Array<Guid> componentGuids;
+    Json::Value &componentsValue = tempEntityValue["components"];
+
+    for (int i = 0; i < componentsValue.size(); i++) {
+        Json::Value &componentValue = componentsValue[i];
+
+        // Same as Entity::CreateEntity(), components of the unknown class are skipped
+        const MetaObject *metaComponent = Object::GetMetaObject(componentValue["classname"].asCString());
+        if (!metaComponent || !metaComponent->IsTypeOf(Component::metaObject)) {
+            continue;
+        }
+
+        Guid componentGuid = Guid::ParseString(componentValue.get("guid", Guid::zero.ToString()).asCString());
+        if (componentGuid.IsZero()) {
+            componentGuid = Guid::CreateGuid();
+        }
+        componentGuids.Append(componentGuid);
+
+        componentValue["guid"] = Guid::zero.ToString();
+    }
+
+    Entity *entity = Entity::CreateEntity(tempEntityValue);
+
+    WriteObject(entity, entityGuid, out);
+
+    // Entity number is not a property
+    Write(out, (int32_t)entityValue.get("spawn_entnum", -1).asInt());
+
+    Write(out, (int32_t)entity->NumComponents());
+
+    for (int i = 0; i < entity->NumComponents(); i++) {
+        WriteObject(entity->GetComponent(i), componentGuids[i], out);
+    }
+
+    Entity::DestroyInstanceImmediate(entity);
+
+    return true;
+}
+
+Str BinaryMap::CookedFilename(const char *filename) {
+    Str cookedFilename = filename;
+    cookedFilename.SetFileExtension(".bmap");
+    return cookedFilename;
+}
+
+bool BinaryMap::Cook(const char *filename, const char *cookedFilename) {
+    char *text = nullptr;
+    fileSystem.LoadFile(filename, true, (void **)&text);
+    if (!text) {
+        BE_WARNLOG(L"Couldn't load '%hs'\n", filename);
+        return false;
+    }
+
+    Json::Value map;
+    Json::Reader jsonReader;
+    bool parsed = jsonReader.parse(text, map);
+
+    fileSystem.FreeFile(text);
+
+    if (!parsed) {
+        BE_WARNLOG(L"Failed to parse JSON text '%hs'\n", filename);
+        return false;
+    }
+
+    BinaryMapWriter writer;
+
+    // Write map render settings
+    Array<byte> settingsData;
+
+    MapRenderSettings *mapRenderSettings = static_cast<MapRenderSettings *>(MapRenderSettings::metaObject.CreateInstance());
+    mapRenderSettings->props->Init(map["renderSettings"]);
+    writer.WriteObject(mapRenderSettings, Guid::zero, settingsData);
+    MapRenderSettings::DestroyInstanceImmediate(mapRenderSettings);
+
+    // Write entities in batches
+    Array<byte> batchesData;
+    Array<byte> batchData;
+    int numEntities = 0;
+    int numBatches = 0;
+    int numBatchEntities = 0;
+
+    const Json::Value &entitiesValue = map["entities"];
+
+    for (int i = 0; i < entitiesValue.size(); i++) {
+        if (writer.WriteEntity(entitiesValue[i], batchData)) {
+            numEntities++;
+            numBatchEntities++;
+        }
+
+        if (numBatchEntities == BMAP_BATCH_SIZE || (i == entitiesValue.size() - 1 && numBatchEntities > 0)) {
+            BMapBatch batch;
+            batch.numEntities = numBatchEntities;
+            batch.size = batchData.Count();
+            PropertyWriter::Write(batchesData, batch);
+            PropertyWriter::WriteBytes(batchesData, batchData.Ptr(), batchData.Count());
+
+            batchData.SetCount(0, false);
+            numBatchEntities = 0;
+            numBatches++;
+        }
+    }
+
+    BMapHeader header;
+    header.ident = BMAP_IDENT;
+    header.version = BMAP_VERSION;
+    header.mapVersion = map["version"].asInt();
+    header.sourceSize = (uint32_t)fileSystem.FileSize(filename);
+    header.sourceTime = fileSystem.GetTimeStamp(filename).Ticks();
+    header.numStrings = writer.numStrings;
+    header.stringsOffset = sizeof(BMapHeader);
+    header.stringsSize = writer.stringData.Count();
+    header.numLayouts = writer.numLayouts;
+    header.layoutsOffset = header.stringsOffset + header.stringsSize;
+    header.layoutsSize = writer.layoutData.Count();
+    header.numMeshes = writer.meshGuids.Count();
+    header.meshesOffset = header.layoutsOffset + header.layoutsSize;
+    header.numAudioClips = writer.audioClipGuids.Count();
+    header.audioClipsOffset = header.meshesOffset + header.numMeshes * sizeof(Guid);
+    header.settingsOffset = header.audioClipsOffset + header.numAudioClips * sizeof(Guid);
+    header.settingsSize = settingsData.Count();
+    header.numEntities = numEntities;
+    header.numBatches = numBatches;
+    header.batchesOffset = header.settingsOffset + header.settingsSize;
+
+    File *fp = fileSystem.OpenFileWrite(cookedFilename);
+    if (!fp) {
+        BE_WARNLOG(L"BinaryMap::Cook: file open error '%hs'\n", cookedFilename);
+        return false;
+    }
+
+    fp->Write(&header, sizeof(header));
+    fp->Write(writer.stringData.Ptr(), writer.stringData.Count());
+    fp->Write(writer.layoutData.Ptr(), writer.layoutData.Count());
+    fp->Write(writer.meshGuids.Ptr(), writer.meshGuids.Count() * sizeof(Guid));
+    fp->Write(writer.audioClipGuids.Ptr(), writer.audioClipGuids.Count() * sizeof(Guid));
+    fp->Write(settingsData.Ptr(), settingsData.Count());
+    fp->Write(batchesData.Ptr(), batchesData.Count());
+
+    fileSystem.CloseFile(fp);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Load
+//-------------------------------------------------------------------------------------------------
+
+// Strings are read from the index of the string table
+class BinaryMapReader : public PropertyReader {
+public:
+    BinaryMapReader(const byte *data, size_t size, const Array<const char *> &strings) : PropertyReader(data, size), strings(strings) {}
+
+    virtual bool            ReadString(Str &str) override;
+
+private:
+    const Array<const char *> &strings;
+};
+
+bool BinaryMapReader::ReadString(Str &str) {
+    const int32_t index = Read<int32_t>();
+    if (index < 0 || index >= strings.Count()) {
+        Fail();
+        return false;
+    }
+
+    str = strings[index];
+    return true;
+}
+
+// Returns true if the section is in the file after the header
+static bool IsValidSection(size_t fileSize, uint32_t offset, uint64_t size) {
+    return offset >= sizeof(BMapHeader) && (uint64_t)offset + size <= (uint64_t)fileSize;
+}
+
+bool BinaryMap::Open(const char *filename, const char *sourceFilename) {
+    Close();
+
+    file = fileSystem.OpenFileRead(filename, true);
+    if (!file) {
+        return false;
+    }
+
+    BMapHeader header;
+    if (file->Read(&header, sizeof(header)) != sizeof(header) || header.ident != BMAP_IDENT || header.version != BMAP_VERSION) {
+        BE_WARNLOG(L"BinaryMap::Open: invalid binary map file '%hs'\n", filename);
+        Close();
+        return false;
+    }
+
+    if (sourceFilename && fileSystem.FileExists(sourceFilename)) {
+        if (fileSystem.FileSize(sourceFilename) != header.sourceSize || fileSystem.GetTimeStamp(sourceFilename).Ticks() != header.sourceTime) {
+            BE_LOG(L"Binary map '%hs' is out of date\n", filename);
+            Close();
+            return false;
+        }
+    }
+
+    auto corrupt = [&]() {
+        BE_WARNLOG(L"BinaryMap::Open: corrupt binary map file '%hs'\n", filename);
+        Close();
+        return false;
+    };
+
+    const size_t fileSize = file->Size();
+
+    if (header.numStrings < 0 || header.numLayouts < 0 || header.numMeshes < 0 || header.numAudioClips < 0 || header.numEntities < 0 || header.numBatches < 0 ||
+        !IsValidSection(fileSize, header.stringsOffset, header.stringsSize) ||
+        !IsValidSection(fileSize, header.layoutsOffset, header.layoutsSize) ||
+        !IsValidSection(fileSize, header.meshesOffset, (uint64_t)header.numMeshes * sizeof(Guid)) ||
+        !IsValidSection(fileSize, header.audioClipsOffset, (uint64_t)header.numAudioClips * sizeof(Guid)) ||
+        !IsValidSection(fileSize, header.settingsOffset, header.settingsSize) ||
+        !IsValidSection(fileSize, header.batchesOffset, 0)) {
+        return corrupt();
+    }
+
+    // Read string table
+    stringData.SetCount(header.stringsSize);
+    file->Seek(header.stringsOffset);
+    if (file->Read(stringData.Ptr(), header.stringsSize) != header.stringsSize) {
+        return corrupt();
+    }
+
+    strings.SetCount(header.numStrings);
+    const char *str = stringData.Ptr();
+    const char *stringDataEnd = stringData.Ptr() + stringData.Count();
+    for (int i = 0; i < header.numStrings; i++) {
+        // Every string should be null-terminated in the table
+        const char *strEnd = str < stringDataEnd ? (const char *)memchr(str, 0, stringDataEnd - str) : nullptr;
+        if (!strEnd) {
+            return corrupt();
+        }
+        strings[i] = str;
+        str = strEnd + 1;
+    }
+
+    // Read layouts, and find the current property specs of them
+    Array<byte> layoutData;
+    layoutData.SetCount(header.layoutsSize);
+    file->Seek(header.layoutsOffset);
+    if (file->Read(layoutData.Ptr(), header.layoutsSize) != header.layoutsSize) {
+        return corrupt();
+    }
+
+    PropertyReader layoutReader(layoutData.Ptr(), layoutData.Count());
+
+    layouts.SetCount(header.numLayouts);
+    for (int i = 0; i < header.numLayouts; i++) {
+        BMapLayout bLayout = layoutReader.Read<BMapLayout>();
+
+        if (layoutReader.IsFailed() || bLayout.classNameIndex < 0 || bLayout.classNameIndex >= header.numStrings || bLayout.numProperties < 0) {
+            return corrupt();
+        }
+
+        Layout &layout = layouts[i];
+        layout.metaObject = Object::GetMetaObject(strings[bLayout.classNameIndex]);
+        layout.scriptGuid = bLayout.scriptGuid;
+        layout.firstProperty = layoutProperties.Count();
+        layout.numProperties = bLayout.numProperties;
+
+        if (!layout.metaObject) {
+            BE_WARNLOG(L"Unknown class '%hs'\n", strings[bLayout.classNameIndex]);
+        }
+
+        for (int propertyIndex = 0; propertyIndex < bLayout.numProperties; propertyIndex++) {
+            BMapLayoutProperty bLayoutProperty = layoutReader.Read<BMapLayoutProperty>();
+
+            if (layoutReader.IsFailed() || bLayoutProperty.nameIndex < 0 || bLayoutProperty.nameIndex >= header.numStrings) {
+                return corrupt();
+            }
+
+            LayoutProperty &layoutProperty = layoutProperties.Alloc();
+            layoutProperty.name = strings[bLayoutProperty.nameIndex];
+            layoutProperty.type = (PropertySpec::Type)bLayoutProperty.type;
+            layoutProperty.isArray = bLayoutProperty.isArray ? true : false;
+            layoutProperty.spec = layout.metaObject ? layout.metaObject->FindPropertySpec(layoutProperty.name) : nullptr;
+        }
+    }
+
+    // Read meshes and audio clips to prefetch
+    meshGuids.SetCount(header.numMeshes);
+    file->Seek(header.meshesOffset);
+    if (file->Read(meshGuids.Ptr(), header.numMeshes * sizeof(Guid)) != header.numMeshes * sizeof(Guid)) {
+        return corrupt();
+    }
+
+    audioClipGuids.SetCount(header.numAudioClips);
+    file->Seek(header.audioClipsOffset);
+    if (file->Read(audioClipGuids.Ptr(), header.numAudioClips * sizeof(Guid)) != header.numAudioClips * sizeof(Guid)) {
+        return corrupt();
+    }
+
+    // Batches should be chained up to the end of the file with the number of entities in the header
+    uint64_t offset = header.batchesOffset;
+    int64_t numBatchEntities = 0;
+    for (int i = 0; i < header.numBatches; i++) {
+        BMapBatch batch;
+
+        if (offset + sizeof(batch) > fileSize) {
+            return corrupt();
+        }
+
+        file->Seek((int)offset);
+        if (file->Read(&batch, sizeof(batch)) != sizeof(batch) || batch.numEntities < 0 || offset + sizeof(batch) + batch.size > fileSize) {
+            return corrupt();
+        }
+
+        numBatchEntities += batch.numEntities;
+        offset += sizeof(batch) + batch.size;
+    }
+
+    if (numBatchEntities != header.numEntities) {
+        return corrupt();
+    }
+
+    settingsOffset = header.settingsOffset;
+    settingsSize = header.settingsSize;
+
+    numEntities = header.numEntities;
+    numBatches = header.numBatches;
+    batchIndex = 0;
+    batchOffset = header.batchesOffset;
+
+    return true;
+}
+
+void BinaryMap::Close() {
+    if (file) {
+        fileSystem.CloseFile(file);
+        file = nullptr;
+    }
+
+    stringData.Clear();
+    strings.Clear();
+    layouts.Clear();
+    layoutProperties.Clear();
+    meshGuids.Clear();
+    audioClipGuids.Clear();
+    batchData.Clear();
+
+    numEntities = 0;
+    numBatches = 0;
+    batchIndex = 0;
+    corrupt = false;
+}
+
+// Values are set as they are, because they are taken from the properties of the same type.
+// Properties which are removed or changed the type after cooking are skipped.
+void BinaryMap::ReadProperties(BinaryMapReader &reader, const Layout &layout, Object *object) const {
+    const bool isScript = layout.metaObject && layout.metaObject->IsTypeOf(ComScript::metaObject);
+
+    for (int i = 0; i < layout.numProperties && !reader.IsFailed(); i++) {
+        const LayoutProperty &layoutProperty = layoutProperties[layout.firstProperty + i];
+
+        // Script property specs are owned by each script component
+        const PropertySpec *spec = (object && isScript) ? object->FindPropertySpec(layoutProperty.name) : layoutProperty.spec;
+        const bool isArray = spec && (spec->GetFlags() & PropertySpec::IsArray) ? true : false;
+
+        if (spec && (spec->GetType() != layoutProperty.type || isArray != layoutProperty.isArray)) {
+            spec = nullptr;
+        }
+
+        Variant value;
+
+        if (layoutProperty.isArray) {
+            int32_t numElements = reader.Read<int32_t>();
+
+            // Every element takes a byte at least
+            if (numElements < 0 || (size_t)numElements > reader.Remaining()) {
+                reader.Fail();
+                return;
+            }
+
+            if (object && spec) {
+                object->props->SetRaw(layoutProperty.name, Variant(), numElements);
+            }
+
+            for (int elementIndex = 0; elementIndex < numElements; elementIndex++) {
+                if (!reader.ReadValue(layoutProperty.type, value)) {
+                    return;
+                }
+
+                if (object && spec) {
+                    object->props->SetRaw(Str(layoutProperty.name) + va("[%d]", elementIndex), value, 0);
+                }
+            }
+        } else {
+            if (!reader.ReadValue(layoutProperty.type, value)) {
+                return;
+            }
+
+            if (object && spec) {
+                object->props->SetRaw(layoutProperty.name, value, 0);
+            }
+        }
+    }
+}
+
+// Returns nullptr if the class is not found or the data is corrupt
+Object *BinaryMap::ReadObject(BinaryMapReader &reader) const {
+    const int32_t layoutIndex = reader.Read<int32_t>();
+    const Guid guid = reader.Read<Guid>();
+
+    if (reader.IsFailed() || layoutIndex < 0 || layoutIndex >= layouts.Count()) {
+        reader.Fail();
+        return nullptr;
+    }
+
+    const Layout &layout = layouts[layoutIndex];
+
+    Object *object = nullptr;
+
+    if (layout.metaObject) {
+        object = layout.metaObject->CreateInstance(guid);
+
+        if (layout.metaObject->IsTypeOf(ComScript::metaObject)) {
+            Json::Value scriptValue;
+            scriptValue["script"] = layout.scriptGuid.ToString();
+
+            object->Cast<ComScript>()->InitPropertySpec(scriptValue);
+        }
+    }
+
+    ReadProperties(reader, layout, object);
+
+    if (reader.IsFailed() && object) {
+        Object::DestroyInstanceImmediate(object);
+        return nullptr;
+    }
+
+    return object;
+}
+
+bool BinaryMap::ReadSettings(Object *settings) {
+    Array<byte> settingsData;
+    settingsData.SetCount(settingsSize);
+    file->Seek(settingsOffset);
+    file->Read(settingsData.Ptr(), settingsSize);
+
+    BinaryMapReader reader(settingsData.Ptr(), settingsSize, strings);
+
+    const int32_t layoutIndex = reader.Read<int32_t>();
+    reader.Read<Guid>();
+
+    if (!reader.IsFailed() && layoutIndex >= 0 && layoutIndex < layouts.Count()) {
+        const Layout &layout = layouts[layoutIndex];
+
+        if (layout.metaObject == settings->GetMetaObject()) {
+            ReadProperties(reader, layout, settings);
+        }
+
+        if (!reader.IsFailed()) {
+            return true;
+        }
+    }
+
+    BE_WARNLOG(L"BinaryMap::ReadSettings: corrupt settings\n");
+    corrupt = true;
+    return false;
+}
+
+bool BinaryMap::ReadEntityBatch(EntityPtrArray &entities, Array<int> &spawnEntityNums) {
+    if (corrupt || batchIndex >= numBatches) {
+        return false;
+    }
+
+    // Batch chain is validated in Open()
+    BMapBatch batch;
+    file->Seek(batchOffset);
+    file->Read(&batch, sizeof(batch));
+
+    batchData.SetCount(batch.size, false);
+    file->Read(batchData.Ptr(), batch.size);
+
+    batchIndex++;
+    batchOffset += sizeof(batch) + batch.size;
+
+    BinaryMapReader reader(batchData.Ptr(), batch.size, strings);
+
+    const int firstEntityIndex = entities.Count();
+
+    for (int i = 0; i < batch.numEntities && !reader.IsFailed(); i++) {
+        Object *object = ReadObject(reader);
+        Entity *entity = object ? object->Cast<Entity>() : nullptr;
+
+        // Layout of the other known class in place of the entity is corrupt
+        if (object && !entity) {
+            Object::DestroyInstanceImmediate(object);
+            reader.Fail();
+            break;
+        }
+
+        int32_t spawnEntityNum = reader.Read<int32_t>();
+
+        if (entity) {
+            entity->name = entity->props->Get("name").As<Str>();
+            entity->tag = entity->props->Get("tag").As<Str>();
+
+            entities.Append(entity);
+            spawnEntityNums.Append(spawnEntityNum);
+        }
+
+        int32_t numComponents = reader.Read<int32_t>();
+
+        for (int componentIndex = 0; componentIndex < numComponents && !reader.IsFailed(); componentIndex++) {
+            Object *componentObject = ReadObject(reader);
+            if (!componentObject) {
+                continue;
+            }
+
+            Component *component = componentObject->Cast<Component>();
+
+            // Layout of the other known class in place of the component is corrupt
+            if (!component) {
+                Object::DestroyInstanceImmediate(componentObject);
+                reader.Fail();
+                break;
+            }
+
+            if (entity) {
+                entity->AddComponent(component);
+            } else {
+                Object::DestroyInstanceImmediate(component);
+            }
+        }
+    }
+
+    // Whole batch should be read exactly
+    if (reader.IsFailed() || !reader.IsAtEnd()) {
+        // Entities of this batch may have broken properties, so none of them are spawned
+        for (int i = firstEntityIndex; i < entities.Count(); i++) {
+            Object::DestroyInstanceImmediate(entities[i]);
+        }
+        entities.SetCount(firstEntityIndex, false);
+        spawnEntityNums.SetCount(firstEntityIndex, false);
+
+        BE_WARNLOG(L"BinaryMap::ReadEntityBatch: corrupt entity batch %i\n", batchIndex - 1);
+        corrupt = true;
+        return false;
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Commands
+//-------------------------------------------------------------------------------------------------
+
+void BinaryMap::Init() {
+    cmdSystem.AddCommand(L"cookMap", Cmd_CookMap);
+}
+
+void BinaryMap::Shutdown() {
+    cmdSystem.RemoveCommand(L"cookMap");
+}
+
+void BinaryMap::Cmd_CookMap(const CmdArgs &args) {
+    if (args.Argc() != 2) {
+        BE_LOG(L"cookMap <filename>\n");
+        return;
+    }
+
+    Str filename = WStr::ToStr(args.Argv(1));
+    filename.DefaultFileExtension(".map");
+
+    const Str cookedFilename = CookedFilename(filename);
+
+    uint64_t startTime = PlatformTime::Microseconds();
+
+    if (!Cook(filename, cookedFilename)) {
+        return;
+    }
+
+    BE_LOG(L"Cooked '%hs' (%hs) to '%hs' (%hs) in %.2f ms\n", filename.c_str(), Str::FormatBytes((int)fileSystem.FileSize(filename)).c_str(),
+        cookedFilename.c_str(), Str::FormatBytes((int)fileSystem.FileSize(cookedFilename)).c_str(), (PlatformTime::Microseconds() - startTime) / 1000.0f);
+}
+
+BE_NAMESPACE_END
@@ -171,6 +171,23 @@ void Entity::RemapGuids(EntityPtrArray &entities, const HashTable<Guid, Guid> &g
     }
 }
 
+void Entity::CloneEntities(const EntityPtrArray &originalEntities, EntityPtrArray &clonedEntities) {
+    HashTable<Guid, Guid> guidMap;
+
+    for (int i = 0; i < originalEntities.Count(); i++) {
+        Json::Value originalEntityValue;
+        originalEntities[i]->Serialize(originalEntityValue);
+
+        Json::Value clonedEntityValue = Entity::CloneEntityValue(originalEntityValue, guidMap);
+
+        Entity *clonedEntity = Entity::CreateEntity(clonedEntityValue);
+        clonedEntities.Append(clonedEntity);
+    }
+
+    // Remap GUIDs for the cloned entities
+    Entity::RemapGuids(clonedEntities, guidMap);
+}
+
 int Entity::GetSpawnId() const {
     return gameWorld->GetEntitySpawnId(this); 
 }
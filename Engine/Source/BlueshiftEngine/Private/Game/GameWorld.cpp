@@ -25,16 +25,29 @@
 #include "Components/ComCamera.h"
 #include "Components/ComRigidBody.h"
 #include "Components/ComSensor.h"
+#include "Components/ComSkinnedMeshRenderer.h"
 #include "Game/Entity.h"
 #include "Game/MapRenderSettings.h"
 #include "Game/GameWorld.h"
+#include "Game/Prefab.h"
+#include "Game/BinaryMap.h"
 #include "Game/GameSettings/TagLayerSettings.h"
 #include "Game/GameSettings/PhysicsSettings.h"
 #include "Containers/StaticArray.h"
+#include "Core/AsyncLoader.h"
+#include "Core/Profiler.h"
+#include "Core/Task.h"
+#include "Core/CVars.h"
+#include "Asset/GuidMapper.h"
 #include "File/FileSystem.h"
+#include "Platform/PlatformTime.h"
 
 BE_NAMESPACE_BEGIN
 
+static CVar prefab_useTemplate(L"prefab_useTemplate", L"1", CVar::Bool, L"instantiate prefabs from the compiled templates instead of JSON");
+static CVar snapshot_deltaRestore(L"snapshot_deltaRestore", L"1", CVar::Bool, L"keep unchanged entities when restoring the world snapshot");
+static CVar anim_parallelUpdate(L"anim_parallelUpdate", L"1", CVar::Bool, L"compute animations of the entities in parallel");
+
 const EventDef EV_RestartGame("restartGame", false, "s");
 
 const SignalDef GameWorld::SIG_EntityRegistered("entityRegistered", "a");
@@ -67,6 +80,8 @@ GameWorld::GameWorld() {
 
     timeScale = 1.0f;
 
+    animationFrameCount = 0;
+
     Reset();
 }
 
@@ -121,6 +136,8 @@ void GameWorld::ClearAllEntities() {
 
     memset(entities, 0, sizeof(entities));
 
+    animationUpdates.Clear();
+
     physicsWorld->ClearScene();
 
     renderWorld->ClearScene();
@@ -130,6 +147,8 @@ void GameWorld::ClearAllEntities() {
     entityHash.Free();
     entityTagHash.Free();
 
+    renderEntityOwners.Clear();
+
     entityHierarchy.RemoveFromHierarchy();
 
     memset(spawnIds, -1, sizeof(spawnIds));
@@ -152,13 +171,22 @@ Entity *GameWorld::FindEntity(const char *name) const {
 }
 
 Entity *GameWorld::FindEntityByGuid(const Guid &guid) const {
-    for (Entity *ent = entityHierarchy.GetChild(); ent; ent = ent->node.GetNext()) {
-        if (ent->GetGuid() == guid) {
-            return ent;
-        }
+    if (guid.IsZero()) {
+        return nullptr;
     }
 
-    return nullptr;
+    Object *object = Object::FindInstance(guid);
+    if (!object) {
+        return nullptr;
+    }
+
+    // Instances are looked up globally, so skip the entities of the other game worlds
+    Entity *ent = object->Cast<Entity>();
+    if (!ent || ent->gameWorld != this) {
+        return nullptr;
+    }
+
+    return ent;
 }
 
 Entity *GameWorld::FindEntityByTag(const char *tagName) const {
@@ -193,15 +221,25 @@ const EntityPtrArray GameWorld::FindEntitiesByTag(const char *tagName) const {
 }
 
 Entity *GameWorld::FindEntityByRenderEntity(int renderEntityHandle) const {
-    for (Entity *ent = entityHierarchy.GetChild(); ent; ent = ent->node.GetNext()) {
-        if (ent->HasRenderEntity(renderEntityHandle)) {
-            return ent; 
-        }
+    Guid ownerGuid;
+    if (!renderEntityOwners.Get(renderEntityHandle, &ownerGuid)) {
+        return nullptr;
+    }
+
+    // Owners are not removed when the handles are freed, so check the handle is still owned by the entity
+    Entity *ent = FindEntityByGuid(ownerGuid);
+    if (ent && ent->HasRenderEntity(renderEntityHandle)) {
+        return ent;
     }
 
     return nullptr;
 }
 
+void GameWorld::OnRenderEntityAdded(const Entity *ent, int renderEntityHandle) {
+    Guid ownerGuid = ent->GetGuid();
+    renderEntityOwners.Set(renderEntityHandle, ownerGuid);
+}
+
 void GameWorld::OnApplicationTerminate() {
     for (Entity *ent = entityHierarchy.GetChild(); ent; ent = ent->node.GetNext()) {
         ent->OnApplicationTerminate();
@@ -316,24 +354,18 @@ Entity *GameWorld::CloneEntity(const Entity *originalEntity) {
     originalEntities.Append(const_cast<Entity *>(originalEntity));
     originalEntity->GetChildren(originalEntities);
 
-    HashTable<Guid, Guid> guidMap;
     EntityPtrArray clonedEntities;
 
     int numEntities = originalEntities.Count();
 
-    for (int i = 0; i < numEntities; i++) {
-        Json::Value originalEntityValue;
-        originalEntities[i]->Serialize(originalEntityValue);
-        
-        Json::Value clonedEntityValue = Entity::CloneEntityValue(originalEntityValue, guidMap);
-
-        Entity *clonedEntity = Entity::CreateEntity(clonedEntityValue);
-        clonedEntities.Append(clonedEntity);
+    if (prefab_useTemplate.GetBool() && originalEntity->IsPrefabParent()) {
+        // Prefab entities are not changed at runtime, so instantiate from the compiled template
+        const PrefabTemplate *prefabTemplate = prefabManager.GetPrefabTemplate(originalEntity);
+        prefabTemplate->Instantiate(clonedEntities);
+    } else {
+        Entity::CloneEntities(originalEntities, clonedEntities);
     }
 
-    // Remap GUIDs for the cloned entities
-    Entity::RemapGuids(clonedEntities, guidMap);
-
     // Initialize & register cloned entities
     for (int i = 0; i < numEntities; i++) {
         const Entity *originalEntity = originalEntities[i];
@@ -603,16 +635,71 @@ void GameWorld::NewMap() {
     Reset();
 }
 
+// Starts loading the meshes and the audio clips referenced by the entities, so that they are loaded in parallel while spawning entities.
+static void PrefetchResources(const Json::Value &value) {
+    if (value.isObject()) {
+        const Json::Value &meshValue = value["mesh"];
+        if (meshValue.isString()) {
+            const Guid meshGuid = Guid::ParseString(meshValue.asCString());
+            const Str meshPath = resourceGuidMapper.Get(meshGuid);
+            meshManager.PrefetchMesh(meshPath, AsyncLoader::NormalPriority);
+        }
+
+        const Json::Value &audioClipValue = value["audioClip"];
+        if (audioClipValue.isString()) {
+            const Guid audioClipGuid = Guid::ParseString(audioClipValue.asCString());
+            const Str audioClipPath = resourceGuidMapper.Get(audioClipGuid);
+            soundSystem.PrefetchSound(audioClipPath, AsyncLoader::LowPriority);
+        }
+    } else if (!value.isArray()) {
+        return;
+    }
+
+    for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it) {
+        PrefetchResources(*it);
+    }
+}
+
 bool GameWorld::LoadMap(const char *filename) {
+    BE_PROFILE_CPU_SCOPE("GameWorld::LoadMap");
+
     BE_LOG(L"Loading map '%hs'...\n", filename);
 
+    uint64_t startTime = PlatformTime::Microseconds();
+
     BeginMapLoading();
 
+    bool loaded;
+
+    BinaryMap binaryMap;
+    if (BinaryMap::map_useCooked.GetBool() && binaryMap.Open(BinaryMap::CookedFilename(filename), filename)) {
+        mapName = filename;
+
+        loaded = LoadBinaryMap(binaryMap);
+        if (!loaded) {
+            // Entities spawned before the corrupt data are thrown away
+            BE_WARNLOG(L"Failed to load cooked map, loading '%hs' instead\n", filename);
+            Reset();
+            loaded = LoadJsonMap(filename);
+        }
+    } else {
+        loaded = LoadJsonMap(filename);
+    }
+
+    FinishMapLoading();
+
+    if (loaded) {
+        BE_LOG(L"Map loaded in %.2f ms\n", (PlatformTime::Microseconds() - startTime) / 1000.0f);
+    }
+
+    return loaded;
+}
+
+bool GameWorld::LoadJsonMap(const char *filename) {
     char *text = nullptr;
     fileSystem.LoadFile(filename, true, (void **)&text);
     if (!text) {
         BE_WARNLOG(L"Couldn't load '%hs'\n", filename);
-        FinishMapLoading();
         return false;
     }
 
@@ -622,6 +709,7 @@ bool GameWorld::LoadMap(const char *filename) {
     Json::Reader jsonReader;
     if (!jsonReader.parse(text, map)) {
         BE_WARNLOG(L"Failed to parse JSON text\n");
+        fileSystem.FreeFile(text);
         return false;
     }
 
@@ -633,15 +721,55 @@ bool GameWorld::LoadMap(const char *filename) {
     mapRenderSettings->Init();
 
     // Read entities
+    PrefetchResources(map["entities"]);
     SpawnEntitiesFromJson(map["entities"]);
     
     fileSystem.FreeFile(text);
 
-    FinishMapLoading();
-
     return true;
 }
 
+bool GameWorld::LoadBinaryMap(BinaryMap &binaryMap) {
+    // Read map render settings
+    if (!binaryMap.ReadSettings(mapRenderSettings)) {
+        return false;
+    }
+    mapRenderSettings->Init();
+
+    // Read entities
+    const Array<Guid> &meshGuids = binaryMap.GetMeshGuids();
+    for (int i = 0; i < meshGuids.Count(); i++) {
+        meshManager.PrefetchMesh(resourceGuidMapper.Get(meshGuids[i]), AsyncLoader::NormalPriority);
+    }
+
+    const Array<Guid> &audioClipGuids = binaryMap.GetAudioClipGuids();
+    for (int i = 0; i < audioClipGuids.Count(); i++) {
+        soundSystem.PrefetchSound(resourceGuidMapper.Get(audioClipGuids[i]), AsyncLoader::LowPriority);
+    }
+
+    // Entities are spawned batch by batch, so only a batch of the map is in memory at once.
+    // Finalize async loaded resources between the batches not to keep the loaded data until the end.
+    EntityPtrArray entities;
+    Array<int> spawnEntityNums;
+    while (binaryMap.ReadEntityBatch(entities, spawnEntityNums)) {
+        for (int i = 0; i < entities.Count(); i++) {
+            Entity *entity = entities[i];
+            entity->gameWorld = this;
+
+            entity->InitHierarchy();
+            entity->Init();
+
+            RegisterEntity(entity, spawnEntityNums[i]);
+        }
+        entities.SetCount(0, false);
+        spawnEntityNums.SetCount(0, false);
+
+        asyncLoader.Update();
+    }
+
+    return !binaryMap.IsCorrupt();
+}
+
 void GameWorld::SerializeEntityHierarchy(const Hierarchy<Entity> &entityHierarchy, Json::Value &entitiesValue) {
     Json::Value entityValue;
 
@@ -678,6 +806,8 @@ void GameWorld::SaveMap(const char *filename) {
 }
 
 void GameWorld::Update(int elapsedTime) {
+    BE_PROFILE_CPU_SCOPE("GameWorld::Update");
+
     prevTime = time;
 
     int scaledElapsedTime = elapsedTime * timeScale;
@@ -697,11 +827,70 @@ void GameWorld::UpdateEntities() {
         ent->Update();
     }
 
+    UpdateAnimations();
+
     for (Entity *ent = entityHierarchy.GetChild(); ent; ent = ent->node.GetNext()) {
         ent->LateUpdate();
     }
 }
 
+void GameWorld::QueueAnimationUpdate(ComSkinnedMeshRenderer *skinnedMeshRenderer) {
+    animationUpdates.Append(skinnedMeshRenderer);
+}
+
+void GameWorld::CancelAnimationUpdate(ComSkinnedMeshRenderer *skinnedMeshRenderer) {
+    animationUpdates.Remove(skinnedMeshRenderer);
+}
+
+// Computes animations of the skinned mesh renderers queued in Update() of the entities.
+// Animations are computed in parallel, and published to the render world in queued order.
+// Off-screen or distant entities are updated less frequently, and the updates are spread across the frames by entity number.
+void GameWorld::UpdateAnimations() {
+    if (animationUpdates.Count() == 0) {
+        return;
+    }
+
+    BE_PROFILE_CPU_SCOPE("GameWorld::UpdateAnimations");
+
+    animationFrameCount++;
+
+    computingAnimations.SetCount(0, false);
+
+    for (int i = 0; i < animationUpdates.Count(); i++) {
+        ComSkinnedMeshRenderer *skinnedMeshRenderer = animationUpdates[i];
+
+        int interval = skinnedMeshRenderer->GetAnimationUpdateInterval();
+        if (interval > 0 && (animationFrameCount + skinnedMeshRenderer->GetEntity()->GetEntityNum()) % interval == 0) {
+            computingAnimations.Append(skinnedMeshRenderer);
+        }
+    }
+
+    ComSkinnedMeshRenderer **skinnedMeshRenderers = computingAnimations.Ptr();
+    const int currentTime = time;
+
+    auto computeAnimations = [skinnedMeshRenderers, currentTime](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            skinnedMeshRenderers[i]->ComputeAnimation(currentTime);
+        }
+    };
+
+    if (anim_parallelUpdate.GetBool()) {
+        taskScheduler.ParallelFor(0, computingAnimations.Count(), 1, computeAnimations);
+    } else {
+        computeAnimations(0, computingAnimations.Count());
+    }
+
+    // Render world is not thread-safe
+    for (int i = 0; i < computingAnimations.Count(); i++) {
+        computingAnimations[i]->PublishAnimation();
+    }
+
+    for (int i = 0; i < animationUpdates.Count(); i++) {
+        animationUpdates[i]->animationUpdateQueued = false;
+    }
+    animationUpdates.SetCount(0, false);
+}
+
 void GameWorld::ProcessPointerInput() {
     if (!gameStarted) {
         return;
@@ -770,28 +959,97 @@ void GameWorld::RenderCamera() {
 }
 
 void GameWorld::SaveSnapshot() {
-    snapshotValues.clear();
+    uint64_t startTime = PlatformTime::Microseconds();
 
-    mapRenderSettings->Serialize(snapshotValues["renderSettings"]);
+    snapshot.Clear();
 
-    for (Entity *child = entityHierarchy.GetChild(); child; child = child->GetNode().GetNextSibling()) {
-        GameWorld::SerializeEntityHierarchy(child->GetNode(), snapshotValues["entities"]);
+    snapshot.WriteSettings(mapRenderSettings);
+
+    // depth-first order
+    for (Entity *ent = entityHierarchy.GetChild(); ent; ent = ent->node.GetNext()) {
+        snapshot.WriteEntity(ent);
     }
 
-    //BE_LOG(L"%i entities snapshot saved\n", snapshotValues["entities"].size());
+    BE_LOG(L"World snapshot saved: %i entities, %hs in %.2f ms\n", snapshot.NumEntities(), Str::FormatBytes((int)snapshot.Size()).c_str(), 
+        (PlatformTime::Microseconds() - startTime) / 1000.0f);
 }
 
 void GameWorld::RestoreSnapshot() {
-    BeginMapLoading();
+    uint64_t startTime = PlatformTime::Microseconds();
 
-    mapRenderSettings->props->Init(snapshotValues["renderSettings"]);
+    EntityPtrArray entityList;
+    for (Entity *ent = entityHierarchy.GetChild(); ent; ent = ent->node.GetNext()) {
+        entityList.Append(ent);
+    }
+
+    // Unchanged entities for each snapshot record
+    EntityPtrArray unchangedEntities;
+    if (snapshot_deltaRestore.GetBool()) {
+        snapshot.FindUnchangedEntities(entityList, unchangedEntities);
+    } else {
+        unchangedEntities.SetCount(snapshot.NumEntities());
+        for (int i = 0; i < unchangedEntities.Count(); i++) {
+            unchangedEntities[i] = nullptr;
+        }
+    }
+
+    // Same as BeginMapLoading() except for clearing all entities
+    isMapLoading = true;
+
+    time = 0;
+    prevTime = 0;
+
+    renderWorld->ClearDebugPrimitives(0);
+    renderWorld->ClearDebugText(0);
+
+    // Destroy changed entities in reverse depth first order
+    int numKeptEntities = 0;
+
+    for (int i = entityList.Count() - 1; i >= 0; i--) {
+        Entity *ent = entityList[i];
+
+        int recordIndex = snapshot.FindEntity(ent->GetGuid());
+        if (recordIndex >= 0 && unchangedEntities[recordIndex] == ent) {
+            numKeptEntities++;
+            continue;
+        }
+
+        Entity::DestroyInstanceImmediate(ent);
+    }
+
+    snapshot.ReadSettings(mapRenderSettings);
     mapRenderSettings->Init();
 
-    SpawnEntitiesFromJson(snapshotValues["entities"]);
+    // Respawn entities in depth first order, so that the parents are spawned before the children
+    for (int recordIndex = 0; recordIndex < snapshot.NumEntities(); recordIndex++) {
+        if (unchangedEntities[recordIndex]) {
+            // Setters can change the state of the kept entities without changing the properties
+            // (transform, color, material, etc), so the components are initialized again from the properties.
+            Entity *entity = unchangedEntities[recordIndex];
+
+            for (int i = 0; i < entity->NumComponents(); i++) {
+                Component *component = entity->GetComponent(i);
+                if (component) {
+                    component->Purge();
+                    component->Init();
+                }
+            }
+            continue;
+        }
+
+        Entity *entity = snapshot.ReadEntity(recordIndex);
+        entity->gameWorld = this;
+
+        entity->InitHierarchy();
+        entity->Init();
 
-    //BE_LOG(L"%i entities snapshot restored\n", snapshotValues["entities"].size());
+        RegisterEntity(entity);
+    }
 
     FinishMapLoading();
+
+    BE_LOG(L"World snapshot restored: %i entities kept, %i respawned in %.2f ms\n", numKeptEntities, snapshot.NumEntities() - numKeptEntities,
+        (PlatformTime::Microseconds() - startTime) / 1000.0f);
 }
 
 BE_NAMESPACE_END
@@ -31,6 +31,7 @@ void Prefab::Clear() {
 
     for (int i = 0; i < entities.Count(); i++) {
         Entity *ent = entities[i];
+        prefabManager.FreePrefabTemplate(ent);
         Entity::DestroyInstanceImmediate(ent);
         entities[i] = nullptr;
     }
@@ -59,6 +60,8 @@ bool Prefab::Create(const Json::Value &entitiesValue) {
 
             entity->InitHierarchy();
 
+            ConnectSignals(entity);
+
             entities.Append(entity);
         } else {
             BE_WARNLOG(L"Unknown classname '%hs'\n", classname);
@@ -68,6 +71,36 @@ bool Prefab::Create(const Json::Value &entitiesValue) {
     return true;
 }
 
+void Prefab::ConnectSignals(Entity *entity) {
+    entity->Connect(&Properties::SIG_PropertyChanged, this, (SignalCallback)&Prefab::PropertyChanged, SignalObject::Unique);
+    entity->Connect(&Entity::SIG_ComponentInserted, this, (SignalCallback)&Prefab::ComponentInserted, SignalObject::Unique);
+    entity->Connect(&Entity::SIG_ComponentRemoved, this, (SignalCallback)&Prefab::ComponentRemoved, SignalObject::Unique);
+
+    for (int i = 0; i < entity->NumComponents(); i++) {
+        entity->GetComponent(i)->Connect(&Properties::SIG_PropertyChanged, this, (SignalCallback)&Prefab::PropertyChanged, SignalObject::Unique);
+    }
+}
+
+void Prefab::InvalidateTemplates() {
+    for (int i = 0; i < entities.Count(); i++) {
+        prefabManager.FreePrefabTemplate(entities[i]);
+    }
+}
+
+void Prefab::PropertyChanged(const char *classname, const char *propName) {
+    InvalidateTemplates();
+}
+
+void Prefab::ComponentInserted(const Component *component, int index) {
+    const_cast<Component *>(component)->Connect(&Properties::SIG_PropertyChanged, this, (SignalCallback)&Prefab::PropertyChanged, SignalObject::Unique);
+
+    InvalidateTemplates();
+}
+
+void Prefab::ComponentRemoved(const Component *component) {
+    InvalidateTemplates();
+}
+
 bool Prefab::Load(const char *filename) {
     char *text = nullptr;
 
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "Precompiled.h"
+#include "Core/Cmds.h"
+#include "Platform/PlatformTime.h"
 #include "Game/Entity.h"
 #include "Game/Prefab.h"
 #include "Game/GameWorld.h"
@@ -24,9 +26,15 @@ PrefabManager   prefabManager;
 
 void PrefabManager::Init() {
     prefabHashMap.Init(1024, 64, 64);
+
+    cmdSystem.AddCommand(L"benchmarkPrefab", Cmd_BenchmarkPrefab);
 }
 
 void PrefabManager::Shutdown() {
+    cmdSystem.RemoveCommand(L"benchmarkPrefab");
+
+    prefabTemplateHash.DeleteContents();
+
     for (int i = 0; i < prefabHashMap.Count(); i++) {
         const auto *entry = prefabHashMap.GetByIndex(i);
         Prefab *prefab = entry->second;
@@ -143,4 +151,86 @@ Json::Value PrefabManager::CreatePrefabValue(const Entity *originalEntity) {
     return prefabEntitiesValue;
 }
 
+const PrefabTemplate *PrefabManager::GetPrefabTemplate(const Entity *prefabEntity) {
+    assert(prefabEntity->IsPrefabParent());
+
+    PrefabTemplate *prefabTemplate;
+    if (prefabTemplateHash.Get(prefabEntity->GetGuid(), &prefabTemplate)) {
+        return prefabTemplate;
+    }
+
+    prefabTemplate = new PrefabTemplate;
+    prefabTemplate->Compile(prefabEntity);
+
+    prefabTemplateHash.Set(prefabEntity->GetGuid(), prefabTemplate);
+
+    return prefabTemplate;
+}
+
+void PrefabManager::FreePrefabTemplate(const Entity *prefabEntity) {
+    PrefabTemplate *prefabTemplate;
+    if (prefabTemplateHash.Get(prefabEntity->GetGuid(), &prefabTemplate)) {
+        prefabTemplateHash.Remove(prefabEntity->GetGuid());
+        delete prefabTemplate;
+    }
+}
+
+static void DestroyEntities(EntityPtrArray &entities) {
+    for (int i = 0; i < entities.Count(); i++) {
+        Entity::DestroyInstanceImmediate(entities[i]);
+    }
+    entities.Clear();
+}
+
+void PrefabManager::Cmd_BenchmarkPrefab(const CmdArgs &args) {
+    if (args.Argc() < 2) {
+        BE_LOG(L"benchmarkPrefab <filename> [count]\n");
+        return;
+    }
+
+    Prefab *prefab = prefabManager.GetPrefab(WStr::ToStr(args.Argv(1)));
+    if (!prefab || !prefab->GetRootEntity()) {
+        BE_WARNLOG(L"Couldn't find prefab \"%ls\"\n", args.Argv(1));
+        return;
+    }
+
+    int count = args.Argc() > 2 ? Max((int)wcstol(args.Argv(2), nullptr, 10), 1) : 1000;
+
+    const Entity *rootEntity = prefab->GetRootEntity();
+
+    EntityPtrArray prefabEntities;
+    prefabEntities.Append(const_cast<Entity *>(rootEntity));
+    rootEntity->GetChildren(prefabEntities);
+
+    EntityPtrArray clonedEntities;
+    clonedEntities.Resize(prefabEntities.Count());
+
+    // Entities are destroyed right after the creation to measure the creation cost only
+    uint64_t jsonTime = 0;
+    for (int i = 0; i < count; i++) {
+        uint64_t startTime = PlatformTime::Microseconds();
+        Entity::CloneEntities(prefabEntities, clonedEntities);
+        jsonTime += PlatformTime::Microseconds() - startTime;
+
+        DestroyEntities(clonedEntities);
+    }
+
+    uint64_t templateTime = 0;
+    for (int i = 0; i < count; i++) {
+        uint64_t startTime = PlatformTime::Microseconds();
+        prefabManager.GetPrefabTemplate(rootEntity)->Instantiate(clonedEntities);
+        templateTime += PlatformTime::Microseconds() - startTime;
+
+        DestroyEntities(clonedEntities);
+    }
+
+    double jsonSpawnTime = (double)jsonTime / count;
+    double templateSpawnTime = (double)templateTime / count;
+
+    BE_LOG(L"%hs: %i entities, %i spawns\n", prefab->hashName.c_str(), prefabEntities.Count(), count);
+    BE_LOG(L"  JSON     : %.2f us/spawn, %.0f spawns/sec\n", jsonSpawnTime, jsonSpawnTime > 0 ? 1000000.0 / jsonSpawnTime : 0.0);
+    BE_LOG(L"  template : %.2f us/spawn, %.0f spawns/sec\n", templateSpawnTime, templateSpawnTime > 0 ? 1000000.0 / templateSpawnTime : 0.0);
+    BE_LOG(L"  speedup  : %.2fx\n", templateSpawnTime > 0 ? jsonSpawnTime / templateSpawnTime : 0.0);
+}
+
 BE_NAMESPACE_END
\ No newline at end of file
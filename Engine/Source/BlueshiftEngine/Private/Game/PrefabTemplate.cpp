@@ -0,0 +1,185 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Components/Component.h"
+#include "Components/ComScript.h"
+#include "Game/Entity.h"
+#include "Game/Prefab.h"
+
+BE_NAMESPACE_BEGIN
+
+void PrefabTemplate::Clear() {
+    numGuidSlots = 0;
+
+    entities.Clear();
+    objects.Clear();
+    properties.Clear();
+}
+
+void PrefabTemplate::Compile(const Entity *rootEntity) {
+    Clear();
+
+    EntityPtrArray sourceEntities;
+    sourceEntities.Append(const_cast<Entity *>(rootEntity));
+    rootEntity->GetChildren(sourceEntities);
+
+    // Assign GUID slots to all the entities and components first, so that the forward references can be resolved
+    HashTable<Guid, int> guidSlotTable;
+
+    for (int i = 0; i < sourceEntities.Count(); i++) {
+        const Entity *entity = sourceEntities[i];
+
+        guidSlotTable.Set(entity->GetGuid(), numGuidSlots);
+        numGuidSlots++;
+
+        for (int componentIndex = 0; componentIndex < entity->NumComponents(); componentIndex++) {
+            guidSlotTable.Set(entity->GetComponent(componentIndex)->GetGuid(), numGuidSlots);
+            numGuidSlots++;
+        }
+    }
+
+    entities.Resize(sourceEntities.Count());
+    objects.Resize(numGuidSlots);
+
+    for (int i = 0; i < sourceEntities.Count(); i++) {
+        const Entity *entity = sourceEntities[i];
+
+        TemplateEntity &templateEntity = entities.Alloc();
+        templateEntity.firstObject = objects.Count();
+        templateEntity.numComponents = entity->NumComponents();
+
+        CompileObject(entity, guidSlotTable);
+
+        for (int componentIndex = 0; componentIndex < entity->NumComponents(); componentIndex++) {
+            CompileObject(entity->GetComponent(componentIndex), guidSlotTable);
+        }
+    }
+}
+
+void PrefabTemplate::CompileObject(const Object *object, const HashTable<Guid, int> &guidSlotTable) {
+    TemplateObject &templateObject = objects.Alloc();
+    templateObject.metaObject = object->GetMetaObject();
+    guidSlotTable.Get(object->GetGuid(), &templateObject.guidSlot);
+    templateObject.firstProperty = properties.Count();
+
+    if (object->IsTypeOf(ComScript::metaObject)) {
+        templateObject.scriptGuid = object->props->Get("script").As<Guid>();
+    } else {
+        templateObject.scriptGuid = Guid::zero;
+    }
+
+    Array<const PropertySpec *> pspecs;
+    object->GetPropertySpecList(pspecs);
+
+    for (int i = 0; i < pspecs.Count(); i++) {
+        const PropertySpec *spec = pspecs[i];
+
+        // Same as the JSON serialization, skipped properties get the default values
+        if (spec->GetFlags() & PropertySpec::SkipSerialization) {
+            continue;
+        }
+
+        const Str name = spec->GetName();
+        const bool isObjectType = spec->GetType() == PropertySpec::ObjectType;
+
+        if (spec->GetFlags() & PropertySpec::IsArray) {
+            int numElements = object->props->NumElements(name);
+
+            TemplateProperty &arrayProperty = properties.Alloc();
+            arrayProperty.name = name;
+            arrayProperty.numElements = numElements;
+            arrayProperty.guidSlot = -1;
+
+            for (int elementIndex = 0; elementIndex < numElements; elementIndex++) {
+                TemplateProperty &elementProperty = properties.Alloc();
+                elementProperty.name = name + va("[%d]", elementIndex);
+                object->props->Get(elementProperty.name, elementProperty.value, true);
+                elementProperty.numElements = 0;
+                elementProperty.guidSlot = -1;
+
+                if (isObjectType) {
+                    guidSlotTable.Get(elementProperty.value.As<Guid>(), &elementProperty.guidSlot);
+                }
+            }
+        } else {
+            TemplateProperty &property = properties.Alloc();
+            property.name = name;
+            object->props->Get(name, property.value, true);
+            property.numElements = 0;
+            property.guidSlot = -1;
+
+            if (isObjectType) {
+                guidSlotTable.Get(property.value.As<Guid>(), &property.guidSlot);
+            }
+        }
+    }
+
+    templateObject.numProperties = properties.Count() - templateObject.firstProperty;
+}
+
+void PrefabTemplate::InitObjectProperties(Object *object, const TemplateObject &templateObject, const Array<Guid> &newGuids) const {
+    for (int i = 0; i < templateObject.numProperties; i++) {
+        const TemplateProperty &property = properties[templateObject.firstProperty + i];
+
+        if (property.guidSlot >= 0) {
+            object->props->SetRaw(property.name, Variant(newGuids[property.guidSlot]), property.numElements);
+        } else {
+            object->props->SetRaw(property.name, property.value, property.numElements);
+        }
+    }
+}
+
+void PrefabTemplate::Instantiate(EntityPtrArray &instantiatedEntities) const {
+    Array<Guid> newGuids;
+    newGuids.SetCount(numGuidSlots);
+
+    for (int i = 0; i < numGuidSlots; i++) {
+        newGuids[i] = Guid::CreateGuid();
+    }
+
+    instantiatedEntities.Resize(instantiatedEntities.Count() + entities.Count());
+
+    for (int i = 0; i < entities.Count(); i++) {
+        const TemplateEntity &templateEntity = entities[i];
+        const TemplateObject &entityObject = objects[templateEntity.firstObject];
+
+        Entity *entity = static_cast<Entity *>(entityObject.metaObject->CreateInstance(newGuids[entityObject.guidSlot]));
+        InitObjectProperties(entity, entityObject, newGuids);
+
+        entity->name = entity->props->Get("name").As<Str>();
+        entity->tag = entity->props->Get("tag").As<Str>();
+
+        for (int componentIndex = 0; componentIndex < templateEntity.numComponents; componentIndex++) {
+            const TemplateObject &componentObject = objects[templateEntity.firstObject + 1 + componentIndex];
+
+            Component *component = static_cast<Component *>(componentObject.metaObject->CreateInstance(newGuids[componentObject.guidSlot]));
+
+            if (componentObject.metaObject->IsTypeOf(ComScript::metaObject)) {
+                Json::Value scriptValue;
+                scriptValue["script"] = componentObject.scriptGuid.ToString();
+
+                component->Cast<ComScript>()->InitPropertySpec(scriptValue);
+            }
+
+            InitObjectProperties(component, componentObject, newGuids);
+
+            entity->AddComponent(component);
+        }
+
+        instantiatedEntities.Append(entity);
+    }
+}
+
+BE_NAMESPACE_END
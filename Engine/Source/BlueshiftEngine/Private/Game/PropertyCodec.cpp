@@ -0,0 +1,159 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Game/PropertyCodec.h"
+
+BE_NAMESPACE_BEGIN
+
+void PropertyWriter::WriteBytes(Array<byte> &out, const void *src, int size) {
+    int offset = out.Count();
+    if (offset + size > out.Capacity()) {
+        out.Reserve(Max(out.Capacity() * 2, offset + size));
+    }
+    out.SetCount(offset + size, false);
+    memcpy(out.Ptr() + offset, src, size);
+}
+
+void PropertyWriter::WriteString(Array<byte> &out, const char *str) {
+    int32_t length = (int32_t)strlen(str);
+    Write(out, length);
+    WriteBytes(out, str, length);
+}
+
+void PropertyWriter::WriteValue(Array<byte> &out, PropertySpec::Type type, const Variant &value) {
+    switch (type) {
+    case PropertySpec::IntType:
+    case PropertySpec::EnumType:
+        Write(out, value.As<int>());
+        break;
+    case PropertySpec::BoolType:
+        Write(out, value.As<bool>());
+        break;
+    case PropertySpec::FloatType:
+        Write(out, value.As<float>());
+        break;
+    case PropertySpec::StringType:
+        WriteString(out, value.As<Str>().c_str());
+        break;
+    case PropertySpec::PointType:
+        Write(out, value.As<Point>());
+        break;
+    case PropertySpec::RectType:
+        Write(out, value.As<Rect>());
+        break;
+    case PropertySpec::Vec2Type:
+        Write(out, value.As<Vec2>());
+        break;
+    case PropertySpec::Vec3Type:
+    case PropertySpec::Color3Type:
+        Write(out, value.As<Vec3>());
+        break;
+    case PropertySpec::Vec4Type:
+    case PropertySpec::Color4Type:
+        Write(out, value.As<Vec4>());
+        break;
+    case PropertySpec::AnglesType:
+        Write(out, value.As<Angles>());
+        break;
+    case PropertySpec::Mat3Type:
+        Write(out, value.As<Mat3>());
+        break;
+    case PropertySpec::ObjectType:
+        Write(out, value.As<Guid>());
+        break;
+    default:
+        assert(0);
+        break;
+    }
+}
+
+bool PropertyReader::ReadBytes(void *dst, size_t size) {
+    if ((size_t)(end - ptr) < size) {
+        memset(dst, 0, size);
+        Fail();
+        return false;
+    }
+
+    memcpy(dst, ptr, size);
+    ptr += size;
+    return true;
+}
+
+bool PropertyReader::ReadString(Str &str) {
+    int32_t length = Read<int32_t>();
+    if (length < 0 || (size_t)(end - ptr) < (size_t)length) {
+        Fail();
+        return false;
+    }
+
+    str.Clear();
+    str.Append((const char *)ptr, length);
+    ptr += length;
+    return true;
+}
+
+bool PropertyReader::ReadValue(PropertySpec::Type type, Variant &value) {
+    switch (type) {
+    case PropertySpec::IntType:
+    case PropertySpec::EnumType:
+        value = Read<int>();
+        break;
+    case PropertySpec::BoolType:
+        value = Read<bool>();
+        break;
+    case PropertySpec::FloatType:
+        value = Read<float>();
+        break;
+    case PropertySpec::StringType: {
+        Str str;
+        ReadString(str);
+        value = str;
+        break; }
+    case PropertySpec::PointType:
+        value = Read<Point>();
+        break;
+    case PropertySpec::RectType:
+        value = Read<Rect>();
+        break;
+    case PropertySpec::Vec2Type:
+        value = Read<Vec2>();
+        break;
+    case PropertySpec::Vec3Type:
+    case PropertySpec::Color3Type:
+        value = Read<Vec3>();
+        break;
+    case PropertySpec::Vec4Type:
+    case PropertySpec::Color4Type:
+        value = Read<Vec4>();
+        break;
+    case PropertySpec::AnglesType:
+        value = Read<Angles>();
+        break;
+    case PropertySpec::Mat3Type:
+        value = Read<Mat3>();
+        break;
+    case PropertySpec::ObjectType:
+        value = Read<Guid>();
+        break;
+    default:
+        // Unknown type comes only from the corrupt data
+        Fail();
+        break;
+    }
+
+    return !failed;
+}
+
+BE_NAMESPACE_END
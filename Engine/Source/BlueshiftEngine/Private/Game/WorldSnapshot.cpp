@@ -0,0 +1,304 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Components/Component.h"
+#include "Components/ComScript.h"
+#include "Game/Entity.h"
+#include "Game/WorldSnapshot.h"
+#include "Game/PropertyCodec.h"
+#include "Core/Checksum_CRC32.h"
+
+BE_NAMESPACE_BEGIN
+
+void WorldSnapshot::Clear() {
+    data.Clear();
+    settingsOffset = 0;
+    settingsSize = 0;
+    entityRecords.Clear();
+    references.Clear();
+    objectRecordHash.Clear();
+}
+
+size_t WorldSnapshot::Size() const {
+    return data.MemoryUsed() + entityRecords.MemoryUsed() + references.MemoryUsed();
+}
+
+int WorldSnapshot::FindEntity(const Guid &entityGuid) const {
+    int recordIndex;
+    if (!objectRecordHash.Get(entityGuid, &recordIndex) || entityRecords[recordIndex].guid != entityGuid) {
+        return -1;
+    }
+    return recordIndex;
+}
+
+// Object is written as class name, GUID, and property values in the order of the property specs.
+// Array property is written as the number of elements followed by the element values.
+void WorldSnapshot::WriteObject(const Object *object, Array<byte> &out, Array<Guid> *references) {
+    PropertyWriter writer;
+
+    writer.WriteString(out, object->ClassName());
+    PropertyWriter::Write(out, object->GetGuid());
+
+    // Script property specs are known after the script is loaded
+    if (object->IsTypeOf(ComScript::metaObject)) {
+        PropertyWriter::Write(out, object->props->Get("script").As<Guid>());
+    }
+
+    Array<const PropertySpec *> pspecs;
+    object->GetPropertySpecList(pspecs);
+
+    for (int i = 0; i < pspecs.Count(); i++) {
+        const PropertySpec *spec = pspecs[i];
+
+        if (spec->GetFlags() & PropertySpec::SkipSerialization) {
+            continue;
+        }
+
+        const Str name = spec->GetName();
+        const PropertySpec::Type type = spec->GetType();
+        Variant value;
+
+        if (spec->GetFlags() & PropertySpec::IsArray) {
+            int32_t numElements = object->props->NumElements(name);
+            PropertyWriter::Write(out, numElements);
+
+            for (int elementIndex = 0; elementIndex < numElements; elementIndex++) {
+                object->props->Get(name + va("[%d]", elementIndex), value, true);
+                writer.WriteValue(out, type, value);
+
+                if (type == PropertySpec::ObjectType && references && !value.As<Guid>().IsZero()) {
+                    references->Append(value.As<Guid>());
+                }
+            }
+        } else {
+            object->props->Get(name, value, true);
+            writer.WriteValue(out, type, value);
+
+            if (type == PropertySpec::ObjectType && references && !value.As<Guid>().IsZero()) {
+                references->Append(value.As<Guid>());
+            }
+        }
+    }
+}
+
+// Property values are set as they are, because they are taken from the properties of the same specs
+void WorldSnapshot::ReadProperties(PropertyReader &reader, Object *object) {
+    Array<const PropertySpec *> pspecs;
+    object->GetPropertySpecList(pspecs);
+
+    for (int i = 0; i < pspecs.Count(); i++) {
+        const PropertySpec *spec = pspecs[i];
+
+        if (spec->GetFlags() & PropertySpec::SkipSerialization) {
+            continue;
+        }
+
+        const Str name = spec->GetName();
+        const PropertySpec::Type type = spec->GetType();
+        Variant value;
+
+        if (spec->GetFlags() & PropertySpec::IsArray) {
+            int32_t numElements = reader.Read<int32_t>();
+
+            object->props->SetRaw(name, Variant(), numElements);
+
+            for (int elementIndex = 0; elementIndex < numElements; elementIndex++) {
+                reader.ReadValue(type, value);
+                object->props->SetRaw(name + va("[%d]", elementIndex), value, 0);
+            }
+        } else {
+            reader.ReadValue(type, value);
+            object->props->SetRaw(name, value, 0);
+        }
+    }
+}
+
+Object *WorldSnapshot::ReadObject(PropertyReader &reader) {
+    Str classname;
+    reader.ReadString(classname);
+
+    const Guid guid = reader.Read<Guid>();
+
+    MetaObject *metaObject = Object::GetMetaObject(classname);
+    assert(metaObject);
+
+    Object *object = metaObject->CreateInstance(guid);
+
+    if (metaObject->IsTypeOf(ComScript::metaObject)) {
+        const Guid scriptGuid = reader.Read<Guid>();
+
+        Json::Value scriptValue;
+        scriptValue["script"] = scriptGuid.ToString();
+
+        object->Cast<ComScript>()->InitPropertySpec(scriptValue);
+    }
+
+    ReadProperties(reader, object);
+
+    return object;
+}
+
+void WorldSnapshot::WriteSettings(const Object *settings) {
+    settingsOffset = data.Count();
+    WriteObject(settings, data, nullptr);
+    settingsSize = data.Count() - settingsOffset;
+}
+
+void WorldSnapshot::ReadSettings(Object *settings) const {
+    PropertyReader reader(data.Ptr() + settingsOffset, settingsSize);
+
+    // Skip the class name and the GUID, settings object is not created again
+    Str classname;
+    reader.ReadString(classname);
+    reader.Read<Guid>();
+
+    ReadProperties(reader, settings);
+
+    assert(reader.IsAtEnd() && !reader.IsFailed());
+}
+
+void WorldSnapshot::WriteEntity(const Entity *entity) {
+    int recordIndex = entityRecords.Count();
+
+    EntityRecord &record = entityRecords.Alloc();
+    record.guid = entity->GetGuid();
+    record.offset = data.Count();
+    record.firstReference = references.Count();
+
+    objectRecordHash.Set(entity->GetGuid(), recordIndex);
+
+    WriteObject(entity, data, &references);
+
+    int32_t numComponents = 0;
+    for (int i = 0; i < entity->NumComponents(); i++) {
+        if (entity->GetComponent(i)) {
+            numComponents++;
+        }
+    }
+    PropertyWriter::Write(data, numComponents);
+
+    for (int i = 0; i < entity->NumComponents(); i++) {
+        const Component *component = entity->GetComponent(i);
+        if (component) {
+            objectRecordHash.Set(component->GetGuid(), recordIndex);
+
+            WriteObject(component, data, &references);
+        }
+    }
+
+    record.size = data.Count() - record.offset;
+    record.hash = CRC32_BlockChecksum(data.Ptr() + record.offset, record.size);
+    record.numReferences = references.Count() - record.firstReference;
+}
+
+Entity *WorldSnapshot::ReadEntity(int recordIndex) const {
+    const EntityRecord &record = entityRecords[recordIndex];
+    PropertyReader reader(data.Ptr() + record.offset, record.size);
+
+    Entity *entity = ReadObject(reader)->Cast<Entity>();
+
+    entity->name = entity->props->Get("name").As<Str>();
+    entity->tag = entity->props->Get("tag").As<Str>();
+
+    int32_t numComponents = reader.Read<int32_t>();
+
+    for (int i = 0; i < numComponents; i++) {
+        Component *component = ReadObject(reader)->Cast<Component>();
+
+        entity->AddComponent(component);
+    }
+
+    assert(reader.IsAtEnd() && !reader.IsFailed());
+
+    return entity;
+}
+
+bool WorldSnapshot::IsUnchanged(int recordIndex, const Entity *entity) const {
+    for (int i = 0; i < entity->NumComponents(); i++) {
+        const Component *component = entity->GetComponent(i);
+        if (component && component->HasRuntimeState()) {
+            return false;
+        }
+    }
+
+    Array<byte> entityData;
+    entityData.Resize(entityRecords[recordIndex].size);
+
+    WriteObject(entity, entityData, nullptr);
+
+    int32_t numComponents = 0;
+    for (int i = 0; i < entity->NumComponents(); i++) {
+        if (entity->GetComponent(i)) {
+            numComponents++;
+        }
+    }
+    PropertyWriter::Write(entityData, numComponents);
+
+    for (int i = 0; i < entity->NumComponents(); i++) {
+        const Component *component = entity->GetComponent(i);
+        if (component) {
+            WriteObject(component, entityData, nullptr);
+        }
+    }
+
+    const EntityRecord &record = entityRecords[recordIndex];
+
+    if (entityData.Count() != record.size || CRC32_BlockChecksum(entityData.Ptr(), entityData.Count()) != record.hash) {
+        return false;
+    }
+    return memcmp(entityData.Ptr(), data.Ptr() + record.offset, record.size) == 0;
+}
+
+void WorldSnapshot::FindUnchangedEntities(const EntityPtrArray &entities, EntityPtrArray &unchangedEntities) const {
+    unchangedEntities.SetCount(entityRecords.Count());
+    for (int i = 0; i < unchangedEntities.Count(); i++) {
+        unchangedEntities[i] = nullptr;
+    }
+
+    for (int i = 0; i < entities.Count(); i++) {
+        const Entity *entity = entities[i];
+
+        int recordIndex = FindEntity(entity->GetGuid());
+        if (recordIndex >= 0 && IsUnchanged(recordIndex, entity)) {
+            unchangedEntities[recordIndex] = const_cast<Entity *>(entity);
+        }
+    }
+
+    // Components resolve the object references in Init(), so the entities referencing respawned objects
+    // should be respawned too. This includes the children of the respawned entities.
+    bool changed;
+    do {
+        changed = false;
+
+        for (int recordIndex = 0; recordIndex < entityRecords.Count(); recordIndex++) {
+            if (!unchangedEntities[recordIndex]) {
+                continue;
+            }
+
+            const EntityRecord &record = entityRecords[recordIndex];
+
+            for (int i = 0; i < record.numReferences; i++) {
+                int referencedRecordIndex;
+                if (objectRecordHash.Get(references[record.firstReference + i], &referencedRecordIndex) && !unchangedEntities[referencedRecordIndex]) {
+                    unchangedEntities[recordIndex] = nullptr;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    } while (changed);
+}
+
+BE_NAMESPACE_END
@@ -15,96 +15,94 @@
 #include "Precompiled.h"
 #include "Image/Image.h"
 #include "Image/DxtEncoder.h"
+#include "Core/Task.h"
 #include "ImageInternal.h"
 
 BE_NAMESPACE_BEGIN
 
-void CompressDXT1(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
-    int numMipmaps = srcImage.NumMipmaps();
-    int numSlices = srcImage.NumSlices();
+typedef void (*compressImageFunc_t)(const byte *src, const int width, const int height, const int depth, byte *dst);
 
-    for (int mipLevel = 0; mipLevel < numMipmaps; mipLevel++) {
-        int w = srcImage.GetWidth(mipLevel);
-        int h = srcImage.GetHeight(mipLevel);
-        int d = srcImage.GetDepth(mipLevel);
+struct CompressSurface {
+    const byte *            src;
+    byte *                  dst;
+    int                     width;
+    int                     height;
+    int                     numBlockRowsPerDepth;
+    int                     firstBlockRow;      ///< Index of the first block row in all the surfaces
+};
 
-        for (int sliceIndex = 0; sliceIndex < numSlices; sliceIndex++) {
-            byte *src = srcImage.GetPixels(mipLevel, sliceIndex);
-            byte *dst = dstImage.GetPixels(mipLevel, sliceIndex);
+// Splits 4x4 block rows of all mip levels and slices across the task scheduler.
+// Each block is encoded independently, so the output is the same as the serial encoding.
+static void CompressBlocksParallel(const Image &srcImage, Image &dstImage, int blockBytes, compressImageFunc_t compressFunc) {
+    const int numMipmaps = srcImage.NumMipmaps();
+    const int numSlices = srcImage.NumSlices();
 
-            if (compressoinQuality == Image::HighQuality) {
-                DXTEncoder::CompressImageDXT1HQ(src, w, h, d, dst);
-            } else {
-                DXTEncoder::CompressImageDXT1Fast(src, w, h, d, dst);
-            }
-        }
-    }
-}
+    Array<CompressSurface> surfaces;
+    surfaces.Resize(numMipmaps * numSlices);
 
-void CompressDXT3(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
-    int numMipmaps = srcImage.NumMipmaps();
-    int numSlices = srcImage.NumSlices();
+    int numBlockRows = 0;
 
     for (int mipLevel = 0; mipLevel < numMipmaps; mipLevel++) {
-        int w = srcImage.GetWidth(mipLevel);
-        int h = srcImage.GetHeight(mipLevel);
-        int d = srcImage.GetDepth(mipLevel);
-
         for (int sliceIndex = 0; sliceIndex < numSlices; sliceIndex++) {
-            byte *src = srcImage.GetPixels(mipLevel, sliceIndex);
-            byte *dst = dstImage.GetPixels(mipLevel, sliceIndex);
-
-            if (compressoinQuality == Image::HighQuality) {
-                DXTEncoder::CompressImageDXT3HQ(src, w, h, d, dst);
-            } else {
-                DXTEncoder::CompressImageDXT3Fast(src, w, h, d, dst);
-            }
+            CompressSurface &surface = surfaces.Alloc();
+            surface.src = srcImage.GetPixels(mipLevel, sliceIndex);
+            surface.dst = dstImage.GetPixels(mipLevel, sliceIndex);
+            surface.width = srcImage.GetWidth(mipLevel);
+            surface.height = srcImage.GetHeight(mipLevel);
+            surface.numBlockRowsPerDepth = (surface.height + 3) / 4;
+            surface.firstBlockRow = numBlockRows;
+
+            numBlockRows += surface.numBlockRowsPerDepth * srcImage.GetDepth(mipLevel);
         }
     }
-}
 
-void CompressDXT5(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
-    int numMipmaps = srcImage.NumMipmaps();
-    int numSlices = srcImage.NumSlices();
+    // At least 1024 blocks per task
+    const int numBlocksPerRow = (srcImage.GetWidth() + 3) / 4;
+    const int grainSize = Max(1024 / numBlocksPerRow, 1);
 
-    for (int mipLevel = 0; mipLevel < numMipmaps; mipLevel++) {
-        int w = srcImage.GetWidth(mipLevel);
-        int h = srcImage.GetHeight(mipLevel);
-        int d = srcImage.GetDepth(mipLevel);
+    taskScheduler.ParallelFor(0, numBlockRows, grainSize, [&surfaces, blockBytes, compressFunc](int rangeBegin, int rangeEnd) {
+        int surfaceIndex = 0;
 
-        for (int sliceIndex = 0; sliceIndex < numSlices; sliceIndex++) {
-            byte *src = srcImage.GetPixels(mipLevel, sliceIndex);
-            byte *dst = dstImage.GetPixels(mipLevel, sliceIndex);
-
-            if (compressoinQuality == Image::HighQuality) {
-                DXTEncoder::CompressImageDXT5HQ(src, w, h, d, dst);
-            } else {
-                DXTEncoder::CompressImageDXT5Fast(src, w, h, d, dst);
+        while (rangeBegin < rangeEnd) {
+            while (surfaceIndex + 1 < surfaces.Count() && surfaces[surfaceIndex + 1].firstBlockRow <= rangeBegin) {
+                surfaceIndex++;
             }
+
+            const CompressSurface &surface = surfaces[surfaceIndex];
+
+            // Block row index in the surface
+            const int blockRow = rangeBegin - surface.firstBlockRow;
+            const int z = blockRow / surface.numBlockRowsPerDepth;
+            const int y = (blockRow % surface.numBlockRowsPerDepth) * 4;
+
+            // Compress block rows up to the end of the depth slice
+            const int numRows = Min(rangeEnd - rangeBegin, surface.numBlockRowsPerDepth - y / 4);
+            const int h = Min(numRows * 4, surface.height - y);
+
+            const byte *src = surface.src + (z * surface.height + y) * surface.width * 4;
+            byte *dst = surface.dst + blockRow * ((surface.width + 3) / 4) * blockBytes;
+
+            compressFunc(src, surface.width, h, 1, dst);
+
+            rangeBegin += numRows;
         }
-    }
+    });
 }
 
-void CompressDXN2(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
-    int numMipmaps = srcImage.NumMipmaps();
-    int numSlices = srcImage.NumSlices();
+void CompressDXT1(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
+    CompressBlocksParallel(srcImage, dstImage, 8, compressoinQuality == Image::HighQuality ? DXTEncoder::CompressImageDXT1HQ : DXTEncoder::CompressImageDXT1Fast);
+}
 
-    for (int mipLevel = 0; mipLevel < numMipmaps; mipLevel++) {
-        int w = srcImage.GetWidth(mipLevel);
-        int h = srcImage.GetHeight(mipLevel);
-        int d = srcImage.GetDepth(mipLevel);
+void CompressDXT3(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
+    CompressBlocksParallel(srcImage, dstImage, 16, compressoinQuality == Image::HighQuality ? DXTEncoder::CompressImageDXT3HQ : DXTEncoder::CompressImageDXT3Fast);
+}
 
-        for (int sliceIndex = 0; sliceIndex < numSlices; sliceIndex++) {
-            byte *src = srcImage.GetPixels(mipLevel, sliceIndex);
-            byte *dst = dstImage.GetPixels(mipLevel, sliceIndex);
+void CompressDXT5(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
+    CompressBlocksParallel(srcImage, dstImage, 16, compressoinQuality == Image::HighQuality ? DXTEncoder::CompressImageDXT5HQ : DXTEncoder::CompressImageDXT5Fast);
+}
 
-            if (compressoinQuality == Image::HighQuality) {
-                DXTEncoder::CompressImageDXN2HQ(src, w, h, d, dst);
-            } else {
-                DXTEncoder::CompressImageDXN2Fast(src, w, h, d, dst);
-            }
-        }
-    }
+void CompressDXN2(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
+    CompressBlocksParallel(srcImage, dstImage, 16, compressoinQuality == Image::HighQuality ? DXTEncoder::CompressImageDXN2HQ : DXTEncoder::CompressImageDXN2Fast);
 }
 
 BE_NAMESPACE_END
@@ -14,6 +14,7 @@
 
 #include "Precompiled.h"
 #include "Core/Heap.h"
+#include "Core/Task.h"
 #include "Image/Image.h"
 #include "ImageInternal.h"
 #include "etc2comp/EtcLib/Etc/Etc.h"
@@ -34,156 +35,71 @@ static float QualityToEffort(Image::CompressionQuality compressoinQuality) {
     return 0;
 }
 
-void CompressETC1(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
-    Etc::ColorFloatRGBA *fsrc = (Etc::ColorFloatRGBA *)Mem_Alloc16(srcImage.GetWidth() * srcImage.GetHeight() * sizeof(Etc::ColorFloatRGBA));
-
-    float effort = QualityToEffort(compressoinQuality);
-
-    int numMipmaps = srcImage.NumMipmaps();
-
-    for (int mipLevel = 0; mipLevel < numMipmaps; mipLevel++) {
-        int w = srcImage.GetWidth(mipLevel);
-        int h = srcImage.GetHeight(mipLevel);
-
-        byte *src = srcImage.GetPixels(mipLevel);
-        byte *dst = dstImage.GetPixels(mipLevel);
-
-        // Convert byte RGBA_8_8_8_8 to float RGBA
-        Etc::ColorFloatRGBA *fsrc_ptr = fsrc;
-        for (byte *src_end = &src[w * h * 4]; src < src_end; src += 4) {
-            *fsrc_ptr++ = Etc::ColorFloatRGBA::ConvertFromRGBA8(src[0], src[1], src[2], src[3]);
-        }
+static void CompressSurfaceETC(const byte *src, int w, int h, byte *dst, size_t dstSize, Etc::Image::Format format, float effort, int numEncodingThreads) {
+    Etc::ColorFloatRGBA *fsrc = (Etc::ColorFloatRGBA *)Mem_Alloc16(w * h * sizeof(Etc::ColorFloatRGBA));
 
-        // Encode ETC1 RGB
-        Etc::Image image((float *)fsrc, w, h, Etc::ErrorMetric::REC709);
-        image.m_bVerboseOutput = false;
-        Etc::Image::EncodingStatus status = image.Encode(Etc::Image::Format::ETC1, Etc::ErrorMetric::REC709, effort, 8, MAX_JOBS);
-        if (status >= Etc::Image::EncodingStatus::ERROR_THRESHOLD) {
-            assert(0);
-            return;
-        }
+    // Convert byte RGBA_8_8_8_8 to float RGBA
+    Etc::ColorFloatRGBA *fsrc_ptr = fsrc;
+    for (const byte *src_end = &src[w * h * 4]; src < src_end; src += 4) {
+        *fsrc_ptr++ = Etc::ColorFloatRGBA::ConvertFromRGBA8(src[0], src[1], src[2], src[3]);
+    }
 
+    Etc::Image image((float *)fsrc, w, h, Etc::ErrorMetric::REC709);
+    image.m_bVerboseOutput = false;
+    Etc::Image::EncodingStatus status = image.Encode(format, Etc::ErrorMetric::REC709, effort, numEncodingThreads, MAX_JOBS);
+    if (status >= Etc::Image::EncodingStatus::ERROR_THRESHOLD) {
+        assert(0);
+    } else {
         // Write to destination memory
         size_t encodedBytes = image.GetEncodingBitsBytes();
-        assert(encodedBytes == dstImage.GetSize(mipLevel));
+        assert(encodedBytes == dstSize);
         memcpy(dst, image.GetEncodingBits(), encodedBytes);
     }
 
     Mem_AlignedFree(fsrc);
 }
 
-void CompressETC2_RGB8(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
-    Etc::ColorFloatRGBA *fsrc = (Etc::ColorFloatRGBA *)Mem_Alloc16(srcImage.GetWidth() * srcImage.GetHeight() * sizeof(Etc::ColorFloatRGBA));
-    
-    float effort = QualityToEffort(compressoinQuality);
+// Mip levels and slices are encoded in parallel on the task scheduler.
+// ETC encoder distributes the effort over all the blocks of an image, so an image is not split into block ranges.
+// The first mip level has 3/4 of all the pixels, so it is encoded with the encoder's own threads.
+static void CompressETC(const Image &srcImage, Image &dstImage, Etc::Image::Format format, Image::CompressionQuality compressoinQuality) {
+    const float effort = QualityToEffort(compressoinQuality);
+    const int numSlices = srcImage.NumSlices();
+    const int numSurfaces = srcImage.NumMipmaps() * numSlices;
 
-    int numMipmaps = srcImage.NumMipmaps();
+    taskScheduler.ParallelFor(0, numSurfaces, 1, [&srcImage, &dstImage, format, effort, numSlices](int rangeBegin, int rangeEnd) {
+        for (int surfaceIndex = rangeBegin; surfaceIndex < rangeEnd; surfaceIndex++) {
+            int mipLevel = surfaceIndex / numSlices;
+            int sliceIndex = surfaceIndex % numSlices;
 
-    for (int mipLevel = 0; mipLevel < numMipmaps; mipLevel++) {
-        int w = srcImage.GetWidth(mipLevel);
-        int h = srcImage.GetHeight(mipLevel);
+            int w = srcImage.GetWidth(mipLevel);
+            int h = srcImage.GetHeight(mipLevel);
 
-        byte *src = srcImage.GetPixels(mipLevel);
-        byte *dst = dstImage.GetPixels(mipLevel);
+            const byte *src = srcImage.GetPixels(mipLevel, sliceIndex);
+            byte *dst = dstImage.GetPixels(mipLevel, sliceIndex);
+            size_t dstSize = dstImage.GetSliceSize(mipLevel);
 
-        // Convert byte RGBA_8_8_8_8 to float RGBA
-        Etc::ColorFloatRGBA *fsrc_ptr = fsrc;
-        for (byte *src_end = &src[w * h * 4]; src < src_end; src += 4) {
-            *fsrc_ptr++ = Etc::ColorFloatRGBA::ConvertFromRGBA8(src[0], src[1], src[2], src[3]);
-        }
+            int numEncodingThreads = mipLevel == 0 ? Max(taskScheduler.NumThreads(), 1) : 1;
 
-        // Encode ETC2 RGB8
-        Etc::Image image((float *)fsrc, w, h, Etc::ErrorMetric::REC709);
-        image.m_bVerboseOutput = false;
-        Etc::Image::EncodingStatus status = image.Encode(Etc::Image::Format::RGB8, Etc::ErrorMetric::REC709, effort, 8, MAX_JOBS);
-        if (status >= Etc::Image::EncodingStatus::ERROR_THRESHOLD) {
-            assert(0);
-            return;
+            CompressSurfaceETC(src, w, h, dst, dstSize, format, effort, numEncodingThreads);
         }
+    });
+}
 
-        // Write to destination memory
-        size_t encodedBytes = image.GetEncodingBitsBytes();
-        assert(encodedBytes == dstImage.GetSize(mipLevel));
-        memcpy(dst, image.GetEncodingBits(), encodedBytes);
-    }
+void CompressETC1(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
+    CompressETC(srcImage, dstImage, Etc::Image::Format::ETC1, compressoinQuality);
+}
 
-    Mem_AlignedFree(fsrc);
+void CompressETC2_RGB8(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
+    CompressETC(srcImage, dstImage, Etc::Image::Format::RGB8, compressoinQuality);
 }
 
 void CompressETC2_RGBA8(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
-    Etc::ColorFloatRGBA *fsrc = (Etc::ColorFloatRGBA *)Mem_Alloc16(srcImage.GetWidth() * srcImage.GetHeight() * sizeof(Etc::ColorFloatRGBA));
-
-    float effort = QualityToEffort(compressoinQuality);
-
-    int numMipmaps = srcImage.NumMipmaps();
-
-    for (int mipLevel = 0; mipLevel < numMipmaps; mipLevel++) {
-        int w = srcImage.GetWidth(mipLevel);
-        int h = srcImage.GetHeight(mipLevel);
-
-        byte *src = srcImage.GetPixels(mipLevel);
-        byte *dst = dstImage.GetPixels(mipLevel);
-
-        // Convert byte RGBA_8_8_8_8 to float RGBA
-        Etc::ColorFloatRGBA *fsrc_ptr = fsrc;
-        for (byte *src_end = &src[w * h * 4]; src < src_end; src += 4) {
-            *fsrc_ptr++ = Etc::ColorFloatRGBA::ConvertFromRGBA8(src[0], src[1], src[2], src[3]);
-        }
-
-        // Encode ETC2 RGBA8
-        Etc::Image image((float *)fsrc, w, h, Etc::ErrorMetric::REC709);
-        image.m_bVerboseOutput = false;
-        Etc::Image::EncodingStatus status = image.Encode(Etc::Image::Format::RGBA8, Etc::ErrorMetric::REC709, effort, 8, MAX_JOBS);
-        if (status >= Etc::Image::EncodingStatus::ERROR_THRESHOLD) {
-            assert(0);
-            return;
-        }
-
-        // Write to destination memory
-        size_t encodedBytes = image.GetEncodingBitsBytes();
-        assert(encodedBytes == dstImage.GetSize(mipLevel));
-        memcpy(dst, image.GetEncodingBits(), encodedBytes);
-    }
-
-    Mem_AlignedFree(fsrc);
+    CompressETC(srcImage, dstImage, Etc::Image::Format::RGBA8, compressoinQuality);
 }
 
 void CompressETC2_RGBA1(const Image &srcImage, Image &dstImage, Image::CompressionQuality compressoinQuality) {
-    Etc::ColorFloatRGBA *fsrc = (Etc::ColorFloatRGBA *)Mem_Alloc16(srcImage.GetWidth() * srcImage.GetHeight() * sizeof(Etc::ColorFloatRGBA));
-
-    float effort = QualityToEffort(compressoinQuality);
-
-    int numMipmaps = srcImage.NumMipmaps();
-
-    for (int mipLevel = 0; mipLevel < numMipmaps; mipLevel++) {
-        int w = srcImage.GetWidth(mipLevel);
-        int h = srcImage.GetHeight(mipLevel);
-
-        byte *src = srcImage.GetPixels(mipLevel);
-        byte *dst = dstImage.GetPixels(mipLevel);
-
-        // Convert byte RGBA_8_8_8_8 to float RGBA
-        Etc::ColorFloatRGBA *fsrc_ptr = fsrc;
-        for (byte *src_end = &src[w * h * 4]; src < src_end; src += 4) {
-            *fsrc_ptr++ = Etc::ColorFloatRGBA::ConvertFromRGBA8(src[0], src[1], src[2], src[3]);
-        }
-
-        // Encode ETC2 RGB8A1
-        Etc::Image image((float *)fsrc, w, h, Etc::ErrorMetric::REC709);
-        image.m_bVerboseOutput = false;
-        Etc::Image::EncodingStatus status = image.Encode(Etc::Image::Format::RGB8A1, Etc::ErrorMetric::REC709, effort, 8, MAX_JOBS);
-        if (status >= Etc::Image::EncodingStatus::ERROR_THRESHOLD) {
-            assert(0);
-            return;
-        }
-
-        // Write to destination memory
-        size_t encodedBytes = image.GetEncodingBitsBytes();
-        assert(encodedBytes == dstImage.GetSize(mipLevel));
-        memcpy(dst, image.GetEncodingBits(), encodedBytes);
-    }
-
-    Mem_AlignedFree(fsrc);
+    CompressETC(srcImage, dstImage, Etc::Image::Format::RGB8A1, compressoinQuality);
 }
 
 BE_NAMESPACE_END
@@ -75,7 +75,11 @@ static void Common_Log(const int logLevel, const wchar_t *msg) {
         }
     }
 
-    platform->Log(bufptr); //
+    if (Engine::logFunc) {
+        (*Engine::logFunc)(logLevel, bufptr);
+    } else {
+        platform->Log(bufptr);
+    }
     
     console.Print(bufptr);
 }
@@ -98,7 +102,11 @@ static void Common_Error(const int errLevel, const wchar_t *msg) {
 
         //common.Shutdown();
 
-        platform->Error(msg);
+        if (Engine::errorFunc) {
+            (*Engine::errorFunc)(errLevel, msg);
+        } else {
+            platform->Error(msg);
+        }
     }
 }
 
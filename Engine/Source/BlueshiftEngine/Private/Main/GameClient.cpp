@@ -17,6 +17,8 @@
 #include "Core/Cmds.h"
 #include "Core/CVars.h"
 #include "Core/Vec4Color.h"
+#include "Core/AsyncLoader.h"
+#include "Core/Profiler.h"
 #include "Render/Render.h"
 #include "Physics/Physics.h"
 #include "Input/KeyCmd.h"
@@ -166,6 +168,12 @@ void GameClient::Shutdown() {
 
     //materialManager.ReleaseMaterial(consoleMaterial);
 
+    // Requests hold the resources, so cancel them before the resource managers are shut down
+    asyncLoader.CancelAll();
+
+    // GPU queries of the profiler should be freed before the render context
+    profiler.StopCapture();
+
     animControllerManager.Shutdown();
 
     physicsSystem.Shutdown();
@@ -196,6 +204,8 @@ void GameClient::RunFrame() {
     // FIXME: use thread
     soundSystem.Update();
 
+    asyncLoader.Update();
+
     renderSystem.CheckModifiedCVars();
 
     physicsSystem.CheckModifiedCVars();
@@ -207,6 +217,13 @@ void GameClient::RunFrame() {
 
 void GameClient::EndFrame() {
     inputSystem.EndFrame();
+
+    if (profiler.IsCapturing()) {
+        // Back end markers of the render thread should be recorded in this frame
+        renderSystem.SyncRenderThread();
+    }
+
+    profiler.SyncFrame();
 }
 
 void GameClient::UpdateConsole() {
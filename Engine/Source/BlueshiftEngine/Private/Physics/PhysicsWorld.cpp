@@ -17,6 +17,7 @@
 #include "Physics/Collider.h"
 #include "ColliderInternal.h"
 #include "PhysicsInternal.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
     
@@ -140,7 +141,7 @@ void PhysicsWorld::ClearScene() {
 }
 
 void PhysicsWorld::StepSimulation(int frameTime) {
-    //startFrameMsec = PlatformTime::Milliseconds();
+    BE_PROFILE_CPU_SCOPE("PhysicsWorld::StepSimulation");
 
     if (!physics_enable.GetBool()) {
         return;
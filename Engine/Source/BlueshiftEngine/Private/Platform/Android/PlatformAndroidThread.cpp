@@ -200,6 +200,10 @@ bool PlatformUnixCondition::TimedWait(const PlatformUnixCondition *posixConditio
 	return true;
 }
 
+void PlatformUnixCondition::Signal(const PlatformUnixCondition *posixCondition) {
+	pthread_cond_signal(posixCondition->cond);
+}
+
 void PlatformUnixCondition::Broadcast(const PlatformUnixCondition *posixCondition) {
 	pthread_cond_broadcast(posixCondition->cond);
 }
@@ -25,15 +25,25 @@ PlatformIOSFile::~PlatformIOSFile() {
 }
 
 Str PlatformIOSFile::NormalizeFilename(const char *filename) {
-    Str normalizedFilename = PlatformFile::GetBasePath();
-    normalizedFilename.AppendPath(filename);
+    Str normalizedFilename;
+    if (filename[0] == '/') {
+        normalizedFilename = filename;
+    } else {
+        normalizedFilename = PlatformFile::GetBasePath();
+        normalizedFilename.AppendPath(filename);
+    }
     normalizedFilename.BackSlashesToSlashes();
     return normalizedFilename;
 }
 
 Str PlatformIOSFile::NormalizeDirectoryName(const char *dirname) {
-    Str normalizedDirname = PlatformFile::GetBasePath();
-    normalizedDirname.AppendPath(dirname);
+    Str normalizedDirname;
+    if (dirname[0] == '/') {
+        normalizedDirname = dirname;
+    } else {
+        normalizedDirname = PlatformFile::GetBasePath();
+        normalizedDirname.AppendPath(dirname);
+    }
     normalizedDirname.BackSlashesToSlashes();
     
     int length = normalizedDirname.Length();
@@ -109,8 +109,13 @@ bool PlatformPosixFile::Write(const void *buffer, size_t bytesToWrite) {
 //-------------------------------------------------------------------------------------------
 
 Str PlatformPosixFile::NormalizeFilename(const char *filename) {
-    Str normalizedFilename(basePath);
-    normalizedFilename.AppendPath(filename);
+    Str normalizedFilename;
+    if (filename[0] == '/') {
+        normalizedFilename = filename;
+    } else {
+        normalizedFilename = basePath;
+        normalizedFilename.AppendPath(filename);
+    }
     normalizedFilename.CleanPath('/');
     //normalizedFilename.BackSlashesToSlashes();
 
@@ -118,8 +123,13 @@ Str PlatformPosixFile::NormalizeFilename(const char *filename) {
 }
 
 Str PlatformPosixFile::NormalizeDirectoryName(const char *dirname) {
-    Str normalizedDirname(basePath);
-    normalizedDirname.AppendPath(dirname);
+    Str normalizedDirname;
+    if (dirname[0] == '/') {
+        normalizedDirname = dirname;
+    } else {
+        normalizedDirname = basePath;
+        normalizedDirname.AppendPath(dirname);
+    }
     normalizedDirname.CleanPath('/');
     //normalizedDirname.BackSlashesToSlashes();
 
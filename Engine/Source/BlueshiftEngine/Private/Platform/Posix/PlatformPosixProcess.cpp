@@ -19,6 +19,12 @@
 
 BE_NAMESPACE_BEGIN
 
+// return the number of logical threads of the system
+int PlatformPosixProcess::NumberOfLogicalProcessors() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
 SharedLib PlatformPosixProcess::OpenLibrary(const char *filename) {
     char cwd[1024];
     char path[1024];
@@ -238,7 +238,8 @@ bool PlatformWinFile::RemoveFile(const char *filename) {
 bool PlatformWinFile::MoveFile(const char *from, const char *to) {
     Str normalizedFrom = NormalizeFilename(from);
     Str normalizedTo = NormalizeFilename(to);
-    return !!MoveFileA(normalizedFrom, normalizedTo);
+    // Replaces the existing file like rename() of the other platforms
+    return !!MoveFileExA(normalizedFrom, normalizedTo, MOVEFILE_REPLACE_EXISTING);
 }
 
 DateTime PlatformWinFile::GetTimeStamp(const char *filename) {
@@ -0,0 +1,186 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Core/Heap.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+#include "Simd/Simd.h"
+
+BE_NAMESPACE_BEGIN
+
+RHI::Handle NullRHI::CreateBuffer(BufferType type, BufferUsage usage, int size, int pitch, const void *data) {
+    NullRHIBuffer *buffer = new NullRHIBuffer;
+    buffer->type        = type;
+    buffer->data        = nullptr;
+    buffer->size        = size;
+    buffer->pitch       = pitch;
+    buffer->writeOffset = 0;
+
+    // Buffers live in system memory so that mapping and writing costs the same CPU work as a driver copy
+    if (size > 0) {
+        buffer->data = (byte *)Mem_Alloc16(size);
+        if (data) {
+            simdProcessor->Memcpy(buffer->data, data, size);
+        }
+    }
+
+    int handle = bufferList.FindNull();
+    if (handle == -1) {
+        handle = bufferList.Append(buffer);
+    } else {
+        bufferList[handle] = buffer;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DeleteBuffer(Handle bufferHandle) {
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    for (int i = 0; i < COUNT_OF(currentContext->state->bufferHandles); i++) {
+        if (bufferHandle == currentContext->state->bufferHandles[i]) {
+            currentContext->state->bufferHandles[i] = NullBuffer;
+            break;
+        }
+    }
+
+    if (buffer->data) {
+        Mem_AlignedFree(buffer->data);
+    }
+
+    delete bufferList[bufferHandle];
+    bufferList[bufferHandle] = nullptr;
+}
+
+void NullRHI::BindBuffer(BufferType type, Handle bufferHandle) {
+    currentContext->state->bufferHandles[type] = bufferHandle;
+}
+
+void *NullRHI::MapBufferRange(Handle bufferHandle, BufferLockMode lockMode, int offset, int size) {
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    if (size < 0) {
+        size = buffer->size;
+    }
+
+    assert(offset + size <= buffer->size);
+
+    return buffer->data + offset;
+}
+
+bool NullRHI::UnmapBuffer(Handle bufferHandle) {
+    return true;
+}
+
+void NullRHI::FlushMappedBufferRange(Handle bufferHandle, int offset, int size) {
+}
+
+int NullRHI::BufferDiscardWrite(Handle bufferHandle, int size, const void *data) {
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    if (size > buffer->size || !buffer->data) {
+        if (buffer->data) {
+            Mem_AlignedFree(buffer->data);
+        }
+        buffer->data = (byte *)Mem_Alloc16(size);
+    }
+
+    if (data) {
+        simdProcessor->Memcpy(buffer->data, data, size);
+    }
+
+    buffer->size = size;
+    buffer->writeOffset = 0;
+
+    return 0;
+}
+
+int NullRHI::BufferWrite(Handle bufferHandle, int alignSize, int size, const void *data) {
+    NullRHIBuffer *writeBuffer = bufferList[bufferHandle];
+
+    if (writeBuffer->pitch > 0 && size > writeBuffer->pitch) {
+        return -1;
+    }
+
+    int base = writeBuffer->writeOffset + alignSize - 1;
+    base -= base % alignSize;
+
+    if (writeBuffer->pitch > 0) {
+        int startRow = base / writeBuffer->pitch;
+        int endRow = (base + size) / writeBuffer->pitch;
+
+        if (endRow > startRow) {
+            base -= base % writeBuffer->pitch;
+            base += writeBuffer->pitch;
+        }
+    }
+
+    int endPos = base + size;
+
+    if (endPos > writeBuffer->size) {
+        return -1;
+    }
+
+    // If date == nullptr, buffer memory is reserved
+    if (data) {
+        simdProcessor->Memcpy(writeBuffer->data + base, data, size);
+    }
+
+    writeBuffer->writeOffset = endPos;
+
+    return base;
+}
+
+int NullRHI::BufferCopy(Handle readBufferHandle, Handle writeBufferHandle, int alignSize, int size) {
+    NullRHIBuffer *writeBuffer = bufferList[writeBufferHandle];
+    const NullRHIBuffer *readBuffer = bufferList[readBufferHandle];
+
+    if (writeBuffer->pitch > 0 && size > writeBuffer->pitch) {
+        return -1;
+    }
+
+    int base = writeBuffer->writeOffset + alignSize - 1;
+    base -= base % alignSize;
+
+    if (writeBuffer->pitch > 0) {
+        int startRow = base / writeBuffer->pitch;
+        int endRow = (base + size) / writeBuffer->pitch;
+
+        if (endRow > startRow) {
+            base -= base % writeBuffer->pitch;
+            base += writeBuffer->pitch;
+        }
+    }
+
+    int endPos = base + size;
+
+    if (endPos > writeBuffer->size) {
+        return -1;
+    }
+
+    simdProcessor->Memcpy(writeBuffer->data + base, readBuffer->data, size);
+
+    writeBuffer->writeOffset = endPos;
+
+    return base;
+}
+
+void NullRHI::BufferRewind(Handle bufferHandle) {
+    NullRHIBuffer *buffer = bufferList[bufferHandle];
+
+    buffer->writeOffset = 0;
+}
+
+BE_NAMESPACE_END
@@ -0,0 +1,439 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Core/Heap.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+NullRHI         rhi;
+
+CVar            null_screenWidth(L"null_screenWidth", L"1280", CVar::Integer, L"width of the null render contexts");
+CVar            null_screenHeight(L"null_screenHeight", L"720", CVar::Integer, L"height of the null render contexts");
+
+NullRHI::NullRHI() {
+    initialized = false;
+    currentContext = nullptr;
+    mainContext = nullptr;
+    memset(&counter, 0, sizeof(counter));
+}
+
+void NullRHI::Init(const Settings *settings) {
+    BE_LOG(L"Initializing Null Renderer...\n");
+
+    InitHandles();
+
+    mainContext = new NullRHIContext;
+    memset(mainContext, 0, sizeof(*mainContext));
+    mainContext->state = new NullRHIState;
+
+    currentContext = mainContext;
+
+    // Reasonable limits of the desktop GPU, so that the renderer takes the same code paths
+    memset(&hwLimit, 0, sizeof(hwLimit));
+    hwLimit.maxTextureSize = 16384;
+    hwLimit.max3dTextureSize = 2048;
+    hwLimit.maxCubeMapTextureSize = 16384;
+    hwLimit.maxRectangleTextureSize = 16384;
+    hwLimit.maxTextureBufferSize = 134217728;
+    hwLimit.maxTextureAnisotropy = 16;
+    hwLimit.maxTextureImageUnits = 32;
+    hwLimit.maxVertexAttribs = 16;
+    hwLimit.maxVertexUniformComponents = 4096;
+    hwLimit.maxVertexTextureImageUnits = 32;
+    hwLimit.maxFragmentUniformComponents = 4096;
+    hwLimit.maxFragmentInputComponents = 128;
+    hwLimit.maxGeometryTextureImageUnits = 32;
+    hwLimit.maxGeometryOutputVertices = 256;
+    hwLimit.maxUniformBlockSize = 65536;
+    hwLimit.uniformBufferOffsetAlignment = 256;
+    hwLimit.maxRenderBufferSize = 16384;
+    hwLimit.maxColorAttachments = 8;
+    hwLimit.maxDrawBuffers = 8;
+
+    SetDefaultState();
+
+    initialized = true;
+}
+
+void NullRHI::Shutdown() {
+    BE_LOG(L"Shutting down Null Renderer...\n");
+
+    initialized = false;
+
+    SAFE_DELETE(mainContext->state);
+    SAFE_DELETE(mainContext);
+
+    currentContext = nullptr;
+
+    FreeHandles();
+}
+
+void NullRHI::InitHandles() {
+    contextList.SetGranularity(16);
+    NullRHIContext *zeroContext = new NullRHIContext;
+    memset(zeroContext, 0, sizeof(*zeroContext));
+    contextList.Append(zeroContext);
+
+    stencilStateList.SetGranularity(32);
+    NullRHIStencilState *zeroStencilState = new NullRHIStencilState;
+    memset(zeroStencilState, 0, sizeof(*zeroStencilState));
+    stencilStateList.Append(zeroStencilState);
+
+    bufferList.SetGranularity(1024);
+    NullRHIBuffer *zeroBuffer = new NullRHIBuffer;
+    memset(zeroBuffer, 0, sizeof(*zeroBuffer));
+    bufferList.Append(zeroBuffer);
+
+    syncList.SetGranularity(8);
+    NullRHISync *zeroSync = new NullRHISync;
+    memset(zeroSync, 0, sizeof(*zeroSync));
+    syncList.Append(zeroSync);
+
+    textureList.SetGranularity(1024);
+    NullRHITexture *zeroTexture = new NullRHITexture;
+    memset(zeroTexture, 0, sizeof(*zeroTexture));
+    textureList.Append(zeroTexture);
+
+    shaderList.SetGranularity(1024);
+    NullRHIShader *zeroShader = new NullRHIShader;
+    memset(zeroShader, 0, sizeof(*zeroShader));
+    shaderList.Append(zeroShader);
+
+    vertexFormatList.SetGranularity(64);
+    NullRHIVertexFormat *zeroVertexFormat = new NullRHIVertexFormat;
+    memset(zeroVertexFormat, 0, sizeof(*zeroVertexFormat));
+    vertexFormatList.Append(zeroVertexFormat);
+
+    renderTargetList.SetGranularity(64);
+    NullRHIRenderTarget *zeroRenderTarget = new NullRHIRenderTarget;
+    memset(zeroRenderTarget, 0, sizeof(*zeroRenderTarget));
+    renderTargetList.Append(zeroRenderTarget);
+
+    queryList.SetGranularity(32);
+    NullRHIQuery *zeroQuery = new NullRHIQuery;
+    memset(zeroQuery, 0, sizeof(*zeroQuery));
+    queryList.Append(zeroQuery);
+}
+
+void NullRHI::FreeHandles() {
+    for (int i = 0; i < bufferList.Count(); i++) {
+        if (bufferList[i]) {
+            Mem_AlignedFree(bufferList[i]->data);
+        }
+    }
+
+    contextList.DeleteContents(true);
+    stencilStateList.DeleteContents(true);
+    bufferList.DeleteContents(true);
+    syncList.DeleteContents(true);
+    textureList.DeleteContents(true);
+    shaderList.DeleteContents(true);
+    vertexFormatList.DeleteContents(true);
+    renderTargetList.DeleteContents(true);
+    queryList.DeleteContents(true);
+}
+
+bool NullRHI::SupportsPolygonMode() const {
+    return true;
+}
+
+bool NullRHI::SupportsPackedFloat() const {
+    return true;
+}
+
+bool NullRHI::SupportsDepthBufferFloat() const {
+    return true;
+}
+
+bool NullRHI::SupportsPixelBufferObject() const {
+    return true;
+}
+
+bool NullRHI::SupportsTextureRectangle() const {
+    return true;
+}
+
+bool NullRHI::SupportsTextureArray() const {
+    return true;
+}
+
+bool NullRHI::SupportsTextureBufferObject() const {
+    return true;
+}
+
+// Textures are kept in the source format, so no compression is needed
+bool NullRHI::SupportsTextureCompressionS3TC() const {
+    return false;
+}
+
+bool NullRHI::SupportsTextureCompressionLATC() const {
+    return false;
+}
+
+bool NullRHI::SupportsTextureCompressionETC2() const {
+    return false;
+}
+
+bool NullRHI::SupportsDebugLabel() const {
+    return false;
+}
+
+bool NullRHI::SupportsTimestampQuery() const {
+    return false;
+}
+
+bool NullRHI::SupportsUniformBuffer() const {
+    return true;
+}
+
+bool NullRHI::SupportsBufferStorage() const {
+    return true;
+}
+
+RHI::Handle NullRHI::CreateContext(RHI::WindowHandle windowHandle, bool useSharedContext) {
+    NullRHIContext *ctx = new NullRHIContext;
+    memset(ctx, 0, sizeof(*ctx));
+
+    int handle = contextList.FindNull();
+    if (handle == -1) {
+        handle = contextList.Append(ctx);
+    } else {
+        contextList[handle] = ctx;
+    }
+
+    ctx->handle = (Handle)handle;
+    ctx->windowHandle = windowHandle;
+    ctx->state = useSharedContext ? new NullRHIState : mainContext->state;
+
+    SetContext((Handle)handle);
+
+    SetDefaultState();
+
+    return (Handle)handle;
+}
+
+void NullRHI::DestroyContext(Handle ctxHandle) {
+    NullRHIContext *ctx = contextList[ctxHandle];
+
+    if (ctx->state != mainContext->state) {
+        delete ctx->state;
+    }
+
+    if (currentContext == ctx) {
+        currentContext = mainContext;
+    }
+
+    delete ctx;
+    contextList[ctxHandle] = nullptr;
+}
+
+void NullRHI::SetContext(Handle ctxHandle) {
+    currentContext = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
+}
+
+void NullRHI::ReleaseContext() {
+}
+
+void NullRHI::SetContextDisplayFunc(Handle ctxHandle, DisplayContextFunc displayFunc, void *displayFuncDataPtr, bool onDemandDrawing) {
+    NullRHIContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
+
+    ctx->displayFunc = displayFunc;
+    ctx->displayFuncDataPtr = displayFuncDataPtr;
+    ctx->onDemandDrawing = onDemandDrawing;
+}
+
+void NullRHI::DisplayContext(Handle ctxHandle) {
+    NullRHIContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
+
+    if (ctx->displayFunc) {
+        ctx->displayFunc(ctxHandle, ctx->displayFuncDataPtr);
+    }
+}
+
+RHI::WindowHandle NullRHI::GetWindowHandleFromContext(Handle ctxHandle) {
+    const NullRHIContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
+    return ctx->windowHandle;
+}
+
+void NullRHI::GetContextSize(Handle ctxHandle, int *windowWidth, int *windowHeight, int *backingWidth, int *backingHeight) {
+    if (windowWidth) {
+        *windowWidth = null_screenWidth.GetInteger();
+    }
+    if (windowHeight) {
+        *windowHeight = null_screenHeight.GetInteger();
+    }
+    if (backingWidth) {
+        *backingWidth = null_screenWidth.GetInteger();
+    }
+    if (backingHeight) {
+        *backingHeight = null_screenHeight.GetInteger();
+    }
+}
+
+bool NullRHI::IsFullscreen() const {
+    return false;
+}
+
+bool NullRHI::SetFullscreen(Handle ctxHandle, int width, int height) {
+    return false;
+}
+
+void NullRHI::ResetFullscreen(Handle ctxHandle) {
+}
+
+void NullRHI::GetGammaRamp(unsigned short ramp[768]) const {
+    // Identity ramp
+    for (int i = 0; i < 256; i++) {
+        ramp[i] = ramp[i + 256] = ramp[i + 512] = (unsigned short)(i * 257);
+    }
+}
+
+void NullRHI::SetGammaRamp(unsigned short ramp[768]) const {
+}
+
+void NullRHI::SwapBuffers() const {
+}
+
+void NullRHI::SwapInterval(int interval) const {
+}
+
+void NullRHI::Clear(int clearBits, const Color4 &color, float depth, unsigned int stencil) {
+}
+
+void NullRHI::ReadPixels(int x, int y, int width, int height, Image::Format imageFormat, byte *data) {
+    memset(data, 0, Image::MemRequired(width, height, 1, 1, imageFormat));
+}
+
+void NullRHI::DrawArrays(Primitive primitives, const int startVertex, const int numVerts) const {
+    counter.drawCalls++;
+}
+
+void NullRHI::DrawArraysInstanced(Primitive primitives, const int startVertex, const int numVerts, const int primCount) const {
+    counter.drawCalls++;
+}
+
+void NullRHI::DrawElements(Primitive primitives, const int startIndex, const int numIndices, const int indexSize, const void *ptr) const {
+    counter.drawCalls++;
+}
+
+void NullRHI::DrawElementsInstanced(Primitive primitives, const int startIndex, const int numIndices, const int indexSize, const void *ptr, const int primCount) const {
+    counter.drawCalls++;
+}
+
+void NullRHI::CheckError(const char *fmt, ...) const {
+}
+
+RHI::Handle NullRHI::CreateVertexFormat(int numElements, const VertexElement *elements) {
+    NullRHIVertexFormat *vertexFormat = new NullRHIVertexFormat;
+    vertexFormat->numElements = numElements;
+
+    int handle = vertexFormatList.FindNull();
+    if (handle == -1) {
+        handle = vertexFormatList.Append(vertexFormat);
+    } else {
+        vertexFormatList[handle] = vertexFormat;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DeleteVertexFormat(Handle vertexFormatHandle) {
+    if (currentContext->state->vertexFormatHandle == vertexFormatHandle) {
+        SetVertexFormat(NullVertexFormat);
+    }
+
+    delete vertexFormatList[vertexFormatHandle];
+    vertexFormatList[vertexFormatHandle] = nullptr;
+}
+
+void NullRHI::SetVertexFormat(Handle vertexFormatHandle) {
+    currentContext->state->vertexFormatHandle = vertexFormatHandle;
+}
+
+void NullRHI::SetStreamSource(int stream, Handle vertexBufferHandle, int base, int stride) {
+    BindBuffer(VertexBuffer, vertexBufferHandle);
+}
+
+RHI::Handle NullRHI::CreateQuery() {
+    NullRHIQuery *query = new NullRHIQuery;
+    query->resultSamples = 0;
+
+    int handle = queryList.FindNull();
+    if (handle == -1) {
+        handle = queryList.Append(query);
+    } else {
+        queryList[handle] = query;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DeleteQuery(Handle queryHandle) {
+    delete queryList[queryHandle];
+    queryList[queryHandle] = nullptr;
+}
+
+void NullRHI::BeginQuery(Handle queryHandle) {
+    // Nothing is rasterized, so every query passes to keep the same work as all visible
+    queryList[queryHandle]->resultSamples = 1;
+}
+
+void NullRHI::EndQuery() {
+}
+
+bool NullRHI::QueryResultAvailable(Handle queryHandle) const {
+    return true;
+}
+
+unsigned int NullRHI::QueryResult(Handle queryHandle) const {
+    return queryList[queryHandle]->resultSamples;
+}
+
+void NullRHI::QueryTimestamp(Handle queryHandle) {
+}
+
+uint64_t NullRHI::QueryTimestampResult(Handle queryHandle) const {
+    return 0;
+}
+
+bool NullRHI::QueryTimerDisjoint() {
+    return false;
+}
+
+RHI::Handle NullRHI::FenceSync() {
+    NullRHISync *sync = new NullRHISync;
+    sync->signaled = true;
+
+    int handle = syncList.FindNull();
+    if (handle == -1) {
+        handle = syncList.Append(sync);
+    } else {
+        syncList[handle] = sync;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DeleteSync(Handle syncHandle) {
+    delete syncList[syncHandle];
+    syncList[syncHandle] = nullptr;
+}
+
+void NullRHI::WaitSync(Handle syncHandle) {
+}
+
+BE_NAMESPACE_END
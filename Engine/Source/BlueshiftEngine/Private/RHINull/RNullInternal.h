@@ -0,0 +1,112 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Core/CVars.h"
+
+BE_NAMESPACE_BEGIN
+
+struct NullRHIState {
+    int                 tmu; // current texture map unit
+    RHI::Handle         textureHandles[RHI::MaxTMU];
+    RHI::Handle         shaderHandle;
+    RHI::Handle         bufferHandles[RHI::MaxBufferTypes];
+    RHI::Handle         vertexFormatHandle;
+    RHI::Handle         renderTargetHandle;
+    RHI::Handle         renderTargetHandleStack[16];
+    int                 renderTargetHandleStackDepth;
+    RHI::Handle         stencilStateHandle;
+    unsigned int        renderState;
+    int                 cull;
+    Rect                viewportRect;
+    Rect                scissorRect;
+    float               lineWidth;
+};
+
+struct NullRHIContext {
+    RHI::Handle         handle;
+    RHI::WindowHandle   windowHandle;
+    RHI::DisplayContextFunc displayFunc;
+    void *              displayFuncDataPtr;
+    bool                onDemandDrawing;
+    NullRHIState *      state;
+};
+
+struct NullRHIStencilState {
+    int                 readMask;
+    int                 writeMask;
+};
+
+struct NullRHITexture {
+    RHI::TextureType    type;
+    int                 width;
+    int                 height;
+    int                 depth;
+    Image::Format       format;
+};
+
+struct NullRHIBuffer {
+    RHI::BufferType     type;
+    byte *              data;       // system memory copy of the buffer
+    int                 size;
+    int                 pitch;
+    int                 writeOffset;
+};
+
+struct NullRHISync {
+    bool                signaled;
+};
+
+struct NullRHIShaderVariable {
+    bool                operator==(const NullRHIShaderVariable &other) const { return Str::Cmp(name, other.name) == 0; }
+    bool                operator<(const NullRHIShaderVariable &other) const { return Str::Cmp(name, other.name) < 0; }
+    bool                operator>(const NullRHIShaderVariable &other) const { return Str::Cmp(name, other.name) > 0; }
+
+    char *              name;
+    int                 index;      // texture unit for the samplers
+};
+
+struct NullRHIShader {
+    char                name[64];
+    int                 numSamplers;
+    NullRHIShaderVariable *samplers;
+    int                 numUniforms;
+    NullRHIShaderVariable *uniforms;
+    int                 numUniformBlocks;
+    NullRHIShaderVariable *uniformBlocks;
+};
+
+struct NullRHIVertexFormat {
+    int                 numElements;
+};
+
+struct NullRHIRenderTarget {
+    RHI::RenderTargetType type;
+    int                 width;
+    int                 height;
+    int                 numColorTextures;
+    RHI::Handle         colorTextureHandles[16];
+    RHI::Handle         depthTextureHandle;
+    int                 flags;
+};
+
+struct NullRHIQuery {
+    unsigned int        resultSamples;
+};
+
+extern CVar             null_screenWidth;
+extern CVar             null_screenHeight;
+
+BE_NAMESPACE_END
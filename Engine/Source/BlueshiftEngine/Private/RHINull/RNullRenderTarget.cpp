@@ -0,0 +1,80 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+RHI::Handle NullRHI::CreateRenderTarget(RenderTargetType type, int width, int height, int numColorTextures, Handle *colorTextureHandles, Handle depthTextureHandle, bool sRGB, int flags) {
+    NullRHIRenderTarget *renderTarget = new NullRHIRenderTarget;
+    renderTarget->type = type;
+    renderTarget->width = width;
+    renderTarget->height = height;
+    renderTarget->flags = flags;
+    renderTarget->numColorTextures = numColorTextures;
+    for (int i = 0; i < numColorTextures; i++) {
+        renderTarget->colorTextureHandles[i] = colorTextureHandles[i];
+    }
+    renderTarget->depthTextureHandle = depthTextureHandle;
+
+    int handle = renderTargetList.FindNull();
+    if (handle == -1) {
+        handle = renderTargetList.Append(renderTarget);
+    } else {
+        renderTargetList[handle] = renderTarget;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DeleteRenderTarget(Handle renderTargetHandle) {
+    if (renderTargetHandle == NullRenderTarget) {
+        BE_WARNLOG(L"NullRHI::DeleteRenderTarget: invalid render target\n");
+        return;
+    }
+
+    if (currentContext->state->renderTargetHandleStackDepth > 0 && 
+        currentContext->state->renderTargetHandleStack[currentContext->state->renderTargetHandleStackDepth - 1] == renderTargetHandle) {
+        BE_WARNLOG(L"NullRHI::DeleteRenderTarget: render target is using\n");
+        return;
+    }
+
+    delete renderTargetList[renderTargetHandle];
+    renderTargetList[renderTargetHandle] = nullptr;
+}
+
+void NullRHI::BeginRenderTarget(Handle renderTargetHandle, int level, int sliceIndex, unsigned int mrtBitMask) {
+    if (currentContext->state->renderTargetHandleStackDepth > 0 && currentContext->state->renderTargetHandleStack[currentContext->state->renderTargetHandleStackDepth - 1] == renderTargetHandle) {
+        BE_WARNLOG(L"NullRHI::BeginRenderTarget: same render target\n");
+    }
+
+    currentContext->state->renderTargetHandleStack[currentContext->state->renderTargetHandleStackDepth++] = currentContext->state->renderTargetHandle;
+    currentContext->state->renderTargetHandle = renderTargetHandle;
+}
+
+void NullRHI::EndRenderTarget() {
+    if (currentContext->state->renderTargetHandleStackDepth == 0) {
+        BE_WARNLOG(L"unmatched BeginRenderTarget() / EndRenderTarget()\n");
+        return;
+    }
+
+    currentContext->state->renderTargetHandle = currentContext->state->renderTargetHandleStack[--currentContext->state->renderTargetHandleStackDepth];
+}
+
+void NullRHI::BlitRenderTarget(Handle srcRenderTargetHandle, const Rect &srcRect, Handle dstRenderTargetHandle, const Rect &dstRect, int mask, int filter) const {
+}
+
+BE_NAMESPACE_END
@@ -0,0 +1,381 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Core/Heap.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+#include "Containers/BinSearch.h"
+
+BE_NAMESPACE_BEGIN
+
+static int CompareShaderVariable(const void *p0, const void *p1) {
+    return Str::Cmp(((NullRHIShaderVariable *)p0)->name, ((NullRHIShaderVariable *)p1)->name);
+}
+
+static const char *SkipWhiteSpaceAndComments(const char *p) {
+    while (*p) {
+        if (*p == '/' && p[1] == '/') {
+            while (*p && *p != '\n') {
+                p++;
+            }
+        } else if (*p == '/' && p[1] == '*') {
+            p += 2;
+            while (*p && !(*p == '*' && p[1] == '/')) {
+                p++;
+            }
+            if (*p) {
+                p += 2;
+            }
+        } else if (*p <= ' ') {
+            p++;
+        } else {
+            break;
+        }
+    }
+    return p;
+}
+
+// Reads an identifier, a number or a single punctuation character
+static const char *ReadToken(const char *p, Str &token) {
+    p = SkipWhiteSpaceAndComments(p);
+
+    const char *start = p;
+    if (isalnum((unsigned char)*p) || *p == '_') {
+        while (isalnum((unsigned char)*p) || *p == '_') {
+            p++;
+        }
+    } else if (*p) {
+        p++;
+    }
+
+    token.Clear();
+    token.Append(start, (int)(p - start));
+    return p;
+}
+
+static bool IsPrecisionQualifier(const Str &token) {
+    return token == "lowp" || token == "mediump" || token == "highp";
+}
+
+static bool IsSamplerType(const Str &token) {
+    return !Str::Cmpn(token, "sampler", 7) || !Str::Cmpn(token, "isampler", 8) || !Str::Cmpn(token, "usampler", 8);
+}
+
+// There is no driver to reflect active uniforms, so uniform declarations are scanned from the shader source.
+// Declarations in inactive preprocessor branches are also collected, which only makes the lists a superset.
+static void ParseUniforms(const char *text, Array<Str> &samplerNames, Array<Str> &uniformNames, Array<Str> &uniformBlockNames) {
+    Str token;
+    Str typeName;
+    Str varName;
+
+    const char *p = text;
+    while (*p) {
+        p = ReadToken(p, token);
+        if (token != "uniform") {
+            continue;
+        }
+
+        do {
+            p = ReadToken(p, typeName);
+        } while (IsPrecisionQualifier(typeName));
+
+        p = ReadToken(p, token);
+        if (token == "{") {
+            // Uniform block, members are accessed through the block
+            uniformBlockNames.AddUnique(typeName);
+
+            int depth = 1;
+            while (*p && depth > 0) {
+                p = ReadToken(p, token);
+                if (token == "{") {
+                    depth++;
+                } else if (token == "}") {
+                    depth--;
+                }
+            }
+            continue;
+        }
+
+        bool isSampler = IsSamplerType(typeName);
+        varName = token;
+
+        while (*p) {
+            int arraySize = 0;
+
+            p = ReadToken(p, token);
+            if (token == "[") {
+                p = ReadToken(p, token);
+                arraySize = token.IsNumeric() ? Max(atoi(token.c_str()), 1) : 1;
+                while (*p && token != "]") {
+                    p = ReadToken(p, token);
+                }
+                p = ReadToken(p, token);
+            }
+
+            if (Str::Cmpn(varName, "gl_", 3)) {
+                if (isSampler) {
+                    if (arraySize > 0) {
+                        for (int i = 0; i < arraySize; i++) {
+                            samplerNames.AddUnique(Str(va("%s[%i]", varName.c_str(), i)));
+                        }
+                    } else {
+                        samplerNames.AddUnique(varName);
+                    }
+                } else {
+                    uniformNames.AddUnique(varName);
+                }
+            }
+
+            if (token != ",") {
+                break;
+            }
+
+            p = ReadToken(p, varName);
+        }
+    }
+}
+
+static NullRHIShaderVariable *AllocShaderVariables(const Array<Str> &names) {
+    if (names.Count() == 0) {
+        return nullptr;
+    }
+
+    NullRHIShaderVariable *variables = (NullRHIShaderVariable *)Mem_Alloc(sizeof(NullRHIShaderVariable) * names.Count());
+    for (int i = 0; i < names.Count(); i++) {
+        variables[i].name = Mem_AllocString(names[i].c_str());
+        variables[i].index = i;
+    }
+
+    // binary search 를 위해 정렬
+    qsort(variables, names.Count(), sizeof(variables[0]), CompareShaderVariable);
+
+    return variables;
+}
+
+RHI::Handle NullRHI::CreateShader(const char *name, const char *vsText, const char *fsText) {
+    Array<Str> samplerNames;
+    Array<Str> uniformNames;
+    Array<Str> uniformBlockNames;
+
+    ParseUniforms(vsText, samplerNames, uniformNames, uniformBlockNames);
+    ParseUniforms(fsText, samplerNames, uniformNames, uniformBlockNames);
+
+    NullRHIShader *shader = new NullRHIShader;
+    Str::Copynz(shader->name, name, COUNT_OF(shader->name));
+    shader->numSamplers     = samplerNames.Count();
+    shader->samplers        = AllocShaderVariables(samplerNames); // index is TMU
+    shader->numUniforms     = uniformNames.Count();
+    shader->uniforms        = AllocShaderVariables(uniformNames);
+    shader->numUniformBlocks = uniformBlockNames.Count();
+    shader->uniformBlocks   = AllocShaderVariables(uniformBlockNames);
+
+    int handle = shaderList.FindNull();
+    if (handle == -1) {
+        handle = shaderList.Append(shader);
+    } else {
+        shaderList[handle] = shader;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DeleteShader(Handle shaderHandle) {
+    if (currentContext->state->shaderHandle == shaderHandle) {
+        BindShader(NullShader);
+    }
+
+    NullRHIShader *shader = shaderList[shaderHandle];
+    for (int i = 0; i < shader->numSamplers; i++) {
+        Mem_Free(shader->samplers[i].name);
+    }
+    for (int i = 0; i < shader->numUniforms; i++) {
+        Mem_Free(shader->uniforms[i].name);
+    }
+    for (int i = 0; i < shader->numUniformBlocks; i++) {
+        Mem_Free(shader->uniformBlocks[i].name);
+    }
+    Mem_Free(shader->samplers);
+    Mem_Free(shader->uniforms);
+    Mem_Free(shader->uniformBlocks);
+
+    delete shader;
+    shaderList[shaderHandle] = nullptr;
+}
+
+void NullRHI::BindShader(Handle shaderHandle) {
+    currentContext->state->shaderHandle = shaderHandle;
+}
+
+int NullRHI::GetSamplerUnit(Handle shaderHandle, const char *name) const {
+    const NullRHIShader *shader = shaderList[shaderHandle];
+    NullRHIShaderVariable find;
+    find.name = const_cast<char *>(name);
+    int index = BinSearch_Equal<NullRHIShaderVariable>(shader->samplers, shader->numSamplers, find);
+    if (index >= 0) {
+        return shader->samplers[index].index;
+    }
+    return -1;
+}
+
+void NullRHI::SetTexture(int unit, Handle textureHandle) {
+    SelectTextureUnit(unit);
+    BindTexture(textureHandle);
+}
+
+int NullRHI::GetShaderConstantLocation(int shaderHandle, const char *name) const {
+    const NullRHIShader *shader = shaderList[shaderHandle];
+    NullRHIShaderVariable find;
+    find.name = const_cast<char *>(name);
+    return BinSearch_Equal<NullRHIShaderVariable>(shader->uniforms, shader->numUniforms, find);
+}
+
+int NullRHI::GetShaderConstantBlockIndex(int shaderHandle, const char *name) const {
+    const NullRHIShader *shader = shaderList[shaderHandle];
+    NullRHIShaderVariable find;
+    find.name = const_cast<char *>(name);
+    return BinSearch_Equal<NullRHIShaderVariable>(shader->uniformBlocks, shader->numUniformBlocks, find);
+}
+
+void NullRHI::SetShaderConstantBlock(int index, Handle bufferHandle, int offset) {
+    if (index < 0) {
+        return;
+    }
+
+    currentContext->state->bufferHandles[UniformBuffer] = bufferHandle;
+
+    counter.constantBlockBinds++;
+}
+
+void NullRHI::SetShaderConstantGeneric(int index, int count) const {
+    if (index < 0) {
+        return;
+    }
+
+    counter.shaderConstantCalls++;
+}
+
+void NullRHI::SetShaderConstant1i(int index, const int constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant2i(int index, const int *constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant3i(int index, const int *constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant4i(int index, const int *constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant1f(int index, const float constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant2f(int index, const float *constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant3f(int index, const float *constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant4f(int index, const float *constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant2f(int index, const Vec2 &constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant3f(int index, const Vec3 &constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant4f(int index, const Vec4 &constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant2x2f(int index, bool rowmajor, const Mat2 &constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant3x3f(int index, bool rowmajor, const Mat3 &constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstant4x4f(int index, bool rowmajor, const Mat4 &constant) const {
+    SetShaderConstantGeneric(index, 1);
+}
+
+void NullRHI::SetShaderConstantArray1i(int index, int count, const int *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray2i(int index, int count, const int *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray3i(int index, int count, const int *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray4i(int index, int count, const int *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray1f(int index, int count, const float *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray2f(int index, int count, const float *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray3f(int index, int count, const float *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray4f(int index, int count, const float *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray2f(int index, int count, const Vec2 *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray3f(int index, int count, const Vec3 *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray4f(int index, int count, const Vec4 *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray2x2f(int index, bool rowmajor, int count, const Mat2 *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray3x3f(int index, bool rowmajor, int count, const Mat3 *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+void NullRHI::SetShaderConstantArray4x4f(int index, bool rowmajor, int count, const Mat4 *constant) const {
+    SetShaderConstantGeneric(index, count);
+}
+
+BE_NAMESPACE_END
@@ -0,0 +1,121 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+void NullRHI::SetDefaultState() {
+    memset(currentContext->state, 0, sizeof(NullRHIState));
+
+    currentContext->state->lineWidth = 1.0f;
+
+    SetStateBits(ColorWrite | AlphaWrite | DepthWrite | DF_LEqual);
+
+    SetCullFace(BackCull);
+}
+
+void NullRHI::SetStateBits(unsigned int stateBits) {
+    if (currentContext->state->renderState ^ stateBits) {
+        counter.stateChanges++;
+
+        currentContext->state->renderState = stateBits;
+    }
+}
+
+void NullRHI::SetCullFace(int cull) {
+    currentContext->state->cull = cull;
+}
+
+void NullRHI::SetDepthBias(float slopeScaleBias, float constantBias) {
+}
+
+void NullRHI::SetDepthRange(float znear, float zfar) {
+}
+
+void NullRHI::SetDepthClamp(bool enable) {
+}
+
+void NullRHI::SetDepthBounds(float zmin, float zmax) {
+}
+
+void NullRHI::SetViewport(const Rect &viewportRect) {
+    currentContext->state->viewportRect = viewportRect;
+}
+
+void NullRHI::SetScissor(const Rect &scissorRect) {
+    if (!scissorRect.IsEmpty()) {
+        currentContext->state->scissorRect = scissorRect;
+    } else {
+        currentContext->state->scissorRect.Set(0, 0, 0, 0);
+    }
+}
+
+void NullRHI::SetSRGBWrite(bool enable) {
+}
+
+void NullRHI::EnableLineSmooth(bool enable) {
+}
+
+float NullRHI::GetLineWidth() const {
+    return currentContext->state->lineWidth;
+}
+
+void NullRHI::SetLineWidth(float width) {
+    currentContext->state->lineWidth = width;
+}
+
+RHI::Handle NullRHI::CreateStencilState(int readMask, int writeMask, StencilFunc funcBack, int failBack, int zfailBack, int zpassBack, StencilFunc funcFront, int failFront, int zfailFront, int zpassFront) {
+    NullRHIStencilState *stencilState = new NullRHIStencilState;
+    stencilState->readMask  = readMask;
+    stencilState->writeMask = writeMask;
+
+    int handle = stencilStateList.FindNull();
+    if (handle == -1) {
+        handle = stencilStateList.Append(stencilState);
+    } else {
+        stencilStateList[handle] = stencilState;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DeleteStencilState(Handle stencilStateHandle) {
+    delete stencilStateList[stencilStateHandle];
+    stencilStateList[stencilStateHandle] = nullptr;
+}
+
+void NullRHI::SetStencilState(Handle stencilStateHandle, int ref) {
+    currentContext->state->stencilStateHandle = stencilStateHandle;
+}
+
+unsigned int NullRHI::GetStateBits() const {
+    return currentContext->state->renderState;
+}
+
+const Rect &NullRHI::GetViewport() const {
+    return currentContext->state->viewportRect;
+}
+
+int NullRHI::GetCullFace() const {
+    return currentContext->state->cull;
+}
+
+const Rect &NullRHI::GetScissor() const {
+    return currentContext->state->scissorRect;
+}
+
+BE_NAMESPACE_END
@@ -0,0 +1,182 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "RHI/RHINull.h"
+#include "RNullInternal.h"
+
+BE_NAMESPACE_BEGIN
+
+RHI::Handle NullRHI::CreateTexture(TextureType type) {
+    NullRHITexture *texture = new NullRHITexture;
+    texture->type   = type;
+    texture->width  = 0;
+    texture->height = 0;
+    texture->depth  = 0;
+    texture->format = Image::UnknownFormat;
+
+    int handle = textureList.FindNull();
+    if (handle == -1) {
+        handle = textureList.Append(texture);
+    } else {
+        textureList[handle] = texture;
+    }
+
+    return (Handle)handle;
+}
+
+void NullRHI::DeleteTexture(Handle textureHandle) {
+    for (int i = 0; i < MaxTMU; i++) {
+        if (currentContext->state->textureHandles[i] == textureHandle) {
+            currentContext->state->textureHandles[i] = NullTexture;
+        }
+    }
+
+    delete textureList[textureHandle];
+    textureList[textureHandle] = nullptr;
+}
+
+void NullRHI::SelectTextureUnit(unsigned int unit) {
+    assert(unit < MaxTMU);
+
+    currentContext->state->tmu = unit;
+}
+
+void NullRHI::BindTexture(Handle textureHandle) {
+    Handle *textureHandlePtr = &currentContext->state->textureHandles[currentContext->state->tmu];
+    if (*textureHandlePtr != textureHandle) {
+        *textureHandlePtr = textureHandle;
+
+        counter.textureBinds++;
+    }
+}
+
+void NullRHI::AdjustTextureSize(TextureType type, bool useNPOT, int inWidth, int inHeight, int inDepth, int *outWidth, int *outHeight, int *outDepth) {
+    int w, h, d;
+
+    if (useNPOT || type == TextureRectangle) {
+        w = inWidth;
+        h = inHeight;
+        d = inDepth;
+    } else {
+        w = Math::CeilPowerOfTwo(inWidth);
+        h = Math::CeilPowerOfTwo(inHeight);
+        d = Math::CeilPowerOfTwo(inDepth);
+    }
+
+    int maxSize;
+    switch (type) {
+    case Texture3D:
+        maxSize = hwLimit.max3dTextureSize;
+        break;
+    case TextureCubeMap:
+        maxSize = hwLimit.maxCubeMapTextureSize;
+        w = h = Min(w, h);
+        break;
+    case TextureRectangle:
+        maxSize = hwLimit.maxRectangleTextureSize;
+        break;
+    default:
+        maxSize = hwLimit.maxTextureSize;
+        break;
+    }
+
+    if (outWidth) *outWidth = Min(w, maxSize);
+    if (outHeight) *outHeight = Min(h, maxSize);
+    if (outDepth) *outDepth = type == Texture3D ? Min(d, maxSize) : d;
+}
+
+void NullRHI::AdjustTextureFormat(TextureType type, bool useCompression, bool useNormalMap, Image::Format inFormat, Image::Format *outFormat) {
+    *outFormat = inFormat;
+}
+
+void NullRHI::SetTextureFilter(TextureFilter filter) {
+}
+
+void NullRHI::SetTextureAddressMode(AddressMode addressMode) {
+}
+
+void NullRHI::SetTextureAnisotropy(int aniso) {
+}
+
+void NullRHI::SetTextureBorderColor(const Color4 &rgba) {
+}
+
+void NullRHI::SetTextureShadowFunc(bool set) {
+}
+
+void NullRHI::SetTextureLODBias(float bias) {
+}
+
+void NullRHI::SetTextureLevel(int baseLevel, int maxLevel) {
+}
+
+void NullRHI::GenerateMipmap() {
+}
+
+void NullRHI::SetTextureImage(TextureType textureType, const Image *srcImage, Image::Format dstFormat, bool useMipmaps, bool useSRGB) {
+    NullRHITexture *texture = textureList[currentContext->state->textureHandles[currentContext->state->tmu]];
+    texture->width  = srcImage->GetWidth();
+    texture->height = srcImage->GetHeight();
+    texture->depth  = srcImage->GetDepth();
+    texture->format = dstFormat;
+}
+
+void NullRHI::SetTextureImageBuffer(Image::Format dstFormat, bool sRGB, int bufferHandle) {
+    NullRHITexture *texture = textureList[currentContext->state->textureHandles[currentContext->state->tmu]];
+    texture->format = dstFormat;
+}
+
+void NullRHI::SetTextureSubImage2D(int level, int xoffset, int yoffset, int width, int height, Image::Format srcFormat, const void *pixels) {
+}
+
+void NullRHI::SetTextureSubImage3D(int level, int xoffset, int yoffset, int zoffset, int width, int height, int depth, Image::Format srcFormat, const void *pixels) {
+}
+
+void NullRHI::SetTextureSubImage2DArray(int level, int xoffset, int yoffset, int zoffset, int width, int height, int arrays, Image::Format srcFormat, const void *pixels) {
+}
+
+void NullRHI::SetTextureSubImageCube(CubeMapFace face, int level, int xoffset, int yoffset, int width, int height, Image::Format srcFormat, const void *pixels) {
+}
+
+void NullRHI::SetTextureSubImageRect(int xoffset, int yoffset, int width, int height, Image::Format srcFormat, const void *pixels) {
+}
+
+void NullRHI::CopyTextureSubImage2D(int xoffset, int yoffset, int x, int y, int width, int height) {
+}
+
+void NullRHI::GetTextureImage2D(int level, Image::Format format, void *pixels) {
+    const NullRHITexture *texture = textureList[currentContext->state->textureHandles[currentContext->state->tmu]];
+    int w = Max(texture->width >> level, 1);
+    int h = Max(texture->height >> level, 1);
+    memset(pixels, 0, Image::MemRequired(w, h, 1, 1, format));
+}
+
+void NullRHI::GetTextureImage3D(int level, Image::Format format, void *pixels) {
+    const NullRHITexture *texture = textureList[currentContext->state->textureHandles[currentContext->state->tmu]];
+    int w = Max(texture->width >> level, 1);
+    int h = Max(texture->height >> level, 1);
+    int d = Max(texture->depth >> level, 1);
+    memset(pixels, 0, Image::MemRequired(w, h, d, 1, format));
+}
+
+void NullRHI::GetTextureImageCube(CubeMapFace face, int level, Image::Format format, void *pixels) {
+    GetTextureImage2D(level, format, pixels);
+}
+
+void NullRHI::GetTextureImageRect(Image::Format format, void *pixels) {
+    GetTextureImage2D(0, format, pixels);
+}
+
+BE_NAMESPACE_END
@@ -37,6 +37,7 @@ bool OpenGLBase::supportsDebugLabel = false;
 bool OpenGLBase::supportsDebugMarker = false;
 bool OpenGLBase::supportsDebugOutput = false;
 bool OpenGLBase::supportsBufferStorage = false;
+bool OpenGLBase::supportsTimerQuery = false;
 
 void OpenGLBase::Init() {
 #ifdef GL_EXT_packed_float // 3.0
@@ -117,6 +118,14 @@ void OpenGLBase::Init() {
 
 #ifdef GL_ARB_buffer_storage
     supportsBufferStorage = gglext._GL_ARB_buffer_storage ? true : false;
+#endif
+
+#ifdef GL_ARB_timer_query // 3.3
+    supportsTimerQuery = gglext._GL_ARB_timer_query ? true : false;
+#endif
+
+#ifdef GL_EXT_disjoint_timer_query
+    supportsTimerQuery = gglext._GL_EXT_disjoint_timer_query ? true : false;
 #endif    
 }
 
@@ -286,13 +286,18 @@ public:
     static bool             SupportsDebugMarker() { return supportsDebugMarker; }
     static bool             SupportsDebugOutput() { return supportsDebugOutput; }
     static bool             SupportsBufferStorage() { return supportsBufferStorage; }
+    static bool             SupportsTimerQuery() { return supportsTimerQuery; }
     static bool             SupportsProgramBinary() { return false; }
+    static bool             SupportsUniformBuffer() { return false; }
     
     static void             PolygonMode(GLenum face, GLenum mode) {}
     static void             ClearDepth(GLdouble depth) {}
     static void             DepthRange(GLdouble znear, GLdouble zfar) {}
     static void             DrawBuffer(GLenum buffer) {}
     static void             BindDefaultFBO() { gglBindFramebuffer(GL_FRAMEBUFFER, 0); }
+    static void             QueryTimestamp(GLuint id) {}
+    static void             GetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params) { *params = 0; }
+    static bool             QueryTimerDisjoint() { return false; }
     
     static bool             ImageFormatToGLFormat(Image::Format imageFormat, bool isSRGB, GLenum *glFormat, GLenum *glType, GLenum *glInternal);
     static Image::Format    ToCompressedImageFormat(Image::Format inFormat, bool useNormalMap);
@@ -318,6 +323,7 @@ private:
     static bool             supportsDebugMarker;
     static bool             supportsDebugOutput;
     static bool             supportsBufferStorage;
+    static bool             supportsTimerQuery;
 };
 
 BE_NAMESPACE_END
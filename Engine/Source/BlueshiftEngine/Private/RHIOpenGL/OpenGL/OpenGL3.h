@@ -44,6 +44,7 @@ public:
     static bool             SupportsTextureCompressionLATC() { return true; }
     static bool             SupportsCompressedGenMipmaps() { return true; }
     static bool             SupportsProgramBinary() { return gglProgramBinary != nullptr; }
+    static bool             SupportsUniformBuffer() { return true; }
     
     static void             APIENTRY DebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam);
 
@@ -52,6 +53,8 @@ public:
     static void             DepthRange(GLdouble znear, GLdouble zfar) { gglDepthRange(znear, zfar); }
     static void             DrawBuffer(GLenum buffer) { gglDrawBuffer(buffer); }
     static void             TexBuffer(GLenum internalFormat, GLuint buffer) { gglTexBuffer(GL_TEXTURE_BUFFER, internalFormat, buffer); }
+    static void             QueryTimestamp(GLuint id) { gglQueryCounter(id, GL_TIMESTAMP); }
+    static void             GetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params) { gglGetQueryObjectui64v(id, pname, params); }
 
     static void             SetTextureSwizzling(GLenum target, Image::Format format);
     static bool             ImageFormatToGLFormat(Image::Format imageFormat, bool isSRGB, GLenum *glFormat, GLenum *glType, GLenum *glInternal);
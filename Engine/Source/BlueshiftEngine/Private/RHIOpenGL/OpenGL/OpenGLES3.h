@@ -75,12 +75,16 @@ public:
     static bool             SupportsTextureCompressionETC2() { return true; }
     static bool             SupportsCompressedGenMipmaps() { return false; }
     static bool             SupportsProgramBinary() { return gglProgramBinary != nullptr; }
+    static bool             SupportsUniformBuffer() { return true; }
 
     static void             PolygonMode(GLenum face, GLenum mode) { }
     static void             ClearDepth(GLdouble depth) { gglClearDepthf(depth); }
     static void             DepthRange(GLdouble znear, GLdouble zfar) { gglDepthRangef(znear, zfar); }
     static void             DrawBuffer(GLenum buffer) { gglDrawBuffers(1, &buffer); }
     static void             TexBuffer(GLenum internalFormat, GLuint buffer) { gglTexBufferEXT(GL_TEXTURE_BUFFER_EXT, internalFormat, buffer); }
+    static void             QueryTimestamp(GLuint id) { gglQueryCounterEXT(id, GL_TIMESTAMP_EXT); }
+    static void             GetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params) { gglGetQueryObjectui64vEXT(id, pname, params); }
+    static bool             QueryTimerDisjoint() { GLint disjoint = 0; gglGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint); return disjoint != 0; }
 
     static void             SetTextureSwizzling(GLenum target, Image::Format format);
     static bool             ImageFormatToGLFormat(Image::Format imageFormat, bool isSRGB, GLenum *glFormat, GLenum *glType, GLenum *glInternal);
@@ -142,7 +142,8 @@ void *OpenGLRHI::MapBufferRange(Handle bufferHandle, BufferLockMode lockMode, in
         if (OpenGL::SupportsBufferStorage()) {
             access |= (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
 
-            gglBufferStorage(buffer->target, size, 0, access);
+            // Storage flags don't accept the map-only bits like GL_MAP_UNSYNCHRONIZED_BIT
+            gglBufferStorage(buffer->target, size, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
         }
 #endif
         break;
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "Precompiled.h"
+#include "Core/Checksum_MD5.h"
 #include "Platform/PlatformFile.h"
 #include "RHI/RHIOpenGL.h"
 #include "RGLInternal.h"
@@ -39,6 +40,7 @@ OpenGLRHI::OpenGLRHI() {
     initialized = false;
     currentContext = nullptr;
     mainContext = nullptr;
+    memset(&counter, 0, sizeof(counter));
 }
 
 void OpenGLRHI::Init(const Settings *settings) {
@@ -55,7 +57,11 @@ void OpenGLRHI::Init(const Settings *settings) {
     SetDefaultState();
 
     if (OpenGL::SupportsProgramBinary()) {
-        GLShader::programCacheDir = "Cache/ProgramBinaryCache";
+        // Program binaries are only valid for the same GPU and driver, so each driver has its own cache directory
+        Str driverString = Str(vendorString) + rendererString + versionString;
+        uint32_t driverHash = MD5_BlockChecksum(driverString.c_str(), driverString.Length());
+
+        GLShader::programCacheDir = va("Cache/ProgramBinaryCache/%08x", driverHash);
 
         if (!PlatformFile::DirectoryExists(GLShader::programCacheDir)) {
             PlatformFile::CreateDirectoryTree(GLShader::programCacheDir);
@@ -237,6 +243,14 @@ void OpenGLRHI::InitGL() {
         BE_LOG(L"Maximum geometry output vertices: %i\n", hwLimit.maxGeometryOutputVertices);
     }
 
+    if (OpenGL::SupportsUniformBuffer()) {
+        gglGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &hwLimit.maxUniformBlockSize);
+        BE_LOG(L"Maximum uniform block size: %i\n", hwLimit.maxUniformBlockSize);
+
+        gglGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &hwLimit.uniformBufferOffsetAlignment);
+        BE_LOG(L"Uniform buffer offset alignment: %i\n", hwLimit.uniformBufferOffsetAlignment);
+    }
+
     // GL_ARB_framebuffer_object (3.0)
     gglGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &hwLimit.maxRenderBufferSize);
     gglGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &hwLimit.maxColorAttachments);	
@@ -345,6 +359,18 @@ bool OpenGLRHI::SupportsDebugLabel() const {
     return OpenGL::SupportsDebugLabel();
 }
 
+bool OpenGLRHI::SupportsTimestampQuery() const {
+    return OpenGL::SupportsTimerQuery();
+}
+
+bool OpenGLRHI::SupportsUniformBuffer() const {
+    return OpenGL::SupportsUniformBuffer();
+}
+
+bool OpenGLRHI::SupportsBufferStorage() const {
+    return OpenGL::SupportsBufferStorage();
+}
+
 void OpenGLRHI::Clear(int clearBits, const Color4 &color, float depth, unsigned int stencil) {
 #if 1
     if (clearBits & ColorBit) {
@@ -422,10 +448,14 @@ void OpenGLRHI::ReadPixels(int x, int y, int width, int height, Image::Format im
 
 void OpenGLRHI::DrawArrays(Primitive primitives, const int startVertex, const int numVerts) const {
     gglDrawArrays(toGLPrim[primitives], startVertex, numVerts);
+
+    counter.drawCalls++;
 }
 
 void OpenGLRHI::DrawArraysInstanced(Primitive primitives, const int startVertex, const int numVerts, const int primCount) const {
     gglDrawArraysInstanced(toGLPrim[primitives], startVertex, numVerts, primCount);
+
+    counter.drawCalls++;
 }
 
 void OpenGLRHI::DrawElements(Primitive primitives, const int startIndex, const int numIndices, const int indexSize, const void *ptr) const {
@@ -433,6 +463,8 @@ void OpenGLRHI::DrawElements(Primitive primitives, const int startIndex, const i
     int indexBufferHandle = currentContext->state->bufferHandles[IndexBuffer];
     const GLvoid *indices = indexBufferHandle != 0 ? BUFFER_OFFSET(indexSize * startIndex) : (byte *)ptr + indexSize * startIndex;
     gglDrawElements(toGLPrim[primitives], numIndices, indexType, indices);
+
+    counter.drawCalls++;
 }
 
 void OpenGLRHI::DrawElementsInstanced(Primitive primitives, const int startIndex, const int numIndices, const int indexSize, const void *ptr, const int primCount) const {
@@ -440,6 +472,8 @@ void OpenGLRHI::DrawElementsInstanced(Primitive primitives, const int startIndex
     int indexBufferHandle = currentContext->state->bufferHandles[IndexBuffer];
     const GLvoid *indices = indexBufferHandle != 0 ? BUFFER_OFFSET(indexSize * startIndex) : (byte *)ptr + indexSize * startIndex;
     gglDrawElementsInstanced(toGLPrim[primitives], numIndices, indexType, indices, primCount);
+
+    counter.drawCalls++;
 }
 
 extern "C" void CheckGLError(const char *msg);
@@ -179,6 +179,16 @@ struct GLUniform {
     int                 count;
 };
 
+struct GLUniformBlock {
+    bool                operator==(const GLUniformBlock &other) const { return Str::Cmp(name, other.name) == 0; }
+    bool                operator<(const GLUniformBlock &other) const { return Str::Cmp(name, other.name) < 0; }
+    bool                operator>(const GLUniformBlock &other) const { return Str::Cmp(name, other.name) > 0; }
+
+    char *              name;
+    GLuint              index;      // also used as the binding point
+    int                 size;       // data size in bytes
+};
+
 struct GLShader {
     char                name[64];
     GLuint              programObject;
@@ -186,6 +196,8 @@ struct GLShader {
     GLSampler *         samplers;
     int                 numUniforms;
     GLUniform *         uniforms;
+    int                 numUniformBlocks;
+    GLUniformBlock *    uniformBlocks;
     static Str          programCacheDir;
 };
 
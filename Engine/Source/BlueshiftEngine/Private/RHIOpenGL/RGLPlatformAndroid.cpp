@@ -380,6 +380,11 @@ void OpenGLRHI::SetContext(Handle ctxHandle) {
 	this->currentContext = ctx;
 }
 
+void OpenGLRHI::ReleaseContext() {
+    // Context is owned by the view on this platform
+    glFlush();
+}
+
 
 
 
@@ -372,6 +372,13 @@ void OpenGLRHI::SetContext(Handle ctxHandle) {
 	this->currentContext = ctx;
 }
 
+void OpenGLRHI::ReleaseContext() {
+    if ([EAGLContext currentContext]) {
+        glFlush();
+        [EAGLContext setCurrentContext:nil];
+    }
+}
+
 void OpenGLRHI::SetContextDisplayFunc(Handle ctxHandle, DisplayContextFunc displayFunc, void *dataPtr, bool onDemandDrawing) {
     GLContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
     
@@ -737,6 +737,13 @@ void OpenGLRHI::SetContext(Handle ctxHandle) {
 	this->currentContext = ctx;
 }
 
+void OpenGLRHI::ReleaseContext() {
+    if ([NSOpenGLContext currentContext]) {
+        glFlush();
+        [NSOpenGLContext clearCurrentContext];
+    }
+}
+
 void OpenGLRHI::SetContextDisplayFunc(Handle ctxHandle, DisplayContextFunc displayFunc, void *dataPtr, bool onDemandDrawing) {
     GLContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
     
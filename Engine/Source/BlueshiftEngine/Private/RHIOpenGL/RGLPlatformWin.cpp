@@ -633,6 +633,13 @@ void OpenGLRHI::SetContext(Handle ctxHandle) {
     this->currentContext = ctx;
 }
 
+void OpenGLRHI::ReleaseContext() {
+    if (wglGetCurrentContext()) {
+        gglFlush();
+        wglMakeCurrent(nullptr, nullptr);
+    }
+}
+
 void OpenGLRHI::SetContextDisplayFunc(Handle ctxHandle, DisplayContextFunc displayFunc, void *displayFuncDataPtr, bool onDemandDrawing) {
     GLContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
     
@@ -378,6 +378,11 @@ void OpenGLRHI::SetContext(Handle ctxHandle) {
 	this->currentContext = ctx;
 }
 
+void OpenGLRHI::ReleaseContext() {
+    // Context is owned by the view on this platform
+    glFlush();
+}
+
 void OpenGLRHI::SetContextDisplayFunc(Handle ctxHandle, DisplayContextFunc displayFunc, void *dataPtr, bool onDemandDrawing) {
     GLContext *ctx = ctxHandle == NullContext ? mainContext : contextList[ctxHandle];
     
@@ -59,6 +59,22 @@ bool OpenGLRHI::QueryResultAvailable(Handle queryHandle) const {
     return available ? true : false;
 }
 
+void OpenGLRHI::QueryTimestamp(Handle queryHandle) {
+    const GLQuery *query = queryList[queryHandle];
+    OpenGL::QueryTimestamp(query->id);
+}
+
+uint64_t OpenGLRHI::QueryTimestampResult(Handle queryHandle) const {
+    const GLQuery *query = queryList[queryHandle];
+    GLuint64 timestamp;
+    OpenGL::GetQueryObjectui64v(query->id, GL_QUERY_RESULT, &timestamp);
+    return timestamp;
+}
+
+bool OpenGLRHI::QueryTimerDisjoint() {
+    return OpenGL::QueryTimerDisjoint();
+}
+
 unsigned int OpenGLRHI::QueryResult(Handle queryHandle) const {
     const GLQuery *query = queryList[queryHandle];
     GLuint samples;
@@ -385,6 +385,10 @@ static int CompareSampler(const void *s0, const void *s1) {
     return strcmp(((GLSampler *)s0)->name, ((GLSampler *)s1)->name);
 }
 
+static int CompareUniformBlock(const void *s0, const void *s1) {
+    return strcmp(((GLUniformBlock *)s0)->name, ((GLUniformBlock *)s1)->name);
+}
+
 static int CompareUniform(const void *s0, const void *s1) {
     return strcmp(((GLUniform *)s0)->name, ((GLUniform *)s1)->name);
 }
@@ -565,6 +569,11 @@ static bool UseCachedProgram(const char *name, const uint32_t hash, GLuint progr
     }
 
     int fileSize = file->Size();
+    if (fileSize <= (int)(sizeof(uint32_t) + sizeof(GLenum))) {
+        delete file;
+        return false;
+    }
+
     byte *programBinary = (byte *)Mem_Alloc16(fileSize);
     file->Read(programBinary, fileSize);
     delete file;
@@ -684,18 +693,55 @@ RHI::Handle OpenGLRHI::CreateShader(const char *name, const char *vsText, const
                         *bracket = '\0';
                     }
 
-                    tempUniforms[numUniforms].name = Mem_AllocString(uniformName);
-                    tempUniforms[numUniforms].location = gglGetUniformLocation(programObject, uniformName);
-                    tempUniforms[numUniforms].type = type;
-                    tempUniforms[numUniforms].count = size;
+                    // Uniforms in the uniform blocks don't have location
+                    GLint location = gglGetUniformLocation(programObject, uniformName);
+                    if (location >= 0) {
+                        tempUniforms[numUniforms].name = Mem_AllocString(uniformName);
+                        tempUniforms[numUniforms].location = location;
+                        tempUniforms[numUniforms].type = type;
+                        tempUniforms[numUniforms].count = size;
 
-                    numUniforms++;
+                        numUniforms++;
+                    }
                 }
             }
         }
     }
     
-    gglUseProgram(0);
+    // Restore the bound program, shaders can be created while rendering
+    gglUseProgram(shaderList[currentContext->state->shaderHandle]->programObject);
+
+    GLint uniformBlockCount = 0;
+    GLUniformBlock *uniformBlocks = nullptr;
+
+    if (OpenGL::SupportsUniformBuffer()) {
+        gglGetProgramiv(programObject, GL_ACTIVE_UNIFORM_BLOCKS, &uniformBlockCount);
+    }
+
+    if (uniformBlockCount > 0) {
+        uniformBlocks = (GLUniformBlock *)Mem_Alloc(sizeof(GLUniformBlock) * uniformBlockCount);
+
+        for (int i = 0; i < uniformBlockCount; i++) {
+            GLint nameLength;
+            gglGetActiveUniformBlockiv(programObject, i, GL_UNIFORM_BLOCK_NAME_LENGTH, &nameLength);
+
+            char *blockName = (char *)_alloca(nameLength + 1);
+            gglGetActiveUniformBlockName(programObject, i, nameLength + 1, nullptr, blockName);
+
+            GLint dataSize;
+            gglGetActiveUniformBlockiv(programObject, i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+
+            // Each block uses the binding point same as its index, so that binding point of the block is known without any query
+            gglUniformBlockBinding(programObject, i, i);
+
+            uniformBlocks[i].name = Mem_AllocString(blockName);
+            uniformBlocks[i].index = i;
+            uniformBlocks[i].size = dataSize;
+        }
+
+        // binary search 를 위해 정렬
+        qsort(uniformBlocks, uniformBlockCount, sizeof(uniformBlocks[0]), CompareUniformBlock);
+    }
 
     GLSampler *samplers = nullptr;
     GLUniform *uniforms = nullptr;
@@ -723,6 +769,8 @@ RHI::Handle OpenGLRHI::CreateShader(const char *name, const char *vsText, const
     shader->samplers        = samplers;
     shader->numUniforms     = numUniforms;
     shader->uniforms        = uniforms;
+    shader->numUniformBlocks = uniformBlockCount;
+    shader->uniformBlocks   = uniformBlocks;
 
     int handle = shaderList.FindNull();
     if (handle == -1) {
@@ -747,8 +795,12 @@ void OpenGLRHI::DeleteShader(Handle shaderHandle) {
     for (int i = 0; i < shader->numUniforms; i++) {
         Mem_Free(shader->uniforms[i].name);
     }
+    for (int i = 0; i < shader->numUniformBlocks; i++) {
+        Mem_Free(shader->uniformBlocks[i].name);
+    }
     Mem_Free(shader->samplers);
     Mem_Free(shader->uniforms);
+    Mem_Free(shader->uniformBlocks);
 
     delete shader;
     shaderList[shaderHandle] = nullptr;
@@ -793,6 +845,31 @@ int OpenGLRHI::GetShaderConstantLocation(int shaderHandle, const char *name) con
     return index;
 }
 
+int OpenGLRHI::GetShaderConstantBlockIndex(int shaderHandle, const char *name) const {
+    const GLShader *shader = shaderList[shaderHandle];
+    GLUniformBlock find;
+    find.name = const_cast<char *>(name);
+    return BinSearch_Equal<GLUniformBlock>(shader->uniformBlocks, shader->numUniformBlocks, find);
+}
+
+void OpenGLRHI::SetShaderConstantBlock(int index, Handle bufferHandle, int offset) {
+    if (index < 0) {
+        return;
+    }
+
+    const GLShader *shader = shaderList[currentContext->state->shaderHandle];
+    const GLUniformBlock *uniformBlock = &shader->uniformBlocks[index];
+    const GLBuffer *buffer = bufferList[bufferHandle];
+    assert(offset + uniformBlock->size <= buffer->size);
+
+    gglBindBufferRange(GL_UNIFORM_BUFFER, uniformBlock->index, buffer->object, offset, uniformBlock->size);
+
+    // glBindBufferRange also binds the buffer to the generic binding point
+    currentContext->state->bufferHandles[UniformBuffer] = bufferHandle;
+
+    counter.constantBlockBinds++;
+}
+
 void OpenGLRHI::SetShaderConstantGeneric(int index, bool rowmajor, int count, const void *data) const {	
     if (index < 0) {
         return;
@@ -800,6 +877,9 @@ void OpenGLRHI::SetShaderConstantGeneric(int index, bool rowmajor, int count, co
 
     const GLShader *shader = shaderList[currentContext->state->shaderHandle];
     GLUniform *uniform = &shader->uniforms[index];
+
+    counter.shaderConstantCalls++;
+
     switch (uniform->type) {
     case GL_FLOAT:
         gglUniform1fv(uniform->location, count, (const GLfloat *)data);
@@ -107,6 +107,8 @@ void OpenGLRHI::SetStateBits(unsigned int stateBits) {
     //state_delta = ~0;
     
     if (state_delta) {
+        counter.stateChanges++;
+
         // polygon mode
         if (OpenGL::SupportsPolygonMode() && (state_delta & MaskPM)) {
             bits = (stateBits & MaskPM);
@@ -158,6 +158,8 @@ void OpenGLRHI::BindTexture(Handle textureHandle) {
         gglBindTexture(target, texture->object);
 
         currentContext->state->textureHandles[currentContext->state->tmu] = textureHandle;
+
+        counter.textureBinds++;
     }
 }
 
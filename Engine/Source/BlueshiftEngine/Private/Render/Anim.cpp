@@ -17,13 +17,18 @@
 #include "Core/JointPose.h"
 #include "Simd/Simd.h"
 #include "Simd/Simd.h"
+#include "Core/Profiler.h"
 
 //#define CYCLIC_DELTA_MOVEMENT
 
 BE_NAMESPACE_BEGIN
 
+CVar Anim::anim_compress(L"anim_compress", L"0", CVar::Bool | CVar::Archive, L"compress uncompressed anims on load");
+CVar Anim::anim_compressMaxError(L"anim_compressMaxError", L"0.05", CVar::Float, L"maximum joint position error of compressed anims in units");
+
 size_t Anim::Allocated() const {
     size_t size = jointInfo.Allocated() + frameComponents.Allocated() + frameToTimeMap.Allocated() + timeToFrameMap.Allocated() + hashName.Allocated();
+    size += compressedTracks.Allocated() + compressedKeyFrames.Allocated() + compressedKeyValues.Allocated();
     return size;
 }
 
@@ -36,11 +41,15 @@ void Anim::Purge() {
     rootRotation = false;
     rootTranslationXY = false;
     rootTranslationZ = false;
+    isCompressed = false;
 
     totalDelta.SetFromScalar(0);
     
     jointInfo.Clear();
     frameComponents.Clear();
+    compressedTracks.Clear();
+    compressedKeyFrames.Clear();
+    compressedKeyValues.Clear();
     frameToTimeMap.Clear();
     timeToFrameMap.Clear();
 }
@@ -55,10 +64,14 @@ Anim &Anim::Copy(const Anim &other) {
     rootRotation = other.rootRotation;
     rootTranslationXY = other.rootTranslationXY;
     rootTranslationZ = other.rootTranslationZ;
+    isCompressed = other.isCompressed;
 
     jointInfo = other.jointInfo;
     baseFrame = other.baseFrame;
     frameComponents = other.frameComponents;
+    compressedTracks = other.compressedTracks;
+    compressedKeyFrames = other.compressedKeyFrames;
+    compressedKeyValues = other.compressedKeyValues;
     frameToTimeMap = other.frameToTimeMap;
     timeToFrameMap = other.timeToFrameMap;
     totalDelta = other.totalDelta;
@@ -91,6 +104,7 @@ void Anim::CreateDefaultAnim(const Skeleton *skeleton) {
         }
         jai->animBits = 0;
         jai->firstComponent = 0;
+        jai->firstTrack = -1;
     }
     
     baseFrame.SetGranularity(1);
@@ -113,6 +127,9 @@ Anim *Anim::CreateAdditiveAnim(const char *hashName, const JointPose *firstFrame
     Anim *additiveAnim = animManager.AllocAnim(hashName);
     additiveAnim->Copy(*this);
 
+    // Additive frames are written in the raw frame components
+    additiveAnim->Decompress();
+
     isAdditiveAnim = true;
 
     JointPose *jointFrame = (JointPose *)_alloca16(numJoints * sizeof(jointFrame[0]));
@@ -217,6 +234,8 @@ Anim *Anim::CreateAdditiveAnim(const Anim *refAnim, int numJointIndexes, const i
 }
 
 bool Anim::Load(const char *filename) {
+    BE_PROFILE_CPU_SCOPE("Anim::Load");
+
     Purge();
 
     Str bAnimFilename = filename;
@@ -233,6 +252,10 @@ bool Anim::Load(const char *filename) {
 
     isDefaultAnim = false;
     isAdditiveAnim = false;
+
+    if (anim_compress.GetBool() && !isCompressed) {
+        Compress(anim_compressMaxError.GetFloat());
+    }
     
     return ret;
 }
@@ -492,23 +515,27 @@ void Anim::GetTranslation(Vec3 &outTranslation, int time, bool cyclicTranslation
 
     TimeToFrameInterpolation(time, frame);
 
-    const float *componentPtr1 = &frameComponents[numAnimatedComponents * frame.frame1 + jointInfo[0].firstComponent];
-    const float *componentPtr2 = &frameComponents[numAnimatedComponents * frame.frame2 + jointInfo[0].firstComponent];
+    if (isCompressed) {
+        outTranslation = DecompressRootJoint(frame).t;
+    } else {
+        const float *componentPtr1 = &frameComponents[numAnimatedComponents * frame.frame1 + jointInfo[0].firstComponent];
+        const float *componentPtr2 = &frameComponents[numAnimatedComponents * frame.frame2 + jointInfo[0].firstComponent];
 
-    if (jointInfo[0].animBits & Tx) {
-        outTranslation.x = *componentPtr1 * frame.frontlerp + *componentPtr2 * frame.backlerp;
-        componentPtr1++;
-        componentPtr2++;
-    }
+        if (jointInfo[0].animBits & Tx) {
+            outTranslation.x = *componentPtr1 * frame.frontlerp + *componentPtr2 * frame.backlerp;
+            componentPtr1++;
+            componentPtr2++;
+        }
 
-    if (jointInfo[0].animBits & Ty) {
-        outTranslation.y = *componentPtr1 * frame.frontlerp + *componentPtr2 * frame.backlerp;
-        componentPtr1++;
-        componentPtr2++;
-    }
+        if (jointInfo[0].animBits & Ty) {
+            outTranslation.y = *componentPtr1 * frame.frontlerp + *componentPtr2 * frame.backlerp;
+            componentPtr1++;
+            componentPtr2++;
+        }
 
-    if (jointInfo[0].animBits & Tz) {
-        outTranslation.z = *componentPtr1 * frame.frontlerp + *componentPtr2 * frame.backlerp;
+        if (jointInfo[0].animBits & Tz) {
+            outTranslation.z = *componentPtr1 * frame.frontlerp + *componentPtr2 * frame.backlerp;
+        }
     }
 
     if (frame.cycleCount && cyclicTranslation) {
@@ -544,6 +571,11 @@ void Anim::GetRotation(Quat &outRotation, int time) const {
     FrameInterpolation frame;
     TimeToFrameInterpolation(time, frame);
 
+    if (isCompressed) {
+        outRotation = DecompressRootJoint(frame).q;
+        return;
+    }
+
     const float *componentPtr1 = &frameComponents[numAnimatedComponents * frame.frame1 + jointInfo[0].firstComponent];
     const float *componentPtr2 = &frameComponents[numAnimatedComponents * frame.frame2 + jointInfo[0].firstComponent];
 
@@ -652,6 +684,11 @@ void Anim::GetScaling(Vec3 &outScaling, int time) const {
     FrameInterpolation frame;
     TimeToFrameInterpolation(time, frame);
 
+    if (isCompressed) {
+        outScaling = DecompressRootJoint(frame).s;
+        return;
+    }
+
     const float *componentPtr1 = &frameComponents[numAnimatedComponents * frame.frame1 + jointInfo[0].firstComponent];
     const float *componentPtr2 = &frameComponents[numAnimatedComponents * frame.frame2 + jointInfo[0].firstComponent];
 
@@ -734,6 +771,21 @@ void Anim::GetAABB(AABB &outAabb, const Array<AABB> &frameAABBs, int time) const
 #endif
 }
 
+void Anim::ApplyRootMotionFlags(JointPose *joints) const {
+    if (!rootTranslationXY) {
+        joints[0].t.x = baseFrame[0].t.x;
+        joints[0].t.y = baseFrame[0].t.y;
+    }
+
+    if (!rootTranslationZ) {
+        joints[0].t.z = baseFrame[0].t.z;
+    }
+
+    if (!rootRotation) {
+        joints[0].q = baseFrame[0].q;
+    }
+}
+
 void Anim::GetSingleFrame(int frameNum, int numJointIndexes, const int *jointIndexes, JointPose *joints) const {
     // copy the baseframe
     simdProcessor->Memcpy(joints, baseFrame.Ptr(), baseFrame.Count() * sizeof(baseFrame[0]));
@@ -743,6 +795,12 @@ void Anim::GetSingleFrame(int frameNum, int numJointIndexes, const int *jointInd
         return;
     }
 
+    if (isCompressed) {
+        DecompressFrame(frameNum, 0.0f, numJointIndexes, jointIndexes, joints);
+        ApplyRootMotionFlags(joints);
+        return;
+    }
+
     const float *frame = &frameComponents[frameNum * numAnimatedComponents];
 
     for (int i = 0; i < numJointIndexes; i++) {
@@ -808,18 +866,7 @@ void Anim::GetSingleFrame(int frameNum, int numJointIndexes, const int *jointInd
     }
 #endif    
     
-    if (!rootTranslationXY) {
-        joints[0].t.x = baseFrame[0].t.x;
-        joints[0].t.y = baseFrame[0].t.y;
-    }
-
-    if (!rootTranslationZ) {
-        joints[0].t.z = baseFrame[0].t.z;
-    }
-
-    if (!rootRotation) {
-        joints[0].q = baseFrame[0].q;
-    }
+    ApplyRootMotionFlags(joints);
 }
 
 void Anim::GetInterpolatedFrame(FrameInterpolation &frame, int numJointIndexes, const int *jointIndexes, JointPose *joints) const {
@@ -831,6 +878,13 @@ void Anim::GetInterpolatedFrame(FrameInterpolation &frame, int numJointIndexes,
         return;
     }
 
+    if (isCompressed) {
+        // Keys are sampled at the interpolated time directly
+        DecompressFrame(frame.frame1, frame.backlerp, numJointIndexes, jointIndexes, joints);
+        ApplyRootMotionFlags(joints);
+        return;
+    }
+
     JointPose *blendJoints = (JointPose *)_alloca16(baseFrame.Count() * sizeof(JointPose));
     int *lerpIndex = (int *)_alloca16(baseFrame.Count() * sizeof(lerpIndex[0]));
     int numLerpJoints = 0;
@@ -1065,18 +1119,7 @@ void Anim::GetInterpolatedFrame(FrameInterpolation &frame, int numJointIndexes,
     }
 #endif    
 
-    if (!rootTranslationXY) {
-        joints[0].t.x = baseFrame[0].t.x;
-        joints[0].t.y = baseFrame[0].t.y;
-    }
-
-    if (!rootTranslationZ) {
-        joints[0].t.z = baseFrame[0].t.z;
-    }
-
-    if (!rootRotation) {
-        joints[0].q = baseFrame[0].q;
-    }
+    ApplyRootMotionFlags(joints);
 }
 
 BE_NAMESPACE_END
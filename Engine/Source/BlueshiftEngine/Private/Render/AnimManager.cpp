@@ -15,6 +15,7 @@
 #include "Precompiled.h"
 #include "Render/Render.h"
 #include "Core/Cmds.h"
+#include "Platform/PlatformTime.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -22,10 +23,12 @@ AnimManager     animManager;
 
 void AnimManager::Init() {
     cmdSystem.AddCommand(L"listAnims", Cmd_ListAnims);
+    cmdSystem.AddCommand(L"compressAnim", Cmd_CompressAnim);
 }
 
 void AnimManager::Shutdown() {
     cmdSystem.RemoveCommand(L"listAnims");
+    cmdSystem.RemoveCommand(L"compressAnim");
         
     animHashMap.DeleteContents(true);
     
@@ -181,8 +184,8 @@ void AnimManager::Cmd_ListAnims(const CmdArgs &args) {
 
         if (anim) {
             size_t s = anim->Size();
-            BE_LOG(L"%2i refs %9hs %.2f secs: %hs\n", 
-                anim->refCount, Str::FormatBytes((int)s).c_str(), anim->animLength / 1000.0f, anim->hashName.c_str());
+            BE_LOG(L"%2i refs %9hs %.2f secs %hs: %hs\n", 
+                anim->refCount, Str::FormatBytes((int)s).c_str(), anim->animLength / 1000.0f, anim->isCompressed ? "C" : " ", anim->hashName.c_str());
 
             size += s;
             num++;
@@ -198,4 +201,75 @@ void AnimManager::Cmd_ListAnims(const CmdArgs &args) {
     BE_LOG(L"total %hs used in %i joint names\n", Str::FormatBytes((int)namesize).c_str(), animManager.jointNameList.Count());
 }
 
+// Returns average time in microseconds to decode an interpolated frame of all joints
+static float MeasureDecodeTime(const Anim *anim) {
+    JointPose *joints = (JointPose *)_alloca16(anim->NumJoints() * sizeof(JointPose));
+    int *jointIndexes = (int *)_alloca16(anim->NumJoints() * sizeof(int));
+    for (int i = 0; i < anim->NumJoints(); i++) {
+        jointIndexes[i] = i;
+    }
+
+    Anim::FrameInterpolation frameInterpolation;
+    int count = 0;
+
+    uint64_t startTime = PlatformTime::Microseconds();
+
+    for (int time = 0; time < (int)anim->Length(); time += 5, count++) {
+        anim->TimeToFrameInterpolation(time, frameInterpolation);
+        anim->GetInterpolatedFrame(frameInterpolation, anim->NumJoints(), jointIndexes, joints);
+    }
+
+    return count > 0 ? (float)(PlatformTime::Microseconds() - startTime) / count : 0.0f;
+}
+
+void AnimManager::Cmd_CompressAnim(const CmdArgs &args) {
+    if (args.Argc() < 2) {
+        BE_LOG(L"compressAnim <filename|all> [maxError]\n");
+        return;
+    }
+
+    float maxError = args.Argc() > 2 ? wcstof(args.Argv(2), nullptr) : Anim::anim_compressMaxError.GetFloat();
+    bool all = !WStr::Icmp(args.Argv(1), L"all");
+
+    Array<Anim *> anims;
+    for (int i = 0; i < animManager.animHashMap.Count(); i++) {
+        Anim *anim = animManager.animHashMap.GetByIndex(i)->second;
+        if (anim && (all || !Str::Icmp(anim->hashName, WStr::ToStr(args.Argv(1))))) {
+            anims.Append(anim);
+        }
+    }
+
+    if (anims.Count() == 0) {
+        BE_WARNLOG(L"Couldn't find anim to compress \"%ls\"\n", args.Argv(1));
+        return;
+    }
+
+    size_t totalRawSize = 0;
+    size_t totalCompressedSize = 0;
+
+    for (int i = 0; i < anims.Count(); i++) {
+        Anim *anim = anims[i];
+        if (anim->isCompressed || anim->isDefaultAnim) {
+            continue;
+        }
+
+        size_t rawSize = anim->Allocated();
+        float rawDecodeTime = MeasureDecodeTime(anim);
+
+        if (!anim->Compress(maxError)) {
+            continue;
+        }
+
+        size_t compressedSize = anim->Allocated();
+        float decodeTime = MeasureDecodeTime(anim);
+
+        BE_LOG(L"decode time %.2f us -> %.2f us per frame: %hs\n", rawDecodeTime, decodeTime, anim->hashName.c_str());
+
+        totalRawSize += rawSize;
+        totalCompressedSize += compressedSize;
+    }
+
+    BE_LOG(L"total %hs -> %hs\n", Str::FormatBytes((int)totalRawSize).c_str(), Str::FormatBytes((int)totalCompressedSize).c_str());
+}
+
 BE_NAMESPACE_END
@@ -23,7 +23,7 @@ BE_NAMESPACE_BEGIN
 
 bool Anim::LoadBinaryAnim(const char *filename) {
     byte *data;
-    fileSystem.LoadFile(filename, true, (void **)&data);
+    size_t size = fileSystem.LoadFile(filename, true, (void **)&data);
     if (!data) {
         return false;
     }
@@ -37,6 +37,12 @@ bool Anim::LoadBinaryAnim(const char *filename) {
         return false;
     }
 
+    if (bAnimHeader->version > BANIM_VERSION) {
+        BE_WARNLOG(L"Anim::LoadBinaryAnim: unsupported version %i %hs\n", bAnimHeader->version, filename);
+        fileSystem.FreeFile(data);
+        return false;
+    }
+
     numFrames = bAnimHeader->numFrames;
     numJoints = bAnimHeader->numJoints;
     numAnimatedComponents = bAnimHeader->numAnimatedComponents;
@@ -45,6 +51,7 @@ bool Anim::LoadBinaryAnim(const char *filename) {
     rootRotation = (bAnimHeader->flags & BAnimFlag::RootRotation) ? true : false;
     rootTranslationXY = (bAnimHeader->flags & BAnimFlag::RootTranslationXY) ? true : false;
     rootTranslationZ = (bAnimHeader->flags & BAnimFlag::RootTranslationZ) ? true : false;
+    isCompressed = (bAnimHeader->flags & BAnimFlag::Compressed) ? true : false;
 
     // --- frameToTimeMap & timeToFrameMap ---
     int frameToTimeMapCount = *(const int *)ptr;
@@ -77,6 +84,7 @@ bool Anim::LoadBinaryAnim(const char *filename) {
         jointInfo->parentNum = bAnimJoint->parentIndex;
         jointInfo->animBits = bAnimJoint->animBits;
         jointInfo->firstComponent = bAnimJoint->firstComponent;
+        jointInfo->firstTrack = -1;
     }
 
     // --- base frame ---
@@ -94,11 +102,21 @@ bool Anim::LoadBinaryAnim(const char *filename) {
         ptr += sizeof(baseFrame[jointIndex].s);
     }
 
-    // --- frames ---
-    frameComponents.SetGranularity(1);
-    frameComponents.SetCount(numAnimatedComponents * numFrames);
-    memcpy(frameComponents.Ptr(), ptr, frameComponents.MemoryUsed());
-    ptr += frameComponents.MemoryUsed();
+    if (isCompressed) {
+        ptr = (byte *)ReadBinaryAnimCompressedTracks(data, size, ptr);
+        if (!ptr) {
+            BE_WARNLOG(L"Anim::LoadBinaryAnim: invalid compressed tracks %hs\n", filename);
+            fileSystem.FreeFile(data);
+            Purge();
+            return false;
+        }
+    } else {
+        // --- frames ---
+        frameComponents.SetGranularity(1);
+        frameComponents.SetCount(numAnimatedComponents * numFrames);
+        memcpy(frameComponents.Ptr(), ptr, frameComponents.MemoryUsed());
+        ptr += frameComponents.MemoryUsed();
+    }
 
     // --- total delta ---
     memcpy(&totalDelta, ptr, sizeof(totalDelta));
@@ -109,6 +127,76 @@ bool Anim::LoadBinaryAnim(const char *filename) {
     return true;
 }
 
+const byte *Anim::ReadBinaryAnimCompressedTracks(const byte *data, size_t size, const byte *ptr) {
+    // --- compressed tracks ---
+    int32_t numTracks;
+    if ((size_t)(ptr - data) + sizeof(numTracks) > size) {
+        return nullptr;
+    }
+    memcpy(&numTracks, ptr, sizeof(numTracks));
+    ptr += sizeof(numTracks);
+
+    // Count is checked first so that the block size can't overflow
+    if (numTracks < 0 || (size_t)numTracks > (size - (ptr - data)) / sizeof(BAnimTrack)) {
+        return nullptr;
+    }
+
+    compressedTracks.SetGranularity(1);
+    compressedTracks.SetCount(numTracks);
+
+    for (int trackIndex = 0; trackIndex < numTracks; trackIndex++) {
+        BAnimTrack bAnimTrack;
+        memcpy(&bAnimTrack, ptr, sizeof(bAnimTrack));
+        ptr += sizeof(BAnimTrack);
+
+        CompressedTrack *track = &compressedTracks[trackIndex];
+        track->firstKey = bAnimTrack.firstKey;
+        track->numKeys = bAnimTrack.numKeys;
+        for (int i = 0; i < 3; i++) {
+            track->rangeMin[i] = bAnimTrack.rangeMin[i];
+            track->rangeExtent[i] = bAnimTrack.rangeExtent[i];
+        }
+    }
+
+    // --- compressed keys ---
+    int32_t numKeys;
+    if ((size_t)(ptr - data) + sizeof(numKeys) > size) {
+        return nullptr;
+    }
+    memcpy(&numKeys, ptr, sizeof(numKeys));
+    ptr += sizeof(numKeys);
+
+    // Each key has a frame number and 3 values
+    const size_t keySize = sizeof(uint16_t) * 4;
+    if (numKeys < 0 || (size_t)numKeys > (size - (ptr - data)) / keySize) {
+        return nullptr;
+    }
+
+    // Every track needs at least one key in the key range
+    for (int trackIndex = 0; trackIndex < numTracks; trackIndex++) {
+        const CompressedTrack &track = compressedTracks[trackIndex];
+        if (track.firstKey < 0 || track.numKeys < 1 || track.firstKey > numKeys - track.numKeys) {
+            return nullptr;
+        }
+    }
+
+    compressedKeyFrames.SetGranularity(1);
+    compressedKeyFrames.SetCount(numKeys);
+    memcpy(compressedKeyFrames.Ptr(), ptr, compressedKeyFrames.MemoryUsed());
+    ptr += compressedKeyFrames.MemoryUsed();
+
+    compressedKeyValues.SetGranularity(1);
+    compressedKeyValues.SetCount(numKeys * 3);
+    memcpy(compressedKeyValues.Ptr(), ptr, compressedKeyValues.MemoryUsed());
+    ptr += compressedKeyValues.MemoryUsed();
+
+    if (!LinkCompressedTracks()) {
+        return nullptr;
+    }
+
+    return ptr;
+}
+
 void Anim::WriteBinaryAnim(const char *filename) {
     File *fp = fileSystem.OpenFile(filename, File::WriteMode);
     if (!fp) {
@@ -120,6 +208,7 @@ void Anim::WriteBinaryAnim(const char *filename) {
     flags |= rootTranslationXY ? BAnimFlag::RootTranslationXY : 0;
     flags |= rootTranslationZ ? BAnimFlag::RootTranslationZ : 0;
     flags |= rootRotation ? BAnimFlag::RootRotation : 0;
+    flags |= isCompressed ? BAnimFlag::Compressed : 0;
 
     BAnimHeader bAnimHeader;
     bAnimHeader.ident = BANIM_IDENT;
@@ -160,8 +249,33 @@ void Anim::WriteBinaryAnim(const char *filename) {
         fp->Write(&baseFrame[jointIndex].s, sizeof(baseFrame[jointIndex].s));
     }
 
-    // --- frames ---
-    fp->Write(frameComponents.Ptr(), frameComponents.MemoryUsed());
+    if (isCompressed) {
+        // --- compressed tracks ---
+        int numTracks = compressedTracks.Count();
+        fp->Write(&numTracks, sizeof(numTracks));
+
+        for (int trackIndex = 0; trackIndex < numTracks; trackIndex++) {
+            const CompressedTrack *track = &compressedTracks[trackIndex];
+
+            BAnimTrack bAnimTrack;
+            bAnimTrack.firstKey = track->firstKey;
+            bAnimTrack.numKeys = track->numKeys;
+            for (int i = 0; i < 3; i++) {
+                bAnimTrack.rangeMin[i] = track->rangeMin[i];
+                bAnimTrack.rangeExtent[i] = track->rangeExtent[i];
+            }
+            fp->Write(&bAnimTrack, sizeof(bAnimTrack));
+        }
+
+        // --- compressed keys ---
+        int numKeys = compressedKeyFrames.Count();
+        fp->Write(&numKeys, sizeof(numKeys));
+        fp->Write(compressedKeyFrames.Ptr(), compressedKeyFrames.MemoryUsed());
+        fp->Write(compressedKeyValues.Ptr(), compressedKeyValues.MemoryUsed());
+    } else {
+        // --- frames ---
+        fp->Write(frameComponents.Ptr(), frameComponents.MemoryUsed());
+    }
     
     // --- total delta ---
     fp->Write(&totalDelta, sizeof(totalDelta));
@@ -0,0 +1,677 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+-------------------------------------------------------------------------------
+
+    Anim compression
+
+    Each animated joint has up to three tracks (translation, rotation, scaling)
+    in that order. A track is a list of keys, and each key is 48 bits.
+
+    Rotation keys are quantized with the smallest three method: the largest
+    component of the quaternion is dropped, and the other three components are
+    stored in 15 bits each. The index of the dropped component is stored in the
+    top bits of the first two words.
+
+    Translation and scaling keys are quantized in 16 bits per component within
+    the range of the track.
+
+    Keys are reduced greedily while the error of the linear interpolation
+    between the keys is smaller than the maximum error. The error is measured
+    at the farthest descendant joint in the hierarchy.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Precompiled.h"
+#include "Render/Render.h"
+#include "Core/JointPose.h"
+#include "Simd/Simd.h"
+#include "Platform/PlatformTime.h"
+
+#if defined(__X86__)
+#include "Simd/SSE/sse.h"
+#endif
+
+BE_NAMESPACE_BEGIN
+
+enum TrackType {
+    TranslationTrack,
+    RotationTrack,
+    ScalingTrack,
+    NumTrackTypes
+};
+
+static const int trackAnimBits[NumTrackTypes] = {
+    Anim::Tx | Anim::Ty | Anim::Tz,
+    Anim::Qx | Anim::Qy | Anim::Qz,
+    Anim::Sx | Anim::Sy | Anim::Sz
+};
+
+// Leaf joints still move the skin around them
+static const float minJointReach = CentiToUnit(10.0f);
+
+static const float smallestThreeMax = 0.70710678f;
+static const float smallestThreeScale = (2.0f * smallestThreeMax) / 32767.0f;
+
+static void QuantizeQuat(const float *q, uint16_t *key) {
+    int largest = 0;
+    for (int i = 1; i < 4; i++) {
+        if (Math::Fabs(q[i]) > Math::Fabs(q[largest])) {
+            largest = i;
+        }
+    }
+
+    // q and -q are the same rotation, so make the dropped component positive
+    const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+    for (int i = 0, n = 0; i < 4; i++) {
+        if (i != largest) {
+            float c = Clamp(q[i] * sign, -smallestThreeMax, smallestThreeMax);
+            key[n++] = (uint16_t)Math::Ftoi((c + smallestThreeMax) / smallestThreeScale + 0.5f);
+        }
+    }
+
+    key[0] |= (largest & 1) << 15;
+    key[1] |= (largest >> 1) << 15;
+}
+
+static void DequantizeQuat(const uint16_t *key, float *q) {
+    const int largest = (key[0] >> 15) | ((key[1] >> 15) << 1);
+
+    float c[3];
+    for (int i = 0; i < 3; i++) {
+        c[i] = (key[i] & 0x7fff) * smallestThreeScale - smallestThreeMax;
+    }
+
+    const float w = Math::Sqrt(Max(0.0f, 1.0f - (c[0] * c[0] + c[1] * c[1] + c[2] * c[2])));
+
+    for (int i = 0, n = 0; i < 4; i++) {
+        q[i] = (i == largest) ? w : c[n++];
+    }
+}
+
+static void QuantizeVec3(const float *v, const float *rangeMin, const float *rangeExtent, uint16_t *key) {
+    for (int i = 0; i < 3; i++) {
+        key[i] = rangeExtent[i] > 0.0f ? (uint16_t)Clamp(Math::Ftoi((v[i] - rangeMin[i]) / rangeExtent[i] * 65535.0f + 0.5f), 0, 65535) : 0;
+    }
+}
+
+static void DequantizeVec3(const uint16_t *key, const float *rangeMin, const float *rangeExtent, float *v) {
+    for (int i = 0; i < 3; i++) {
+        v[i] = rangeMin[i] + key[i] * (rangeExtent[i] / 65535.0f);
+    }
+    v[3] = 0.0f;
+}
+
+static void LerpKeys(int type, const float *v1, const float *v2, float lerp, float *v) {
+    if (type == RotationTrack) {
+        // Normalized lerp along the shortest path
+        const float d = v1[0] * v2[0] + v1[1] * v2[1] + v1[2] * v2[2] + v1[3] * v2[3];
+        const float sign = d < 0.0f ? -1.0f : 1.0f;
+
+        float lengthSqr = 0.0f;
+        for (int i = 0; i < 4; i++) {
+            v[i] = v1[i] + (v2[i] * sign - v1[i]) * lerp;
+            lengthSqr += v[i] * v[i];
+        }
+
+        const float invLength = Math::InvSqrt(lengthSqr);
+        for (int i = 0; i < 4; i++) {
+            v[i] *= invLength;
+        }
+    } else {
+        for (int i = 0; i < 4; i++) {
+            v[i] = v1[i] + (v2[i] - v1[i]) * lerp;
+        }
+    }
+}
+
+// Returns the displacement of the farthest descendant joint caused by the difference of two keys
+static float KeyError(int type, const float *v1, const float *v2, float reach) {
+    if (type == RotationTrack) {
+        // Rotation angle is about twice the distance of two close unit quaternions.
+        // ACos is not precise enough for small angles.
+        const float d = v1[0] * v2[0] + v1[1] * v2[1] + v1[2] * v2[2] + v1[3] * v2[3];
+        const float sign = d < 0.0f ? -1.0f : 1.0f;
+
+        float distSqr = 0.0f;
+        for (int i = 0; i < 4; i++) {
+            float delta = v1[i] - v2[i] * sign;
+            distSqr += delta * delta;
+        }
+        return 2.0f * Math::Sqrt(distSqr) * reach;
+    }
+
+    const float dx = v1[0] - v2[0];
+    const float dy = v1[1] - v2[1];
+    const float dz = v1[2] - v2[2];
+
+    if (type == TranslationTrack) {
+        return Math::Sqrt(dx * dx + dy * dy + dz * dz);
+    }
+    return Max3(Math::Fabs(dx), Math::Fabs(dy), Math::Fabs(dz)) * reach;
+}
+
+#if defined(__X86__)
+
+static BE_FORCE_INLINE ssef LoadKey(const uint16_t *key) {
+    return ssef(_mm_set_epi32(0, key[2], key[1], key[0]));
+}
+
+static BE_FORCE_INLINE ssef Dot4(const ssef &a, const ssef &b) {
+    ssef m = a * b;
+    m = m + shuffle<1, 0, 3, 2>(m);
+    return m + shuffle<2, 3, 0, 1>(m);
+}
+
+static BE_FORCE_INLINE ssef DequantizeQuatSSE(const uint16_t *key) {
+    const int largest = (key[0] >> 15) | ((key[1] >> 15) << 1);
+
+    const __m128i bits = _mm_and_si128(_mm_set_epi32(0, key[2], key[1], key[0]), _mm_set1_epi32(0x7fff));
+    const ssef c = _mm_and_ps(ssef(bits) * ssef(smallestThreeScale) - ssef(smallestThreeMax), _mm_lookupmask_ps[7]);
+    const ssef w = sqrt(vmax(ssef(1.0f) - Dot4(c, c), ssef(0.0f)));
+    const ssef q = _mm_or_ps(c, _mm_and_ps(w, _mm_lookupmask_ps[8]));
+
+    switch (largest) {
+    case 0:
+        return shuffle<3, 0, 1, 2>(q);
+    case 1:
+        return shuffle<0, 3, 1, 2>(q);
+    case 2:
+        return shuffle<0, 1, 3, 2>(q);
+    default:
+        return q;
+    }
+}
+
+static BE_FORCE_INLINE void DecodeQuat(const uint16_t *key1, const uint16_t *key2, float lerp, Quat &q) {
+    const ssef q1 = DequantizeQuatSSE(key1);
+    ssef q2 = DequantizeQuatSSE(key2);
+
+    // Flip the sign of q2 to take the shortest path
+    q2 = _mm_xor_ps(q2, _mm_and_ps(Dot4(q1, q2), _mm_castsi128_ps(_mm_set1_epi32(0x80000000))));
+
+    const ssef r = q1 + (q2 - q1) * ssef(lerp);
+    _mm_storeu_ps(&q.x, r * rsqrt_nr(Dot4(r, r)));
+}
+
+static BE_FORCE_INLINE void DecodeVec3(const uint16_t *key1, const uint16_t *key2, float lerp, const float *rangeMin, const float *rangeExtent, Vec3 &v) {
+    const ssef k1 = LoadKey(key1);
+    const ssef k = k1 + (LoadKey(key2) - k1) * ssef(lerp);
+    const ssef r = ssef(rangeMin[0], rangeMin[1], rangeMin[2], 0.0f) + k * (ssef(rangeExtent[0], rangeExtent[1], rangeExtent[2], 0.0f) * ssef(1.0f / 65535.0f));
+
+    _mm_storel_pi((__m64 *)&v.x, r);
+    _mm_store_ss(&v.z, shuffle<2, 2, 2, 2>(r));
+}
+
+#else
+
+static BE_FORCE_INLINE void DecodeQuat(const uint16_t *key1, const uint16_t *key2, float lerp, Quat &q) {
+    float q1[4], q2[4], r[4];
+    DequantizeQuat(key1, q1);
+    DequantizeQuat(key2, q2);
+    LerpKeys(RotationTrack, q1, q2, lerp, r);
+    q.Set(r[0], r[1], r[2], r[3]);
+}
+
+static BE_FORCE_INLINE void DecodeVec3(const uint16_t *key1, const uint16_t *key2, float lerp, const float *rangeMin, const float *rangeExtent, Vec3 &v) {
+    for (int i = 0; i < 3; i++) {
+        const float k = key1[i] + (key2[i] - key1[i]) * lerp;
+        v[i] = rangeMin[i] + k * (rangeExtent[i] / 65535.0f);
+    }
+}
+
+#endif
+
+bool Anim::LinkCompressedTracks() {
+    int trackIndex = 0;
+
+    for (int jointIndex = 0; jointIndex < numJoints; jointIndex++) {
+        JointInfo *infoPtr = &jointInfo[jointIndex];
+        infoPtr->firstTrack = trackIndex;
+
+        for (int type = 0; type < NumTrackTypes; type++) {
+            if (infoPtr->animBits & trackAnimBits[type]) {
+                trackIndex++;
+            }
+        }
+    }
+
+    return trackIndex == compressedTracks.Count();
+}
+
+void Anim::DecodeRawFrame(int frameNum, JointPose *joints) const {
+    simdProcessor->Memcpy(joints, baseFrame.Ptr(), baseFrame.Count() * sizeof(baseFrame[0]));
+
+    const float *frame = &frameComponents[frameNum * numAnimatedComponents];
+
+    for (int jointIndex = 0; jointIndex < numJoints; jointIndex++) {
+        const JointInfo *infoPtr = &jointInfo[jointIndex];
+        const float *jointframe = frame + infoPtr->firstComponent;
+        const int animBits = infoPtr->animBits;
+
+        JointPose *jointPtr = &joints[jointIndex];
+
+        if (animBits & Tx) {
+            jointPtr->t.x = *jointframe++;
+        }
+
+        if (animBits & Ty) {
+            jointPtr->t.y = *jointframe++;
+        }
+
+        if (animBits & Tz) {
+            jointPtr->t.z = *jointframe++;
+        }
+
+        if (animBits & (Qx | Qy | Qz)) {
+            if (animBits & Qx) {
+                jointPtr->q.x = *jointframe++;
+            }
+
+            if (animBits & Qy) {
+                jointPtr->q.y = *jointframe++;
+            }
+
+            if (animBits & Qz) {
+                jointPtr->q.z = *jointframe++;
+            }
+            jointPtr->q.w = jointPtr->q.CalcW();
+        }
+
+        if (animBits & Sx) {
+            jointPtr->s.x = *jointframe++;
+        }
+
+        if (animBits & Sy) {
+            jointPtr->s.y = *jointframe++;
+        }
+
+        if (animBits & Sz) {
+            jointPtr->s.z = *jointframe++;
+        }
+    }
+}
+
+BE_INLINE float Anim::FindCompressedKeys(const CompressedTrack &track, int frameNum, float sampleTime, const uint16_t **key1, const uint16_t **key2) const {
+    const uint16_t *keyFrames = &compressedKeyFrames[track.firstKey];
+    const uint16_t *keyValues = &compressedKeyValues[track.firstKey * 3];
+
+    // Binary search the last key at or before frameNum
+    int lo = 0;
+    int hi = track.numKeys - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) >> 1;
+        if (keyFrames[mid] <= frameNum) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    *key1 = &keyValues[lo * 3];
+
+    if (lo == track.numKeys - 1) {
+        *key2 = *key1;
+        return 0.0f;
+    }
+
+    *key2 = &keyValues[(lo + 1) * 3];
+
+    const float t1 = (float)frameToTimeMap[keyFrames[lo]];
+    const float t2 = (float)frameToTimeMap[keyFrames[lo + 1]];
+    return (sampleTime - t1) / (t2 - t1);
+}
+
+void Anim::DecompressFrame(int frameNum, float backlerp, int numJointIndexes, const int *jointIndexes, JointPose *joints) const {
+    float sampleTime = (float)frameToTimeMap[frameNum];
+    if (backlerp > 0.0f) {
+        sampleTime += backlerp * (frameToTimeMap[frameNum + 1] - frameToTimeMap[frameNum]);
+    }
+
+    const uint16_t *key1;
+    const uint16_t *key2;
+
+    for (int i = 0; i < numJointIndexes; i++) {
+        int j = jointIndexes[i];
+        const JointInfo *infoPtr = &jointInfo[j];
+
+        int animBits = infoPtr->animBits;
+        if (animBits == 0) {
+            continue;
+        }
+
+        JointPose *jointPtr = &joints[j];
+        const CompressedTrack *track = &compressedTracks[infoPtr->firstTrack];
+
+        if (animBits & (Tx | Ty | Tz)) {
+            float lerp = FindCompressedKeys(*track, frameNum, sampleTime, &key1, &key2);
+            DecodeVec3(key1, key2, lerp, track->rangeMin, track->rangeExtent, jointPtr->t);
+            track++;
+        }
+
+        if (animBits & (Qx | Qy | Qz)) {
+            float lerp = FindCompressedKeys(*track, frameNum, sampleTime, &key1, &key2);
+            DecodeQuat(key1, key2, lerp, jointPtr->q);
+            track++;
+        }
+
+        if (animBits & (Sx | Sy | Sz)) {
+            float lerp = FindCompressedKeys(*track, frameNum, sampleTime, &key1, &key2);
+            DecodeVec3(key1, key2, lerp, track->rangeMin, track->rangeExtent, jointPtr->s);
+        }
+    }
+}
+
+JointPose Anim::DecompressRootJoint(const FrameInterpolation &frameInterpolation) const {
+    JointPose rootJoint = baseFrame[0];
+    const int rootJointIndex = 0;
+
+    DecompressFrame(frameInterpolation.frame1, frameInterpolation.backlerp, 1, &rootJointIndex, &rootJoint);
+
+    return rootJoint;
+}
+
+bool Anim::Compress(float maxError) {
+    if (isCompressed || !numAnimatedComponents) {
+        return false;
+    }
+
+    if (numFrames > 65536) {
+        BE_WARNLOG(L"Anim::Compress: too many frames to compress (%i) in '%hs'\n", numFrames, hashName.c_str());
+        return false;
+    }
+
+    const uint64_t startTime = PlatformTime::Microseconds();
+    const size_t rawSize = Allocated();
+
+    // Distance from each joint to the farthest descendant joint, measured with the bone lengths of the base frame.
+    // Child joints always come after the parent joint.
+    Array<float> jointReaches;
+    jointReaches.SetCount(numJoints);
+    for (int jointIndex = 0; jointIndex < numJoints; jointIndex++) {
+        jointReaches[jointIndex] = 0.0f;
+    }
+
+    for (int jointIndex = numJoints - 1; jointIndex > 0; jointIndex--) {
+        const int parentIndex = jointInfo[jointIndex].parentNum;
+        const float boneLength = baseFrame[jointIndex].t.Length();
+
+        if (parentIndex >= 0) {
+            jointReaches[parentIndex] = Max(jointReaches[parentIndex], jointReaches[jointIndex] + boneLength);
+        }
+    }
+
+    // Decode all the raw frames
+    Array<JointPose> frames;
+    frames.SetCount(numFrames * numJoints);
+
+    for (int frameNum = 0; frameNum < numFrames; frameNum++) {
+        DecodeRawFrame(frameNum, &frames[frameNum * numJoints]);
+    }
+
+    Array<float> frameTimes;
+    frameTimes.SetCount(numFrames);
+    for (int frameNum = 0; frameNum < numFrames; frameNum++) {
+        frameTimes[frameNum] = (float)frameToTimeMap[frameNum];
+    }
+
+    Array<float> values;            // original values of a track for each frame
+    Array<float> quantizedValues;   // dequantized values of a track for each frame
+    Array<uint16_t> quantizedKeys;
+    values.SetCount(numFrames * 4);
+    quantizedValues.SetCount(numFrames * 4);
+    quantizedKeys.SetCount(numFrames * 3);
+
+    compressedTracks.Clear();
+    compressedKeyFrames.Clear();
+    compressedKeyValues.Clear();
+
+    float maxMeasuredError = 0.0f;
+
+    for (int jointIndex = 0; jointIndex < numJoints; jointIndex++) {
+        const int animBits = jointInfo[jointIndex].animBits;
+        const float reach = Max(jointReaches[jointIndex], minJointReach);
+
+        for (int type = 0; type < NumTrackTypes; type++) {
+            if (!(animBits & trackAnimBits[type])) {
+                continue;
+            }
+
+            for (int frameNum = 0; frameNum < numFrames; frameNum++) {
+                const JointPose &pose = frames[frameNum * numJoints + jointIndex];
+                float *v = &values[frameNum * 4];
+
+                if (type == RotationTrack) {
+                    v[0] = pose.q.x; v[1] = pose.q.y; v[2] = pose.q.z; v[3] = pose.q.w;
+                } else {
+                    const Vec3 &vec = type == TranslationTrack ? pose.t : pose.s;
+                    v[0] = vec.x; v[1] = vec.y; v[2] = vec.z; v[3] = 0.0f;
+                }
+            }
+
+            CompressedTrack &track = compressedTracks.Alloc();
+            track.firstKey = compressedKeyFrames.Count();
+
+            if (type == RotationTrack) {
+                for (int i = 0; i < 3; i++) {
+                    track.rangeMin[i] = 0.0f;
+                    track.rangeExtent[i] = 0.0f;
+                }
+            } else {
+                for (int i = 0; i < 3; i++) {
+                    float minValue = values[i];
+                    float maxValue = values[i];
+                    for (int frameNum = 1; frameNum < numFrames; frameNum++) {
+                        minValue = Min(minValue, values[frameNum * 4 + i]);
+                        maxValue = Max(maxValue, values[frameNum * 4 + i]);
+                    }
+                    track.rangeMin[i] = minValue;
+                    track.rangeExtent[i] = maxValue - minValue;
+                }
+            }
+
+            for (int frameNum = 0; frameNum < numFrames; frameNum++) {
+                uint16_t *key = &quantizedKeys[frameNum * 3];
+                float *v = &quantizedValues[frameNum * 4];
+
+                if (type == RotationTrack) {
+                    QuantizeQuat(&values[frameNum * 4], key);
+                    DequantizeQuat(key, v);
+                } else {
+                    QuantizeVec3(&values[frameNum * 4], track.rangeMin, track.rangeExtent, key);
+                    DequantizeVec3(key, track.rangeMin, track.rangeExtent, v);
+                }
+            }
+
+            // Returns true if the frames between two keys are interpolated within the maximum error
+            auto checkSegment = [&](int frame1, int frame2) -> bool {
+                float lerped[4];
+                for (int frameNum = frame1 + 1; frameNum < frame2; frameNum++) {
+                    float lerp = (frameTimes[frameNum] - frameTimes[frame1]) / (frameTimes[frame2] - frameTimes[frame1]);
+                    LerpKeys(type, &quantizedValues[frame1 * 4], &quantizedValues[frame2 * 4], lerp, lerped);
+                    if (KeyError(type, &values[frameNum * 4], lerped, reach) > maxError) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            auto addKey = [&](int frameNum) {
+                compressedKeyFrames.Append((uint16_t)frameNum);
+                for (int i = 0; i < 3; i++) {
+                    compressedKeyValues.Append(quantizedKeys[frameNum * 3 + i]);
+                }
+            };
+
+            addKey(0);
+
+            // Constant track needs only one key
+            bool constant = true;
+            for (int frameNum = 1; frameNum < numFrames && constant; frameNum++) {
+                constant = KeyError(type, &values[frameNum * 4], &quantizedValues[0], reach) <= maxError;
+            }
+
+            int keyFrame = 0;
+            while (!constant && keyFrame < numFrames - 1) {
+                // Gallop to find a failing segment, and then binary search the longest passing segment
+                int passFrame = keyFrame + 1;
+                int failFrame = keyFrame + 2;
+                while (failFrame < numFrames && checkSegment(keyFrame, failFrame)) {
+                    passFrame = failFrame;
+                    failFrame = keyFrame + (failFrame - keyFrame) * 2;
+                }
+                failFrame = Min(failFrame, numFrames);
+
+                while (failFrame - passFrame > 1) {
+                    int midFrame = (passFrame + failFrame) >> 1;
+                    if (checkSegment(keyFrame, midFrame)) {
+                        passFrame = midFrame;
+                    } else {
+                        failFrame = midFrame;
+                    }
+                }
+
+                addKey(passFrame);
+                keyFrame = passFrame;
+            }
+
+            track.numKeys = compressedKeyFrames.Count() - track.firstKey;
+
+            // Measure the final error including quantization
+            for (int frameNum = 0, keyIndex = track.firstKey; frameNum < numFrames; frameNum++) {
+                while (keyIndex < track.firstKey + track.numKeys - 1 && compressedKeyFrames[keyIndex + 1] <= frameNum) {
+                    keyIndex++;
+                }
+
+                float lerped[4];
+                if (keyIndex == track.firstKey + track.numKeys - 1) {
+                    memcpy(lerped, &quantizedValues[compressedKeyFrames[keyIndex] * 4], sizeof(lerped));
+                } else {
+                    int frame1 = compressedKeyFrames[keyIndex];
+                    int frame2 = compressedKeyFrames[keyIndex + 1];
+                    float lerp = (frameTimes[frameNum] - frameTimes[frame1]) / (frameTimes[frame2] - frameTimes[frame1]);
+                    LerpKeys(type, &quantizedValues[frame1 * 4], &quantizedValues[frame2 * 4], lerp, lerped);
+                }
+
+                maxMeasuredError = Max(maxMeasuredError, KeyError(type, &values[frameNum * 4], lerped, reach));
+            }
+        }
+    }
+
+    compressedTracks.Squeeze();
+    compressedKeyFrames.Squeeze();
+    compressedKeyValues.Squeeze();
+
+    bool linked = LinkCompressedTracks();
+    assert(linked);
+
+    frameComponents.Clear();
+    isCompressed = true;
+
+    const size_t compressedSize = Allocated();
+
+    BE_LOG(L"Compressed anim '%hs': %hs -> %hs (%.1f%%), %i keys in %i tracks of %i frames, max error %.4f, %.1f ms\n",
+        hashName.c_str(), Str::FormatBytes((int)rawSize).c_str(), Str::FormatBytes((int)compressedSize).c_str(),
+        100.0f * compressedSize / rawSize, compressedKeyFrames.Count(), compressedTracks.Count(), numFrames,
+        maxMeasuredError, (PlatformTime::Microseconds() - startTime) / 1000.0f);
+
+    return true;
+}
+
+void Anim::Decompress() {
+    if (!isCompressed) {
+        return;
+    }
+
+    JointPose *joints = (JointPose *)_alloca16(numJoints * sizeof(JointPose));
+    int *jointIndexes = (int *)_alloca16(numJoints * sizeof(int));
+    for (int i = 0; i < numJoints; i++) {
+        jointIndexes[i] = i;
+    }
+
+    frameComponents.SetGranularity(1);
+    frameComponents.SetCount(numAnimatedComponents * numFrames);
+
+    for (int frameNum = 0; frameNum < numFrames; frameNum++) {
+        simdProcessor->Memcpy(joints, baseFrame.Ptr(), baseFrame.Count() * sizeof(baseFrame[0]));
+
+        DecompressFrame(frameNum, 0.0f, numJoints, jointIndexes, joints);
+
+        float *frame = &frameComponents[frameNum * numAnimatedComponents];
+
+        for (int jointIndex = 0; jointIndex < numJoints; jointIndex++) {
+            const JointInfo *infoPtr = &jointInfo[jointIndex];
+            const int animBits = infoPtr->animBits;
+            float *jointframe = frame + infoPtr->firstComponent;
+
+            JointPose *jointPtr = &joints[jointIndex];
+
+            // Raw frames keep w positive
+            if (jointPtr->q.w < 0.0f) {
+                jointPtr->q = -jointPtr->q;
+            }
+
+            if (animBits & Tx) {
+                *jointframe++ = jointPtr->t.x;
+            }
+
+            if (animBits & Ty) {
+                *jointframe++ = jointPtr->t.y;
+            }
+
+            if (animBits & Tz) {
+                *jointframe++ = jointPtr->t.z;
+            }
+
+            if (animBits & Qx) {
+                *jointframe++ = jointPtr->q.x;
+            }
+
+            if (animBits & Qy) {
+                *jointframe++ = jointPtr->q.y;
+            }
+
+            if (animBits & Qz) {
+                *jointframe++ = jointPtr->q.z;
+            }
+
+            if (animBits & Sx) {
+                *jointframe++ = jointPtr->s.x;
+            }
+
+            if (animBits & Sy) {
+                *jointframe++ = jointPtr->s.y;
+            }
+
+            if (animBits & Sz) {
+                *jointframe++ = jointPtr->s.z;
+            }
+        }
+    }
+
+    compressedTracks.Clear();
+    compressedKeyFrames.Clear();
+    compressedKeyValues.Clear();
+
+    for (int jointIndex = 0; jointIndex < numJoints; jointIndex++) {
+        jointInfo[jointIndex].firstTrack = -1;
+    }
+
+    isCompressed = false;
+}
+
+BE_NAMESPACE_END
@@ -304,6 +304,9 @@ void Anim::LerpFrame(int framenum1, int framenum2, float backlerp, JointPose *jo
 }
 
 void Anim::RemoveFrames(int numRemoveFrames, const int *removeFramenums) {
+    // Frames are removed from the raw frame components
+    Decompress();
+
     Array<float>	newFrameComponents;
     Array<int>	newFrameTimes;
     Array<AABB>	newAABBs;
@@ -348,6 +351,9 @@ void Anim::OptimizeFrames(float epsilonT, float epsilonQ, float epsilonS) {
         return;
     }
 
+    // Frames are compared in the raw frame components
+    Decompress();
+
     Array<int> removeFrameNums;
     removeFrameNums.Resize(numFrames);
 
@@ -20,15 +20,18 @@ BE_NAMESPACE_BEGIN
 #define BSKEL_VERSION   1
 
 #define BMESH_IDENT     MAKE_FOURCC('B', 'E', 'M', '1')
-#define BMESH_VERSION   1
+#define BMESH_VERSION   2
+
+#define BMESH_BLOCK_ALIGN   16      // alignment of the vertex, weight and index blocks in the file (version 2)
 
 #define BANIM_IDENT     MAKE_FOURCC('B', 'E', 'A', '1')
-#define BANIM_VERSION   1
+#define BANIM_VERSION   2
 
 enum BAnimFlag {
     RootTranslationXY   = BIT(0),
     RootTranslationZ    = BIT(1),
     RootRotation        = BIT(2),
+    Compressed          = BIT(3),
 };
 
 #pragma pack(1)
@@ -64,6 +67,24 @@ struct BMeshSurf {
     Vec3            aabbMax;
 };
 
+// Surface of version 2.
+// Vertex, weight and index blocks are stored in the memory layout of VertexGenericLit, VertexWeightX and TriIndex
+// at the offsets from the beginning of the file, so that they can be copied at once from the mapped file.
+struct BMeshSurf2 {
+    int32_t         materialIndex;
+    uint32_t        numVerts;
+    uint32_t        numIndexes;
+    uint32_t        maxWeights;
+    uint32_t        vertexSize;         // sizeof(VertexGenericLit)
+    uint32_t        weightSize;         // sizeof(VertexWeightX), 0 if no weights
+    uint32_t        indexSize;          // sizeof(TriIndex)
+    uint32_t        vertexOffset;
+    uint32_t        weightOffset;
+    uint32_t        indexOffset;
+    Vec3            aabbMin;
+    Vec3            aabbMax;
+};
+
 struct BMeshVert {
     Vec3            position;
     Vec2            texCoord;
@@ -91,6 +112,13 @@ struct BAnimJoint {
     int32_t         firstComponent;
 };
 
+struct BAnimTrack {
+    int32_t         firstKey;
+    int32_t         numKeys;
+    float           rangeMin[3];
+    float           rangeExtent[3];
+};
+
 #pragma pack()
 
 BE_NAMESPACE_END
@@ -20,7 +20,6 @@
 BE_NAMESPACE_BEGIN
 
 #define PINNED_MEMORY   1
-#define PERSISTENT_MAP  0
 
 BufferCacheManager      bufferCacheManager;
 
@@ -31,8 +30,13 @@ static const int        TB_PITCH    = TB_BPP * TB_WIDTH;
 static const int        TB_BYTES    = TB_PITCH * TB_HEIGHT;
 
 void BufferCacheManager::Init() {
-    int vertexBytes = r_dynamicCacheVertexBytes.GetInteger();
-    int indexBytes = r_dynamicCacheIndexBytes.GetInteger();
+    vertexBytes = r_dynamicCacheVertexBytes.GetInteger();
+    indexBytes = r_dynamicCacheIndexBytes.GetInteger();
+
+    uniformBytes = 0;
+    if (renderGlobal.useUniformBuffer || renderGlobal.useInstancing) {
+        uniformBytes = r_dynamicCacheUniformBytes.GetInteger();
+    }
 
     for (int i = 0; i < COUNT_OF(frameData); i++) {
         FrameDataBufferSet *bufferSet = &frameData[i];
@@ -42,6 +46,11 @@ void BufferCacheManager::Init() {
         bufferSet->vertexBuffer = rhi.CreateBuffer(RHI::VertexBuffer, RHI::Dynamic, vertexBytes, 0, nullptr);
         bufferSet->indexBuffer = rhi.CreateBuffer(RHI::IndexBuffer, RHI::Dynamic, indexBytes, 0, nullptr);
 
+        if (uniformBytes > 0) {
+            // Binding range of the block is always the whole block size, so reserve the extra space for the last allocation
+            bufferSet->uniformBuffer = rhi.CreateBuffer(RHI::UniformBuffer, RHI::Dynamic, uniformBytes + rhi.HWLimit().maxUniformBlockSize, 0, nullptr);
+        }
+
         if (renderGlobal.vtUpdateMethod == Mesh::TboUpdate) {
             // Create texture buffer to write directly
             bufferSet->texelBufferType = RHI::TexelBuffer;
@@ -67,13 +76,14 @@ void BufferCacheManager::Init() {
     if (frameData[0].texelBuffer) {
         BE_LOG(L"dynamic texel buffer created (%hs x %i)\n", Str::FormatBytes(TB_BYTES).c_str(), COUNT_OF(frameData));
     }
+    if (frameData[0].uniformBuffer) {
+        BE_LOG(L"dynamic uniform buffer created (%hs x %i)\n", Str::FormatBytes(uniformBytes).c_str(), COUNT_OF(frameData));
+    }
     
     // Create stream buffer for use in debug drawing
     streamVertexBuffer = rhi.CreateBuffer(RHI::VertexBuffer, RHI::Stream, 0);
     streamIndexBuffer = rhi.CreateBuffer(RHI::IndexBuffer, RHI::Stream, 0);
 
-    pboWriteOffset = 0;
-
     frameCount = 0;
     mappedNum = 0;
     unmappedNum = -1;
@@ -81,14 +91,22 @@ void BufferCacheManager::Init() {
     mostUsedVertexMem = 0;
     mostUsedIndexMem = 0;
     mostUsedTexelMem = 0;
+    mostUsedUniformMem = 0;
 
 #if PINNED_MEMORY
-    MapBufferSet(frameData[mappedNum]);
-#if PERSISTENT_MAP
-    for (int i = mappedNum + 1; i < COUNT_OF(frameData); i++) {
-        MapBufferSet(frameData[i]);
+    // Map the buffers of all frames once if the buffer storage can stay mapped while the GPU reads it
+    persistentMap = rhi.SupportsBufferStorage();
+
+    if (persistentMap) {
+        for (int i = 0; i < COUNT_OF(frameData); i++) {
+            MapBufferSet(frameData[i]);
+        }
+        BE_LOG(L"dynamic buffers are persistently mapped\n");
+    } else {
+        MapBufferSet(frameData[mappedNum]);
     }
-#endif
+#else
+    persistentMap = false;
 #endif
 }
 
@@ -111,6 +129,10 @@ void BufferCacheManager::Shutdown() {
         if (frameData[i].texelBuffer) {
             rhi.DeleteBuffer(frameData[i].texelBuffer);
         }
+
+        if (frameData[i].uniformBuffer) {
+            rhi.DeleteBuffer(frameData[i].uniformBuffer);
+        }
         
         if (frameData[i].texture) {
             textureManager.DestroyTexture(frameData[i].texture);
@@ -120,11 +142,7 @@ void BufferCacheManager::Shutdown() {
 
 void BufferCacheManager::MapBufferSet(FrameDataBufferSet &bufferSet) {
 #if PINNED_MEMORY
-#if PERSISTENT_MAP
-    RHI::BufferLockMode lockMode = RHI::WriteOnlyPersistent;
-#else
-    RHI::BufferLockMode lockMode = RHI::WriteOnly;
-#endif
+    RHI::BufferLockMode lockMode = persistentMap ? RHI::WriteOnlyPersistent : RHI::WriteOnly;
 
     if (!bufferSet.mappedVertexBase) {
         rhi.BindBuffer(RHI::VertexBuffer, bufferSet.vertexBuffer);
@@ -143,6 +161,12 @@ void BufferCacheManager::MapBufferSet(FrameDataBufferSet &bufferSet) {
         bufferSet.mappedTexelBase = rhi.MapBufferRange(bufferSet.texelBuffer, lockMode);
         rhi.BindBuffer(bufferSet.texelBufferType, RHI::NullBuffer);
     }
+
+    if (!bufferSet.mappedUniformBase && bufferSet.uniformBuffer) {
+        rhi.BindBuffer(RHI::UniformBuffer, bufferSet.uniformBuffer);
+        bufferSet.mappedUniformBase = rhi.MapBufferRange(bufferSet.uniformBuffer, lockMode);
+        rhi.BindBuffer(RHI::UniformBuffer, RHI::NullBuffer);
+    }
 #endif
 }
 
@@ -168,6 +192,13 @@ void BufferCacheManager::UnmapBufferSet(FrameDataBufferSet &bufferSet) {
         rhi.BindBuffer(bufferSet.texelBufferType, RHI::NullBuffer);
         bufferSet.mappedTexelBase = nullptr;
     }
+
+    if (bufferSet.mappedUniformBase && bufferSet.uniformBuffer) {
+        rhi.BindBuffer(RHI::UniformBuffer, bufferSet.uniformBuffer);
+        rhi.UnmapBuffer(bufferSet.uniformBuffer);
+        rhi.BindBuffer(RHI::UniformBuffer, RHI::NullBuffer);
+        bufferSet.mappedUniformBase = nullptr;
+    }
 #endif
 }
 
@@ -194,25 +225,30 @@ void BufferCacheManager::BeginBackEnd() {
     mostUsedVertexMem = Max(mostUsedVertexMem, (int)frameData[mappedNum].vertexMemUsed.GetValue());
     mostUsedIndexMem = Max(mostUsedIndexMem, (int)frameData[mappedNum].indexMemUsed.GetValue());
     mostUsedTexelMem = Max(mostUsedTexelMem, (int)frameData[mappedNum].texelMemUsed.GetValue());
+    mostUsedUniformMem = Max(mostUsedUniformMem, (int)frameData[mappedNum].uniformMemUsed.GetValue());
 
     if (r_showBufferCache.GetBool()) {
-        BE_LOG(L"%08d: %d alloc, vMem(%hs), iMem(%hs), tMem(%hs) : vMem(%hs), iMem(%hs), tMem(%hs)\n",
-            frameCount, frameData[mappedNum].allocations,
+        BE_LOG(L"%08d: %d alloc, vMem(%hs), iMem(%hs), tMem(%hs), uMem(%hs) : vMem(%hs), iMem(%hs), tMem(%hs), uMem(%hs)\n",
+            frameCount, frameData[mappedNum].allocations.GetValue(),
             Str::FormatBytes(frameData[mappedNum].vertexMemUsed.GetValue()).c_str(),
             Str::FormatBytes(frameData[mappedNum].indexMemUsed.GetValue()).c_str(),
             Str::FormatBytes(frameData[mappedNum].texelMemUsed.GetValue()).c_str(),
+            Str::FormatBytes(frameData[mappedNum].uniformMemUsed.GetValue()).c_str(),
             Str::FormatBytes(mostUsedVertexMem).c_str(),
             Str::FormatBytes(mostUsedIndexMem).c_str(),
-            Str::FormatBytes(mostUsedTexelMem).c_str());
+            Str::FormatBytes(mostUsedTexelMem).c_str(),
+            Str::FormatBytes(mostUsedUniformMem).c_str());
     }
 
-#if PINNED_MEMORY && !PERSISTENT_MAP
-    // unmap the current frame so the GPU can read it
-    const uint32_t startUnmap = PlatformTime::Milliseconds();
-    UnmapBufferSet(frameData[mappedNum]);
-    const uint32_t endUnmap = PlatformTime::Milliseconds();
-    if (r_showBufferCacheTiming.GetBool() && endUnmap - startUnmap > 1) {
-        BE_DLOG(L"BufferCacheManager::BeginBackEnd: unmap took %i msec\n", endUnmap - startUnmap);
+#if PINNED_MEMORY
+    if (!persistentMap) {
+        // unmap the current frame so the GPU can read it
+        const uint32_t startUnmap = PlatformTime::Milliseconds();
+        UnmapBufferSet(frameData[mappedNum]);
+        const uint32_t endUnmap = PlatformTime::Milliseconds();
+        if (r_showBufferCacheTiming.GetBool() && endUnmap - startUnmap > 1) {
+            BE_DLOG(L"BufferCacheManager::BeginBackEnd: unmap took %i msec\n", endUnmap - startUnmap);
+        }
     }
 #endif
 
@@ -234,31 +270,29 @@ void BufferCacheManager::BeginBackEnd() {
     frameCount++;
     mappedNum = frameCount % COUNT_OF(frameData);
     
-#if PINNED_MEMORY && !PERSISTENT_MAP
-    const uint32_t startMap = PlatformTime::Milliseconds();
-    MapBufferSet(frameData[mappedNum]);
-    const uint32_t endMap = PlatformTime::Milliseconds();
-    if (r_showBufferCacheTiming.GetBool() && endMap - startMap > 1) {
-        BE_DLOG(L"BufferCacheManager::BeginBackEnd: map took %i msec\n", endMap - startMap);
+#if PINNED_MEMORY
+    if (!persistentMap) {
+        const uint32_t startMap = PlatformTime::Milliseconds();
+        MapBufferSet(frameData[mappedNum]);
+        const uint32_t endMap = PlatformTime::Milliseconds();
+        if (r_showBufferCacheTiming.GetBool() && endMap - startMap > 1) {
+            BE_DLOG(L"BufferCacheManager::BeginBackEnd: map took %i msec\n", endMap - startMap);
+        }
     }
 #endif
 
     // clear current frame data
-    rhi.BufferRewind(frameData[mappedNum].vertexBuffer);
     frameData[mappedNum].vertexMemUsed.SetValue(0);
-
-    rhi.BufferRewind(frameData[mappedNum].indexBuffer);
     frameData[mappedNum].indexMemUsed.SetValue(0);
+    frameData[mappedNum].texelMemUsed.SetValue(0);
+    frameData[mappedNum].uniformMemUsed.SetValue(0);
 
-    if (frameData[mappedNum].texelBuffer) {
-        rhi.BufferRewind(frameData[mappedNum].texelBuffer);
-        frameData[mappedNum].texelMemUsed.SetValue(0);
-    }
-
-    frameData[mappedNum].allocations = 0;
+    frameData[mappedNum].allocations.SetValue(0);
 }
 
 void BufferCacheManager::AllocStaticVertex(int bytes, const void *data, BufferCache *bc) {
+    renderSystem.SyncRenderThread();
+
     bc->buffer = rhi.CreateBuffer(RHI::VertexBuffer, RHI::Static, bytes, 0, data);
     bc->offset = 0;
     bc->bytes = bytes;
@@ -266,6 +300,8 @@ void BufferCacheManager::AllocStaticVertex(int bytes, const void *data, BufferCa
 }
 
 void BufferCacheManager::AllocStaticIndex(int bytes, const void *data, BufferCache *bc) {
+    renderSystem.SyncRenderThread();
+
     bc->buffer = rhi.CreateBuffer(RHI::IndexBuffer, RHI::Static, bytes, 0, data);
     bc->offset = 0;
     bc->bytes = bytes;
@@ -273,6 +309,8 @@ void BufferCacheManager::AllocStaticIndex(int bytes, const void *data, BufferCac
 }
 
 void BufferCacheManager::AllocStaticTexel(int bytes, const void *data, BufferCache *bc) {
+    renderSystem.SyncRenderThread();
+
     bc->buffer = rhi.CreateBuffer(RHI::TexelBuffer, RHI::Static, bytes, 0, data);
     bc->offset = 0;
     bc->bytes = bytes;
@@ -285,22 +323,44 @@ static void WriteBuffer(void *dst, const void *src, int numBytes) {
     memcpy(dst, src, numBytes);
 }
 
+int BufferCacheManager::ReserveRange(PlatformAtomic &memUsed, int bufferSize, int alignSize, int pitch, int bytes) {
+    if (pitch > 0 && bytes > pitch) {
+        return -1;
+    }
+
+    while (1) {
+        const int writeOffset = memUsed.GetValue();
+
+        int base = writeOffset + alignSize - 1;
+        base -= base % alignSize;
+
+        // Don't let the range span rows
+        if (pitch > 0 && (base + bytes) / pitch > base / pitch) {
+            base -= base % pitch;
+            base += pitch;
+        }
+
+        if (base + bytes > bufferSize) {
+            return -1;
+        }
+
+        // Retry if another thread has reserved its range in the meantime
+        if (CompareExchange(memUsed, base + bytes, writeOffset) == writeOffset) {
+            return base;
+        }
+    }
+}
+
 bool BufferCacheManager::AllocVertex(int numVertexes, int vertexSize, const void *data, BufferCache *bc) {
     int bytes = vertexSize * numVertexes;
 
     FrameDataBufferSet *currentBufferSet = &frameData[mappedNum];
 
-    // thread safe interlocked adds
-    currentBufferSet->vertexMemUsed.Add(bytes);
-
-    //rhi.BindBuffer(RHI::VertexBuffer, currentBufferSet->vertexBuffer);
-    // Check just write offset (don't write)
-    int offset = rhi.BufferWrite(currentBufferSet->vertexBuffer, vertexSize, bytes, nullptr);
+    int offset = ReserveRange(currentBufferSet->vertexMemUsed, vertexBytes, vertexSize, 0, bytes);
     if (offset == -1) {
         BE_FATALERROR(L"Out of vertex cache");
         return false;
     }
-    //rhi.BindBuffer(RHI::VertexBuffer, RHI::NullBuffer);
 
     currentBufferSet->allocations++;
 
@@ -331,17 +391,11 @@ bool BufferCacheManager::AllocIndex(int numIndexes, int indexSize, const void *d
     
     FrameDataBufferSet *currentBufferSet = &frameData[mappedNum];
 
-    // thread safe interlocked adds
-    currentBufferSet->indexMemUsed.Add(bytes);
-
-    //rhi.BindBuffer(RHI::IndexBuffer, currentBufferSet->indexBuffer);
-    // Check just write offset (don't write)
-    int offset = rhi.BufferWrite(currentBufferSet->indexBuffer, indexSize, bytes, nullptr);
+    int offset = ReserveRange(currentBufferSet->indexMemUsed, indexBytes, indexSize, 0, bytes);
     if (offset == -1) {
         BE_FATALERROR(L"Out of index cache");
         return false;
     }
-    //rhi.BindBuffer(RHI::IndexBuffer, RHI::NullBuffer);
 
     currentBufferSet->allocations++;
 
@@ -371,17 +425,13 @@ bool BufferCacheManager::AllocTexel(int bytes, const void *data, BufferCache *bc
     FrameDataBufferSet *currentBufferSet = &frameData[mappedNum];
     assert(currentBufferSet->texelBuffer);
 
-    // thread safe interlocked adds
-    currentBufferSet->texelMemUsed.Add(bytes);
-
-    //rhi.BindBuffer(currentBufferSet->texelBufferType, currentBufferSet->texelBuffer);
-    // Check just write offset (don't write)
-    int offset = rhi.BufferWrite(currentBufferSet->texelBuffer, TB_BPP, bytes, nullptr);
+    // Rows of the PBO are copied to the rows of the texture, so an allocation can't span rows
+    int pitch = renderGlobal.vtUpdateMethod == Mesh::PboUpdate ? TB_PITCH : 0;
+    int offset = ReserveRange(currentBufferSet->texelMemUsed, TB_BYTES, TB_BPP, pitch, bytes);
     if (offset == -1) {
         BE_FATALERROR(L"Out of texel cache");
         return false;
     }
-    //rhi.BindBuffer(currentBufferSet->texelBufferType, RHI::NullBuffer);
 
     currentBufferSet->allocations++;
 
@@ -409,8 +459,6 @@ bool BufferCacheManager::AllocTexel(int bytes, const void *data, BufferCache *bc
         bc->tcBase[0] = texelOffset % TB_WIDTH;
         bc->tcBase[1] = texelOffset / TB_WIDTH;
         bc->texture = frameData[0].texture;
-
-        pboWriteOffset = offset + bytes;
     }
 
     bc->buffer = currentBufferSet->texelBuffer;
@@ -420,6 +468,49 @@ bool BufferCacheManager::AllocTexel(int bytes, const void *data, BufferCache *bc
     return true;
 }
 
+bool BufferCacheManager::AllocUniform(int bytes, const void *data, BufferCache *bc) {
+    FrameDataBufferSet *currentBufferSet = &frameData[mappedNum];
+    assert(currentBufferSet->uniformBuffer);
+
+    int offset = ReserveRange(currentBufferSet->uniformMemUsed, uniformBytes, rhi.HWLimit().uniformBufferOffsetAlignment, 0, bytes);
+    if (offset == -1) {
+        BE_FATALERROR(L"Out of uniform cache");
+        return false;
+    }
+
+    currentBufferSet->allocations++;
+
+    if (data) {
+#if PINNED_MEMORY
+        assert(currentBufferSet->mappedUniformBase);
+        WriteBuffer((byte *)currentBufferSet->mappedUniformBase + offset, data, bytes);
+#else
+        rhi.BindBuffer(RHI::UniformBuffer, currentBufferSet->uniformBuffer);
+        void *base = rhi.MapBufferRange(currentBufferSet->uniformBuffer, RHI::WriteOnly, offset, bytes);
+
+        WriteBuffer((byte *)base, data, bytes);
+
+        rhi.UnmapBuffer(currentBufferSet->uniformBuffer);
+        rhi.BindBuffer(RHI::UniformBuffer, RHI::NullBuffer);
+#endif
+    }
+
+    bc->buffer = currentBufferSet->uniformBuffer;
+    bc->offset = offset;
+    bc->bytes = bytes;
+    bc->frameCount = frameCount;
+    return true;
+}
+
+bool BufferCacheManager::CanAllocUniform(int bytes) const {
+    const FrameDataBufferSet *currentBufferSet = &frameData[mappedNum];
+    if (!currentBufferSet->uniformBuffer) {
+        return false;
+    }
+
+    return AlignUp(currentBufferSet->uniformMemUsed.GetValue(), rhi.HWLimit().uniformBufferOffsetAlignment) + bytes <= uniformBytes;
+}
+
 byte *BufferCacheManager::MapVertexBuffer(BufferCache *bc) const {
     const FrameDataBufferSet *currentBufferSet = &frameData[mappedNum];
     assert(bc->frameCount == frameCount);
@@ -499,7 +590,8 @@ bool BufferCacheManager::IsCached(const BufferCache *bc) const {
 void BufferCacheManager::UpdatePBOTexture() const {
     const FrameDataBufferSet *currentBufferSet = &frameData[unmappedNum];
 
-    int texelOffset = pboWriteOffset / TB_BPP;
+    // End of the last reserved range in the frame
+    int texelOffset = currentBufferSet->texelMemUsed.GetValue() / TB_BPP;
 
     int updateW = Min(texelOffset, TB_WIDTH);
     int updateH = (texelOffset + TB_WIDTH - 1) / TB_WIDTH;
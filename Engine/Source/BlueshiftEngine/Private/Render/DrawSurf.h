@@ -23,7 +23,7 @@ public:
         ShowWires           = BIT(1)            ///< means to draw wireframes
     };
 
-    void                    MakeSortKey(int entityIdx, const Material *material);
+    void                    MakeSortKey(int entityIdx, const Material *material, const SubMesh *subMesh);
 
     uint64_t                sortKey;
     uint32_t                flags;
@@ -31,16 +31,27 @@ public:
     const Material *        material;           ///< material of this surface
     const float *           materialRegisters;
     SubMesh *               subMesh;
+    int                     numInstances;       ///< number of following surfaces drawn with instancing including this surface (0 if not instanced)
+    const BufferCache *     instanceBufferCache;///< per-instance data of the instanced surfaces
 };
 
 //---------------------------------------------------
 // sortKey bits:
-// 0x0000FFFF00000000 (0~65535) : material sort
-// 0x00000000FFFF0000 (0~65535) : entity index
-// 0x000000000000FFFF (0~65535) : material index
+// 0xFFFF000000000000 (0~65535) : material sort
+// 0x0000FFFF00000000 (0~65535) : material index
+// 0x00000000FFFF0000 (0~65535) : sub mesh key
+// 0x000000000000FFFF (0~65535) : entity index
+//
+// Sub mesh key is the hash of the vertex buffer shared by the static meshes,
+// so the surfaces of the same sub mesh and material are sorted next to each other to be instanced.
 //---------------------------------------------------
-BE_INLINE void DrawSurf::MakeSortKey(int entityIdx, const Material *material) {
-    sortKey = (((uint64_t)material->GetSort() << 32) | ((uint64_t)entityIdx << 16) | (uint64_t)materialManager.GetIndexByMaterial(material));
+BE_INLINE void DrawSurf::MakeSortKey(int entityIdx, const Material *material, const SubMesh *subMesh) {
+    uint64_t subMeshKey = 0;
+    if (subMesh->GetType() == Mesh::StaticMesh) {
+        subMeshKey = ((uint64_t)(uintptr_t)subMesh->vertexCache * 0x9E3779B97F4A7C15ULL) >> 48;
+    }
+
+    sortKey = (((uint64_t)material->GetSort() << 48) | ((uint64_t)materialManager.GetIndexByMaterial(material) << 32) | (subMeshKey << 16) | (uint64_t)(entityIdx & 0xFFFF));
 }
 
 BE_NAMESPACE_END
@@ -358,6 +358,9 @@ FontGlyph *FontFaceFreeType::GetGlyph(int charCode) {
 
     DrawGlyphBufferFromFTBitmap(bitmap);
 
+    // Glyphs are cached from the game thread
+    renderSystem.SyncRenderThread();
+
     rhi.SelectTextureUnit(0);
 
     texture->Bind();
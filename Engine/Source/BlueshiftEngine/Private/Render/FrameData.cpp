@@ -16,6 +16,7 @@
 #include "Render/Render.h"
 #include "RenderInternal.h"
 #include "Core/Heap.h"
+#include "Platform/PlatformProcess.h"
 #include "Simd/Simd.h"
 
 BE_NAMESPACE_BEGIN
@@ -24,80 +25,131 @@ static const int MEMORY_BLOCK_SIZE = 0x100000;
 
 FrameData   frameData;
 
-void FrameData::Init() {
-    Shutdown();
-
+FrameData::MemBlock *FrameData::AllocMemBlock() {
     int size = MEMORY_BLOCK_SIZE;
     MemBlock *block = (MemBlock *)Mem_Alloc(sizeof(*block) + 15 + size);
     if (!block) {
-        BE_FATALERROR(L"FrameData::Init: failed to allocate memory");
+        return nullptr;
     }
     block->base = (byte *)AlignUp((intptr_t)block + sizeof(*block), 16);
     block->size = size;
     block->used = 0;
-    block->next = nullptr;
+    return block;
+}
+
+void FrameData::Init() {
+    Shutdown();
+
+    for (int i = 0; i < NumFrames; i++) {
+        MemBlock *block = AllocMemBlock();
+        if (!block) {
+            BE_FATALERROR(L"FrameData::Init: failed to allocate memory");
+        }
+
+        memset(frames[i].blocks, 0, sizeof(frames[i].blocks));
+        frames[i].blocks[0] = block;
+        frames[i].numUsedBlocks.SetValue(0);
 
-    this->mem = block;
-    this->alloc = block;
-    this->commands.used = 0;
+        for (int arenaIndex = 0; arenaIndex < NumArenas; arenaIndex++) {
+            frames[i].arenas[arenaIndex].block = nullptr;
+            frames[i].arenas[arenaIndex].lock.SetValue(0);
+        }
+
+        frames[i].commands.used = 0;
+    }
+
+    currentFrame = 0;
 }
 
 void FrameData::Shutdown() {
-    MemBlock *nextBlock;
-    for (MemBlock *block = this->mem; block; block = nextBlock) {
-        nextBlock = block->next;
-        Mem_Free(block);
+    for (int i = 0; i < NumFrames; i++) {
+        for (int blockIndex = 0; blockIndex < MaxMemBlocks; blockIndex++) {
+            if (frames[i].blocks[blockIndex]) {
+                Mem_Free(frames[i].blocks[blockIndex]);
+                frames[i].blocks[blockIndex] = nullptr;
+            }
+        }
     }
-    
-    this->mem = nullptr;
 }
 
 void FrameData::ToggleFrame() {
-    // reset the mem allocation to the first block
-    this->alloc = this->mem;
+    currentFrame = (currentFrame + 1) % NumFrames;
+
+    Frame &frame = frames[currentFrame];
+
+    // return all the used blocks to the pool
+    int numUsedBlocks = Min(frame.numUsedBlocks.GetValue(), MaxMemBlocks);
+    for (int i = 0; i < numUsedBlocks; i++) {
+        frame.blocks[i]->used = 0;
+    }
+    frame.numUsedBlocks.SetValue(0);
 
-    // clear all the blocks
-    for (MemBlock *block = this->mem; block; block = block->next) {
-        block->used = 0;
+    for (int i = 0; i < NumArenas; i++) {
+        frame.arenas[i].block = nullptr;
     }
+
+    frame.commands.used = 0;
 }
 
-void *FrameData::Alloc(int bytes) {
-    bytes = AlignUp(bytes, 16);
-    MemBlock *block = this->alloc;
+void *FrameData::AllocFromArena(Frame &frame, Arena &arena, int bytes) {
+    MemBlock *block = arena.block;
 
-    if (block->size - block->used >= bytes) {
+    if (block && block->size - block->used >= bytes) {
         void *buf = block->base + block->used;
         block->used += bytes;
         return buf;
     }
 
-    // advance to the next mem block if available
-    block = block->next;
-    // create a new block if we are at the end of the chain
+    // grab the next block in the pool
+    int blockIndex = frame.numUsedBlocks++;
+    if (blockIndex >= MaxMemBlocks) {
+        BE_FATALERROR(L"FrameData::Alloc: out of memory blocks");
+    }
+
+    // create a new block if the pool has not been grown up to here.
+    // Each index is grabbed by only one thread, so this doesn't need locking.
+    block = frame.blocks[blockIndex];
     if (!block) {
-        int size = MEMORY_BLOCK_SIZE;
-        block = (MemBlock *)Mem_Alloc(sizeof(*block) + 15 + size);
+        block = AllocMemBlock();
         if (!block) {
             BE_FATALERROR(L"FrameData::Alloc: Mem_Alloc() failed");
         }
-        block->base = (byte *)AlignUp((intptr_t)block + sizeof(*block), 16);
-        block->size = size;
-        block->used = 0;
-        block->next = nullptr;
-        this->alloc->next = block;
+        frame.blocks[blockIndex] = block;
     }
 
     if (bytes > block->size) {
         BE_FATALERROR(L"FrameData::Alloc of %i exceeded MEMORY_BLOCK_SIZE", bytes);
     }
 
-    this->alloc = block;
+    arena.block = block;
     block->used = bytes;
 
     return block->base;
 }
 
+void *FrameData::Alloc(int bytes) {
+    bytes = AlignUp(bytes, 16);
+    Frame &frame = frames[currentFrame];
+
+    int threadIndex = TaskScheduler::ThreadIndex();
+    if (threadIndex >= 0) {
+        return AllocFromArena(frame, frame.arenas[threadIndex], bytes);
+    }
+
+    // threads not owned by the task scheduler share the last arena
+    Arena &sharedArena = frame.arenas[NumArenas - 1];
+
+    while (CompareExchange(sharedArena.lock, 1, 0) != 0) {
+        PlatformProcess::Sleep(0);
+    }
+
+    void *buf = AllocFromArena(frame, sharedArena, bytes);
+
+    CompareExchange(sharedArena.lock, 0, 1);
+
+    return buf;
+}
+
 void *FrameData::ClearedAlloc(int bytes) {
     void *r = Alloc(bytes);
     simdProcessor->Memset(r, 0, bytes);
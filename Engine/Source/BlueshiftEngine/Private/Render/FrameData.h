@@ -14,33 +14,58 @@
 
 #pragma once
 
+#include "Core/Task.h"
 #include "RenderCmd.h"
 
 BE_NAMESPACE_BEGIN
 
 /// All of the information needed by the back end must be contained in.
+/// Memory of the two frames is used alternately, so the back end can read the previous frame on the render thread while the front end writes the next one.
+/// Each thread of the task scheduler allocates from its own arena without locking, and arenas grab memory blocks from the pool of the frame with an atomic add.
 class FrameData {
 public:
     void                    Init();
     void                    Shutdown();
+                            /// Switches to the memory of the other frame and clears it.
+                            /// Memory of the current frame is valid until the next call.
     void                    ToggleFrame();
 
+                            /// Lock-free on the threads of the task scheduler. Other threads share an arena guarded by a spin lock.
     void *                  Alloc(int bytes);
     void *                  ClearedAlloc(int bytes);
 
-    RenderCommandBuffer *   GetCommands() { return &commands; }
+    RenderCommandBuffer *   GetCommands() { return &frames[currentFrame].commands; }
 
 private:
+    static const int        NumFrames = 2;
+    static const int        MaxMemBlocks = 1024;
+                            // The last arena is shared by the threads not owned by the task scheduler
+    static const int        NumArenas = TaskScheduler::MaxThreads + 1;
+
     struct MemBlock {
-        MemBlock *          next;
         int32_t             size;
         int32_t             used;
         byte *              base;
     };
 
-    MemBlock *              mem;
-    MemBlock *              alloc;
-    RenderCommandBuffer     commands;
+    // Each arena sits on its own cache line to avoid false sharing between threads
+    struct alignas(64) Arena {
+        MemBlock *          block;              ///< Current block to allocate from
+        PlatformAtomic      lock;               ///< Spin lock used only by the shared arena
+    };
+
+    struct Frame {
+        MemBlock *          blocks[MaxMemBlocks];   ///< Block pool shared by the arenas. Blocks are allocated on demand and reused in the next frames.
+        PlatformAtomic      numUsedBlocks;
+        Arena               arenas[NumArenas];
+        RenderCommandBuffer commands;
+    };
+
+    static MemBlock *       AllocMemBlock();
+    static void *           AllocFromArena(Frame &frame, Arena &arena, int bytes);
+
+    Frame                   frames[NumFrames];
+    int                     currentFrame;
 };
 
 extern FrameData            frameData;
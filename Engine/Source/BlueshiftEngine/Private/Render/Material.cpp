@@ -18,12 +18,15 @@
 #include "Asset/Asset.h"
 #include "Asset/GuidMapper.h"
 #include "File/FileSystem.h"
+#include "Core/AsyncLoader.h"
 
 BE_NAMESPACE_BEGIN
 
 #define MATERIAL_VERSION 1
 
 void Material::Purge() {
+    renderSystem.SyncRenderThread();
+
     if (pass) {
         if (pass->shader) {
             shaderManager.ReleaseShader(pass->shader);
@@ -175,7 +178,7 @@ bool Material::ParsePass(Lexer &lexer, ShaderPass *pass) {
                                 shaderProp.data = PropertySpec::ToVariant(shaderSpec.GetType(), propDict.GetString(shaderSpecKey, defaultTextureGuid.ToString()));
                                 const Guid textureGuid = shaderProp.data.As<Guid>();
                                 const Str texturePath = resourceGuidMapper.Get(textureGuid);
-                                shaderProp.texture = textureManager.GetTexture(texturePath);
+                                shaderProp.texture = textureManager.GetTextureAsync(texturePath, AsyncLoader::NormalPriority);
                             }
                         } else {
                             shaderProp.data = PropertySpec::ToVariant(shaderSpec.GetType(), propDict.GetString(shaderSpecKey, shaderSpec.GetDefaultValue()));
@@ -194,7 +197,7 @@ bool Material::ParsePass(Lexer &lexer, ShaderPass *pass) {
             if (lexer.ReadToken(&token, false)) {
                 const Guid textureGuid = Guid::ParseString(token);
                 const Str texturePath = resourceGuidMapper.Get(textureGuid);
-                pass->texture = textureManager.GetTexture(texturePath);
+                pass->texture = textureManager.GetTextureAsync(texturePath, AsyncLoader::NormalPriority);
             } else {
                 BE_WARNLOG(L"missing map GUID in material '%hs'\n", hashName.c_str());
             }
@@ -425,7 +428,7 @@ void Material::EndShaderPropertiesChanged() {
                 }
                 const Guid textureGuid = shaderProp.data.As<Guid>();
                 const Str texturePath = resourceGuidMapper.Get(textureGuid);
-                shaderProp.texture = textureManager.GetTexture(texturePath);
+                shaderProp.texture = textureManager.GetTextureAsync(texturePath, AsyncLoader::NormalPriority);
             }
         }
     }
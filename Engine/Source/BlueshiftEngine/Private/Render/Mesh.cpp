@@ -18,6 +18,7 @@
 #include "Core/JointPose.h"
 #include "Simd/Simd.h"
 #include "Core/Heap.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -26,6 +27,16 @@ bool Mesh::IsDefaultMesh() const {
 }
 
 void Mesh::Purge() {
+    // Mesh being loaded on the loader thread has no GPU buffers yet, so it is purged without waiting for the render thread
+    for (int i = 0; i < surfaces.Count(); i++) {
+        const SubMesh *subMesh = surfaces[i]->subMesh;
+        if (subMesh->alloced && subMesh->type == ReferenceMesh && 
+            (subMesh->vertexCache->buffer != RHI::NullBuffer || subMesh->indexCache->buffer != RHI::NullBuffer)) {
+            renderSystem.SyncRenderThread();
+            break;
+        }
+    }
+
     for (int i = 0; i < surfaces.Count(); i++) {
         FreeSurface(surfaces[i]);
     }
@@ -76,7 +87,7 @@ MeshSurf *Mesh::AllocInstantiatedSurface(const MeshSurf *refSurf, int meshType)
     surf->drawSurf      = nullptr;
     surf->viewCount     = 0;
 
-    surf->subMesh->AllocInstantiatedSubMesh(refSurf->subMesh, meshType);
+    surf->subMesh->AllocInstantiatedSubMesh(refSurf->subMesh, meshType, useGpuSkinning);
 
     return surf;
 }
@@ -111,24 +122,26 @@ void Mesh::Instantiate(int meshType) {
     if (isSkinnedMesh) {
         useGpuSkinning = CapableGPUJointSkinning((Mesh::SkinningMethod)renderGlobal.skinningMethod, numJoints);
 
-        if (useGpuSkinning) {
-            skinningJointCache = new SkinningJointCache;
-            skinningJointCache->viewFrameCount = -1;
-
-            // NOTE: VTF skinning 일 때만 모션블러 함
-            if (renderGlobal.skinningMethod == VtfSkinning) {
-                skinningJointCache->numJoints = numJoints;
-                if (r_motionBlur.GetInteger() == 2) {
-                    skinningJointCache->numJoints *= 2;
-                }
-                skinningJointCache->skinningJoints = (Mat3x4 *)Mem_Alloc16(sizeof(Mat3x4) * skinningJointCache->numJoints);
-
-                skinningJointCache->jointIndexOffsetCurr = 0;
-                skinningJointCache->jointIndexOffsetPrev = 0;
-            } else {
-                skinningJointCache->numJoints = numJoints;
-                skinningJointCache->skinningJoints = (Mat3x4 *)Mem_Alloc16(sizeof(Mat3x4) * skinningJointCache->numJoints);
+        // Skinning joints are used for CPU skinning as well
+        skinningJointCache = new SkinningJointCache;
+        skinningJointCache->viewFrameCount = -1;
+
+        // NOTE: VTF skinning 일 때만 모션블러 함
+        if (useGpuSkinning && renderGlobal.skinningMethod == VtfSkinning) {
+            skinningJointCache->numJoints = numJoints;
+            if (r_motionBlur.GetInteger() == 2) {
+                skinningJointCache->numJoints *= 2;
             }
+            skinningJointCache->skinningJoints = (Mat3x4 *)Mem_Alloc16(sizeof(Mat3x4) * skinningJointCache->numJoints);
+
+            skinningJointCache->jointIndexOffsetCurr = 0;
+            skinningJointCache->jointIndexOffsetPrev = 0;
+        } else {
+            skinningJointCache->numJoints = numJoints;
+            skinningJointCache->skinningJoints = (Mat3x4 *)Mem_Alloc16(sizeof(Mat3x4) * skinningJointCache->numJoints);
+
+            skinningJointCache->jointIndexOffsetCurr = 0;
+            skinningJointCache->jointIndexOffsetPrev = 0;
         }
     }
 
@@ -170,7 +183,7 @@ void Mesh::FinishSurfaces(int flags) {
     //SplitMirroredVerts();
 
     if (flags & OptimizeIndicesFlag) {
-        OptimizeIndexedTriangles();
+        OptimizeIndexedTriangles(flags & OptimizeOverdrawFlag ? true : false);
     }
 
     if ((flags & ComputeNormalsFlag) && !(flags & ComputeTangentsFlag)) {
@@ -202,10 +215,10 @@ void Mesh::TransformVerts(const Mat3 &rotation, const Vec3 &translation) {
     ComputeAABB();
 }
 
-void Mesh::OptimizeIndexedTriangles() {
+void Mesh::OptimizeIndexedTriangles(bool optimizeOverdraw) {
     for (int i = 0; i < surfaces.Count(); i++) {
         SubMesh *subMesh = surfaces[i]->subMesh;
-        subMesh->OptimizeIndexedTriangles();
+        subMesh->OptimizeIndexedTriangles(optimizeOverdraw);
     }
 }
 
@@ -341,7 +354,7 @@ bool Mesh::CapableGPUJointSkinning(SkinningMethod skinningMethod, int numJoints)
 }
 
 void Mesh::UpdateSkinningJointCache(const Skeleton *skeleton, const Mat3x4 *jointMats) {
-    if (!useGpuSkinning || !skinningJointCache) {
+    if (!skinningJointCache) {
         return;
     }
 
@@ -351,7 +364,7 @@ void Mesh::UpdateSkinningJointCache(const Skeleton *skeleton, const Mat3x4 *join
 
     skinningJointCache->viewFrameCount = renderSystem.GetCurrentRenderContext()->frameCount;
 
-    if (r_usePostProcessing.GetBool() && (r_motionBlur.GetInteger() & 2)) {
+    if (useGpuSkinning && r_usePostProcessing.GetBool() && (r_motionBlur.GetInteger() & 2)) {
         if (skinningJointCache->viewFrameCount == renderSystem.GetCurrentRenderContext()->frameCount) {
             skinningJointCache->jointIndexOffsetPrev = skinningJointCache->jointIndexOffsetCurr;
             skinningJointCache->jointIndexOffsetCurr = skinningJointCache->jointIndexOffsetCurr == 0 ? numJoints : 0;
@@ -363,8 +376,13 @@ void Mesh::UpdateSkinningJointCache(const Skeleton *skeleton, const Mat3x4 *join
 
     simdProcessor->MultiplyJoints(skinningJointCache->skinningJoints + skinningJointCache->jointIndexOffsetCurr, jointMats, skeleton->GetInvBindPoseMats(), numJoints);
 
-    if (renderGlobal.skinningMethod == VtfSkinning) {
-        bufferCacheManager.AllocTexel(skinningJointCache->numJoints * sizeof(Mat3x4), skinningJointCache->skinningJoints, &skinningJointCache->bufferCache);
+    if (useGpuSkinning) {
+        if (renderGlobal.skinningMethod == VtfSkinning) {
+            bufferCacheManager.AllocTexel(skinningJointCache->numJoints * sizeof(Mat3x4), skinningJointCache->skinningJoints, &skinningJointCache->bufferCache);
+        } else if (renderGlobal.useUniformBuffer) {
+            // Upload once and share between all the draws of this frame instead of setting joint constants in every draw
+            bufferCacheManager.AllocUniform(skinningJointCache->numJoints * sizeof(Mat3x4), skinningJointCache->skinningJoints, &skinningJointCache->bufferCache);
+        }
     }
 
     renderSystem.GetCurrentRenderContext()->renderCounter.numSkinningEntities++;
@@ -421,6 +439,8 @@ const Vec3 Mesh::ComputeCentroid() const {
 }
 
 bool Mesh::Load(const char *filename) {
+    BE_PROFILE_CPU_SCOPE("Mesh::Load");
+
     Purge();
 
     Str bMeshFilename = filename;
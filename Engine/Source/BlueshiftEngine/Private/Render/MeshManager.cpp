@@ -15,6 +15,7 @@
 #include "Precompiled.h"
 #include "Render/Render.h"
 #include "Core/Cmds.h"
+#include "Core/AsyncLoader.h"
 
 BE_NAMESPACE_BEGIN
     
@@ -214,6 +215,15 @@ Mesh *MeshManager::GetMesh(const char *hashName) {
     }
 
     Mesh *mesh = FindMesh(hashName);
+    if (!mesh) {
+        // Finish prefetching right now
+        const auto *entry = meshLoadRequests.Get(hashName);
+        if (entry) {
+            asyncLoader.Complete(entry->second);
+            mesh = FindMesh(hashName);
+        }
+    }
+
     if (mesh) {
         mesh->refCount++;
         return mesh;
@@ -229,6 +239,66 @@ Mesh *MeshManager::GetMesh(const char *hashName) {
     return mesh;
 }
 
+// Loads mesh on the loader thread, and registers it to the mesh manager on the main thread.
+class MeshLoadRequest : public AsyncLoadRequest {
+public:
+    MeshLoadRequest(const char *hashName) : hashName(hashName) {
+        meshManager.meshLoadRequests.Set(this->hashName, this);
+    }
+    virtual ~MeshLoadRequest() {
+        meshManager.meshLoadRequests.Remove(hashName);
+        if (mesh) {
+            delete mesh;
+        }
+    }
+
+    virtual void Load() override {
+        mesh = new Mesh;
+        mesh->hashName = hashName;
+        mesh->name = hashName;
+        mesh->name.StripPath();
+        mesh->name.StripFileExtension();
+
+        if (!mesh->Load(hashName)) {
+            SAFE_DELETE(mesh);
+        }
+    }
+
+    virtual void Finalize() override {
+        if (!mesh) {
+            BE_WARNLOG(L"Couldn't load mesh '%hs'\n", hashName.c_str());
+            return;
+        }
+
+        if (!meshManager.FindMesh(hashName)) {
+            // Not referenced until GetMesh() is called
+            mesh->refCount = 0;
+            meshManager.meshHashMap.Set(mesh->hashName, mesh);
+            mesh = nullptr;
+        }
+    }
+
+private:
+    Str                     hashName;
+    Mesh *                  mesh = nullptr;
+};
+
+void MeshManager::PrefetchMesh(const char *hashName, int priority) {
+    if (!asyncLoader.IsEnabled()) {
+        return;
+    }
+
+    if (!hashName || !hashName[0]) {
+        return;
+    }
+
+    if (FindMesh(hashName) || meshLoadRequests.Get(hashName)) {
+        return;
+    }
+
+    asyncLoader.AddRequest(new MeshLoadRequest(hashName), priority);
+}
+
 void MeshManager::EndLevelLoad() {
 #if 0
     for (int i = 0; i < meshHashMap.Count(); i++) {
@@ -202,6 +202,7 @@ void Mesh::CreateBox(const Vec3 &origin, const Mat3 &axis, const Vec3 &extents)
 }
 
 void Mesh::CreateSphere(const Vec3 &origin, const Mat3 &axis, float radius, int numSegments) {
+    // Sphere is a capsule with no height, which is optimized in CreateCapsule()
     CreateCapsule(origin, axis, radius, 0, numSegments);
 }
 
@@ -253,7 +254,7 @@ void Mesh::CreateGeosphere(const Vec3 &origin, float radius, int numTess) {
         }
     }
 
-    FinishSurfaces(ComputeAABBFlag | ComputeTangentsFlag);
+    FinishSurfaces(ComputeAABBFlag | ComputeTangentsFlag | OptimizeIndicesFlag);
 
     if (!origin.IsZero()) {
         TransformVerts(Mat3::identity, origin);
@@ -360,7 +361,7 @@ void Mesh::CreateCylinder(const Vec3 &origin, const Mat3 &axis, float radius, fl
         *idx++ = offset + b + 1;
     }
 
-    FinishSurfaces(ComputeAABBFlag | ComputeTangentsFlag);
+    FinishSurfaces(ComputeAABBFlag | ComputeTangentsFlag | OptimizeIndicesFlag);
 
     if (!axis.IsIdentity() || !origin.IsZero()) {
         TransformVerts(axis, origin);
@@ -463,7 +464,7 @@ void Mesh::CreateCapsule(const Vec3 &origin, const Mat3 &axis, float radius, flo
         }
     }
 
-    FinishSurfaces(ComputeAABBFlag | ComputeTangentsFlag);
+    FinishSurfaces(ComputeAABBFlag | ComputeTangentsFlag | OptimizeIndicesFlag);
 
     if (!axis.IsIdentity() || !origin.IsZero()) {
         TransformVerts(axis, origin);
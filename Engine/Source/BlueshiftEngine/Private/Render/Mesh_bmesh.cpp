@@ -17,150 +17,292 @@
 #include "BModel.h"
 #include "Core/Heap.h"
 #include "File/FileSystem.h"
+#include "File/FileMapping.h"
+#include "Simd/Simd.h"
 
 BE_NAMESPACE_BEGIN
 
 bool Mesh::LoadBinaryMesh(const char *filename) {
-    byte *data;
-    fileSystem.LoadFile(filename, true, (void **)&data);
-    if (!data) {
-        return false;
-    }
- 
-    const BMeshHeader *bMeshHeader = (const BMeshHeader *)data;
-    byte *ptr = data + sizeof(BMeshHeader);
-    
-    if (bMeshHeader->ident != BMESH_IDENT) {
-        BE_WARNLOG(L"Mesh::LoadBinaryMesh: bad format %hs\n", filename);
-        fileSystem.FreeFile(data);
-        return false;
+    // Map the file to avoid loading whole file into the heap. Files in archives are loaded.
+    FileMapping fileMapping;
+    byte *loadedData = nullptr;
+    const byte *data;
+    size_t size;
+
+    if (fileSystem.MapFile(filename, true, fileMapping)) {
+        data = (const byte *)fileMapping.GetData();
+        size = fileMapping.GetSize();
+    } else {
+        size = fileSystem.LoadFile(filename, true, (void **)&loadedData);
+        if (!loadedData) {
+            return false;
+        }
+        data = loadedData;
     }
 
-    numJoints = bMeshHeader->numJoints;
-    if (numJoints > 0) {
-        joints = new Joint[numJoints];
+    const BMeshHeader *bMeshHeader = (const BMeshHeader *)data;
+    const byte *ptr = data + sizeof(BMeshHeader);
 
-        // --- joints ---
-        for (int jointIndexes = 0; jointIndexes < numJoints; jointIndexes++) {
-            const BJoint *bJoint = (const BJoint *)ptr;
+    bool valid = true;
+    int version = 0;
 
-            joints[jointIndexes].name = bJoint->name;
-            joints[jointIndexes].parent = bJoint->parentIndex >= 0 ? &this->joints[bJoint->parentIndex] : nullptr;
+    if (size < sizeof(BMeshHeader) || bMeshHeader->ident != BMESH_IDENT) {
+        BE_WARNLOG(L"Mesh::LoadBinaryMesh: bad format %hs\n", filename);
+        valid = false;
+    } else if (bMeshHeader->version != 1 && bMeshHeader->version != BMESH_VERSION) {
+        BE_WARNLOG(L"Mesh::LoadBinaryMesh: unsupported version %i %hs\n", bMeshHeader->version, filename);
+        valid = false;
+    }
 
-            ptr += sizeof(BJoint);
-        }
+    if (valid && bMeshHeader->numJoints > (size - sizeof(BMeshHeader)) / sizeof(BJoint)) {
+        BE_WARNLOG(L"Mesh::LoadBinaryMesh: invalid joint count %hs\n", filename);
+        valid = false;
     }
 
-    aabb = AABB(bMeshHeader->aabbMin, bMeshHeader->aabbMax);
+    if (valid) {
+        version = bMeshHeader->version;
 
-    // --- surfaces ---
-    for (int surfaceIndex = 0; surfaceIndex < bMeshHeader->numSurfs; surfaceIndex++) {
-        const BMeshSurf *bMeshSurf = (const BMeshSurf *)ptr;
-        ptr += sizeof(BMeshSurf);
+        numJoints = bMeshHeader->numJoints;
+        if (numJoints > 0) {
+            joints = new Joint[numJoints];
 
-        MeshSurf *meshSurf = AllocSurface(bMeshSurf->numVerts, bMeshSurf->numIndexes);
-        surfaces.Append(meshSurf);
-        SubMesh *subMesh = meshSurf->subMesh;
-        subMesh->aabb = AABB(bMeshSurf->aabbMin, bMeshSurf->aabbMax);
+            // --- joints ---
+            for (int jointIndexes = 0; jointIndexes < numJoints; jointIndexes++) {
+                const BJoint *bJoint = (const BJoint *)ptr;
 
-        meshSurf->materialIndex = bMeshSurf->materialIndex;
+                joints[jointIndexes].name = bJoint->name;
+                joints[jointIndexes].parent = bJoint->parentIndex >= 0 && bJoint->parentIndex < numJoints ? &this->joints[bJoint->parentIndex] : nullptr;
 
-        // --- vertexes ---
-        for (int i = 0; i < bMeshSurf->numVerts; i++) {
-            VertexGenericLit *v = &subMesh->verts[i];
-            
-            BMeshVert copy;
-            memcpy(&copy, ptr, sizeof(BMeshVert)); // for alignment BUS Error
-
-            v->SetPosition(copy.position);
-            v->SetTexCoord(copy.texCoord);
-            v->SetNormal(copy.normal);
-            v->SetTangent(copy.tangent);
-            v->SetBiTangent(copy.bitangent);
-            v->SetColor(*reinterpret_cast<const uint32_t *>(copy.color));
-
-            ptr += sizeof(BMeshVert);
+                ptr += sizeof(BJoint);
+            }
         }
 
-        // --- vertex weights ---
-        if (bMeshSurf->maxWeights > 0) {
-            int vertexWeightSize = 0;
-
-            if (bMeshSurf->maxWeights == 1) {
-                vertexWeightSize = sizeof(VertexWeight1);
-                subMesh->vertWeights = Mem_Alloc16(vertexWeightSize * bMeshSurf->numVerts);
-                subMesh->gpuSkinningVersionIndex = 0;
-
-                VertexWeight1 *dstPtr = (VertexWeight1 *)subMesh->vertWeights;
-                for (int i = 0; i < bMeshSurf->numVerts; i++, dstPtr++) {
-                    dstPtr->jointIndex = *ptr++;
-                }
-            } else if (bMeshSurf->maxWeights <= 4) {
-                vertexWeightSize = sizeof(VertexWeight4);
-                subMesh->vertWeights = Mem_Alloc16(vertexWeightSize * bMeshSurf->numVerts);
-                subMesh->gpuSkinningVersionIndex = 1;
-
-                VertexWeight4 *dstPtr = (VertexWeight4 *)subMesh->vertWeights;
-                for (int i = 0; i < bMeshSurf->numVerts; i++, dstPtr++) {
-                    dstPtr->jointIndexes[0] = *ptr++;
-                    dstPtr->jointIndexes[1] = *ptr++;
-                    dstPtr->jointIndexes[2] = *ptr++;
-                    dstPtr->jointIndexes[3] = *ptr++;
-
-                    dstPtr->jointWeights[0] = *ptr++;
-                    dstPtr->jointWeights[1] = *ptr++;
-                    dstPtr->jointWeights[2] = *ptr++;
-                    dstPtr->jointWeights[3] = *ptr++;
-                }
-            } else if (bMeshSurf->maxWeights <= 8) {
-                vertexWeightSize = sizeof(VertexWeight8);
-                subMesh->vertWeights = Mem_Alloc16(vertexWeightSize * bMeshSurf->numVerts);
-                subMesh->gpuSkinningVersionIndex = 2;
-
-                VertexWeight8 *dstPtr = (VertexWeight8 *)subMesh->vertWeights;
-                for (int i = 0; i < bMeshSurf->numVerts; i++, dstPtr++) {
-                    dstPtr->jointIndexes[0] = *ptr++;
-                    dstPtr->jointIndexes[1] = *ptr++;
-                    dstPtr->jointIndexes[2] = *ptr++;
-                    dstPtr->jointIndexes[3] = *ptr++;
-                    dstPtr->jointIndexes[4] = *ptr++;
-                    dstPtr->jointIndexes[5] = *ptr++;
-                    dstPtr->jointIndexes[6] = *ptr++;
-                    dstPtr->jointIndexes[7] = *ptr++;
-
-                    dstPtr->jointWeights[0] = *ptr++;
-                    dstPtr->jointWeights[1] = *ptr++;
-                    dstPtr->jointWeights[2] = *ptr++;
-                    dstPtr->jointWeights[3] = *ptr++;
-                    dstPtr->jointWeights[4] = *ptr++;
-                    dstPtr->jointWeights[5] = *ptr++;
-                    dstPtr->jointWeights[6] = *ptr++;
-                    dstPtr->jointWeights[7] = *ptr++;
-                }
+        aabb = AABB(bMeshHeader->aabbMin, bMeshHeader->aabbMax);
+
+        // --- surfaces ---
+        for (int surfaceIndex = 0; surfaceIndex < bMeshHeader->numSurfs; surfaceIndex++) {
+            if (bMeshHeader->version == 1) {
+                ptr = ReadBinaryMeshSurfV1(ptr);
             } else {
-                assert(0);
+                ptr = ReadBinaryMeshSurf(data, size, ptr);
+            }
+
+            if (!ptr) {
+                BE_WARNLOG(L"Mesh::LoadBinaryMesh: invalid surface data %hs\n", filename);
+                valid = false;
+                break;
             }
         }
+    }
 
-        // --- indexes ---
-        if (bMeshSurf->indexSize == 4) {
-            for (int i = 0; i < bMeshSurf->numIndexes; i++) {
-                subMesh->indexes[i] = *(uint32_t *)ptr;
-                ptr += sizeof(uint32_t);
+    if (loadedData) {
+        fileSystem.FreeFile(loadedData);
+    } else {
+        fileMapping.Close();
+    }
+
+    if (!valid) {
+        Purge();
+        return false;
+    }
+
+    if (version == 1) {
+        // Version 1 meshes come straight from the importer. Optimize them once and
+        // convert the file to the current version so that later loads skip this.
+        FinishSurfaces(OptimizeIndicesFlag);
+
+        BE_LOG(L"Converting '%hs' to bmesh version %i\n", filename, BMESH_VERSION);
+        WriteBinaryMesh(filename);
+    } else {
+        FinishSurfaces();
+    }
+
+    return true;
+}
+
+// Reads a surface of version 1 which stores vertex elements one by one.
+const byte *Mesh::ReadBinaryMeshSurfV1(const byte *ptr) {
+    const BMeshSurf *bMeshSurf = (const BMeshSurf *)ptr;
+    ptr += sizeof(BMeshSurf);
+
+    MeshSurf *meshSurf = AllocSurface(bMeshSurf->numVerts, bMeshSurf->numIndexes);
+    surfaces.Append(meshSurf);
+    SubMesh *subMesh = meshSurf->subMesh;
+    subMesh->aabb = AABB(bMeshSurf->aabbMin, bMeshSurf->aabbMax);
+
+    meshSurf->materialIndex = bMeshSurf->materialIndex;
+
+    // --- vertexes ---
+    for (int i = 0; i < bMeshSurf->numVerts; i++) {
+        VertexGenericLit *v = &subMesh->verts[i];
+        
+        BMeshVert copy;
+        memcpy(&copy, ptr, sizeof(BMeshVert)); // for alignment BUS Error
+
+        v->SetPosition(copy.position);
+        v->SetTexCoord(copy.texCoord);
+        v->SetNormal(copy.normal);
+        v->SetTangent(copy.tangent);
+        v->SetBiTangent(copy.bitangent);
+        v->SetColor(*reinterpret_cast<const uint32_t *>(copy.color));
+
+        ptr += sizeof(BMeshVert);
+    }
+
+    // --- vertex weights ---
+    if (bMeshSurf->maxWeights > 0) {
+        int vertexWeightSize = 0;
+
+        if (bMeshSurf->maxWeights == 1) {
+            vertexWeightSize = sizeof(VertexWeight1);
+            subMesh->vertWeights = Mem_Alloc16(vertexWeightSize * bMeshSurf->numVerts);
+            subMesh->gpuSkinningVersionIndex = 0;
+
+            VertexWeight1 *dstPtr = (VertexWeight1 *)subMesh->vertWeights;
+            for (int i = 0; i < bMeshSurf->numVerts; i++, dstPtr++) {
+                dstPtr->jointIndex = *ptr++;
+            }
+        } else if (bMeshSurf->maxWeights <= 4) {
+            vertexWeightSize = sizeof(VertexWeight4);
+            subMesh->vertWeights = Mem_Alloc16(vertexWeightSize * bMeshSurf->numVerts);
+            subMesh->gpuSkinningVersionIndex = 1;
+
+            VertexWeight4 *dstPtr = (VertexWeight4 *)subMesh->vertWeights;
+            for (int i = 0; i < bMeshSurf->numVerts; i++, dstPtr++) {
+                dstPtr->jointIndexes[0] = *ptr++;
+                dstPtr->jointIndexes[1] = *ptr++;
+                dstPtr->jointIndexes[2] = *ptr++;
+                dstPtr->jointIndexes[3] = *ptr++;
+
+                dstPtr->jointWeights[0] = *ptr++;
+                dstPtr->jointWeights[1] = *ptr++;
+                dstPtr->jointWeights[2] = *ptr++;
+                dstPtr->jointWeights[3] = *ptr++;
             }
-        } else if (bMeshSurf->indexSize == 2) {
-            for (int i = 0; i < bMeshSurf->numIndexes; i++) {
-                subMesh->indexes[i] = *(uint16_t *)ptr;
-                ptr += sizeof(uint16_t);
+        } else if (bMeshSurf->maxWeights <= 8) {
+            vertexWeightSize = sizeof(VertexWeight8);
+            subMesh->vertWeights = Mem_Alloc16(vertexWeightSize * bMeshSurf->numVerts);
+            subMesh->gpuSkinningVersionIndex = 2;
+
+            VertexWeight8 *dstPtr = (VertexWeight8 *)subMesh->vertWeights;
+            for (int i = 0; i < bMeshSurf->numVerts; i++, dstPtr++) {
+                dstPtr->jointIndexes[0] = *ptr++;
+                dstPtr->jointIndexes[1] = *ptr++;
+                dstPtr->jointIndexes[2] = *ptr++;
+                dstPtr->jointIndexes[3] = *ptr++;
+                dstPtr->jointIndexes[4] = *ptr++;
+                dstPtr->jointIndexes[5] = *ptr++;
+                dstPtr->jointIndexes[6] = *ptr++;
+                dstPtr->jointIndexes[7] = *ptr++;
+
+                dstPtr->jointWeights[0] = *ptr++;
+                dstPtr->jointWeights[1] = *ptr++;
+                dstPtr->jointWeights[2] = *ptr++;
+                dstPtr->jointWeights[3] = *ptr++;
+                dstPtr->jointWeights[4] = *ptr++;
+                dstPtr->jointWeights[5] = *ptr++;
+                dstPtr->jointWeights[6] = *ptr++;
+                dstPtr->jointWeights[7] = *ptr++;
             }
+        } else {
+            assert(0);
+        }
+    }
+
+    // --- indexes ---
+    if (bMeshSurf->indexSize == 4) {
+        for (int i = 0; i < bMeshSurf->numIndexes; i++) {
+            subMesh->indexes[i] = *(uint32_t *)ptr;
+            ptr += sizeof(uint32_t);
+        }
+    } else if (bMeshSurf->indexSize == 2) {
+        for (int i = 0; i < bMeshSurf->numIndexes; i++) {
+            subMesh->indexes[i] = *(uint16_t *)ptr;
+            ptr += sizeof(uint16_t);
         }
     }
 
-    fileSystem.FreeFile(data);
+    return ptr;
+}
 
-    FinishSurfaces();
+// Reads a surface of version 2.
+// Vertex, weight and index blocks are already in the memory layout, so each of them is copied at once.
+const byte *Mesh::ReadBinaryMeshSurf(const byte *data, size_t size, const byte *ptr) {
+    if (ptr < data || (size_t)(ptr - data) + sizeof(BMeshSurf2) > size) {
+        return nullptr;
+    }
 
-    return true;
+    BMeshSurf2 bMeshSurf;
+    memcpy(&bMeshSurf, ptr, sizeof(bMeshSurf));
+
+    uint32_t weightSize = 0;
+    int gpuSkinningVersionIndex = 0;
+    if (bMeshSurf.maxWeights > 0) {
+        if (bMeshSurf.maxWeights == 1) {
+            weightSize = sizeof(VertexWeight1);
+            gpuSkinningVersionIndex = 0;
+        } else if (bMeshSurf.maxWeights <= 4) {
+            weightSize = sizeof(VertexWeight4);
+            gpuSkinningVersionIndex = 1;
+        } else if (bMeshSurf.maxWeights <= 8) {
+            weightSize = sizeof(VertexWeight8);
+            gpuSkinningVersionIndex = 2;
+        } else {
+            return nullptr;
+        }
+    }
+
+    // Stored layout should be the same with the runtime layout
+    if (bMeshSurf.vertexSize != sizeof(VertexGenericLit) || bMeshSurf.weightSize != weightSize || bMeshSurf.indexSize != sizeof(TriIndex)) {
+        BE_WARNLOG(L"Mesh::ReadBinaryMeshSurf: vertex layout mismatch\n");
+        return nullptr;
+    }
+
+    // Counts are checked first so that the block sizes can't overflow
+    if (bMeshSurf.numVerts > size / sizeof(VertexGenericLit) || bMeshSurf.numIndexes > size / sizeof(TriIndex) || bMeshSurf.numIndexes % 3 != 0) {
+        return nullptr;
+    }
+
+    const size_t vertsSize = (size_t)bMeshSurf.numVerts * sizeof(VertexGenericLit);
+    const size_t weightsSize = (size_t)bMeshSurf.numVerts * weightSize;
+    const size_t indexesSize = (size_t)bMeshSurf.numIndexes * sizeof(TriIndex);
+
+    if (bMeshSurf.vertexOffset > size || vertsSize > size - bMeshSurf.vertexOffset ||
+        bMeshSurf.weightOffset > size || weightsSize > size - bMeshSurf.weightOffset ||
+        bMeshSurf.indexOffset > size || indexesSize > size - bMeshSurf.indexOffset || bMeshSurf.indexOffset % sizeof(TriIndex) != 0) {
+        return nullptr;
+    }
+
+    // Out of range indexes would be read by skinning and the GPU
+    const TriIndex *srcIndexes = (const TriIndex *)(data + bMeshSurf.indexOffset);
+    for (uint32_t i = 0; i < bMeshSurf.numIndexes; i++) {
+        if (srcIndexes[i] >= bMeshSurf.numVerts) {
+            return nullptr;
+        }
+    }
+
+    MeshSurf *meshSurf = AllocSurface(bMeshSurf.numVerts, bMeshSurf.numIndexes);
+    surfaces.Append(meshSurf);
+    SubMesh *subMesh = meshSurf->subMesh;
+    subMesh->aabb = AABB(bMeshSurf.aabbMin, bMeshSurf.aabbMax);
+
+    meshSurf->materialIndex = bMeshSurf.materialIndex;
+
+    // --- vertexes ---
+    simdProcessor->Memcpy(subMesh->verts, data + bMeshSurf.vertexOffset, vertsSize);
+
+    // --- vertex weights ---
+    if (weightSize > 0) {
+        subMesh->vertWeights = Mem_Alloc16(weightsSize);
+        subMesh->gpuSkinningVersionIndex = gpuSkinningVersionIndex;
+
+        simdProcessor->Memcpy(subMesh->vertWeights, data + bMeshSurf.weightOffset, weightsSize);
+    }
+
+    // --- indexes ---
+    simdProcessor->Memcpy(subMesh->indexes, data + bMeshSurf.indexOffset, indexesSize);
+
+    return data + bMeshSurf.indexOffset + indexesSize;
 }
 
 void Mesh::WriteBinaryMesh(const char *filename) {
@@ -191,92 +333,47 @@ void Mesh::WriteBinaryMesh(const char *filename) {
         }
     }
 
+    static const byte zeros[BMESH_BLOCK_ALIGN] = { 0, };
+
     // --- surfaces ---
     for (int surfaceIndex = 0; surfaceIndex < bMeshHeader.numSurfs; surfaceIndex++) {
         const MeshSurf *meshSurf = GetSurface(surfaceIndex);
         const SubMesh *subMesh = meshSurf->subMesh;
 
-        BMeshSurf bMeshSurf;
+        const uint32_t weightSize = subMesh->vertWeights ? subMesh->VertexWeightSize() : 0;
+        const uint32_t vertsSize = subMesh->numVerts * sizeof(VertexGenericLit);
+        const uint32_t weightsSize = subMesh->numVerts * weightSize;
+        const uint32_t indexesSize = subMesh->numIndexes * sizeof(TriIndex);
+
+        // Each block starts at the aligned offset
+        BMeshSurf2 bMeshSurf;
         bMeshSurf.materialIndex     = meshSurf->materialIndex;
         bMeshSurf.numVerts          = subMesh->numVerts;
         bMeshSurf.numIndexes        = subMesh->numIndexes;
-        bMeshSurf.indexSize         = subMesh->numIndexes < BIT(16) ? sizeof(uint16_t) : sizeof(uint32_t);
-        bMeshSurf.maxWeights        = subMesh->MaxVertexWeights();
+        bMeshSurf.maxWeights        = subMesh->vertWeights ? subMesh->MaxVertexWeights() : 0;
+        bMeshSurf.vertexSize        = sizeof(VertexGenericLit);
+        bMeshSurf.weightSize        = weightSize;
+        bMeshSurf.indexSize         = sizeof(TriIndex);
+        bMeshSurf.vertexOffset      = AlignUp(fp->Tell() + (int)sizeof(BMeshSurf2), BMESH_BLOCK_ALIGN);
+        bMeshSurf.weightOffset      = AlignUp(bMeshSurf.vertexOffset + vertsSize, BMESH_BLOCK_ALIGN);
+        bMeshSurf.indexOffset       = AlignUp(bMeshSurf.weightOffset + weightsSize, BMESH_BLOCK_ALIGN);
         bMeshSurf.aabbMin           = subMesh->GetAABB()[0];
         bMeshSurf.aabbMax           = subMesh->GetAABB()[1];
         fp->Write(&bMeshSurf, sizeof(bMeshSurf));
 
         // --- vertexes ---
-        for (int i = 0; i < subMesh->numVerts; i++) {
-            const VertexGenericLit *v = &subMesh->verts[i];
-            const Vec3 position     = v->GetPosition();
-            const Vec2 texCoord     = v->GetTexCoord();
-            const Vec3 normal       = v->GetNormal();
-            const Vec3 tangent      = v->GetTangent();
-            const Vec3 biTangent    = v->GetBiTangent();
-            
-            fp->Write(&position, sizeof(Vec3));
-            fp->Write(&texCoord, sizeof(Vec2));
-            fp->Write(&normal, sizeof(Vec3));
-            fp->Write(&tangent, sizeof(Vec3));
-            fp->Write(&biTangent, sizeof(Vec3));
-            fp->WriteUInt32(subMesh->verts[i].GetColor());
-        }
+        fp->Write(zeros, bMeshSurf.vertexOffset - fp->Tell());
+        fp->Write(subMesh->verts, vertsSize);
 
         // --- vertex weights ---
-        if (bMeshSurf.maxWeights > 0) {
-            if (bMeshSurf.maxWeights == 1) {
-                VertexWeight1 *vw = (VertexWeight1 *)subMesh->vertWeights;
-                for (int i = 0; i < bMeshSurf.numVerts; i++, vw++) {
-                    fp->WriteUChar(vw->jointIndex);
-                }
-            } else if (bMeshSurf.maxWeights <= 4) {
-                VertexWeight4 *vw = (VertexWeight4 *)subMesh->vertWeights;
-                for (int i = 0; i < bMeshSurf.numVerts; i++, vw++) {
-                    fp->WriteUChar(vw->jointIndexes[0]);
-                    fp->WriteUChar(vw->jointIndexes[1]);
-                    fp->WriteUChar(vw->jointIndexes[2]);
-                    fp->WriteUChar(vw->jointIndexes[3]);
-
-                    fp->WriteUChar(vw->jointWeights[0]);
-                    fp->WriteUChar(vw->jointWeights[1]);
-                    fp->WriteUChar(vw->jointWeights[2]);
-                    fp->WriteUChar(vw->jointWeights[3]);
-                }
-            } else if (bMeshSurf.maxWeights <= 8) {
-                VertexWeight8 *vw = (VertexWeight8 *)subMesh->vertWeights;
-                for (int i = 0; i < bMeshSurf.numVerts; i++, vw++) {
-                    fp->WriteUChar(vw->jointIndexes[0]);
-                    fp->WriteUChar(vw->jointIndexes[1]);
-                    fp->WriteUChar(vw->jointIndexes[2]);
-                    fp->WriteUChar(vw->jointIndexes[3]);
-                    fp->WriteUChar(vw->jointIndexes[4]);
-                    fp->WriteUChar(vw->jointIndexes[5]);
-                    fp->WriteUChar(vw->jointIndexes[6]);
-                    fp->WriteUChar(vw->jointIndexes[7]);
-
-                    fp->WriteUChar(vw->jointWeights[0]);
-                    fp->WriteUChar(vw->jointWeights[1]);
-                    fp->WriteUChar(vw->jointWeights[2]);
-                    fp->WriteUChar(vw->jointWeights[3]);
-                    fp->WriteUChar(vw->jointWeights[4]);
-                    fp->WriteUChar(vw->jointWeights[5]);
-                    fp->WriteUChar(vw->jointWeights[6]);
-                    fp->WriteUChar(vw->jointWeights[7]);
-                }
-            }
+        fp->Write(zeros, bMeshSurf.weightOffset - fp->Tell());
+        if (weightsSize > 0) {
+            fp->Write(subMesh->vertWeights, weightsSize);
         }
 
         // --- indexes ---
-        if (subMesh->numIndexes < BIT(16)) {
-            for (int i = 0; i < subMesh->numIndexes; i++) {
-                fp->WriteUInt16(subMesh->indexes[i]);
-            }
-        } else {
-            for (int i = 0; i < subMesh->numIndexes; i++) {
-                fp->WriteUInt32(subMesh->indexes[i]);
-            }
-        }
+        fp->Write(zeros, bMeshSurf.indexOffset - fp->Tell());
+        fp->Write(subMesh->indexes, indexesSize);
     }
 
     fileSystem.CloseFile(fp);
@@ -0,0 +1,311 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Render/Render.h"
+#include "RenderInternal.h"
+#include "Core/Heap.h"
+
+#if defined(__X86__)
+#include "Simd/SSE/sse.h"
+#endif
+
+BE_NAMESPACE_BEGIN
+
+OcclusionBuffer::OcclusionBuffer() {
+    depthBuffer = (float *)Mem_Alloc16(Width * Height * sizeof(float));
+    minClipW = 0.0f;
+
+    Clear(0.0f);
+}
+
+OcclusionBuffer::~OcclusionBuffer() {
+    Mem_AlignedFree(depthBuffer);
+}
+
+void OcclusionBuffer::Clear(float zNear) {
+    // 0 means infinitely far
+    memset(depthBuffer, 0, Width * Height * sizeof(float));
+    memset(tileMinDepths, 0, sizeof(tileMinDepths));
+
+    minClipW = Max(zNear, 0.0001f);
+    numRasterizedTris = 0;
+}
+
+void OcclusionBuffer::TransformVerts(const Mat4 &modelViewProjMatrix, const VertexGenericLit *verts, int numVerts) {
+    screenVerts.SetCount(numVerts, false);
+
+    const float halfWidth = Width * 0.5f;
+    const float halfHeight = Height * 0.5f;
+
+#if defined(__X86__)
+    // Columns of the matrix
+    const Mat4 transposedMatrix = modelViewProjMatrix.Transpose();
+    const ssef c0(transposedMatrix[0].Ptr());
+    const ssef c1(transposedMatrix[1].Ptr());
+    const ssef c2(transposedMatrix[2].Ptr());
+    const ssef c3(transposedMatrix[3].Ptr());
+
+    for (int i = 0; i < numVerts; i++) {
+        const Vec3 &xyz = verts[i].xyz;
+
+        const ssef clip = c0 * ssef(xyz.x) + c1 * ssef(xyz.y) + c2 * ssef(xyz.z) + c3;
+
+        Vec4 &screenVert = screenVerts[i];
+        screenVert.w = clip[3];
+
+        if (clip[3] >= minClipW) {
+            float invW = 1.0f / clip[3];
+            screenVert.x = (clip[0] * invW + 1.0f) * halfWidth;
+            screenVert.y = (clip[1] * invW + 1.0f) * halfHeight;
+            screenVert.z = invW;
+        }
+    }
+#else
+    for (int i = 0; i < numVerts; i++) {
+        Vec4 clip = modelViewProjMatrix * Vec4(verts[i].xyz, 1.0f);
+
+        Vec4 &screenVert = screenVerts[i];
+        screenVert.w = clip.w;
+
+        if (clip.w >= minClipW) {
+            float invW = 1.0f / clip.w;
+            screenVert.x = (clip.x * invW + 1.0f) * halfWidth;
+            screenVert.y = (clip.y * invW + 1.0f) * halfHeight;
+            screenVert.z = invW;
+        }
+    }
+#endif
+}
+
+void OcclusionBuffer::RasterizeMesh(const Mat4 &modelViewProjMatrix, const VertexGenericLit *verts, int numVerts, const TriIndex *indexes, int numIndexes) {
+    TransformVerts(modelViewProjMatrix, verts, numVerts);
+
+    for (int i = 0; i < numIndexes; i += 3) {
+        const Vec4 &v0 = screenVerts[indexes[i + 0]];
+        const Vec4 &v1 = screenVerts[indexes[i + 1]];
+        const Vec4 &v2 = screenVerts[indexes[i + 2]];
+
+        // Near plane clipping is not needed as long as occluders stay conservative
+        if (v0.w < minClipW || v1.w < minClipW || v2.w < minClipW) {
+            continue;
+        }
+
+        RasterizeTriangle(v0, v1, v2);
+    }
+}
+
+void OcclusionBuffer::RasterizeTriangle(const Vec4 &v0, const Vec4 &v1, const Vec4 &v2) {
+    const Vec4 *p0 = &v0;
+    const Vec4 *p1 = &v1;
+    const Vec4 *p2 = &v2;
+
+    // Both windings are rasterized, so occluders don't depend on the cull type of the material
+    float area = (p1->x - p0->x) * (p2->y - p0->y) - (p2->x - p0->x) * (p1->y - p0->y);
+    if (area < 0.0f) {
+        Swap(p1, p2);
+        area = -area;
+    }
+
+    if (area < 1e-6f) {
+        return;
+    }
+
+    const float minX = Min3(p0->x, p1->x, p2->x);
+    const float maxX = Max3(p0->x, p1->x, p2->x);
+    const float minY = Min3(p0->y, p1->y, p2->y);
+    const float maxY = Max3(p0->y, p1->y, p2->y);
+
+    if (maxX < 0.0f || maxY < 0.0f || minX >= Width || minY >= Height) {
+        return;
+    }
+
+    // x0 is aligned to 4 pixels for SIMD
+    const int x0 = (int)Max(minX, 0.0f) & ~3;
+    const int x1 = Min((int)maxX, Width - 1);
+    const int y0 = (int)Max(minY, 0.0f);
+    const int y1 = Min((int)maxY, Height - 1);
+
+    // Edge functions E(x, y) = A * x + B * y + C, positive inside of the triangle.
+    // C is pulled in by half a pixel along each axis, so the test at the pixel center passes
+    // only if the whole pixel is inside of the triangle.
+    const float a0 = p0->y - p1->y, b0 = p1->x - p0->x;
+    const float a1 = p1->y - p2->y, b1 = p2->x - p1->x;
+    const float a2 = p2->y - p0->y, b2 = p0->x - p2->x;
+    const float c0 = p0->x * p1->y - p1->x * p0->y - 0.5f * (Math::Fabs(a0) + Math::Fabs(b0));
+    const float c1 = p1->x * p2->y - p2->x * p1->y - 0.5f * (Math::Fabs(a1) + Math::Fabs(b1));
+    const float c2 = p2->x * p0->y - p0->x * p2->y - 0.5f * (Math::Fabs(a2) + Math::Fabs(b2));
+
+    // 1/w is linear in screen space. The depth at the pixel center is pushed back to the farthest
+    // depth over the pixel, so an occluder never gets nearer than it is.
+    const float invArea = 1.0f / area;
+    const float dzdx = ((p1->z - p0->z) * (p2->y - p0->y) - (p2->z - p0->z) * (p1->y - p0->y)) * invArea;
+    const float dzdy = ((p2->z - p0->z) * (p1->x - p0->x) - (p1->z - p0->z) * (p2->x - p0->x)) * invArea;
+    const float zc = p0->z - dzdx * p0->x - dzdy * p0->y - 0.5f * (Math::Fabs(dzdx) + Math::Fabs(dzdy));
+
+#if defined(__X86__)
+    const ssef zero(0.0f);
+    const ssef px = ssef((float)x0) + ssef(0.5f, 1.5f, 2.5f, 3.5f);
+
+    const ssef e0Start = ssef(a0) * px;
+    const ssef e1Start = ssef(a1) * px;
+    const ssef e2Start = ssef(a2) * px;
+    const ssef zStart = ssef(dzdx) * px;
+
+    const ssef e0Step(a0 * 4.0f);
+    const ssef e1Step(a1 * 4.0f);
+    const ssef e2Step(a2 * 4.0f);
+    const ssef zStep(dzdx * 4.0f);
+
+    for (int y = y0; y <= y1; y++) {
+        const float py = y + 0.5f;
+        float *row = &depthBuffer[y * Width];
+
+        ssef e0 = e0Start + ssef(b0 * py + c0);
+        ssef e1 = e1Start + ssef(b1 * py + c1);
+        ssef e2 = e2Start + ssef(b2 * py + c2);
+        ssef z = zStart + ssef(dzdy * py + zc);
+
+        for (int x = x0; x <= x1; x += 4) {
+            const sseb inside = (e0 >= zero) & (e1 >= zero) & (e2 >= zero);
+
+            if (any(inside)) {
+                const ssef depth = _mm_load_ps(row + x);
+                _mm_store_ps(row + x, select(inside, vmax(depth, vmax(z, zero)), depth));
+            }
+
+            e0 += e0Step;
+            e1 += e1Step;
+            e2 += e2Step;
+            z += zStep;
+        }
+    }
+#else
+    for (int y = y0; y <= y1; y++) {
+        const float py = y + 0.5f;
+        float *row = &depthBuffer[y * Width];
+
+        for (int x = x0; x <= x1; x++) {
+            const float px = x + 0.5f;
+
+            if (a0 * px + b0 * py + c0 >= 0.0f && a1 * px + b1 * py + c1 >= 0.0f && a2 * px + b2 * py + c2 >= 0.0f) {
+                row[x] = Max3(row[x], dzdx * px + dzdy * py + zc, 0.0f);
+            }
+        }
+    }
+#endif
+
+    numRasterizedTris++;
+}
+
+void OcclusionBuffer::BuildHierarchy() {
+    for (int ty = 0; ty < NumTilesY; ty++) {
+        for (int tx = 0; tx < NumTilesX; tx++) {
+            const float *tile = &depthBuffer[ty * TileHeight * Width + tx * TileWidth];
+
+#if defined(__X86__)
+            ssef minDepth = _mm_load_ps(tile);
+
+            for (int y = 0; y < TileHeight; y++) {
+                const float *row = tile + y * Width;
+
+                for (int x = 0; x < TileWidth; x += 4) {
+                    minDepth = vmin(minDepth, ssef(_mm_load_ps(row + x)));
+                }
+            }
+
+            tileMinDepths[ty * NumTilesX + tx] = reduce_min(minDepth);
+#else
+            float minDepth = tile[0];
+
+            for (int y = 0; y < TileHeight; y++) {
+                const float *row = tile + y * Width;
+
+                for (int x = 0; x < TileWidth; x++) {
+                    minDepth = Min(minDepth, row[x]);
+                }
+            }
+
+            tileMinDepths[ty * NumTilesX + tx] = minDepth;
+#endif
+        }
+    }
+}
+
+bool OcclusionBuffer::IsAABBOccluded(const Mat4 &viewProjMatrix, const AABB &aabb) const {
+    Vec3 points[8];
+    aabb.ToPoints(points);
+
+    float minX = Math::Infinity, maxX = -Math::Infinity;
+    float minY = Math::Infinity, maxY = -Math::Infinity;
+    float maxDepth = 0.0f;
+
+    for (int i = 0; i < 8; i++) {
+        Vec4 clip = viewProjMatrix * Vec4(points[i], 1.0f);
+
+        // Intersects the near plane
+        if (clip.w < minClipW) {
+            return false;
+        }
+
+        float invW = 1.0f / clip.w;
+        float x = (clip.x * invW + 1.0f) * (Width * 0.5f);
+        float y = (clip.y * invW + 1.0f) * (Height * 0.5f);
+
+        minX = Min(minX, x);
+        maxX = Max(maxX, x);
+        minY = Min(minY, y);
+        maxY = Max(maxY, y);
+        maxDepth = Max(maxDepth, invW);
+    }
+
+    // Pixels whose centers are covered by the screen bounds
+    const int x0 = Max((int)Math::Floor(minX), 0);
+    const int x1 = Min((int)Math::Ceil(maxX), (int)Width) - 1;
+    const int y0 = Max((int)Math::Floor(minY), 0);
+    const int y1 = Min((int)Math::Ceil(maxY), (int)Height) - 1;
+
+    if (x0 > x1 || y0 > y1) {
+        // Out of the screen, leave it to the frustum culling
+        return false;
+    }
+
+    for (int ty = y0 / TileHeight; ty <= y1 / TileHeight; ty++) {
+        for (int tx = x0 / TileWidth; tx <= x1 / TileWidth; tx++) {
+            // Every pixel in this tile is nearer than the bounds
+            if (tileMinDepths[ty * NumTilesX + tx] > maxDepth) {
+                continue;
+            }
+
+            const int px0 = Max(x0, tx * TileWidth);
+            const int px1 = Min(x1, tx * TileWidth + TileWidth - 1);
+            const int py0 = Max(y0, ty * TileHeight);
+            const int py1 = Min(y1, ty * TileHeight + TileHeight - 1);
+
+            for (int y = py0; y <= py1; y++) {
+                const float *row = &depthBuffer[y * Width];
+
+                for (int x = px0; x <= px1; x++) {
+                    if (row[x] <= maxDepth) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+BE_NAMESPACE_END
@@ -64,6 +64,9 @@ static int          rb_numDebugText = 0;
 static int          rb_debugTextTime = 0;
 
 void RB_ClearDebugPrimitives(int time) {
+    // Debug primitives are drawn by the render thread
+    renderSystem.SyncRenderThread();
+
     rb_debugPrimsTime = time;
 
     if (!time) {
@@ -95,6 +98,8 @@ void RB_ClearDebugPrimitives(int time) {
 }
 
 Vec3 *RB_ReserveDebugPrimsVerts(int prims, int numVerts, const Color4 &color, const float lineWidth, const bool twoSided, const bool depthTest, const int lifeTime) {
+    renderSystem.SyncRenderThread();
+
     DebugPrims *debugPrims;
     byte rgba[4];
 
@@ -259,6 +264,8 @@ static void RB_DrawDebugPrims() {
 }
 
 void RB_ClearDebugText(int time) {
+    renderSystem.SyncRenderThread();
+
     rb_debugTextTime = time;
 
     if (!time) {
@@ -286,6 +293,8 @@ void RB_ClearDebugText(int time) {
 }
 
 void RB_AddDebugText(const char *text, const Vec3 &origin, const Mat3 &viewAxis, float scale, float lineWidth, const Color4 &color, const int align, const int lifeTime, const bool depthTest) {
+    renderSystem.SyncRenderThread();
+
     DebugText *debugText;
     byte rgba[4];
 
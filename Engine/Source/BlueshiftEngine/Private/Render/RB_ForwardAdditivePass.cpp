@@ -52,6 +52,32 @@ static void RB_LitPass(const viewLight_t *viewLight) {
                 continue;    
             }
 
+            if (litSurfNode->numInstances > 0) {
+                if (prevMaterial) {
+                    backEnd.rbsurf.Flush();
+                }
+
+                if (prevDepthHack) {
+                    rhi.SetDepthRange(0.0f, 1.0f);
+                    prevDepthHack = false;
+                }
+
+                // Instances are transformed with the per-instance model view projection matrix,
+                // and the light is transformed to each instance in the vertex shader
+                backEnd.rbsurf.Begin(RBSurf::LitFlush, surf->material, surf->materialRegisters, surf->space, viewLight);
+                backEnd.rbsurf.DrawInstancedSubMesh(surf->subMesh, litSurfNode->instanceBufferCache, litSurfNode->numInstances);
+
+                // Skip the following nodes drawn as instances
+                for (int i = 1; i < litSurfNode->numInstances; i++) {
+                    litSurfNode = litSurfNode->next;
+                }
+
+                prevSortkey = -1;
+                prevSpace = nullptr;
+                prevMaterial = nullptr;
+                continue;
+            }
+
             if (surf->material != prevMaterial || surf->space != prevSpace) {
                 if (prevMaterial) {
                     backEnd.rbsurf.Flush();
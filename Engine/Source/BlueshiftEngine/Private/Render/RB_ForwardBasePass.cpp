@@ -46,6 +46,30 @@ static void RB_BasePass(int numDrawSurfs, DrawSurf **drawSurfs) {
                 continue;
             }
 
+            if (surf->numInstances > 0) {
+                if (prevMaterial) {
+                    backEnd.rbsurf.Flush();
+                }
+
+                if (prevDepthHack) {
+                    rhi.SetDepthRange(0.0f, 1.0f);
+                    prevDepthHack = false;
+                }
+
+                // Instances are transformed with the per-instance model view projection matrix,
+                // and the primary light is transformed to each instance in the vertex shader
+                backEnd.rbsurf.Begin(RBSurf::AmbientFlush, surf->material, surf->materialRegisters, surf->space, backEnd.primaryLight);
+                backEnd.rbsurf.DrawInstancedSubMesh(surf->subMesh, surf->instanceBufferCache, surf->numInstances);
+
+                // Skip the following surfaces drawn as instances
+                i += surf->numInstances - 1;
+
+                prevSortkey = -1;
+                prevSpace = nullptr;
+                prevMaterial = nullptr;
+                continue;
+            }
+
             bool isDifferentEntity = surf->space != prevSpace ? true : false;
             bool isDifferentMaterial = surf->material != prevMaterial ? true : false;
 
@@ -16,6 +16,7 @@
 #include "Render/Render.h"
 #include "RenderInternal.h"
 #include "Platform/PlatformTime.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -698,6 +699,9 @@ static void RB_Draw2DView() {
 }
 
 static const void *RB_ExecuteDrawView(const void *data) {
+    BE_PROFILE_CPU_SCOPE("RB_ExecuteDrawView");
+    BE_PROFILE_GPU_SCOPE("DrawView");
+
     DrawViewRenderCommand *cmd = (DrawViewRenderCommand *)data;
 
     backEnd.view            = &cmd->view;
@@ -1070,6 +1074,9 @@ static const void *RB_ExecuteSwapBuffers(const void *data) {
 }
 
 void RB_Execute(const void *data) {
+    BE_PROFILE_CPU_SCOPE("RB_Execute");
+    BE_PROFILE_GPU_SCOPE("RB_Execute");
+
     int t1, t2;
 
     t1 = PlatformTime::Milliseconds();
@@ -452,6 +452,28 @@ static bool RB_ShadowMapPass(const viewLight_t *viewLight, const Frustum &viewFr
             backEnd.projMatrix = backEnd.shadowProjectionMatrix;
         }
 
+        if (shadowCasterSurfNode->numInstances > 0) {
+            backEnd.rbsurf.Flush();
+
+            // Instances are transformed to world space in the vertex shader
+            backEnd.modelViewMatrix = viewLight->def->viewMatrix;
+            backEnd.modelViewProjMatrix = backEnd.projMatrix * backEnd.modelViewMatrix;
+
+            backEnd.rbsurf.Begin(RBSurf::ShadowFlush, surf->material, surf->materialRegisters, surf->space, viewLight);
+            backEnd.rbsurf.DrawInstancedSubMesh(surf->subMesh, shadowCasterSurfNode->instanceBufferCache, shadowCasterSurfNode->numInstances);
+
+            // Skip the following nodes drawn as instances
+            for (int i = 1; i < shadowCasterSurfNode->numInstances; i++) {
+                shadowCasterSurfNode = shadowCasterSurfNode->next;
+            }
+
+            prevSortkey = -1;
+            prevSpace = nullptr;
+            prevMaterial = nullptr;
+            entity2 = nullptr;
+            continue;
+        }
+
         if (surf->space != entity2) {
             entity2 = surf->space;
 
@@ -29,6 +29,7 @@ void RBSurf::Init() {
     numVerts = 0;
     numIndexes = 0;
     numInstances = 0;
+    instanceBufferCache = nullptr;
 
     material = nullptr;
     subMesh = nullptr;
@@ -51,9 +52,9 @@ void RBSurf::Begin(int flushType, const Material *material, const float *materia
 }
 
 void RBSurf::DrawSubMesh(SubMesh *subMesh) {
-    if (subMesh->GetType() == Mesh::ReferenceMesh || 
+    if ((subMesh->GetType() == Mesh::ReferenceMesh || 
         subMesh->GetType() == Mesh::StaticMesh || 
-        subMesh->GetType() == Mesh::SkinnedMesh) {
+        subMesh->GetType() == Mesh::SkinnedMesh) && !subMesh->IsCpuSkinning()) {
         DrawStaticSubMesh(subMesh);
     } else {
         DrawDynamicSubMesh(subMesh);
@@ -80,6 +81,26 @@ void RBSurf::DrawStaticSubMesh(SubMesh *subMesh) {
     Flush();
 }
 
+void RBSurf::DrawInstancedSubMesh(SubMesh *subMesh, const BufferCache *instanceBufferCache, int numInstances) {
+    if (this->numIndexes) {
+        Flush();
+    }
+
+    this->startIndex = 0;
+
+    this->vbHandle = subMesh->vertexCache->buffer;
+    this->ibHandle = subMesh->indexCache->buffer;
+
+    this->numVerts = subMesh->numVerts;
+    this->numIndexes = subMesh->numIndexes;
+    this->numInstances = numInstances;
+    this->instanceBufferCache = instanceBufferCache;
+
+    this->subMesh = subMesh;
+
+    Flush();
+}
+
 void RBSurf::DrawDynamicSubMesh(SubMesh *subMesh) {
     if (startIndex < 0) {
         // startIndex 는 Flush 후에 -1 로 세팅된다
@@ -182,6 +203,7 @@ void RBSurf::Flush() {
     numVerts = 0;
     numIndexes = 0;
     numInstances = 0;
+    instanceBufferCache = nullptr;
 }
 
 // Converts 24-bit ID to Vec3
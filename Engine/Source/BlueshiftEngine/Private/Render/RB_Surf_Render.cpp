@@ -28,31 +28,35 @@ void RBSurf::DrawPrimitives() const {
         rhi.DrawElements(RHI::TrianglesPrim, startIndex, numIndexes, sizeof(TriIndex), 0);
     }
 
+    const int instanceCount = Max(numInstances, 1);
+
     if (flushType == ShadowFlush) {
         backEnd.ctx->renderCounter.shadowDrawCalls++;
-        backEnd.ctx->renderCounter.shadowDrawIndexes += numIndexes;
-        backEnd.ctx->renderCounter.shadowDrawVerts += numVerts;
+        backEnd.ctx->renderCounter.shadowDrawIndexes += numIndexes * instanceCount;
+        backEnd.ctx->renderCounter.shadowDrawVerts += numVerts * instanceCount;
     } else {
         backEnd.ctx->renderCounter.drawCalls++;
-        backEnd.ctx->renderCounter.drawIndexes += numIndexes;
-        backEnd.ctx->renderCounter.drawVerts += numVerts;
+        backEnd.ctx->renderCounter.drawIndexes += numIndexes * instanceCount;
+        backEnd.ctx->renderCounter.drawVerts += numVerts * instanceCount;
     }
 }
 
 void RBSurf::SetShaderProperties(const Shader *shader, const StrHashMap<Shader::Property> &shaderProperties) const {
     const auto &specHashMap = shader->GetSpecHashMap();
+    assert(shader->propertyLocations.Count() == specHashMap.Count());
 
     // Iterate over all shader property specs
     for (int i = 0; i < specHashMap.Count(); i++) {
+        // Skip if it is a shader define or not used in the shader
+        const int location = shader->propertyLocations[i];
+        if (location < 0) {
+            continue;
+        }
+
         const auto *entry = specHashMap.GetByIndex(i);
         const auto &key = entry->first;
         const auto &spec = entry->second;
 
-        // Skip if it is a shader define
-        if (spec.GetFlags() & PropertySpec::ShaderDefine) {
-            continue;
-        }
-
         // Skip if not exist in shader properties
         const auto *propEntry = shaderProperties.Get(key);
         if (!propEntry) {
@@ -63,30 +67,30 @@ void RBSurf::SetShaderProperties(const Shader *shader, const StrHashMap<Shader::
 
         switch (spec.GetType()) {
         case PropertySpec::FloatType:
-            shader->SetConstant1f(key, prop.data.As<float>());
+            shader->SetConstant1f(location, prop.data.As<float>());
             break;
         case PropertySpec::Vec2Type:
-            shader->SetConstant2f(key, prop.data.As<Vec2>());
+            shader->SetConstant2f(location, prop.data.As<Vec2>());
             break;
         case PropertySpec::Vec3Type:
         case PropertySpec::Color3Type:
-            shader->SetConstant3f(key, prop.data.As<Vec3>());
+            shader->SetConstant3f(location, prop.data.As<Vec3>());
             break;
         case PropertySpec::Vec4Type:
         case PropertySpec::Color4Type:
-            shader->SetConstant4f(key, prop.data.As<Vec4>());
+            shader->SetConstant4f(location, prop.data.As<Vec4>());
             break;
         case PropertySpec::PointType:
-            shader->SetConstant2i(key, prop.data.As<Point>());
+            shader->SetConstant2i(location, prop.data.As<Point>());
             break;
         case PropertySpec::RectType:
-            shader->SetConstant4i(key, prop.data.As<Rect>());
+            shader->SetConstant4i(location, prop.data.As<Rect>());
             break;
         case PropertySpec::Mat3Type:
-            shader->SetConstant3x3f(key, true, prop.data.As<Mat3>());
+            shader->SetConstant3x3f(location, true, prop.data.As<Mat3>());
             break;
         case PropertySpec::ObjectType: // 
-            shader->SetTexture(key, prop.texture);
+            shader->SetTexture(location, prop.texture);
             break;
         default:
             assert(0);
@@ -164,25 +168,34 @@ void RBSurf::SetSkinningConstants(const Shader *shader, const SkinningJointCache
     }
 
     if (renderGlobal.skinningMethod == Mesh::VertexShaderSkinning) {
-        shader->SetConstantArray4f("joints", cache->numJoints * 3, cache->skinningJoints[0].Ptr());
+        if (renderGlobal.useUniformBuffer) {
+            // Joints are uploaded once per frame in Mesh::UpdateSkinningJointCache()
+            shader->SetConstantBuffer(shader->builtInConstantBlockIndexes[Shader::JointsBlock], cache->bufferCache.buffer, cache->bufferCache.offset);
+        } else {
+            shader->SetConstantArray4f(shader->builtInConstantLocations[Shader::JointsConst], cache->numJoints * 3, cache->skinningJoints[0].Ptr());
+        }
     } else if (renderGlobal.skinningMethod == Mesh::VtfSkinning) {
         const Texture *jointsMapTexture = cache->bufferCache.texture;
-        shader->SetTexture("jointsMap", jointsMapTexture);
+        shader->SetTexture(shader->builtInSamplerUnits[Shader::JointsMapSampler], jointsMapTexture);
 
         if (renderGlobal.vtUpdateMethod == Mesh::TboUpdate) {
-            shader->SetConstant1i("tcBase", cache->bufferCache.tcBase[0]);
+            shader->SetConstant1i(shader->builtInConstantLocations[Shader::TcBaseConst], cache->bufferCache.tcBase[0]);
         } else {
-            shader->SetConstant2f("invJointsMapSize", Vec2(1.0f / jointsMapTexture->GetWidth(), 1.0f / jointsMapTexture->GetHeight()));
-            shader->SetConstant2f("tcBase", Vec2(cache->bufferCache.tcBase[0], cache->bufferCache.tcBase[1]));
+            shader->SetConstant2f(shader->builtInConstantLocations[Shader::InvJointsMapSizeConst], Vec2(1.0f / jointsMapTexture->GetWidth(), 1.0f / jointsMapTexture->GetHeight()));
+            shader->SetConstant2f(shader->builtInConstantLocations[Shader::TcBaseConst], Vec2(cache->bufferCache.tcBase[0], cache->bufferCache.tcBase[1]));
         }
 
         if (r_usePostProcessing.GetBool() && (r_motionBlur.GetInteger() & 2)) {
-            shader->SetConstant1i("jointIndexOffsetCurr", cache->jointIndexOffsetCurr);
-            shader->SetConstant1i("jointIndexOffsetPrev", cache->jointIndexOffsetPrev);
+            shader->SetConstant1i(shader->builtInConstantLocations[Shader::JointIndexOffsetCurrConst], cache->jointIndexOffsetCurr);
+            shader->SetConstant1i(shader->builtInConstantLocations[Shader::JointIndexOffsetPrevConst], cache->jointIndexOffsetPrev);
         }
     }
 }
 
+void RBSurf::SetInstancingConstants(const Shader *shader) const {
+    shader->SetConstantBuffer(shader->builtInConstantBlockIndexes[Shader::InstanceDataBlock], instanceBufferCache->buffer, instanceBufferCache->offset);
+}
+
 void RBSurf::RenderColor(const Color4 &color) const {
     Shader *shader = ShaderManager::constantColorShader;
 
@@ -197,8 +210,7 @@ void RBSurf::RenderColor(const Color4 &color) const {
     SetMatrixConstants(shader);
 
     if (subMesh->useGpuSkinning) {
-        const Mesh *mesh = surfSpace->def->parms.mesh;
-        SetSkinningConstants(shader, mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
 
     shader->SetConstant4f("color", color);
@@ -224,12 +236,11 @@ void RBSurf::RenderSelection(const Material::ShaderPass *mtrlPass, const Vec3 &v
     SetMatrixConstants(shader);
 
     if (subMesh->useGpuSkinning) {
-        const Mesh *mesh = surfSpace->def->parms.mesh;
-        SetSkinningConstants(shader, mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
 
     if (mtrlPass->renderingMode == Material::RenderingMode::AlphaCutoff) {
-        shader->SetConstant1f("perforatedAlpha", mtrlPass->cutoffAlpha);
+        shader->SetConstant1f(shader->builtInConstantLocations[Shader::PerforatedAlphaConst], mtrlPass->cutoffAlpha);
 
         Vec4 textureMatrixS = Vec4(mtrlPass->tcScale[0], 0.0f, 0.0f, mtrlPass->tcTranslation[0]);
         Vec4 textureMatrixT = Vec4(0.0f, mtrlPass->tcScale[1], 0.0f, mtrlPass->tcTranslation[1]);
@@ -244,7 +255,7 @@ void RBSurf::RenderSelection(const Material::ShaderPass *mtrlPass, const Vec3 &v
             color = mtrlPass->constantColor;
         }
 
-        shader->SetConstant4f("constantColor", color);
+        shader->SetConstant4f(shader->builtInConstantLocations[Shader::ConstantColorConst], color);
 
         const Texture *baseTexture = mtrlPass->shader ? TextureFromShaderProperties(mtrlPass, "albedoMap") : mtrlPass->texture;
         shader->SetTexture(shader->builtInSamplerUnits[Shader::AlbedoMapSampler], baseTexture);
@@ -256,13 +267,18 @@ void RBSurf::RenderSelection(const Material::ShaderPass *mtrlPass, const Vec3 &v
 }
 
 void RBSurf::RenderDepth(const Material::ShaderPass *mtrlPass) const {
-    Shader *shader = ShaderManager::depthShader;
+    // Instanced shadow casters are transformed to world space first, the shadow cascades share the per-instance data
+    Shader *shader = flushType == ShadowFlush ? ShaderManager::shadowDepthShader : ShaderManager::depthShader;
 
     if (mtrlPass->renderingMode == Material::RenderingMode::AlphaCutoff && shader->GetPerforatedVersion()) {
         shader = shader->GetPerforatedVersion();
     }
 
-    if (subMesh->useGpuSkinning) {
+    if (numInstances > 0) {
+        // Only the surfaces having the instancing version of the shader are instanced in RenderWorld::BuildInstancedDrawSurfs()
+        assert(shader->GetInstancingVersion());
+        shader = shader->GetInstancingVersion();
+    } else if (subMesh->useGpuSkinning) {
         if (shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex)) {
             shader = shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex);
         }
@@ -272,13 +288,16 @@ void RBSurf::RenderDepth(const Material::ShaderPass *mtrlPass) const {
 
     SetMatrixConstants(shader);
 
+    if (numInstances > 0) {
+        SetInstancingConstants(shader);
+    }
+
     if (subMesh->useGpuSkinning) {
-        const Mesh *mesh = surfSpace->def->parms.mesh;
-        SetSkinningConstants(shader, mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
 
     if (mtrlPass->renderingMode == Material::RenderingMode::AlphaCutoff) {
-        shader->SetConstant1f("perforatedAlpha", mtrlPass->cutoffAlpha);
+        shader->SetConstant1f(shader->builtInConstantLocations[Shader::PerforatedAlphaConst], mtrlPass->cutoffAlpha);
 
         Vec4 textureMatrixS = Vec4(mtrlPass->tcScale[0], 0.0f, 0.0f, mtrlPass->tcTranslation[0]);
         Vec4 textureMatrixT = Vec4(0.0f, mtrlPass->tcScale[1], 0.0f, mtrlPass->tcTranslation[1]);
@@ -293,7 +312,7 @@ void RBSurf::RenderDepth(const Material::ShaderPass *mtrlPass) const {
             color = mtrlPass->constantColor;
         }
 
-        shader->SetConstant4f("constantColor", color);
+        shader->SetConstant4f(shader->builtInConstantLocations[Shader::ConstantColorConst], color);
 
         const Texture *baseTexture = mtrlPass->shader ? TextureFromShaderProperties(mtrlPass, "albedoMap") : mtrlPass->texture;
         shader->SetTexture(shader->builtInSamplerUnits[Shader::AlbedoMapSampler], baseTexture);
@@ -323,15 +342,15 @@ void RBSurf::RenderVelocity(const Material::ShaderPass *mtrlPass) const {
     //shader->SetConstantMatrix4fv("prevModelViewMatrix", 1, true, prevModelViewMatrix);
 
     Mat4 prevModelViewProjMatrix = backEnd.view->def->projMatrix * prevModelViewMatrix;
-    shader->SetConstant4x4f("prevModelViewProjectionMatrix", true, prevModelViewProjMatrix);
+    shader->SetConstant4x4f(shader->builtInConstantLocations[Shader::PrevModelViewProjectionMatrixConst], true, prevModelViewProjMatrix);
 
-    shader->SetConstant1f("shutterSpeed", r_motionBlur_ShutterSpeed.GetFloat() / backEnd.ctx->frameTime);
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::ShutterSpeedConst], r_motionBlur_ShutterSpeed.GetFloat() / backEnd.ctx->frameTime);
     //shader->SetConstant1f("motionBlurID", (float)surfSpace->id);
 
-    shader->SetTexture("depthMap", backEnd.ctx->screenDepthTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::DepthMapSampler], backEnd.ctx->screenDepthTexture);
 
     if (mtrlPass->renderingMode == Material::RenderingMode::AlphaCutoff) {
-        shader->SetConstant1f("perforatedAlpha", mtrlPass->cutoffAlpha);
+        shader->SetConstant1f(shader->builtInConstantLocations[Shader::PerforatedAlphaConst], mtrlPass->cutoffAlpha);
 
         const Texture *baseTexture = mtrlPass->shader ? TextureFromShaderProperties(mtrlPass, "albedoMap") : mtrlPass->texture;
         shader->SetTexture(shader->builtInSamplerUnits[Shader::AlbedoMapSampler], baseTexture);
@@ -344,8 +363,7 @@ void RBSurf::RenderVelocity(const Material::ShaderPass *mtrlPass) const {
     }
 
     if (subMesh->useGpuSkinning) {
-        const Mesh *mesh = surfSpace->def->parms.mesh;
-        SetSkinningConstants(shader, mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
 
     DrawPrimitives();
@@ -389,8 +407,7 @@ void RBSurf::RenderGeneric(const Material::ShaderPass *mtrlPass) const {
     SetMatrixConstants(shader);
 
     if (subMesh->useGpuSkinning) {
-        const Mesh *mesh = surfSpace->def->parms.mesh;
-        SetSkinningConstants(shader, mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
 
     Vec3 localViewOrigin = surfSpace->def->parms.axis.TransposedMulVec(backEnd.view->def->parms.origin - surfSpace->def->parms.origin) / surfSpace->def->parms.scale;
@@ -418,7 +435,7 @@ void RBSurf::RenderGeneric(const Material::ShaderPass *mtrlPass) const {
     }
 
     shader->SetConstant4f(shader->builtInConstantLocations[Shader::ConstantColorConst], color);
-    shader->SetConstant1f("ambientScale", 1.0f);
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::AmbientScaleConst], 1.0f);
 
     DrawPrimitives();
 }
@@ -430,7 +447,11 @@ void RBSurf::RenderAmbient(const Material::ShaderPass *mtrlPass, float ambientSc
         shader = shader->GetPerforatedVersion();
     }
 
-    if (subMesh->useGpuSkinning) {
+    if (numInstances > 0) {
+        // Only the surfaces having the instancing version of the shader are instanced in RenderWorld::BuildInstancedDrawSurfs()
+        assert(shader->GetInstancingVersion());
+        shader = shader->GetInstancingVersion();
+    } else if (subMesh->useGpuSkinning) {
         if (shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex)) {
             shader = shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex);
         }
@@ -440,16 +461,19 @@ void RBSurf::RenderAmbient(const Material::ShaderPass *mtrlPass, float ambientSc
 
     SetMatrixConstants(shader);
 
+    if (numInstances > 0) {
+        SetInstancingConstants(shader);
+    }
+
     if (subMesh->useGpuSkinning) {
-        const Mesh *mesh = surfSpace->def->parms.mesh;
-        SetSkinningConstants(shader, mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
 
     const Texture *baseTexture = mtrlPass->shader ? TextureFromShaderProperties(mtrlPass, "albedoMap") : mtrlPass->texture;
     shader->SetTexture(shader->builtInSamplerUnits[Shader::AlbedoMapSampler], baseTexture);
 
     if (mtrlPass->renderingMode == Material::RenderingMode::AlphaCutoff) {
-        shader->SetConstant1f("perforatedAlpha", mtrlPass->cutoffAlpha);
+        shader->SetConstant1f(shader->builtInConstantLocations[Shader::PerforatedAlphaConst], mtrlPass->cutoffAlpha);
     }
 
     Vec4 textureMatrixS = Vec4(mtrlPass->tcScale[0], 0.0f, 0.0f, mtrlPass->tcTranslation[0]);
@@ -468,7 +492,7 @@ void RBSurf::RenderAmbient(const Material::ShaderPass *mtrlPass, float ambientSc
     }
 
     shader->SetConstant4f(shader->builtInConstantLocations[Shader::ConstantColorConst], color);
-    shader->SetConstant1f("ambientScale", ambientScale);
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::AmbientScaleConst], ambientScale);
 
     DrawPrimitives();
 }
@@ -486,7 +510,11 @@ void RBSurf::RenderAmbientLit(const Material::ShaderPass *mtrlPass, float ambien
         shader = shader->GetPerforatedVersion();
     }
 
-    if (subMesh->useGpuSkinning) {
+    if (numInstances > 0) {
+        // Only the surfaces having the instancing version of the shader are instanced in RenderWorld::BuildInstancedDrawSurfs()
+        assert(shader->GetInstancingVersion());
+        shader = shader->GetInstancingVersion();
+    } else if (subMesh->useGpuSkinning) {
         if (shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex)) {
             shader = shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex);
         }
@@ -507,19 +535,22 @@ void RBSurf::RenderAmbientLit(const Material::ShaderPass *mtrlPass, float ambien
 
     SetMatrixConstants(shader);
 
+    if (numInstances > 0) {
+        SetInstancingConstants(shader);
+    }
+
     if (subMesh->useGpuSkinning) {
-        const Mesh *mesh = surfSpace->def->parms.mesh;
-        SetSkinningConstants(shader, mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
 
     // TODO:
-    shader->SetTexture("envCubeMap", backEnd.envCubeTexture);
-    shader->SetTexture("integrationLUTMap", backEnd.integrationLUTTexture);
-    shader->SetTexture("irradianceEnvCubeMap0", backEnd.irradianceEnvCubeTexture);
-    shader->SetTexture("irradianceEnvCubeMap1", backEnd.irradianceEnvCubeTexture);
-    shader->SetTexture("prefilteredEnvCubeMap0", backEnd.prefilteredEnvCubeTexture);
-    shader->SetTexture("prefilteredEnvCubeMap1", backEnd.prefilteredEnvCubeTexture);
-    shader->SetConstant1f("ambientLerp", 0.0f);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::EnvCubeMapSampler], backEnd.envCubeTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::IntegrationLUTMapSampler], backEnd.integrationLUTTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::IrradianceEnvCubeMap0Sampler], backEnd.irradianceEnvCubeTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::IrradianceEnvCubeMap1Sampler], backEnd.irradianceEnvCubeTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::PrefilteredEnvCubeMap0Sampler], backEnd.prefilteredEnvCubeTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::PrefilteredEnvCubeMap1Sampler], backEnd.prefilteredEnvCubeTexture);
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::AmbientLerpConst], 0.0f);
 
     // view vector: world -> to mesh coordinates
     Vec3 localViewOrigin = surfSpace->def->parms.axis.TransposedMulVec(backEnd.view->def->parms.origin - surfSpace->def->parms.origin) / surfSpace->def->parms.scale;
@@ -532,7 +563,7 @@ void RBSurf::RenderAmbientLit(const Material::ShaderPass *mtrlPass, float ambien
     shader->SetConstant4f(shader->builtInConstantLocations[Shader::WorldMatrixRConst], worldMatrix[2]);
 
     if (mtrlPass->renderingMode == Material::RenderingMode::AlphaCutoff) {
-        shader->SetConstant1f("perforatedAlpha", mtrlPass->cutoffAlpha);
+        shader->SetConstant1f(shader->builtInConstantLocations[Shader::PerforatedAlphaConst], mtrlPass->cutoffAlpha);
     }
 
     Vec4 textureMatrixS = Vec4(mtrlPass->tcScale[0], 0.0f, 0.0f, mtrlPass->tcTranslation[0]);
@@ -551,7 +582,7 @@ void RBSurf::RenderAmbientLit(const Material::ShaderPass *mtrlPass, float ambien
     }
 
     shader->SetConstant4f(shader->builtInConstantLocations[Shader::ConstantColorConst], color);
-    shader->SetConstant1f("ambientScale", ambientScale);
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::AmbientScaleConst], ambientScale);
 
     DrawPrimitives();
 }
@@ -580,7 +611,11 @@ void RBSurf::RenderAmbient_DirectLit(const Material::ShaderPass *mtrlPass, float
         shader = shader->GetPerforatedVersion();
     }
 
-    if (subMesh->useGpuSkinning) {
+    if (numInstances > 0) {
+        // Only the surfaces having the instancing version of the shader are instanced in RenderWorld::BuildInstancedDrawSurfs()
+        assert(shader->GetInstancingVersion());
+        shader = shader->GetInstancingVersion();
+    } else if (subMesh->useGpuSkinning) {
         if (shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex)) {
             shader = shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex);
         }
@@ -601,11 +636,15 @@ void RBSurf::RenderAmbient_DirectLit(const Material::ShaderPass *mtrlPass, float
 
     SetMatrixConstants(shader);
 
+    if (numInstances > 0) {
+        SetInstancingConstants(shader);
+    }
+
     if (mtrlPass->renderingMode == Material::RenderingMode::AlphaCutoff) {
-        shader->SetConstant1f("perforatedAlpha", mtrlPass->cutoffAlpha);
+        shader->SetConstant1f(shader->builtInConstantLocations[Shader::PerforatedAlphaConst], mtrlPass->cutoffAlpha);
     }
 
-    shader->SetConstant1f("ambientScale", ambientScale);
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::AmbientScaleConst], ambientScale);
 
     SetupLightingShader(mtrlPass, shader, useShadowMap);
 
@@ -636,7 +675,11 @@ void RBSurf::RenderAmbientLit_DirectLit(const Material::ShaderPass *mtrlPass, fl
         shader = shader->GetPerforatedVersion();
     }
 
-    if (subMesh->useGpuSkinning) {
+    if (numInstances > 0) {
+        // Only the surfaces having the instancing version of the shader are instanced in RenderWorld::BuildInstancedDrawSurfs()
+        assert(shader->GetInstancingVersion());
+        shader = shader->GetInstancingVersion();
+    } else if (subMesh->useGpuSkinning) {
         if (shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex)) {
             shader = shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex);
         }
@@ -657,20 +700,24 @@ void RBSurf::RenderAmbientLit_DirectLit(const Material::ShaderPass *mtrlPass, fl
 
     SetMatrixConstants(shader);
 
+    if (numInstances > 0) {
+        SetInstancingConstants(shader);
+    }
+
     if (mtrlPass->renderingMode == Material::RenderingMode::AlphaCutoff) {
-        shader->SetConstant1f("perforatedAlpha", mtrlPass->cutoffAlpha);
+        shader->SetConstant1f(shader->builtInConstantLocations[Shader::PerforatedAlphaConst], mtrlPass->cutoffAlpha);
     }
 
-    shader->SetConstant1f("ambientScale", ambientScale);
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::AmbientScaleConst], ambientScale);
 
     // TODO:
-    shader->SetTexture("envCubeMap", backEnd.envCubeTexture);
-    shader->SetTexture("integrationLUTMap", backEnd.integrationLUTTexture);
-    shader->SetTexture("irradianceEnvCubeMap0", backEnd.irradianceEnvCubeTexture);
-    shader->SetTexture("irradianceEnvCubeMap1", backEnd.irradianceEnvCubeTexture);
-    shader->SetTexture("prefilteredEnvCubeMap0", backEnd.prefilteredEnvCubeTexture);
-    shader->SetTexture("prefilteredEnvCubeMap1", backEnd.prefilteredEnvCubeTexture);
-    shader->SetConstant1f("ambientLerp", 0.0f);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::EnvCubeMapSampler], backEnd.envCubeTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::IntegrationLUTMapSampler], backEnd.integrationLUTTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::IrradianceEnvCubeMap0Sampler], backEnd.irradianceEnvCubeTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::IrradianceEnvCubeMap1Sampler], backEnd.irradianceEnvCubeTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::PrefilteredEnvCubeMap0Sampler], backEnd.prefilteredEnvCubeTexture);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::PrefilteredEnvCubeMap1Sampler], backEnd.prefilteredEnvCubeTexture);
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::AmbientLerpConst], 0.0f);
 
     SetupLightingShader(mtrlPass, shader, useShadowMap);
 
@@ -718,6 +765,17 @@ void RBSurf::SetupLightingShader(const Material::ShaderPass *mtrlPass, const Sha
     localLightAxis[1] *= surfSpace->def->parms.scale;
     localLightAxis[2] *= surfSpace->def->parms.scale;
 
+    if (numInstances > 0) {
+        // Light parameters are in world space in instanced draw, the vertex shader transforms them to each instance
+        if (surfLight->def->parms.type == SceneLight::DirectionalLight) {
+            localLightOrigin = Vec4(-surfLight->def->parms.axis[0], 1.0f);
+        } else {
+            localLightOrigin = Vec4(surfLight->def->parms.origin, 0.0f);
+        }
+
+        localLightAxis = surfLight->def->parms.axis;
+    }
+
     shader->SetConstant3f(shader->builtInConstantLocations[Shader::LocalViewOriginConst], localViewOrigin);
     shader->SetConstant4f(shader->builtInConstantLocations[Shader::LocalLightOriginConst], localLightOrigin);
     shader->SetConstant3x3f(shader->builtInConstantLocations[Shader::LocalLightAxisConst], false, localLightAxis);
@@ -740,26 +798,25 @@ void RBSurf::SetupLightingShader(const Material::ShaderPass *mtrlPass, const Sha
     shader->SetConstant4f(shader->builtInConstantLocations[Shader::ConstantColorConst], color);
 
     if (subMesh->useGpuSkinning) {
-        const Mesh *mesh = surfSpace->def->parms.mesh;
-        SetSkinningConstants(shader, mesh->skinningJointCache);
+        SetSkinningConstants(shader, surfSpace->skinningJointCache);
     }
         
-    shader->SetConstant3f("lightInvRadius", lightInvRadius);
-    shader->SetConstant1f("lightFallOffExponent", surfLight->def->parms.fallOffExponent);
-    shader->SetConstant1i("removeBackProjection", surfLight->def->parms.type == SceneLight::SpotLight ? 1 : 0);
+    shader->SetConstant3f(shader->builtInConstantLocations[Shader::LightInvRadiusConst], lightInvRadius);
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::LightFallOffExponentConst], surfLight->def->parms.fallOffExponent);
+    shader->SetConstant1i(shader->builtInConstantLocations[Shader::RemoveBackProjectionConst], surfLight->def->parms.type == SceneLight::SpotLight ? 1 : 0);
         
     if (useShadowMap) {
         if (surfLight->def->parms.type == SceneLight::PointLight) {
-            shader->SetConstant2f("shadowProjectionDepth", backEnd.shadowProjectionDepth);
-            shader->SetConstant1f("vscmBiasedScale", backEnd.ctx->vscmBiasedScale);
-            shader->SetTexture("cubicNormalCubeMap", textureManager.cubicNormalCubeMapTexture);
-            shader->SetTexture("indirectionCubeMap", backEnd.ctx->indirectionCubeMapTexture);
-            shader->SetTexture("shadowMap", backEnd.ctx->vscmRT->DepthStencilTexture());
+            shader->SetConstant2f(shader->builtInConstantLocations[Shader::ShadowProjectionDepthConst], backEnd.shadowProjectionDepth);
+            shader->SetConstant1f(shader->builtInConstantLocations[Shader::VscmBiasedScaleConst], backEnd.ctx->vscmBiasedScale);
+            shader->SetTexture(shader->builtInSamplerUnits[Shader::CubicNormalCubeMapSampler], textureManager.cubicNormalCubeMapTexture);
+            shader->SetTexture(shader->builtInSamplerUnits[Shader::IndirectionCubeMapSampler], backEnd.ctx->indirectionCubeMapTexture);
+            shader->SetTexture(shader->builtInSamplerUnits[Shader::ShadowMapSampler], backEnd.ctx->vscmRT->DepthStencilTexture());
         } else if (surfLight->def->parms.type == SceneLight::SpotLight) {
-            shader->SetConstant4x4f("shadowProjMatrix", true, backEnd.shadowViewProjectionScaleBiasMatrix[0]);
-            shader->SetTexture("shadowArrayMap", backEnd.ctx->shadowMapRT->DepthStencilTexture());
+            shader->SetConstant4x4f(shader->builtInConstantLocations[Shader::ShadowProjMatrixConst], true, backEnd.shadowViewProjectionScaleBiasMatrix[0]);
+            shader->SetTexture(shader->builtInSamplerUnits[Shader::ShadowArrayMapSampler], backEnd.ctx->shadowMapRT->DepthStencilTexture());
         } else if (surfLight->def->parms.type == SceneLight::DirectionalLight) {
-            shader->SetConstantArray4x4f("shadowCascadeProjMatrix", true, r_CSM_count.GetInteger(), backEnd.shadowViewProjectionScaleBiasMatrix);
+            shader->SetConstantArray4x4f(shader->builtInConstantLocations[Shader::ShadowCascadeProjMatrixConst], true, r_CSM_count.GetInteger(), backEnd.shadowViewProjectionScaleBiasMatrix);
 
             if (r_CSM_selectionMethod.GetInteger() == 0) {
                 // z-based selection shader needs shadowSplitFar value
@@ -769,15 +826,15 @@ void RBSurf::SetupLightingShader(const Material::ShaderPass *mtrlPass, const Sha
                     sFar[cascadeIndex] = (backEnd.projMatrix[2][2] * -dFar + backEnd.projMatrix[2][3]) / dFar;
                     sFar[cascadeIndex] = sFar[cascadeIndex] * 0.5f + 0.5f;
                 }
-                shader->SetConstant4f("shadowSplitFar", sFar);
+                shader->SetConstant4f(shader->builtInConstantLocations[Shader::ShadowSplitFarConst], sFar);
             }
-            shader->SetConstant1f("cascadeBlendSize", r_CSM_blendSize.GetFloat());
-            shader->SetConstantArray1f("shadowMapFilterSize", r_CSM_count.GetInteger(), backEnd.shadowMapFilterSize);
-            shader->SetTexture("shadowArrayMap", backEnd.ctx->shadowMapRT->DepthStencilTexture());
+            shader->SetConstant1f(shader->builtInConstantLocations[Shader::CascadeBlendSizeConst], r_CSM_blendSize.GetFloat());
+            shader->SetConstantArray1f(shader->builtInConstantLocations[Shader::ShadowMapFilterSizeConst], r_CSM_count.GetInteger(), backEnd.shadowMapFilterSize);
+            shader->SetTexture(shader->builtInSamplerUnits[Shader::ShadowArrayMapSampler], backEnd.ctx->shadowMapRT->DepthStencilTexture());
         }
 
         if (r_shadowMapQuality.GetInteger() == 3) {
-            shader->SetTexture("randomRotMatMap", textureManager.randomRotMatTexture);
+            shader->SetTexture(shader->builtInSamplerUnits[Shader::RandomRotMatMapSampler], textureManager.randomRotMatTexture);
         }
 
         Vec2 shadowMapTexelSize;
@@ -790,7 +847,7 @@ void RBSurf::SetupLightingShader(const Material::ShaderPass *mtrlPass, const Sha
             shadowMapTexelSize.y = 1.0f / backEnd.ctx->shadowMapRT->GetHeight();
         }
 
-        shader->SetConstant2f("shadowMapTexelSize", shadowMapTexelSize);
+        shader->SetConstant2f(shader->builtInConstantLocations[Shader::ShadowMapTexelSizeConst], shadowMapTexelSize);
     } else {
         /*
         // WARNING: for the nvidia's stupid dynamic branching... 
@@ -806,11 +863,11 @@ void RBSurf::SetupLightingShader(const Material::ShaderPass *mtrlPass, const Sha
 
     const Material *lightMaterial = surfLight->def->GetMaterial();
 
-    shader->SetTexture("lightProjectionMap", lightMaterial->GetPass()->texture);
-    shader->SetConstant4x4f("lightTextureMatrix", true, surfLight->viewProjTexMatrix);
+    shader->SetTexture(shader->builtInSamplerUnits[Shader::LightProjectionMapSampler], lightMaterial->GetPass()->texture);
+    shader->SetConstant4x4f(shader->builtInConstantLocations[Shader::LightTextureMatrixConst], true, surfLight->viewProjTexMatrix);
 
     Color4 lightColor = surfLight->lightColor * surfLight->def->parms.intensity * r_lightScale.GetFloat();
-    shader->SetConstant4f("lightColor", lightColor);
+    shader->SetConstant4f(shader->builtInConstantLocations[Shader::LightColorConst], lightColor);
 
     //bool useLightCube = lightStage->textureStage.texture->GetType() == TextureCubeMap ? true : false;
     //shader->SetConstant1i("useLightCube", useLightCube);
@@ -842,7 +899,11 @@ void RBSurf::RenderLightInteraction(const Material::ShaderPass *mtrlPass) const
         }
     }
 
-    if (subMesh->useGpuSkinning) {
+    if (numInstances > 0) {
+        // Only the surfaces having the instancing version of the shader are instanced in RenderWorld::BuildInstancedDrawSurfs()
+        assert(shader->GetInstancingVersion());
+        shader = shader->GetInstancingVersion();
+    } else if (subMesh->useGpuSkinning) {
         if (shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex)) {
             shader = shader->GetGPUSkinningVersion(subMesh->gpuSkinningVersionIndex);
         }
@@ -863,7 +924,11 @@ void RBSurf::RenderLightInteraction(const Material::ShaderPass *mtrlPass) const
 
     SetMatrixConstants(shader);
 
-    shader->SetConstant1f("ambientScale", 0);
+    if (numInstances > 0) {
+        SetInstancingConstants(shader);
+    }
+
+    shader->SetConstant1f(shader->builtInConstantLocations[Shader::AmbientScaleConst], 0);
 
     SetupLightingShader(mtrlPass, shader, useShadowMap);
    
@@ -883,8 +948,8 @@ void RBSurf::RenderFogLightInteraction(const Material::ShaderPass *mtrlPass) con
 
     // light texture transform matrix
     Mat4 viewProjScaleBiasMat = surfLight->def->GetViewProjScaleBiasMatrix() * surfSpace->def->GetModelMatrix();	
-    shader->SetConstant4x4f("lightTextureMatrix", true, viewProjScaleBiasMat);
-    shader->SetConstant3f("fogColor", &surfLight->def->parms.materialParms[SceneEntity::RedParm]);
+    shader->SetConstant4x4f(shader->builtInConstantLocations[Shader::LightTextureMatrixConst], true, viewProjScaleBiasMat);
+    shader->SetConstant3f(shader->builtInConstantLocations[Shader::FogColorConst], &surfLight->def->parms.materialParms[SceneEntity::RedParm]);
 
     Vec3 vec = surfLight->def->parms.origin - backEnd.view->def->parms.origin;
     bool fogEnter = vec.Dot(surfLight->def->parms.axis[0]) < 0.0f ? true : false;
@@ -922,8 +987,8 @@ void RBSurf::RenderBlendLightInteraction(const Material::ShaderPass *mtrlPass) c
 
     // light texture transform matrix
     Mat4 viewProjScaleBiasMat = surfLight->def->GetViewProjScaleBiasMatrix() * surfSpace->def->GetModelMatrix();
-    shader->SetConstant4x4f("lightTextureMatrix", true, viewProjScaleBiasMat);
-    shader->SetConstant3f("blendColor", blendColor);
+    shader->SetConstant4x4f(shader->builtInConstantLocations[Shader::LightTextureMatrixConst], true, viewProjScaleBiasMat);
+    shader->SetConstant3f(shader->builtInConstantLocations[Shader::BlendColorConst], blendColor);
 
     const Material *lightMaterial = surfLight->def->parms.material;
     shader->SetTexture("blendProjectionMap", lightMaterial->GetPass()->texture);	
@@ -943,7 +1008,7 @@ void RBSurf::RenderGui(const Material::ShaderPass *mtrlPass) const {
         shader = ShaderManager::simpleShader;
         shader->Bind();
 
-        shader->SetTexture("albedoMap", mtrlPass->texture);
+        shader->SetTexture(shader->builtInSamplerUnits[Shader::AlbedoMapSampler], mtrlPass->texture);
     }
 
     SetMatrixConstants(shader);
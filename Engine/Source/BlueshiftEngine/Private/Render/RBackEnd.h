@@ -50,6 +50,8 @@ public:
 
     void                Begin(int flushType, const Material *material, const float *materialRegisters, const viewEntity_t *surfSpace, const viewLight_t *surfLight);
     void                DrawSubMesh(SubMesh *subMesh);
+                        /// Draws instances of the static sub mesh at once. Per-instance data is read from the instance buffer.
+    void                DrawInstancedSubMesh(SubMesh *subMesh, const BufferCache *instanceBufferCache, int numInstances);
     void                Flush();
 
     void                EndFrame();
@@ -79,6 +81,7 @@ private:
     void                SetMatrixConstants(const Shader *shader) const;
     void                SetVertexColorConstants(const Shader *shader, const Material::VertexColorMode &vertexColor) const;
     void                SetSkinningConstants(const Shader *shader, const SkinningJointCache *cache) const;
+    void                SetInstancingConstants(const Shader *shader) const;
 
     void                SetupLightingShader(const Material::ShaderPass *mtrlPass, const Shader *shader, bool useShadowMap) const;
 
@@ -115,6 +118,7 @@ private:
     int                 numVerts;
     int                 numIndexes;
     int                 numInstances;
+    const BufferCache * instanceBufferCache;
 };
 
 /*
@@ -138,7 +142,7 @@ struct SkinningJointCache {
     Mat3x4 *            skinningJoints;         // animation 결과 matrix(3x4) 를 담는다.
     int                 jointIndexOffsetCurr;   // motion blur 용 현재 프레임 joint index offset
     int                 jointIndexOffsetPrev;   // motion blur 용 이전 프레임 joint index offset
-    BufferCache         bufferCache;            // VTF skinning 일 때 사용
+    BufferCache         bufferCache;            // VTF skinning 이나 uniform buffer 를 쓰는 VS skinning 일 때 사용
     int                 viewFrameCount;         // 현재 프레임에 계산을 마쳤음을 표시하기 위한 marking number
 };
 
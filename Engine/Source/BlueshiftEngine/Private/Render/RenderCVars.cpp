@@ -26,6 +26,10 @@ CVAR(r_gamma, L"1.0", CVar::Float | CVar::Archive, L"changes gamma tables");
 CVAR(r_swapInterval, L"0", CVar::Integer | CVar::Archive, L"");
 CVAR(r_dynamicCacheVertexBytes, L"0x800000", CVar::Integer, L"size of dynamic vertex buffer");
 CVAR(r_dynamicCacheIndexBytes, L"0x300000", CVar::Integer, L"size of dynamic index buffer");
+CVAR(r_dynamicCacheUniformBytes, L"0x100000", CVar::Integer, L"size of dynamic uniform buffer");
+CVAR(r_useUniformBuffer, L"1", CVar::Bool | CVar::Archive, L"use uniform buffer for the shader constant blocks");
+CVAR(r_lazyShaderCompile, L"1", CVar::Bool, L"compile instantiated shaders on the first use");
+CVAR(r_instancing, L"1", CVar::Bool | CVar::Archive, L"draw identical static meshes with instancing");
 
 CVAR(r_fastSkinning, L"3", CVar::Integer | CVar::Archive, L"matrix skinning calculation, 0 = CPU skinning, 1 = VS skinning, 2 = VTF skinning, 3 = VTF skinning with instancing");
 CVAR(r_vertexTextureUpdate, L"2", CVar::Integer | CVar::Archive, L"texel fetch buffer, 0 = direct copy, 1 = PBO, 2 = TBO");
@@ -59,6 +63,7 @@ CVAR(r_optimizedShadowProjection, L"1", CVar::Integer, L"");
 
 CVAR(r_HOM, L"0", CVar::Bool, L"use hierarchical occlusion map culling");
 CVAR(r_HOM_debug, L"0", CVar::Bool, L"");
+CVAR(r_softOcclusion, L"1", CVar::Bool, L"cull static meshes and shadow casters with occluders rasterized on the CPU");
 
 CVAR(r_ambientLit, L"1", CVar::Bool | CVar::Archive, L"use ambient lighting");
 CVAR(r_ambientScale, L"0.5", CVar::Float | CVar::Archive, L"ambient light intensities are mutipled by this");
@@ -110,6 +115,7 @@ CVAR(r_useUnsmoothedTangents, L"1", CVar::Bool, L"");
 CVAR(r_useLightScissors, L"1", CVar::Bool, L"use custom scissor rectangle for each light");
 CVAR(r_useLightOcclusionQuery, L"0", CVar::Bool, L"");
 CVAR(r_usePostProcessing, L"1", CVar::Bool | CVar::Archive, L"");
+CVAR(r_smp, L"1", CVar::Bool | CVar::Archive, L"run the back end on the render thread overlapped with the next frame");
 
 CVAR(r_skipBackEnd, L"0", CVar::Bool, L"don't draw anything");
 CVAR(r_skipAmbientPass, L"0", CVar::Bool, L"skip ambient draw pass");
@@ -137,4 +143,6 @@ CVAR(r_drawEntities, L"1", CVar::Bool, L"");
 CVAR(r_noSubView, L"0", CVar::Bool, L"");
 CVAR(r_subViewOnly, L"0", CVar::Bool, L"");
 
+CVAR(r_parallelCulling, L"1", CVar::Bool, L"split view frustum culling into DBVT sub-trees and run them on the task scheduler");
+
 BE_NAMESPACE_END
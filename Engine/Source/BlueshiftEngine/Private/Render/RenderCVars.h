@@ -35,6 +35,10 @@ extern CVar     r_gamma;
 extern CVar     r_swapInterval;
 extern CVar     r_dynamicCacheVertexBytes;
 extern CVar     r_dynamicCacheIndexBytes;
+extern CVar     r_dynamicCacheUniformBytes;
+extern CVar     r_useUniformBuffer;
+extern CVar     r_lazyShaderCompile;
+extern CVar     r_instancing;
 
 extern CVar     r_fastSkinning;
 extern CVar     r_vertexTextureUpdate;
@@ -68,6 +72,7 @@ extern CVar     r_optimizedShadowProjection;
 
 extern CVar     r_HOM;
 extern CVar     r_HOM_debug;
+extern CVar     r_softOcclusion;
 
 extern CVar     r_ambientLit;
 extern CVar     r_ambientScale;
@@ -119,6 +124,7 @@ extern CVar     r_useUnsmoothedTangents;
 extern CVar     r_useLightScissors;
 extern CVar     r_useLightOcclusionQuery;
 extern CVar     r_usePostProcessing;
+extern CVar     r_smp;
 
 extern CVar     r_skipBackEnd;
 extern CVar     r_skipAmbientPass;
@@ -145,4 +151,6 @@ extern CVar     r_drawEntities;
 extern CVar     r_noSubView;
 extern CVar     r_subViewOnly;
 
+extern CVar     r_parallelCulling;
+
 BE_NAMESPACE_END
@@ -75,6 +75,8 @@ RenderContext::RenderContext() {
 }
 
 void RenderContext::Init(RHI::WindowHandle hwnd, int renderWidth, int renderHeight, RHI::DisplayContextFunc displayFunc, void *displayFuncDataPtr, int flags) {
+    renderSystem.SyncRenderThread();
+
     this->contextHandle = rhi.CreateContext(hwnd, (flags & Flag::UseSharedContext) ? true : false);
     this->flags = flags;
     
@@ -102,6 +104,8 @@ void RenderContext::Init(RHI::WindowHandle hwnd, int renderWidth, int renderHeig
 }
 
 void RenderContext::Shutdown() {
+    renderSystem.SyncRenderThread();
+
     FreeScreenMapRT();
 
     FreeHdrMapRT();
@@ -509,9 +513,14 @@ void RenderContext::BeginFrame() {
 
     elapsedTime = startFrameMsec * 0.001f;
 
-    memset(&renderCounter, 0, sizeof(renderCounter));
+    // In SMP mode, the rendering context is owned by the render thread, and the counters are reset in EndFrame()
+    if (!renderSystem.IsRenderThreadEnabled()) {
+        memset(&renderCounter, 0, sizeof(renderCounter));
 
-    rhi.SetContext(GetContextHandle());
+        rhi.ResetCounter();
+
+        rhi.SetContext(GetContextHandle());
+    }
 
     // Window size have changed since last call of BeginFrame()
     if (renderWidth != screenRT->GetWidth() || renderHeight != screenRT->GetHeight()) {
@@ -526,7 +535,9 @@ void RenderContext::BeginFrame() {
     cmd->commandId = BeginContextCommand;
     cmd->renderContext = this;
 
-    bufferCacheManager.BeginWrite();
+    if (!renderSystem.IsRenderThreadEnabled()) {
+        bufferCacheManager.BeginWrite();
+    }
 }
 
 void RenderContext::EndFrame() {
@@ -539,18 +550,25 @@ void RenderContext::EndFrame() {
     SwapBuffersRenderCommand *cmd = (SwapBuffersRenderCommand *)renderSystem.GetCommandBuffer(sizeof(SwapBuffersRenderCommand));
     cmd->commandId = SwapBuffersCommand;
 
-    bufferCacheManager.BeginBackEnd();
-    
-    renderSystem.IssueCommands();
+    const bool useRenderThread = renderSystem.IsRenderThreadEnabled();
 
-    bufferCacheManager.EndDrawCommand();
+    if (useRenderThread) {
+        // Wait for the back end of the previous frame to read the counters
+        renderSystem.SyncRenderThread();
+    } else {
+        renderSystem.IssueCommands();
+    }
 
     guiMesh.Clear();
 
-    frameData.ToggleFrame();
-
     renderCounter.frameMsec = PlatformTime::Milliseconds() - startFrameMsec;
 
+    renderCounter.rhiDrawCalls = rhi.GetCounter().drawCalls;
+    renderCounter.stateChanges = rhi.GetCounter().stateChanges;
+    renderCounter.textureBinds = rhi.GetCounter().textureBinds;
+    renderCounter.shaderConstantCalls = rhi.GetCounter().shaderConstantCalls;
+    renderCounter.constantBlockBinds = rhi.GetCounter().constantBlockBinds;
+
     if (r_showStats.GetInteger() > 0) {
         switch (r_showStats.GetInteger()) {
         case 1:
@@ -566,9 +584,27 @@ void RenderContext::EndFrame() {
             BE_LOG(L"shadowmap:%i skinning:%i\n",
                 renderCounter.numShadowMapDraw, renderCounter.numSkinningEntities);
             break;
+        case 4:
+            BE_LOG(L"rhiDraw:%i states:%i textures:%i constants:%i constantBlocks:%i\n",
+                renderCounter.rhiDrawCalls, renderCounter.stateChanges, renderCounter.textureBinds, 
+                renderCounter.shaderConstantCalls, renderCounter.constantBlockBinds);
+            break;
+        case 5:
+            BE_LOG(L"occluderTris:%i occludedSurfs:%i occludedShadowCasters:%i\n",
+                renderCounter.occluderTris, renderCounter.occlusionCulledSurfs, renderCounter.occlusionCulledShadowCasters);
+            break;
         }
     }
 
+    if (useRenderThread) {
+        memset(&renderCounter, 0, sizeof(renderCounter));
+
+        rhi.ResetCounter();
+
+        // Back end of this frame runs on the render thread while the next frame is being prepared
+        renderSystem.IssueCommands();
+    }
+
     renderSystem.currentContext = nullptr;
 }
 
@@ -790,6 +826,8 @@ void RenderContext::TakeScreenShot(const char *filename, RenderWorld *renderWorl
     renderSystem.CmdScreenshot(0, 0, width, height, path);
     EndFrame();
 
+    renderSystem.SyncRenderThread();
+
     BE_LOG(L"Screenshot saved to \"%hs\"\n", path);
 }
 
@@ -839,6 +877,8 @@ void RenderContext::CaptureEnvCubeImage(RenderWorld *renderWorld, const Vec3 &or
 
         EndFrame();
 
+        renderSystem.SyncRenderThread();
+
         screenRT->Blit(srcRect, dstRect, targetRT, RHI::ColorBlitMask, RHI::NearestBlitFilter);
 
         faceImages[faceIndex].Create2D(size, size, 1, Image::RGB_32F_32F_32F, nullptr, 0);
@@ -882,6 +922,8 @@ void RenderContext::CaptureEnvCubeImage(RenderWorld *renderWorld, const Vec3 &or
         
         EndFrame();
 
+        renderSystem.SyncRenderThread();
+
         //screenRT->Blit(srcRect, dstRect, targetRT, RHI::ColorBlitMask, RHI::NearestBlitFilter);
 
         rhi.ReadPixels(0, 0, size, size, Image::RGB_32F_32F_32F, faceImages[faceIndex].GetPixels());
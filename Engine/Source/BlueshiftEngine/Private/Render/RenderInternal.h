@@ -24,6 +24,9 @@ struct viewEntity_t {
     Mat4                    modelViewMatrix;
     Mat4                    modelViewProjMatrix;
 
+                            // copy of the skinning joint cache of the mesh in this frame, the back end reads only this
+    const SkinningJointCache *skinningJointCache;
+
     bool                    ambientVisible;
     bool                    shadowVisible;
 };
@@ -32,6 +35,20 @@ struct drawSurfNode_t {
     const DrawSurf *        drawSurf;
 
     drawSurfNode_t *        next;
+
+                            // surfaces of the same sub mesh following this node are drawn with instancing
+    int                     numInstances;       // 0 if not instanced
+    const BufferCache *     instanceBufferCache;
+};
+
+// Per-instance data of the instanced draw (std140 layout of InstanceData in Instancing.glsl)
+struct instanceData_t {
+    Mat4                    modelViewProjMatrix;    // transposed for column major mat4
+    Vec4                    worldMatrixS;
+    Vec4                    worldMatrixT;
+    Vec4                    worldMatrixR;
+    Vec4                    localViewOrigin;
+    Vec4                    constantColor;
 };
 
 struct viewLight_t {
@@ -79,6 +96,9 @@ struct view_t {
 struct renderGlobal_t {
     int                     skinningMethod;
     int                     vtUpdateMethod;          // vertex texture update method
+    bool                    useUniformBuffer;        // vertex shader skinning joints are uploaded to uniform buffer
+    bool                    useInstancing;           // identical static meshes are drawn with instancing
+    int                     maxInstances;            // maximum number of instances in one instanced draw
 };
 
 extern renderGlobal_t       renderGlobal;
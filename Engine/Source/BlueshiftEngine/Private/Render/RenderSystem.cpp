@@ -18,15 +18,22 @@
 #include "Render/Font.h"
 #include "Core/Cmds.h"
 #include "File/FileSystem.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
 renderGlobal_t      renderGlobal;
 RenderSystem        renderSystem;
 
+static BE_THREAD_LOCAL bool isMainThread = false;
+static BE_THREAD_LOCAL bool isRenderThread = false;
+
 void RenderSystem::Init(const RHI::Settings *settings) {
     cmdSystem.AddCommand(L"screenshot", Cmd_ScreenShot);
 
+    // Rendering context is handed over between this thread and the render thread only
+    isMainThread = true;
+
     // Initialize OpenGL renderer
     rhi.Init(settings);
 
@@ -49,6 +56,15 @@ void RenderSystem::Init(const RHI::Settings *settings) {
         renderGlobal.vtUpdateMethod = Mesh::DirectCopyUpdate;
     }
 
+    renderGlobal.useUniformBuffer = renderGlobal.skinningMethod == Mesh::VertexShaderSkinning && r_useUniformBuffer.GetBool() && rhi.SupportsUniformBuffer();
+
+    // Per-instance data is read from the uniform buffer by gl_InstanceID
+    renderGlobal.useInstancing = r_instancing.GetBool() && rhi.SupportsUniformBuffer();
+    renderGlobal.maxInstances = 0;
+    if (renderGlobal.useInstancing) {
+        renderGlobal.maxInstances = Min(256, rhi.HWLimit().maxUniformBlockSize / (int)sizeof(instanceData_t));
+    }
+
     textureManager.Init();
 
     shaderManager.Init();
@@ -83,12 +99,21 @@ void RenderSystem::Init(const RHI::Settings *settings) {
     r_gamma.SetModified();
     r_swapInterval.SetModified();
 
+    renderThread = nullptr;
+    renderThreadOwnsContext = false;
+
+    if (r_smp.GetBool()) {
+        StartRenderThread();
+    }
+
     initialized = true;
 }
 
 void RenderSystem::Shutdown() {
     cmdSystem.RemoveCommand(L"screenshot");
 
+    StopRenderThread();
+
     frameData.Shutdown();
 
     bufferCacheManager.Shutdown();
@@ -115,6 +140,8 @@ void RenderSystem::Shutdown() {
 
     textureManager.Shutdown();
 
+    profiler.FreeGpuQueries();
+
     rhi.Shutdown();
 
     initialized = false;
@@ -158,6 +185,8 @@ RenderContext *RenderSystem::AllocRenderContext(bool isMainContext) {
 }
 
 void RenderSystem::FreeRenderContext(RenderContext *rc) {
+    SyncRenderThread();
+
     if (mainContext == rc) {
         mainContext = nullptr;
     }
@@ -193,6 +222,26 @@ void *RenderSystem::GetCommandBuffer(int bytes) {
     return cmds->data + cmds->used - bytes;
 }
 
+// Shallow copy to the frame data. Containers of the copy share the memory with the original, so the back end shouldn't read them.
+template <typename T>
+static const T *CopyToFrameData(const T *src) {
+    T *dst = (T *)frameData.Alloc(sizeof(T));
+    memcpy((void *)dst, (const void *)src, sizeof(T));
+    return dst;
+}
+
+static void CopySceneDefs(view_t *view) {
+    view->def = CopyToFrameData(view->def);
+
+    for (viewEntity_t *viewEntity = view->viewEntities; viewEntity; viewEntity = viewEntity->next) {
+        viewEntity->def = CopyToFrameData(viewEntity->def);
+    }
+
+    for (viewLight_t *viewLight = view->viewLights; viewLight; viewLight = viewLight->next) {
+        viewLight->def = CopyToFrameData(viewLight->def);
+    }
+}
+
 void RenderSystem::CmdDrawView(const view_t *view) {
     DrawViewRenderCommand *cmd = (DrawViewRenderCommand *)GetCommandBuffer(sizeof(DrawViewRenderCommand));
     if (!cmd) {
@@ -201,6 +250,12 @@ void RenderSystem::CmdDrawView(const view_t *view) {
 
     cmd->commandId      = DrawViewCommand;
     cmd->view           = *view;
+
+    if (renderThread) {
+        // Scene objects can be updated by the game while the render thread is reading them,
+        // so the back end reads the copies in the frame data.
+        CopySceneDefs(&cmd->view);
+    }
 }
 
 void RenderSystem::CmdScreenshot(int x, int y, int width, int height, const char *filename) {
@@ -225,9 +280,147 @@ void RenderSystem::IssueCommands() {
     // clear it out, in case this is a sync and not a buffer flip
     cmds->used = 0;
 
+    if (renderThread) {
+        // Wait for the back end of the previous frame
+        SyncRenderThread();
+
+        // Render thread is idle now
+        ApplyModifiedCVars();
+    }
+
+    bufferCacheManager.BeginBackEnd();
+
+    if (renderThread) {
+        // Next frame is written to the other buffer sets while the render thread reads this frame
+        bufferCacheManager.BeginWrite();
+
+        frameData.ToggleFrame();
+
+        // Hand over the rendering context to the render thread
+        renderThreadContextHandle = currentContext->GetContextHandle();
+        renderThreadOwnsContext = true;
+        rhi.ReleaseContext();
+
+        PlatformMutex::Lock(renderThreadMutex);
+        renderThreadCommands = cmds->data;
+        PlatformCondition::Broadcast(renderThreadCondition);
+        PlatformMutex::Unlock(renderThreadMutex);
+        return;
+    }
+
     if (!r_skipBackEnd.GetBool()) {
         RB_Execute(cmds->data);
     }
+
+    bufferCacheManager.EndDrawCommand();
+
+    frameData.ToggleFrame();
+}
+
+void RenderSystem_ThreadProc(void *param) {
+    RenderSystem *rs = (RenderSystem *)param;
+
+    isRenderThread = true;
+
+    while (1) {
+        PlatformMutex::Lock(rs->renderThreadMutex);
+
+        while (!rs->renderThreadTerminate && !rs->renderThreadCommands) {
+            PlatformCondition::Wait(rs->renderThreadCondition, rs->renderThreadMutex);
+        }
+
+        if (rs->renderThreadTerminate) {
+            PlatformMutex::Unlock(rs->renderThreadMutex);
+            break;
+        }
+
+        const void *commands = rs->renderThreadCommands;
+
+        PlatformMutex::Unlock(rs->renderThreadMutex);
+
+        rhi.SetContext(rs->renderThreadContextHandle);
+
+        if (!r_skipBackEnd.GetBool()) {
+            RB_Execute(commands);
+        }
+
+        bufferCacheManager.EndDrawCommand();
+
+        rhi.ReleaseContext();
+
+        PlatformMutex::Lock(rs->renderThreadMutex);
+        rs->renderThreadCommands = nullptr;
+        PlatformCondition::Broadcast(rs->renderThreadCondition);
+        PlatformMutex::Unlock(rs->renderThreadMutex);
+    }
+}
+
+void RenderSystem::StartRenderThread() {
+    if (renderThread) {
+        return;
+    }
+
+#if defined(__WIN32__)
+    renderThreadMutex = PlatformMutex::Create();
+    renderThreadCondition = PlatformCondition::Create();
+    renderThreadCommands = nullptr;
+    renderThreadOwnsContext = false;
+    renderThreadTerminate = false;
+
+    renderThread = PlatformThread::Create(RenderSystem_ThreadProc, (void *)this, 0);
+
+    BE_LOG(L"Render thread started\n");
+#else
+    // Rendering context is bound to the thread of the view on the other platforms
+    BE_LOG(L"Render thread is not supported on this platform\n");
+#endif
+}
+
+void RenderSystem::StopRenderThread() {
+    if (!renderThread) {
+        return;
+    }
+
+    SyncRenderThread();
+
+    PlatformMutex::Lock(renderThreadMutex);
+    renderThreadTerminate = true;
+    PlatformCondition::Broadcast(renderThreadCondition);
+    PlatformMutex::Unlock(renderThreadMutex);
+
+    PlatformThread::Wait(renderThread);
+    renderThread = nullptr;
+
+    PlatformCondition::Delete(renderThreadCondition);
+    PlatformMutex::Delete(renderThreadMutex);
+
+    BE_LOG(L"Render thread stopped\n");
+}
+
+void RenderSystem::SyncRenderThread() {
+    if (isRenderThread) {
+        return;
+    }
+
+    // Loader threads must leave RHI calls to the main thread, or they would take the rendering context from it
+    assert(isMainThread);
+
+    if (!renderThread || !isMainThread) {
+        return;
+    }
+
+    BE_PROFILE_CPU_SCOPE("RenderSystem::SyncRenderThread");
+
+    PlatformMutex::Lock(renderThreadMutex);
+    while (renderThreadCommands) {
+        PlatformCondition::Wait(renderThreadCondition, renderThreadMutex);
+    }
+    PlatformMutex::Unlock(renderThreadMutex);
+
+    if (renderThreadOwnsContext) {
+        renderThreadOwnsContext = false;
+        rhi.SetContext(renderThreadContextHandle);
+    }
 }
 
 void RenderSystem::RecreateScreenMapRT() {
@@ -255,6 +448,25 @@ void RenderSystem::RecreateShadowMapRT() {
 }
 
 void RenderSystem::CheckModifiedCVars() {
+    if (renderThread) {
+        // Applied in IssueCommands() while the render thread is idle
+        return;
+    }
+
+    ApplyModifiedCVars();
+}
+
+void RenderSystem::ApplyModifiedCVars() {
+    if (r_smp.IsModified()) {
+        r_smp.ClearModified();
+
+        if (r_smp.GetBool()) {
+            StartRenderThread();
+        } else {
+            StopRenderThread();
+        }
+    }
+
     if (r_gamma.IsModified()) {
         r_gamma.ClearModified();
 
@@ -91,6 +91,8 @@ RenderTarget *RenderTarget::Create(const Texture *colorTexture, const Texture *d
 }
 
 RenderTarget *RenderTarget::Create(int numColorTextures, const Texture **colorTextures, const Texture *depthStencilTexture, int flags) {
+    renderSystem.SyncRenderThread();
+
     RHI::Handle         colorTextureHandles[MaxMultipleColorTextures] = { RHI::NullTexture, };
     RHI::Handle         depthStencilTextureHandle = RHI::NullTexture;
     RHI::TextureType    textureType;
@@ -162,6 +164,8 @@ RenderTarget *RenderTarget::Create(int numColorTextures, const Texture **colorTe
 }
 
 void RenderTarget::Delete(RenderTarget *renderTarget) {
+    renderSystem.SyncRenderThread();
+
     rhi.DeleteRenderTarget(renderTarget->rtHandle);
     rts.RemoveIndex(rts.FindIndex(renderTarget));
     delete renderTarget;
@@ -32,10 +32,14 @@ RenderWorld::RenderWorld() {
 
     debugLineColor.Set(0, 0, 0, 0);
     debugFillColor.Set(0, 0, 0, 0);
+
+    occlusionBuffer = new OcclusionBuffer;
 }
 
 RenderWorld::~RenderWorld() {
     ClearScene();
+
+    delete occlusionBuffer;
 }
 
 void RenderWorld::ClearScene() {
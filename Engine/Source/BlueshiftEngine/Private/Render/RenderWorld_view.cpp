@@ -15,9 +15,57 @@
 #include "Precompiled.h"
 #include "Render/Render.h"
 #include "RenderInternal.h"
+#include "Core/Task.h"
+#include "Simd/Simd.h"
+#include "Core/Profiler.h"
+#include "Containers/RadixSort.h"
 
 BE_NAMESPACE_BEGIN
 
+// Queries the DBVT with the view volume and gathers proxy ids which pass isVisible test.
+// DBVT is split into sub-trees which are queried in parallel, and each sub-tree writes its own culledProxyIds[i],
+// so the result is deterministic when it is read in sub-tree order. isVisible must be thread-safe.
+// Returns number of sub-trees.
+template <typename Func>
+int RenderWorld::CullProxies(const DynamicAABBTree &dbvt, const view_t *view, const Func &isVisible) {
+    int maxSubTrees = 1;
+    if (r_parallelCulling.GetBool()) {
+        maxSubTrees = Min(taskScheduler.NumThreads() * 4, (int)MaxCullSubTrees);
+    }
+
+    int32_t subTrees[MaxCullSubTrees];
+    int numSubTrees;
+    if (view->def->parms.orthogonal) {
+        numSubTrees = dbvt.FindSubTrees(view->def->box, maxSubTrees, subTrees);
+    } else {
+        numSubTrees = dbvt.FindSubTrees(view->def->frustum, maxSubTrees, subTrees);
+    }
+
+    auto cullSubTrees = [this, &dbvt, view, &isVisible, subTrees](int begin, int end) {
+        for (int subTreeIndex = begin; subTreeIndex < end; subTreeIndex++) {
+            Array<int32_t> &proxyIds = culledProxyIds[subTreeIndex];
+            proxyIds.SetCount(0, false);
+
+            auto addProxy = [&isVisible, &proxyIds](int32_t proxyId) -> bool {
+                if (isVisible(proxyId)) {
+                    proxyIds.Append(proxyId);
+                }
+                return true;
+            };
+
+            if (view->def->parms.orthogonal) {
+                dbvt.Query(view->def->box, subTrees[subTreeIndex], addProxy);
+            } else {
+                dbvt.Query(view->def->frustum, subTrees[subTreeIndex], addProxy);
+            }
+        }
+    };
+
+    taskScheduler.ParallelFor(0, numSubTrees, 1, cullSubTrees);
+
+    return numSubTrees;
+}
+
 // sceneEntity 로 부터 viewEntity 를 등록, 같은 view 에 여러번 등록 방지
 viewEntity_t *RenderWorld::RegisterViewEntity(view_t *view, SceneEntity *sceneEntity) {
     if (sceneEntity->viewCount == viewCount) {
@@ -38,6 +86,8 @@ viewEntity_t *RenderWorld::RegisterViewEntity(view_t *view, SceneEntity *sceneEn
     // RenderView 에서 1 씩 증가되는 viewCount
     sceneEntity->viewCount = viewCount;
 
+    sceneEntity->viewDistance = sceneEntity->parms.origin.Distance(view->def->parms.origin);
+
     return viewEntity;
 }
 
@@ -123,35 +173,43 @@ void RenderWorld::FindViewLightsAndEntities(view_t *view) {
         return true;
     };
 
-    // Called for each entities intersecting with view frustum 
-    // Returns true if it want to proceed next query
-    auto addViewEntities = [this, view](int32_t proxyId) -> bool {
-        DbvtProxy *proxy = (DbvtProxy *)entityDbvt.GetUserData(proxyId);
-        SceneEntity *sceneEntity = proxy->sceneEntity;
+    // Called for each entities intersecting with view frustum in parallel
+    // Returns true if the entity is visible
+    auto isEntityVisible = [this, view](int32_t proxyId) -> bool {
+        const DbvtProxy *proxy = (const DbvtProxy *)entityDbvt.GetUserData(proxyId);
+        const SceneEntity *sceneEntity = proxy->sceneEntity;
 
         if (!sceneEntity) {
-            return true;
+            return false;
         }
 
         if (!(BIT(sceneEntity->parms.layer) & view->def->parms.layerMask)) {
-            return true;
+            return false;
         }
 
         // Skip first person view only entity in subView 
         if (sceneEntity->parms.firstPersonOnly && view->isSubview) {
-            return true;
+            return false;
         }
 
         // Skip 3rd person view only entity in subView
         if (sceneEntity->parms.thirdPersonOnly && !view->isSubview) {
-            return true;
+            return false;
         }
 
         // Skip if a entity is farther than maximum visible distance
         if (sceneEntity->parms.origin.DistanceSqr(view->def->parms.origin) > sceneEntity->parms.maxVisDist * sceneEntity->parms.maxVisDist) {
-            return true;
+            return false;
         }
 
+        return true;
+    };
+
+    // Registers visible entity to the view
+    auto addViewEntity = [this, view](int32_t proxyId) {
+        DbvtProxy *proxy = (DbvtProxy *)entityDbvt.GetUserData(proxyId);
+        SceneEntity *sceneEntity = proxy->sceneEntity;
+
         viewEntity_t *viewEntity = RegisterViewEntity(view, sceneEntity);
             
         viewEntity->ambientVisible = true;
@@ -180,34 +238,91 @@ void RenderWorld::FindViewLightsAndEntities(view_t *view) {
         if (viewEntity->def->parms.numJoints > 0 && r_showSkeleton.GetInteger() > 0) {
             DebugJoints(viewEntity->def, r_showSkeleton.GetInteger() == 2, view->def->parms.axis);
         }
-
-        return true;
     };
 
     if (view->def->parms.orthogonal) {
         lightDbvt.Query(view->def->box, addViewLights);
-        entityDbvt.Query(view->def->box, addViewEntities);
     } else {
         lightDbvt.Query(view->def->frustum, addViewLights);
-        entityDbvt.Query(view->def->frustum, addViewEntities);
     }
+
+    // Cull entities in parallel and register them in sub-tree order
+    int numSubTrees = CullProxies(entityDbvt, view, isEntityVisible);
+
+    for (int subTreeIndex = 0; subTreeIndex < numSubTrees; subTreeIndex++) {
+        const Array<int32_t> &proxyIds = culledProxyIds[subTreeIndex];
+
+        for (int i = 0; i < proxyIds.Count(); i++) {
+            addViewEntity(proxyIds[i]);
+        }
+    }
+}
+
+// Returns true if the software occlusion buffer can be used for culling in this view
+static bool UseSoftOcclusion(const view_t *view) {
+    return r_softOcclusion.GetBool() && !view->def->parms.orthogonal;
+}
+
+// Rasterizes opaque surfaces of the visible occluder entities into the software occlusion buffer
+void RenderWorld::RenderOccluders(view_t *view) {
+    BE_PROFILE_CPU_SCOPE("RenderWorld::RenderOccluders");
+
+    occlusionBuffer->Clear(view->def->zNear);
+
+    if (!UseSoftOcclusion(view)) {
+        return;
+    }
+
+    for (viewEntity_t *viewEntity = view->viewEntities; viewEntity; viewEntity = viewEntity->next) {
+        if (!viewEntity->ambientVisible) {
+            continue;
+        }
+
+        const SceneEntity::Parms &parms = viewEntity->def->parms;
+
+        if (!parms.occluder || !parms.mesh || parms.joints || parms.billboard) {
+            continue;
+        }
+
+        for (int surfaceIndex = 0; surfaceIndex < parms.mesh->NumSurfaces(); surfaceIndex++) {
+            const MeshSurf *surf = parms.mesh->GetSurface(surfaceIndex);
+            const Material *material = parms.customMaterials[surf->materialIndex];
+
+            // Only opaque surfaces can hide things behind
+            if (material && material->GetRenderingMode() != Material::Opaque) {
+                continue;
+            }
+
+            const SubMesh *subMesh = surf->subMesh;
+
+            occlusionBuffer->RasterizeMesh(viewEntity->modelViewProjMatrix, subMesh->Verts(), subMesh->NumVerts(), subMesh->Indexes(), subMesh->NumIndexes());
+        }
+    }
+
+    occlusionBuffer->BuildHierarchy();
+
+    renderSystem.GetCurrentRenderContext()->renderCounter.occluderTris += occlusionBuffer->NumRasterizedTris();
 }
 
 // static mesh 들을 ambient drawSurfs 에 담는다.
 void RenderWorld::AddStaticMeshes(view_t *view) {
-    // Called for each static mesh surfaces intersecting with view frustum 
-    // Returns true if it want to proceed next query
-    auto addStaticMeshSurfs = [this, view](int32_t proxyId) -> bool {
-        DbvtProxy *proxy = (DbvtProxy *)staticMeshDbvt.GetUserData(proxyId);
-        MeshSurf *surf = proxy->mesh->GetSurface(proxy->meshSurfIndex);
+    const bool testOcclusion = UseSoftOcclusion(view) && occlusionBuffer->HasOccluders();
+
+    PlatformAtomic numOccludedSurfs;
+
+    // Called for each static mesh surfaces intersecting with view frustum in parallel
+    // Returns true if the surface is visible
+    auto isStaticMeshSurfVisible = [this, view, testOcclusion, &numOccludedSurfs](int32_t proxyId) -> bool {
+        const DbvtProxy *proxy = (const DbvtProxy *)staticMeshDbvt.GetUserData(proxyId);
+        const MeshSurf *surf = proxy->mesh->GetSurface(proxy->meshSurfIndex);
 
         // surf 가 없다면 static mesh 가 아님
         if (!surf) {
-            return true;
+            return false;
         }
 
         if (proxy->sceneEntity->viewCount != this->viewCount) {
-            return true;
+            return false;
         }
 
         /*if (proxy->lodGroup >= 0) {
@@ -223,10 +338,26 @@ void RenderWorld::AddStaticMeshes(view_t *view) {
         // More accurate OBB culling
         OBB obb = OBB(proxy->sceneEntity->GetAABB(), proxy->sceneEntity->parms.origin, proxy->sceneEntity->parms.axis);
         if (view->def->frustum.CullOBB(obb)) {
-            return true;
+            return false;
         }
 #endif
 
+        // Occluders never hide themselves, so skip the test for them
+        if (testOcclusion && !proxy->sceneEntity->parms.occluder) {
+            if (occlusionBuffer->IsAABBOccluded(view->def->viewProjMatrix, proxy->aabb)) {
+                numOccludedSurfs++;
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    // Adds drawSurf for the visible static mesh surface
+    auto addStaticMeshSurf = [this, view](int32_t proxyId) {
+        const DbvtProxy *proxy = (const DbvtProxy *)staticMeshDbvt.GetUserData(proxyId);
+        MeshSurf *surf = proxy->mesh->GetSurface(proxy->meshSurfIndex);
+
         int flags = DrawSurf::AmbientVisible;
         if (proxy->sceneEntity->parms.wireframeMode != SceneEntity::WireframeMode::ShowNone || r_showWireframe.GetInteger() > 0) {
             flags |= DrawSurf::ShowWires;
@@ -243,15 +374,20 @@ void RenderWorld::AddStaticMeshes(view_t *view) {
             SetDebugColor(Color4(1, 1, 1, 0.5), Color4::zero);
             DebugAABB(proxy->aabb, 1, true, r_showAABB.GetInteger() == 1 ? true : false);
         }
-
-        return true;
     };
 
-    if (view->def->parms.orthogonal) {
-        staticMeshDbvt.Query(view->def->box, addStaticMeshSurfs);
-    } else {
-        staticMeshDbvt.Query(view->def->frustum, addStaticMeshSurfs);
+    // Cull static mesh surfaces in parallel and add drawSurfs in sub-tree order
+    int numSubTrees = CullProxies(staticMeshDbvt, view, isStaticMeshSurfVisible);
+
+    for (int subTreeIndex = 0; subTreeIndex < numSubTrees; subTreeIndex++) {
+        const Array<int32_t> &proxyIds = culledProxyIds[subTreeIndex];
+
+        for (int i = 0; i < proxyIds.Count(); i++) {
+            addStaticMeshSurf(proxyIds[i]);
+        }
     }
+
+    renderSystem.GetCurrentRenderContext()->renderCounter.occlusionCulledSurfs += numOccludedSurfs.GetValue();
 }
 
 // skinned mesh 들을 ambient drawSurfs 에 담는다. 
@@ -280,10 +416,8 @@ void RenderWorld::AddSkinnedMeshes(view_t *view) {
             flags |= DrawSurf::ShowWires;
         }
 
-        if (entityParms.skeleton && entityParms.joints) {
-            // Update skinning joint cache for GPU skinning
-            entityParms.mesh->UpdateSkinningJointCache(entityParms.skeleton, entityParms.joints);
-        }
+        // Update skinning joint cache for GPU/CPU skinning
+        UpdateSkinningJointCache(viewEntity);
 
         for (int surfaceIndex = 0; surfaceIndex < entityParms.mesh->NumSurfaces(); surfaceIndex++) {
             MeshSurf *surf = entityParms.mesh->GetSurface(surfaceIndex);
@@ -413,13 +547,49 @@ void RenderWorld::AddSkyBoxMeshes(view_t *view) {
     AddDrawSurf(view, viewEntity, skyboxMaterial, meshSurf->subMesh, DrawSurf::AmbientVisible);
 }
 
+// Computes conservative bounds of the region that can be shadowed by the caster.
+// Returns false if the bounds are unlimited.
+static bool ShadowVolumeAABB(const SceneLight *light, const AABB &casterAABB, AABB &shadowAABB) {
+    const float lightLength = light->obb.Extents().Length() * 2.0f;
+
+    if (light->parms.type == SceneLight::DirectionalLight) {
+        // Sweep caster bounds along the light direction
+        shadowAABB = casterAABB;
+        shadowAABB.AddAABB(casterAABB + light->parms.axis[0] * lightLength);
+        return true;
+    }
+
+    const Vec3 &lightOrigin = light->GetOrigin();
+
+    float dist = casterAABB.Distance(lightOrigin);
+    if (dist < 1.0f) {
+        return false;
+    }
+
+    // Scaling caster bounds about the light origin covers every shadow ray within the light range
+    const float scale = Max(lightLength / dist, 1.0f);
+
+    Vec3 points[8];
+    casterAABB.ToPoints(points);
+
+    shadowAABB = casterAABB;
+    for (int i = 0; i < 8; i++) {
+        shadowAABB.AddPoint(lightOrigin + (points[i] - lightOrigin) * scale);
+    }
+    return true;
+}
+
 // static mesh 들을 viewLight 의 litSurfs/shadowCasterSurfs 리스트에 담는다.
 void RenderWorld::AddStaticMeshesForLights(view_t *view) {
     viewLight_t *viewLight = view->viewLights;
 
+    const bool testOcclusion = UseSoftOcclusion(view) && occlusionBuffer->HasOccluders();
+
+    int numOccludedShadowCasters = 0;
+
     // Called for static mesh surfaces intersecting with each light volume
     // Returns true if it want to proceed next query
-    auto addStaticMeshSurfsForLights = [this, view, &viewLight](int32_t proxyId) -> bool {
+    auto addStaticMeshSurfsForLights = [this, view, testOcclusion, &numOccludedShadowCasters, &viewLight](int32_t proxyId) -> bool {
         const DbvtProxy *proxy = (const DbvtProxy *)staticMeshDbvt.GetUserData(proxyId);
         const SceneEntity *proxyEntity = proxy->sceneEntity;
 
@@ -453,7 +623,7 @@ void RenderWorld::AddStaticMeshesForLights(view_t *view) {
         // Is surface visible for this frame ?
         if (surf->viewCount == this->viewCount) {
             if ((surf->drawSurf->flags & DrawSurf::AmbientVisible) && material->IsLitSurface()) {
-                drawSurfNode_t *drawSurfNode = (drawSurfNode_t *)frameData.Alloc(sizeof(drawSurfNode_t));
+                drawSurfNode_t *drawSurfNode = (drawSurfNode_t *)frameData.ClearedAlloc(sizeof(drawSurfNode_t));
                 drawSurfNode->drawSurf = surf->drawSurf;
                 drawSurfNode->next = viewLight->litSurfs;
 
@@ -468,6 +638,19 @@ void RenderWorld::AddStaticMeshesForLights(view_t *view) {
                 return true;
             }
 
+            // Skip the caster if every visible receiver it can shadow is hidden behind the occluders
+            if (testOcclusion && !proxyEntity->parms.occluder) {
+                AABB shadowAABB;
+                if (ShadowVolumeAABB(viewLight->def, proxy->aabb, shadowAABB)) {
+                    shadowAABB.IntersectSelf(view->aabb);
+
+                    if (shadowAABB.IsCleared() || occlusionBuffer->IsAABBOccluded(view->def->viewProjMatrix, shadowAABB)) {
+                        numOccludedShadowCasters++;
+                        return true;
+                    }
+                }
+            }
+
             // This surface is not visible but shadow might be visible as a shadow caster.
             if (surf->viewCount != this->viewCount) {
                 // Register a viewEntity used only for shadow caster
@@ -480,7 +663,7 @@ void RenderWorld::AddStaticMeshesForLights(view_t *view) {
                 surf->drawSurf = view->drawSurfs[view->numDrawSurfs - 1];
             }
 
-            drawSurfNode_t *drawSurfNode = (drawSurfNode_t *)frameData.Alloc(sizeof(drawSurfNode_t));
+            drawSurfNode_t *drawSurfNode = (drawSurfNode_t *)frameData.ClearedAlloc(sizeof(drawSurfNode_t));
             drawSurfNode->drawSurf = surf->drawSurf;
             drawSurfNode->next = viewLight->shadowCasterSurfs;
 
@@ -514,6 +697,8 @@ void RenderWorld::AddStaticMeshesForLights(view_t *view) {
 
        viewLight = viewLight->next;
     }
+
+    renderSystem.GetCurrentRenderContext()->renderCounter.occlusionCulledShadowCasters += numOccludedShadowCasters;
 }
 
 // skinned mesh 들을 viewLight 의 litSurfs/shadowCasterSurfs 리스트에 담는다.
@@ -556,7 +741,7 @@ void RenderWorld::AddSkinnedMeshesForLights(view_t *view) {
 
             // 이미 ambient visible surf 로 등록되었고, lighting 이 필요한 surf 라면 litSurfs 리스트에 추가한다.
             if (surf->viewCount == this->viewCount && surf->drawSurf->flags & DrawSurf::AmbientVisible && material->IsLitSurface()) {
-                drawSurfNode_t *drawSurfNode = (drawSurfNode_t *)frameData.Alloc(sizeof(drawSurfNode_t));
+                drawSurfNode_t *drawSurfNode = (drawSurfNode_t *)frameData.ClearedAlloc(sizeof(drawSurfNode_t));
                 drawSurfNode->drawSurf = surf->drawSurf;
                 drawSurfNode->next = viewLight->litSurfs;
 
@@ -592,9 +777,7 @@ void RenderWorld::AddSkinnedMeshesForLights(view_t *view) {
                         shadowViewEntity->shadowVisible = true;
                     }
 
-                    if (shadowViewEntity->def->parms.skeleton && shadowViewEntity->def->parms.joints) {
-                        shadowViewEntity->def->parms.mesh->UpdateSkinningJointCache(shadowViewEntity->def->parms.skeleton, shadowViewEntity->def->parms.joints);
-                    }
+                    UpdateSkinningJointCache(shadowViewEntity);
 
                     // drawSurf for shadow
                     AddDrawSurf(view, shadowViewEntity, material, surf->subMesh, 0);
@@ -603,7 +786,7 @@ void RenderWorld::AddSkinnedMeshesForLights(view_t *view) {
                     surf->drawSurf = view->drawSurfs[view->numDrawSurfs - 1];
                 }
 
-                drawSurfNode_t *drawSurfNode = (drawSurfNode_t *)frameData.Alloc(sizeof(drawSurfNode_t));
+                drawSurfNode_t *drawSurfNode = (drawSurfNode_t *)frameData.ClearedAlloc(sizeof(drawSurfNode_t));
                 drawSurfNode->drawSurf = surf->drawSurf;
                 drawSurfNode->next = viewLight->shadowCasterSurfs;
                 
@@ -684,29 +867,374 @@ void RenderWorld::OptimizeLights(view_t *view) {
     }
 }
 
-static int BE_CDECL _CompareDrawSurf(const void *elem1, const void *elem2) {
-    const uint64_t sortKey1 = (*(DrawSurf **)elem1)->sortKey;
-    const uint64_t sortKey2 = (*(DrawSurf **)elem2)->sortKey;
+void RenderWorld::SortDrawSurfs(view_t *view) {
+    const int numDrawSurfs = view->numDrawSurfs;
+    if (numDrawSurfs < 2) {
+        return;
+    }
 
-    if (sortKey1 < sortKey2) {
-        return -1;
+    // Radix sort 64 bit sort keys with drawSurf pointers
+    drawSurfSortKeys.SetCount(numDrawSurfs * 2, false);
+    tempDrawSurfs.SetCount(numDrawSurfs, false);
+
+    uint64_t *sortKeys = drawSurfSortKeys.Ptr();
+    for (int i = 0; i < numDrawSurfs; i++) {
+        sortKeys[i] = view->drawSurfs[i]->sortKey;
     }
-    if (sortKey1 > sortKey2) {
-        return 1;
+
+    RadixSort(sortKeys, view->drawSurfs, numDrawSurfs, sortKeys + numDrawSurfs, tempDrawSurfs.Ptr());
+}
+
+// Returns true if the shader for the material pass has the instancing version.
+static bool HasInstancingVersion(Shader *shader, const Material::ShaderPass *mtrlPass) {
+    if (mtrlPass->renderingMode == Material::RenderingMode::AlphaCutoff && shader->GetPerforatedVersion()) {
+        shader = shader->GetPerforatedVersion();
     }
-    return 0;
+
+    return shader->GetInstancingVersion() ? true : false;
 }
 
-void RenderWorld::SortDrawSurfs(view_t *view) {
-    qsort(view->drawSurfs, view->numDrawSurfs, sizeof(DrawSurf *), _CompareDrawSurf);
+// Returns true if the direct lighting shader and all of its shadowed versions have the instancing version.
+static bool HasLitInstancingVersions(Shader *shader, const Material::ShaderPass *mtrlPass) {
+    if (!HasInstancingVersion(shader, mtrlPass)) {
+        return false;
+    }
+
+    Shader *shadowVersions[] = { shader->GetParallelShadowVersion(), shader->GetSpotShadowVersion(), shader->GetPointShadowVersion() };
+
+    for (int i = 0; i < COUNT_OF(shadowVersions); i++) {
+        if (!shadowVersions[i] || !HasInstancingVersion(shadowVersions[i], mtrlPass)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns true if the surface can be drawn with instancing.
+// Static meshes instantiated from the same reference mesh share the vertex buffer, so they can be drawn at once.
+static bool IsInstanceableSurf(const DrawSurf *surf) {
+    if (surf->subMesh->GetType() != Mesh::StaticMesh) {
+        return false;
+    }
+
+    const SceneEntity::Parms &entityParms = surf->space->def->parms;
+    if (entityParms.depthHack || entityParms.billboard) {
+        return false;
+    }
+
+    if (surf->material->GetSort() != Material::Sort::OpaqueSort && surf->material->GetSort() != Material::Sort::AlphaTestSort) {
+        return false;
+    }
+
+    const Material::ShaderPass *mtrlPass = surf->material->GetPass();
+    if (!mtrlPass->shader || !(mtrlPass->shader->GetFlags() & Shader::Instancing)) {
+        return false;
+    }
+
+    // Shaders chosen by RBSurf::RenderDepth(), RBSurf::RenderBase() and RBSurf::RenderLightInteraction() should have the instancing version
+    if (!HasInstancingVersion(ShaderManager::depthShader, mtrlPass)) {
+        return false;
+    }
+
+    Shader *directLitShader = mtrlPass->shader->GetDirectLitVersion();
+    if (!HasLitInstancingVersions(directLitShader ? directLitShader : ShaderManager::standardDefaultDirectLitShader, mtrlPass)) {
+        return false;
+    }
+
+    if (r_ambientLit.GetBool()) {
+        Shader *ambientLitShader = mtrlPass->shader->GetAmbientLitVersion();
+        if (!HasInstancingVersion(ambientLitShader ? ambientLitShader : ShaderManager::standardDefaultAmbientLitShader, mtrlPass)) {
+            return false;
+        }
+
+        Shader *ambientLitDirectLitShader = mtrlPass->shader->GetAmbientLitDirectLitVersion();
+        if (!HasLitInstancingVersions(ambientLitDirectLitShader ? ambientLitDirectLitShader : ShaderManager::standardDefaultAmbientLitDirectLitShader, mtrlPass)) {
+            return false;
+        }
+    } else if (!HasInstancingVersion(ShaderManager::standardDefaultShader, mtrlPass)) {
+        return false;
+    }
+
+    return true;
+}
+
+// Returns true if the surface b can be drawn as an instance of the surface a.
+// Per-instance data has the constant color only, so surfaces with any other material parameters
+// or evaluated material registers are not merged. Shadow receiving selects the lighting shader of all instances.
+bool RenderWorld::IsSameInstance(const DrawSurf *a, const DrawSurf *b) {
+    const float *aParms = a->space->def->parms.materialParms;
+    const float *bParms = b->space->def->parms.materialParms;
+
+    return a->material == b->material && 
+        a->subMesh->vertexCache == b->subMesh->vertexCache && 
+        a->subMesh->indexCache == b->subMesh->indexCache &&
+        !a->materialRegisters && !b->materialRegisters &&
+        !memcmp(&aParms[SceneEntity::TimeOffsetParm], &bParms[SceneEntity::TimeOffsetParm], (SceneEntity::MaxMaterialParms - SceneEntity::TimeOffsetParm) * sizeof(float)) &&
+        a->space->def->parms.receiveShadows == b->space->def->parms.receiveShadows &&
+        IsInstanceableSurf(b);
+}
+
+// Writes per-instance data of the surfaces in the uniform buffer.
+// Returns nullptr if the uniform buffer is full, then the surfaces are drawn one by one.
+static const BufferCache *AllocInstanceData(const view_t *view, const DrawSurf *const *surfs, int numInstances, Array<instanceData_t> &instanceData) {
+    const int bytes = numInstances * sizeof(instanceData_t);
+    if (!bufferCacheManager.CanAllocUniform(bytes)) {
+        return nullptr;
+    }
+
+    instanceData.SetCount(numInstances, false);
+
+    for (int i = 0; i < numInstances; i++) {
+        const DrawSurf *surf = surfs[i];
+        const SceneEntity::Parms &entityParms = surf->space->def->parms;
+        const Material::ShaderPass *mtrlPass = surf->material->GetPass();
+        const Mat4 &worldMatrix = surf->space->def->GetModelMatrix();
+
+        instanceData_t &instance = instanceData[i];
+
+        // The same matrix as the non-instanced draw, so the depth is equal whether instanced or not.
+        // Not used by the shadow depth shader, shadow casters are transformed to world space first.
+        instance.modelViewProjMatrix = surf->space->modelViewProjMatrix.Transpose();
+
+        instance.worldMatrixS = worldMatrix[0];
+        instance.worldMatrixT = worldMatrix[1];
+        instance.worldMatrixR = worldMatrix[2];
+
+        // view vector: world -> to mesh coordinates
+        Vec3 localViewOrigin = entityParms.axis.TransposedMulVec(view->def->parms.origin - entityParms.origin) / entityParms.scale;
+        instance.localViewOrigin = Vec4(localViewOrigin, 1.0f);
+
+        if (mtrlPass->useOwnerColor) {
+            instance.constantColor = Vec4(&entityParms.materialParms[SceneEntity::RedParm]);
+        } else {
+            instance.constantColor = mtrlPass->constantColor.ToVec4();
+        }
+    }
+
+    BufferCache *instanceBufferCache = (BufferCache *)frameData.Alloc(sizeof(BufferCache));
+    bufferCacheManager.AllocUniform(bytes, instanceData.Ptr(), instanceBufferCache);
+
+    return instanceBufferCache;
+}
+
+// Groups the consecutive nodes of the same static sub mesh and material to be drawn with instancing.
+void RenderWorld::InstanceDrawSurfNodes(const view_t *view, drawSurfNode_t **nodes, const DrawSurf *const *surfs, int numNodes, bool shadowCaster, Array<instanceData_t> &instanceData) {
+    auto canInstance = [shadowCaster](const DrawSurf *surf) {
+        if (shadowCaster) {
+            return surf->space->def->parms.castShadows && !(surf->material->GetFlags() & Material::NoShadow);
+        }
+        return (surf->flags & DrawSurf::AmbientVisible) ? true : false;
+    };
+
+    for (int i = 0; i < numNodes; ) {
+        const DrawSurf *surf = surfs[i];
+
+        if (!canInstance(surf) || !IsInstanceableSurf(surf)) {
+            i++;
+            continue;
+        }
+
+        int count = 1;
+        while (i + count < numNodes && count < renderGlobal.maxInstances) {
+            const DrawSurf *nextSurf = surfs[i + count];
+            if (!canInstance(nextSurf) || !IsSameInstance(surf, nextSurf)) {
+                break;
+            }
+            count++;
+        }
+
+        if (count > 1) {
+            nodes[i]->instanceBufferCache = AllocInstanceData(view, &surfs[i], count, instanceData);
+            if (nodes[i]->instanceBufferCache) {
+                nodes[i]->numInstances = count;
+            }
+        }
+
+        i += count;
+    }
+}
+
+// Groups the consecutive surfaces of the same static sub mesh and material to be drawn with instancing.
+// The first surface of each group has the number of instances, and the backend skips the rest of the group.
+// Surfaces of the view are already sorted, and lit surfaces and shadow caster surfaces of each light are sorted here.
+// Instanced draws use the same model view projection matrix as the non-instanced draws, so a surface can be
+// instanced in one pass and not in another one drawn with the equal depth test.
+void RenderWorld::BuildInstancedDrawSurfs(view_t *view) {
+    if (!renderGlobal.useInstancing || view->is2D) {
+        return;
+    }
+
+    BE_PROFILE_CPU_SCOPE("RenderWorld::BuildInstancedDrawSurfs");
+
+    Array<instanceData_t> instanceData;
+
+    DrawSurf **drawSurfs = view->drawSurfs;
+
+    for (int i = 0; i < view->numDrawSurfs; ) {
+        DrawSurf *surf = drawSurfs[i];
+
+        if (!(surf->flags & DrawSurf::AmbientVisible) || !IsInstanceableSurf(surf)) {
+            i++;
+            continue;
+        }
+
+        int count = 1;
+        while (i + count < view->numDrawSurfs && count < renderGlobal.maxInstances) {
+            const DrawSurf *nextSurf = drawSurfs[i + count];
+            if (!(nextSurf->flags & DrawSurf::AmbientVisible) || !IsSameInstance(surf, nextSurf)) {
+                break;
+            }
+            count++;
+        }
+
+        if (count > 1) {
+            surf->instanceBufferCache = AllocInstanceData(view, &drawSurfs[i], count, instanceData);
+            if (surf->instanceBufferCache) {
+                surf->numInstances = count;
+            }
+        }
+
+        i += count;
+    }
+
+    // Sorts the nodes by the sort keys and relinks them.
+    // Sorted nodes are left in tempDrawSurfNodes and their surfaces in tempDrawSurfs.
+    auto sortDrawSurfNodes = [this](drawSurfNode_t *&headNode) {
+        int numNodes = 0;
+        for (drawSurfNode_t *node = headNode; node; node = node->next) {
+            numNodes++;
+        }
+
+        if (numNodes < 2) {
+            return numNodes;
+        }
+
+        drawSurfSortKeys.SetCount(numNodes * 2, false);
+        tempDrawSurfNodes.SetCount(numNodes * 2, false);
+
+        uint64_t *sortKeys = drawSurfSortKeys.Ptr();
+        drawSurfNode_t **nodes = tempDrawSurfNodes.Ptr();
+
+        int nodeIndex = 0;
+        for (drawSurfNode_t *node = headNode; node; node = node->next) {
+            sortKeys[nodeIndex] = node->drawSurf->sortKey;
+            nodes[nodeIndex] = node;
+            nodeIndex++;
+        }
+
+        RadixSort(sortKeys, nodes, numNodes, sortKeys + numNodes, nodes + numNodes);
+
+        tempDrawSurfs.SetCount(numNodes, false);
+
+        for (int i = 0; i < numNodes; i++) {
+            nodes[i]->next = i + 1 < numNodes ? nodes[i + 1] : nullptr;
+            tempDrawSurfs[i] = const_cast<DrawSurf *>(nodes[i]->drawSurf);
+        }
+
+        headNode = nodes[0];
+
+        return numNodes;
+    };
+
+    for (viewLight_t *viewLight = view->viewLights; viewLight; viewLight = viewLight->next) {
+        // Surfaces lit by the primary light are drawn with the view surfaces in the base pass
+        if (viewLight != view->primaryLight && viewLight->def->GetMaterial()->GetType() == Material::LightMaterialType) {
+            int numNodes = sortDrawSurfNodes(viewLight->litSurfs);
+            if (numNodes >= 2) {
+                InstanceDrawSurfNodes(view, tempDrawSurfNodes.Ptr(), tempDrawSurfs.Ptr(), numNodes, false, instanceData);
+            }
+        }
+
+        int numNodes = sortDrawSurfNodes(viewLight->shadowCasterSurfs);
+
+        // Shadow casters of point light are culled by each cube map face one by one
+        if (numNodes >= 2 && viewLight->def->parms.type != SceneLight::PointLight) {
+            InstanceDrawSurfNodes(view, tempDrawSurfNodes.Ptr(), tempDrawSurfs.Ptr(), numNodes, true, instanceData);
+        }
+    }
+}
+
+// Sub meshes collected by AddDrawSurf() are skinned in parallel.
+// Vertices and indexes of all the sub meshes are allocated in one block of the dynamic buffers,
+// so the buffers are mapped once and the worker threads write into them directly.
+void RenderWorld::SkinCpuSkinnedSurfs() {
+    if (cpuSkinningSurfs.Count() == 0) {
+        return;
+    }
+
+    BE_PROFILE_CPU_SCOPE("RenderWorld::SkinCpuSkinnedSurfs");
+
+    int numVerts = 0;
+    int numIndexes = 0;
+
+    for (int i = 0; i < cpuSkinningSurfs.Count(); i++) {
+        CpuSkinningSurf &skinningSurf = cpuSkinningSurfs[i];
+        skinningSurf.firstVert = numVerts;
+        skinningSurf.firstIndex = numIndexes;
+
+        numVerts += skinningSurf.subMesh->NumVerts();
+        numIndexes += skinningSurf.subMesh->NumIndexes();
+    }
+
+    BufferCache vertexCache;
+    BufferCache indexCache;
+    bufferCacheManager.AllocVertex(numVerts, sizeof(VertexGenericLit), nullptr, &vertexCache);
+    bufferCacheManager.AllocIndex(numIndexes, sizeof(TriIndex), nullptr, &indexCache);
+
+    const int baseVertex = vertexCache.offset / sizeof(VertexGenericLit);
+
+    // Each sub mesh refers to its own range of the allocated blocks
+    for (int i = 0; i < cpuSkinningSurfs.Count(); i++) {
+        const CpuSkinningSurf &skinningSurf = cpuSkinningSurfs[i];
+        SubMesh *subMesh = skinningSurf.subMesh;
+
+        *subMesh->vertexCache = vertexCache;
+        subMesh->vertexCache->offset += skinningSurf.firstVert * sizeof(VertexGenericLit);
+        subMesh->vertexCache->bytes = subMesh->NumVerts() * sizeof(VertexGenericLit);
+
+        *subMesh->indexCache = indexCache;
+        subMesh->indexCache->offset += skinningSurf.firstIndex * sizeof(TriIndex);
+        subMesh->indexCache->bytes = subMesh->NumIndexes() * sizeof(TriIndex);
+    }
+
+    VertexGenericLit *dstVerts = (VertexGenericLit *)bufferCacheManager.MapVertexBuffer(&vertexCache);
+    TriIndex *dstIndexes = (TriIndex *)bufferCacheManager.MapIndexBuffer(&indexCache);
+
+    const CpuSkinningSurf *skinningSurfs = cpuSkinningSurfs.Ptr();
+
+    taskScheduler.ParallelFor(0, cpuSkinningSurfs.Count(), 1, [skinningSurfs, dstVerts, dstIndexes, baseVertex](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const CpuSkinningSurf &skinningSurf = skinningSurfs[i];
+
+            skinningSurf.subMesh->SkinVerts(skinningSurf.skinningJoints, dstVerts + skinningSurf.firstVert);
+            skinningSurf.subMesh->WriteIndexes(baseVertex + skinningSurf.firstVert, dstIndexes + skinningSurf.firstIndex);
+        }
+    });
+
+    bufferCacheManager.UnmapIndexBuffer(&indexCache);
+    bufferCacheManager.UnmapVertexBuffer(&vertexCache);
+
+    cpuSkinningSurfs.SetCount(0, false);
 }
 
 void RenderWorld::RenderView(view_t *view) {
+    BE_PROFILE_CPU_SCOPE("RenderWorld::RenderView");
+
+    // Update 4-ary SIMD nodes of the DBVTs if the trees have been changed.
+    // This must be done before the trees are queried in parallel.
+    entityDbvt.BuildWideNodes();
+    staticMeshDbvt.BuildWideNodes();
+    lightDbvt.BuildWideNodes();
+
     // view frustum 을 entity dynamic bounding volume tree 에 query 해서 빠르게 sceneLight, sceneEntity 를 찾는다.
     // 찾은 def 들은 각각 viewLights, viewEntities 를 생성하며 view 에 등록
     // sceneEntity 와 sceneLight 의 pointer 에도 연결 (아래 단계에서 다시 한번 dbvt 를 seaching 할때 이미 등록된 viewLights/viewEntities 를 한번에 찾기위해)
     FindViewLightsAndEntities(view);
 
+    // occluder 로 지정된 entity 들을 software occlusion buffer 에 그려서 아래 단계에서 가려진 surface 들을 컬링
+    RenderOccluders(view);
+
     // staticDBVT 를 query 해서 찾은 static mesh surface 를 drawSurf 에 등록
     AddStaticMeshes(view);
 
@@ -755,14 +1283,46 @@ void RenderWorld::RenderView(view_t *view) {
     // 바로 윗 단계와 비슷하나 entity 단위로 컬링하고 skinned mesh 의 surf 를 한꺼번에 등록
     AddSkinnedMeshesForLights(view);
 
+    // CPU skinning 하는 surf 들을 worker thread 들에서 한꺼번에 skinning
+    SkinCpuSkinnedSurfs();
+
     OptimizeLights(view);
 
+    // 같은 sub mesh 와 material 을 사용하는 static mesh surf 들을 instancing 으로 그리도록 묶는다
+    BuildInstancedDrawSurfs(view);
+
     renderSystem.CmdDrawView(view);
 }
 
 void RenderWorld::RenderSubView(viewEntity_t *viewEntity, const DrawSurf *drawSurf, const Material *material) {
 }
 
+// Updates the skinning joint cache of the mesh for this frame, and copies it to the frame data.
+// The game thread updates the cache of the mesh for the next frame while the render thread draws this frame.
+void RenderWorld::UpdateSkinningJointCache(viewEntity_t *viewEntity) {
+    const SceneEntity::Parms &entityParms = viewEntity->def->parms;
+    Mesh *mesh = entityParms.mesh;
+
+    if (entityParms.skeleton && entityParms.joints) {
+        mesh->UpdateSkinningJointCache(entityParms.skeleton, entityParms.joints);
+    }
+
+    if (!mesh->skinningJointCache || viewEntity->skinningJointCache) {
+        return;
+    }
+
+    SkinningJointCache *cache = (SkinningJointCache *)frameData.Alloc(sizeof(SkinningJointCache));
+    *cache = *mesh->skinningJointCache;
+
+    // Joints are set as the shader constants in the back end unless they are in the buffer
+    if (mesh->useGpuSkinning && renderGlobal.skinningMethod == Mesh::VertexShaderSkinning && !renderGlobal.useUniformBuffer) {
+        cache->skinningJoints = (Mat3x4 *)frameData.Alloc(cache->numJoints * sizeof(Mat3x4));
+        simdProcessor->Memcpy(cache->skinningJoints, mesh->skinningJointCache->skinningJoints, cache->numJoints * sizeof(Mat3x4));
+    }
+
+    viewEntity->skinningJointCache = cache;
+}
+
 void RenderWorld::AddDrawSurf(view_t *view, viewEntity_t *viewEntity, const Material *material, SubMesh *subMesh, int flags) {
     if (view->numDrawSurfs + 1 > view->maxDrawSurfs) {
         BE_WARNLOG(L"RenderWorld::AddDrawSurf: not enough renderable surfaces\n");
@@ -785,7 +1345,20 @@ void RenderWorld::AddDrawSurf(view_t *view, viewEntity_t *viewEntity, const Mate
 
     realMaterial->GetExprChunk()->Evaluate(localParms, outputValues);*/
 
-    if (!bufferCacheManager.IsCached(subMesh->vertexCache)) {
+    if (subMesh->IsCpuSkinning()) {
+        // Skinned later in SkinCpuSkinnedSurfs() with other sub meshes.
+        // Shadow caster surfaces add the same sub mesh for each light, so it is collected once per view.
+        if (subMesh->cpuSkinningViewCount != viewCount && !bufferCacheManager.IsCached(subMesh->vertexCache)) {
+            subMesh->cpuSkinningViewCount = viewCount;
+
+            const SceneEntity::Parms &entityParms = viewEntity->def->parms;
+
+            CpuSkinningSurf skinningSurf;
+            skinningSurf.subMesh = subMesh;
+            skinningSurf.skinningJoints = entityParms.skeleton && entityParms.mesh->skinningJointCache ? entityParms.mesh->skinningJointCache->skinningJoints : nullptr;
+            cpuSkinningSurfs.Append(skinningSurf);
+        }
+    } else if (!bufferCacheManager.IsCached(subMesh->vertexCache)) {
         if (subMesh->GetType() == Mesh::ReferenceMesh || 
             subMesh->GetType() == Mesh::StaticMesh || 
             subMesh->GetType() == Mesh::SkinnedMesh) {
@@ -802,7 +1375,7 @@ void RenderWorld::AddDrawSurf(view_t *view, viewEntity_t *viewEntity, const Mate
     drawSurf->subMesh           = subMesh;
     drawSurf->flags             = flags;
 
-    drawSurf->MakeSortKey(viewEntity->def->index, realMaterial);
+    drawSurf->MakeSortKey(viewEntity->def->index, realMaterial, subMesh);
     
     view->drawSurfs[view->numDrawSurfs++] = drawSurf;
 }
@@ -28,6 +28,7 @@ SceneEntity::SceneEntity() {
     motionBlurModelMatrix[0].SetIdentity();
     motionBlurModelMatrix[1].SetIdentity();
     viewCount = 0;
+    viewDistance = 0.0f;
     viewEntity = nullptr;
     proxy = nullptr;
     meshSurfProxies = nullptr;
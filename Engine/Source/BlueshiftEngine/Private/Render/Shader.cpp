@@ -41,13 +41,58 @@ static const char *builtInConstantNames[] = {
     "vertexColorAdd",                       // VertexColorAddConst
     "localViewOrigin",                      // LocalViewOriginConst
     "localLightOrigin",                     // LocalLightOriginConst
-    "localLightAxis"                        // LocalLightAxisConst
+    "localLightAxis",                       // LocalLightAxisConst
+    "prevModelViewProjectionMatrix",        // PrevModelViewProjectionMatrixConst
+    "shutterSpeed",                         // ShutterSpeedConst
+    "perforatedAlpha",                      // PerforatedAlphaConst
+    "ambientScale",                         // AmbientScaleConst
+    "ambientLerp",                          // AmbientLerpConst
+    "joints",                               // JointsConst
+    "tcBase",                               // TcBaseConst
+    "invJointsMapSize",                     // InvJointsMapSizeConst
+    "jointIndexOffsetCurr",                 // JointIndexOffsetCurrConst
+    "jointIndexOffsetPrev",                 // JointIndexOffsetPrevConst
+    "lightInvRadius",                       // LightInvRadiusConst
+    "lightFallOffExponent",                 // LightFallOffExponentConst
+    "lightTextureMatrix",                   // LightTextureMatrixConst
+    "lightColor",                           // LightColorConst
+    "removeBackProjection",                 // RemoveBackProjectionConst
+    "shadowProjectionDepth",                // ShadowProjectionDepthConst
+    "vscmBiasedScale",                      // VscmBiasedScaleConst
+    "shadowProjMatrix",                     // ShadowProjMatrixConst
+    "shadowCascadeProjMatrix",              // ShadowCascadeProjMatrixConst
+    "shadowSplitFar",                       // ShadowSplitFarConst
+    "cascadeBlendSize",                     // CascadeBlendSizeConst
+    "shadowMapFilterSize",                  // ShadowMapFilterSizeConst
+    "shadowMapTexelSize",                   // ShadowMapTexelSizeConst
+    "fogColor",                             // FogColorConst
+    "blendColor"                            // BlendColorConst
+};
+
+// NOTE: BuiltInConstantBlock enum 과 반드시 순서가 같아야 함
+static const char *builtInConstantBlockNames[] = {
+    "JointsBlock",                          // JointsBlock
+    "InstanceDataBlock"                     // InstanceDataBlock
 };
 
 // NOTE: BuiltInSampler enum 과 반드시 순서가 같아야 함
 static const char *builtInSamplerNames[] = {
     "albedoMap",
-    "normalMap"
+    "normalMap",
+    "depthMap",
+    "jointsMap",
+    "envCubeMap",
+    "integrationLUTMap",
+    "irradianceEnvCubeMap0",
+    "irradianceEnvCubeMap1",
+    "prefilteredEnvCubeMap0",
+    "prefilteredEnvCubeMap1",
+    "cubicNormalCubeMap",
+    "indirectionCubeMap",
+    "shadowMap",
+    "shadowArrayMap",
+    "randomRotMatMap",
+    "lightProjectionMap"
 };
 
 int Shader::GetFlags() const {
@@ -65,11 +110,15 @@ const StrHashMap<PropertySpec> &Shader::GetSpecHashMap() const {
 }
 
 void Shader::Purge() {
+    renderSystem.SyncRenderThread();
+
     if (shaderHandle != RHI::NullShader) {
         rhi.DeleteShader(shaderHandle);
         shaderHandle = RHI::NullShader;
     }
 
+    needsCompile = false;
+
     if (ambientLitVersion) {
         shaderManager.ReleaseShader(ambientLitVersion);
         ambientLitVersion = nullptr;
@@ -117,6 +166,11 @@ void Shader::Purge() {
         }
     }
 
+    if (instancingVersion) {
+        shaderManager.ReleaseShader(instancingVersion);
+        instancingVersion = nullptr;
+    }
+
     defineArray.Clear();
     specHashMap.Clear();
 }
@@ -128,6 +182,7 @@ bool Shader::Create(const char *text, const char *baseDir) {
     bool generateParallelShadowVersion = false;
     bool generatePointShadowVersion = false;
     bool generateSpotShadowVersion = false;
+    bool generateInstancingVersion = false;
 
     this->baseDir = baseDir;
 
@@ -268,6 +323,8 @@ bool Shader::Create(const char *text, const char *baseDir) {
             generatePointShadowVersion = true;
         } else if (!token.Icmp("generateSpotShadowVersion")) {
             generateSpotShadowVersion = true;
+        } else if (!token.Icmp("generateInstancingVersion")) {
+            generateInstancingVersion = true;
         } else if (!token.Icmp("glsl_vp")) {
             lexer.ParseBracedSectionExact(vsText);
         } else if (!token.Icmp("glsl_fp")) {
@@ -277,7 +334,7 @@ bool Shader::Create(const char *text, const char *baseDir) {
         }
     }
 
-    return Finish(generatePerforatedVersion, generatePremulAlphaVersion, generateGpuSkinningVersion, generateParallelShadowVersion, generateSpotShadowVersion, generatePointShadowVersion, baseDir);
+    return Finish(generatePerforatedVersion, generatePremulAlphaVersion, generateGpuSkinningVersion, generateParallelShadowVersion, generateSpotShadowVersion, generatePointShadowVersion, generateInstancingVersion, baseDir);
 }
 
 bool Shader::ParseProperties(Lexer &lexer) {
@@ -421,7 +478,26 @@ bool Shader::GeneratePremulAlphaVersion(Shader *shader, const Str &shaderNamePos
     return true;
 }
 
-bool Shader::Finish(bool generatePerforatedVersion, bool generatePremulAlphaVersion, bool genereateGpuSkinningVersion, bool generateParallelShadowVersion, bool generateSpotShadowVersion, bool generatePointShadowVersion, const char *baseDir) {
+bool Shader::GenerateInstancingVersion(Shader *shader, const Str &shaderNamePostfix, const Str &vsHeaderText, const Str &fsHeaderText, bool generatePerforatedVersion) {
+    if (!shader->instancingVersion) {
+        shader->instancingVersion = GenerateSubShader(shaderNamePostfix + "-instancing",
+            vsHeaderText + "#define INSTANCED_DRAW\n$include \"Instancing.glsl\"\n", fsHeaderText, 0);
+        if (!shader->instancingVersion) {
+            return false;
+        }
+    }
+
+    if (generatePerforatedVersion) {
+        if (!GenerateInstancingVersion(shader->perforatedVersion,
+            shaderNamePostfix + "-perforated", vsHeaderText + "#define PERFORATED\n", fsHeaderText + "#define PERFORATED\n", false)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Shader::Finish(bool generatePerforatedVersion, bool generatePremulAlphaVersion, bool genereateGpuSkinningVersion, bool generateParallelShadowVersion, bool generateSpotShadowVersion, bool generatePointShadowVersion, bool generateInstancingVersion, const char *baseDir) {
     if (genereateGpuSkinningVersion) {
         if (!GenerateGpuSkinningVersion(this, "", "", "")) {
             return false;
@@ -440,6 +516,15 @@ bool Shader::Finish(bool generatePerforatedVersion, bool generatePremulAlphaVers
         }
     }
 
+    // Per-instance data of the instancing version is read from the uniform buffer
+    if (generateInstancingVersion && renderGlobal.useInstancing) {
+        if (!GenerateInstancingVersion(this, "", "", "", generatePerforatedVersion)) {
+            return false;
+        }
+
+        flags |= Instancing;
+    }
+
     if (generateParallelShadowVersion) {
         const Str shaderNamePostfix = "-parallelShadowed";
         const Str vsHeaderText = "#define USE_SHADOW_CASCADE\n";
@@ -463,6 +548,12 @@ bool Shader::Finish(bool generatePerforatedVersion, bool generatePremulAlphaVers
                 return false;
             }
         }
+
+        if (generateInstancingVersion && renderGlobal.useInstancing) {
+            if (!GenerateInstancingVersion(parallelShadowVersion, shaderNamePostfix, vsHeaderText, fsHeaderText, generatePerforatedVersion)) {
+                return false;
+            }
+        }
     }
 
     if (generateSpotShadowVersion) {
@@ -488,6 +579,12 @@ bool Shader::Finish(bool generatePerforatedVersion, bool generatePremulAlphaVers
                 return false;
             }
         }
+
+        if (generateInstancingVersion && renderGlobal.useInstancing) {
+            if (!GenerateInstancingVersion(spotShadowVersion, shaderNamePostfix, vsHeaderText, fsHeaderText, generatePerforatedVersion)) {
+                return false;
+            }
+        }
     }
 
     if (generatePointShadowVersion) {
@@ -513,6 +610,12 @@ bool Shader::Finish(bool generatePerforatedVersion, bool generatePremulAlphaVers
                 return false;
             }
         }
+
+        if (generateInstancingVersion && renderGlobal.useInstancing) {
+            if (!GenerateInstancingVersion(pointShadowVersion, shaderNamePostfix, vsHeaderText, fsHeaderText, generatePerforatedVersion)) {
+                return false;
+            }
+        }
     }
 
     return true;
@@ -527,8 +630,9 @@ const char *Shader::MangleNameWithDefineList(const Str &basename, const Array<Sh
             return (a.name).Icmp(b.name) < 0;
         });
     
-        for (int i = 0; i < defineArray.Count(); i++) {
-            mangledName += "+" + defineArray[i].name + "=" + defineArray[i].value;
+        // Mangled name is the permutation key, so the same define list in different order should get the same name
+        for (int i = 0; i < sortedDefineArray.Count(); i++) {
+            mangledName += "+" + sortedDefineArray[i].name + "=" + sortedDefineArray[i].value;
         }
     }
 
@@ -540,6 +644,8 @@ Shader *Shader::InstantiateShader(const Array<Define> &defineArray) {
     // instantiated shader name start with '@' character
     MangleNameWithDefineList("@" + name, defineArray, mangledName);
 
+    ShaderManager::ScopedLock lock;
+
     // return instantiated shader if it already exist
     Shader *shader = shaderManager.FindShader(mangledName);
     if (shader) {
@@ -563,6 +669,17 @@ Shader *Shader::InstantiateShader(const Array<Define> &defineArray) {
     return shader;
 }
 
+// Versions are instantiated lazily on both the game thread and the render thread, so they are instantiated under the lock.
+Shader *Shader::InstantiateVersion(Shader *&version, Shader *originalVersion) {
+    ShaderManager::ScopedLock lock;
+
+    if (!version) {
+        version = originalVersion->InstantiateShader(defineArray);
+    }
+
+    return version;
+}
+
 Shader *Shader::GetPerforatedVersion() {
     if (perforatedVersion) {
         return perforatedVersion;
@@ -570,8 +687,7 @@ Shader *Shader::GetPerforatedVersion() {
 
     if (originalShader) {
         if (originalShader->perforatedVersion) {
-            perforatedVersion = originalShader->perforatedVersion->InstantiateShader(defineArray);
-            return perforatedVersion;
+            return InstantiateVersion(perforatedVersion, originalShader->perforatedVersion);
         }
     }
 
@@ -585,8 +701,7 @@ Shader *Shader::GetPremulAlphaVersion() {
 
     if (originalShader) {
         if (originalShader->premulAlphaVersion) {
-            premulAlphaVersion = originalShader->premulAlphaVersion->InstantiateShader(defineArray);
-            return premulAlphaVersion;
+            return InstantiateVersion(premulAlphaVersion, originalShader->premulAlphaVersion);
         }
     }
 
@@ -600,8 +715,7 @@ Shader *Shader::GetAmbientLitVersion() {
 
     if (originalShader) {
         if (originalShader->ambientLitVersion) {
-            ambientLitVersion = originalShader->ambientLitVersion->InstantiateShader(defineArray);
-            return ambientLitVersion;
+            return InstantiateVersion(ambientLitVersion, originalShader->ambientLitVersion);
         }
     }
 
@@ -615,8 +729,7 @@ Shader *Shader::GetDirectLitVersion() {
 
     if (originalShader) {
         if (originalShader->directLitVersion) {
-            directLitVersion = originalShader->directLitVersion->InstantiateShader(defineArray);
-            return directLitVersion;
+            return InstantiateVersion(directLitVersion, originalShader->directLitVersion);
         }
     }
 
@@ -630,8 +743,7 @@ Shader *Shader::GetAmbientLitDirectLitVersion() {
 
     if (originalShader) {
         if (originalShader->ambientLitDirectLitVersion) {
-            ambientLitDirectLitVersion = originalShader->ambientLitDirectLitVersion->InstantiateShader(defineArray);
-            return ambientLitDirectLitVersion;
+            return InstantiateVersion(ambientLitDirectLitVersion, originalShader->ambientLitDirectLitVersion);
         }
     }
 
@@ -645,8 +757,7 @@ Shader *Shader::GetParallelShadowVersion() {
 
     if (originalShader) {
         if (originalShader->parallelShadowVersion) {
-            parallelShadowVersion = originalShader->parallelShadowVersion->InstantiateShader(defineArray);
-            return parallelShadowVersion;
+            return InstantiateVersion(parallelShadowVersion, originalShader->parallelShadowVersion);
         }
     }
 
@@ -660,8 +771,7 @@ Shader *Shader::GetSpotShadowVersion() {
 
     if (originalShader) {
         if (originalShader->spotShadowVersion) {
-            spotShadowVersion = originalShader->spotShadowVersion->InstantiateShader(defineArray);
-            return spotShadowVersion;
+            return InstantiateVersion(spotShadowVersion, originalShader->spotShadowVersion);
         }
     }
 
@@ -675,8 +785,7 @@ Shader *Shader::GetPointShadowVersion() {
 
     if (originalShader) {
         if (originalShader->pointShadowVersion) {
-            pointShadowVersion = originalShader->pointShadowVersion->InstantiateShader(defineArray);
-            return pointShadowVersion;
+            return InstantiateVersion(pointShadowVersion, originalShader->pointShadowVersion);
         }
     }
 
@@ -690,8 +799,21 @@ Shader *Shader::GetGPUSkinningVersion(int index) {
 
     if (originalShader) {
         if (originalShader->gpuSkinningVersion[index]) {
-            gpuSkinningVersion[index] = originalShader->gpuSkinningVersion[index]->InstantiateShader(defineArray);
-            return gpuSkinningVersion[index];
+            return InstantiateVersion(gpuSkinningVersion[index], originalShader->gpuSkinningVersion[index]);
+        }
+    }
+
+    return nullptr;
+}
+
+Shader *Shader::GetInstancingVersion() {
+    if (instancingVersion) {
+        return instancingVersion;
+    }
+
+    if (originalShader) {
+        if (originalShader->instancingVersion) {
+            return InstantiateVersion(instancingVersion, originalShader->instancingVersion);
         }
     }
 
@@ -829,9 +951,24 @@ void Shader::Reinstantiate() {
             }
         }
     }
+
+    if (originalShader->instancingVersion) {
+        if (instancingVersion) {
+            instancingVersion->originalShader = originalShader->instancingVersion;
+            instancingVersion->Reinstantiate();
+        } else {
+            instancingVersion = originalShader->instancingVersion->InstantiateShader(defineArray);
+        }
+    } else {
+        if (instancingVersion) {
+            shaderManager.ReleaseShader(instancingVersion);
+            instancingVersion = nullptr;
+        }
+    }
 }
 
 bool Shader::Instantiate(const Array<Define> &defineArray) {
+    // Progress screen while loading. Not in Compile(), which can be called by Bind() in the middle of a frame.
 #if defined __ANDROID__ && ! defined __XAMARIN__
     static int progress = 0;
 
@@ -850,6 +987,20 @@ bool Shader::Instantiate(const Array<Define> &defineArray) {
     //BE_LOG(L"progress %f %f %f %f %d", color.r, color.g, color.b, f, progress);
 #endif
 
+    // Compiling is deferred until the first bind, so that the variants never used are not compiled
+    if (r_lazyShaderCompile.GetBool()) {
+        needsCompile = true;
+        return true;
+    }
+
+    return Compile();
+}
+
+bool Shader::Compile() {
+    renderSystem.SyncRenderThread();
+
+    needsCompile = false;
+
     Str processedVsText;
     Str processedFsText;
     hasVertexShader = ProcessShaderText(originalShader->vsText, originalShader->baseDir, defineArray, processedVsText);
@@ -866,31 +1017,54 @@ bool Shader::Instantiate(const Array<Define> &defineArray) {
     shaderHandle = rhi.CreateShader(hashName, processedVsText, processedFsText);
 
     assert(MaxBuiltInConstants == COUNT_OF(builtInConstantNames));
+    assert(MaxBuiltInConstantBlocks == COUNT_OF(builtInConstantBlockNames));
     assert(MaxBuiltInSamplers == COUNT_OF(builtInSamplerNames));
 
     for (int i = 0; i < MaxBuiltInConstants; i++) {
         builtInConstantLocations[i] = rhi.GetShaderConstantLocation(shaderHandle, builtInConstantNames[i]);
     }
 
+    for (int i = 0; i < MaxBuiltInConstantBlocks; i++) {
+        builtInConstantBlockIndexes[i] = rhi.GetShaderConstantBlockIndex(shaderHandle, builtInConstantBlockNames[i]);
+    }
+
     for (int i = 0; i < MaxBuiltInSamplers; i++) {
         builtInSamplerUnits[i] = rhi.GetSamplerUnit(shaderHandle, builtInSamplerNames[i]);
     }
 
+    // Resolve locations of the property constants, so that material properties don't need to be searched by name in every draw
+    const auto &specHashMap = GetSpecHashMap();
+    propertyLocations.SetCount(specHashMap.Count());
+
+    for (int i = 0; i < specHashMap.Count(); i++) {
+        const auto *entry = specHashMap.GetByIndex(i);
+        const auto &spec = entry->second;
+
+        if (spec.GetFlags() & PropertySpec::ShaderDefine) {
+            propertyLocations[i] = -1;
+        } else if (spec.GetType() == PropertySpec::ObjectType) {
+            propertyLocations[i] = rhi.GetSamplerUnit(shaderHandle, entry->first);
+        } else {
+            propertyLocations[i] = rhi.GetShaderConstantLocation(shaderHandle, entry->first);
+        }
+    }
+
     return true;
 }
 
 bool Shader::ProcessShaderText(const char *text, const char *baseDir, const Array<Define> &defineArray, Str &outStr) const {
-    outStr = text;
+    // Build the text in one pass: global headers first, followed by the local define array
+    outStr.Clear();
+
+    for (int i = 0; i < shaderManager.globalHeaderList.Count(); i++) {
+        outStr.Append(shaderManager.globalHeaderList[i]);
+    }
 
-    // insert local define array
     for (int i = 0; i < defineArray.Count(); i++) {
-        outStr.Insert(va("#define %s %i\n", defineArray[i].name.c_str(), defineArray[i].value), 0);
+        outStr.Append(va("#define %s %i\n", defineArray[i].name.c_str(), defineArray[i].value));
     }
 
-    // insert global define array
-    for (int i = shaderManager.globalHeaderList.Count() - 1; i >= 0; i--) {
-        outStr.Insert(shaderManager.globalHeaderList[i].c_str(), 0);
-    }    
+    outStr.Append(text);
 
     ProcessIncludeRecursive(baseDir, outStr);
 
@@ -901,14 +1075,15 @@ bool Shader::ProcessIncludeRecursive(const char *baseDir, Str &outText) const {
     Lexer lexer;
     lexer.Init(LexerFlag::LEXFL_NOERRORS);
 
-    int pos = 0;
+    int pos = outText.Find(directiveInclude, true, 0);
+    if (pos == -1) {
+        return true;
+    }
 
-    do {
-        pos = outText.Find(directiveInclude, true, pos);
-        if (pos == -1) {
-            return true;
-        }
+    Str processedText;
+    int copiedPos = 0;
 
+    do {
         const char *data_p = outText.c_str() + pos + Str::Length(directiveInclude);
         lexer.Load(data_p, Str::Length(data_p), hashName);
 
@@ -916,30 +1091,50 @@ bool Shader::ProcessIncludeRecursive(const char *baseDir, Str &outText) const {
         lexer.ExpectTokenType(TT_STRING, &relativeFileName);
 
         Str path = baseDir;
-        path.AppendPath(relativeFileName);  
+        path.AppendPath(relativeFileName);
+
+        // Include files are cached with their nested includes expanded, so that each file is read once for all the permutations
+        const auto *entry = shaderManager.includeTextCache.Get(path);
+        if (!entry) {
+            char *includingText;
+            size_t fileLen = fileSystem.LoadFile(path.c_str(), true, (void **)&includingText);
+            if (!fileLen) {
+                BE_FATALERROR(L"Shader::ProcessIncludeRecursive: Cannot open include file '%hs'", path.c_str());
+                return false;
+            }
 
-        char *includingText;
-        size_t fileLen = fileSystem.LoadFile(path.c_str(), true, (void **)&includingText);
-        if (!fileLen) {
-            BE_FATALERROR(L"Shader::ProcessIncludeRecursive: Cannot open include file '%hs'", path.c_str());
-            return false;
+            Str newBaseDir = path;
+            newBaseDir.StripFileName();
+
+            Str nestedText = includingText;
+            fileSystem.FreeFile(includingText);
+
+            ProcessIncludeRecursive(newBaseDir, nestedText);
+
+            shaderManager.includeTextCache.Set(path, nestedText);
+            entry = shaderManager.includeTextCache.Get(path);
         }
 
-        Str newBaseDir = path;
-        newBaseDir.StripFileName();
+        processedText.Append(outText.c_str() + copiedPos, pos - copiedPos);
+        processedText.Append(entry->second);
+
+        copiedPos = (int)(data_p - outText.c_str()) + lexer.GetCurrentOffset();
 
-        Str nestedText = includingText;
-        ProcessIncludeRecursive(newBaseDir, nestedText);
+        pos = outText.Find(directiveInclude, true, copiedPos);
+    } while (pos != -1);
 
-        outText = outText.Left(pos) + nestedText + Str(data_p + lexer.GetCurrentOffset());
+    processedText.Append(outText.c_str() + copiedPos);
 
-        fileSystem.FreeFile(includingText);
-    } while (1);
+    outText = processedText;
 
     return true;
 }
 
 void Shader::Bind() const { 
+    if (needsCompile) {
+        const_cast<Shader *>(this)->Compile();
+    }
+
     rhi.BindShader(shaderHandle);
 }
 
@@ -1311,6 +1506,23 @@ void Shader::SetConstantArray4x4f(const char *name, bool rowmajor, int num, cons
     rhi.SetShaderConstantArray4x4f(index, rowmajor, num, constant);
 }
 
+int Shader::GetConstantBlockIndex(const char *name) const {
+    return rhi.GetShaderConstantBlockIndex(shaderHandle, name);
+}
+
+void Shader::SetConstantBuffer(int index, RHI::Handle bufferHandle, int offset) const {
+    rhi.SetShaderConstantBlock(index, bufferHandle, offset);
+}
+
+void Shader::SetConstantBuffer(const char *name, RHI::Handle bufferHandle, int offset) const {
+    int index = rhi.GetShaderConstantBlockIndex(shaderHandle, name);
+    if (index < 0) {
+        //BE_WARNLOG(L"Shader::SetConstantBuffer: invalid constant block name '%hs' in shader '%hs'\n", name, this->hashName.c_str());
+        return;
+    }
+    rhi.SetShaderConstantBlock(index, bufferHandle, offset);
+}
+
 int Shader::GetSamplerUnit(const char *name) const {
     return rhi.GetSamplerUnit(shaderHandle, name);
 }
@@ -1396,6 +1608,11 @@ bool Shader::Reload() {
         return false;
     }
 
+    ShaderManager::ScopedLock lock;
+
+    // Include files might be changed too
+    shaderManager.includeTextCache.Clear();
+
     Str _hashName = shader->hashName;
     bool ret = shader->Load(_hashName);
 
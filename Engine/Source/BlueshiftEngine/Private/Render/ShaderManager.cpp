@@ -86,6 +86,7 @@ Shader *            ShaderManager::drawArrayTextureShader;
 Shader *            ShaderManager::simpleShader;
 Shader *            ShaderManager::selectionIdShader;
 Shader *            ShaderManager::depthShader;
+Shader *            ShaderManager::shadowDepthShader;
 Shader *            ShaderManager::constantColorShader;
 Shader *            ShaderManager::vertexColorShader;
 Shader *            ShaderManager::objectMotionBlurShader;
@@ -138,6 +139,8 @@ void ShaderManager::Init() {
 
     shaderHashMap.Init(1024, 128, 128);
 
+    mutex = PlatformMutex::Create();
+
     InitShaders();
 
     //defaultShader = AllocShader("_defaultShader", DefaultShaderGuid);
@@ -159,6 +162,23 @@ void ShaderManager::Shutdown() {
     shaderHashMap.DeleteContents(true);
 
     globalHeaderList.Clear();
+
+    includeTextCache.Clear();
+
+    PlatformMutex::Delete(mutex);
+    mutex = nullptr;
+}
+
+void ShaderManager::Lock() const {
+    // The render thread may wait for this lock while the game thread waits for the render thread
+    // in Shader::Compile() or Shader::Purge(), so the game thread syncs before taking it.
+    renderSystem.SyncRenderThread();
+
+    PlatformMutex::Lock(mutex);
+}
+
+void ShaderManager::Unlock() const {
+    PlatformMutex::Unlock(mutex);
 }
 
 void ShaderManager::InitShaders() {
@@ -202,6 +222,10 @@ void ShaderManager::InitGlobalDefines() {
         shaderManager.AddGlobalHeader("#define USE_BUFFER_TEXTURE\n");
     }
 
+    if (renderGlobal.useUniformBuffer) {
+        shaderManager.AddGlobalHeader("#define USE_UNIFORM_BUFFER\n");
+    }
+
     if (r_shadows.GetInteger() == 1) {
         shaderManager.AddGlobalHeader("#define USE_SHADOW_MAP\n");
     }
@@ -209,8 +233,16 @@ void ShaderManager::InitGlobalDefines() {
     shaderManager.AddGlobalHeader(va("#define SHADOW_MAP_QUALITY %i\n", r_shadowMapQuality.GetInteger()));
     
     int maxShaderJoints = (rhi.HWLimit().maxVertexUniformComponents - 256) / (4 * 3);
+    if (renderGlobal.useUniformBuffer) {
+        // Joints block should fit in the uniform block size
+        maxShaderJoints = Min(maxShaderJoints, rhi.HWLimit().maxUniformBlockSize / (int)sizeof(Mat3x4));
+    }
     shaderManager.AddGlobalHeader(va("#define MAX_SHADER_JOINTSX3 %i\n", maxShaderJoints * 3));
 
+    if (renderGlobal.useInstancing) {
+        shaderManager.AddGlobalHeader(va("#define MAX_INSTANCES %i\n", renderGlobal.maxInstances));
+    }
+
     shaderManager.AddGlobalHeader(va("#define CSM_COUNT %i\n", r_CSM_count.GetInteger()));
     shaderManager.AddGlobalHeader(va("#define CASCADE_SELECTION_METHOD %i\n", r_CSM_selectionMethod.GetInteger()));
 
@@ -249,6 +281,10 @@ void ShaderManager::InstantiateEngineShaders() {
 
     depthShader = originalShaders[DepthShader]->InstantiateShader(Array<Shader::Define>());
 
+    defineArray.Clear();
+    defineArray.Append(Shader::Define("SHADOW_DEPTH", 1));
+    shadowDepthShader = originalShaders[DepthShader]->InstantiateShader(defineArray);
+
     constantColorShader = originalShaders[ConstantColorShader]->InstantiateShader(Array<Shader::Define>());
     vertexColorShader = originalShaders[VertexColorShader]->InstantiateShader(Array<Shader::Define>());
 
@@ -373,6 +409,8 @@ void ShaderManager::ReloadLitSurfaceShaders() {
 }
 
 void ShaderManager::DestroyUnusedShaders() {
+    ScopedLock lock;
+
     Array<Shader *> removeArray;
 
     for (int i = 0; i < shaderHashMap.Count(); i++) {
@@ -390,6 +428,8 @@ void ShaderManager::DestroyUnusedShaders() {
 }
 
 void ShaderManager::DestroyShader(Shader *shader) {
+    ScopedLock lock;
+
     if (shader->refCount > 1) {
         BE_WARNLOG(L"ShaderManager::DestroyShader: shader '%hs' has %i reference count\n", shader->hashName.c_str(), shader->refCount);
     }
@@ -400,6 +440,8 @@ void ShaderManager::DestroyShader(Shader *shader) {
 }
 
 Shader *ShaderManager::AllocShader(const char *hashName) {
+    ScopedLock lock;
+
     if (shaderHashMap.Get(hashName)) {
         BE_FATALERROR(L"%hs shader already allocated", hashName);
     }
@@ -417,6 +459,8 @@ Shader *ShaderManager::AllocShader(const char *hashName) {
 }
 
 Shader *ShaderManager::FindShader(const char *hashName) const {
+    ScopedLock lock;
+
     const auto *entry = shaderHashMap.Get(hashName);
     if (entry) {
         return entry->second;
@@ -430,6 +474,8 @@ Shader *ShaderManager::GetShader(const char *hashName) {
         return nullptr;
     }
 
+    ScopedLock lock;
+
     Shader *shader = FindShader(hashName);
     if (shader) {
         shader->refCount++;
@@ -446,6 +492,8 @@ Shader *ShaderManager::GetShader(const char *hashName) {
 }
 
 void ShaderManager::RenameShader(Shader *shader, const Str &newName) {
+    ScopedLock lock;
+
     if (shader->originalShader) {
         shader = shader->originalShader;
     }
@@ -484,6 +532,8 @@ void ShaderManager::ReleaseShader(Shader *shader, bool immediateDestroy) {
         return;
     }
 
+    ScopedLock lock;
+
     if (shader->refCount > 0) {
         shader->refCount--;
     }
@@ -17,7 +17,6 @@
 #include "RenderInternal.h"
 #include "Simd/Simd.h"
 #include "Core/Heap.h"
-#include "NvTriStrip.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -74,13 +73,14 @@ void SubMesh::AllocSubMesh(int numVerts, int numIndexes) {
 
     this->vertWeights               = nullptr;
     this->useGpuSkinning            = false;
+    this->useCpuSkinning            = false;
     this->gpuSkinningVersionIndex   = 0;
 
     this->vertexCache               = (BufferCache *)Mem_ClearedAlloc(sizeof(BufferCache));
     this->indexCache                = (BufferCache *)Mem_ClearedAlloc(sizeof(BufferCache));
 }
 
-void SubMesh::AllocInstantiatedSubMesh(const SubMesh *ref, int meshType) {
+void SubMesh::AllocInstantiatedSubMesh(const SubMesh *ref, int meshType, bool gpuSkinning) {
     assert(ref->type == Mesh::ReferenceMesh);
 
     this->alloced                   = true;
@@ -108,7 +108,8 @@ void SubMesh::AllocInstantiatedSubMesh(const SubMesh *ref, int meshType) {
     this->jointWeightVerts          = ref->jointWeightVerts;
 
     this->vertWeights               = ref->vertWeights;
-    this->useGpuSkinning            = (ref->vertWeights && meshType == Mesh::SkinnedMesh) ? true : false;
+    this->useGpuSkinning            = (ref->vertWeights && meshType == Mesh::SkinnedMesh && gpuSkinning) ? true : false;
+    this->useCpuSkinning            = (ref->vertWeights && meshType == Mesh::SkinnedMesh && !gpuSkinning) ? true : false;
     this->gpuSkinningVersionIndex   = ref->gpuSkinningVersionIndex;
 
     this->aabb                      = ref->aabb;
@@ -118,6 +119,12 @@ void SubMesh::AllocInstantiatedSubMesh(const SubMesh *ref, int meshType) {
 
         this->vertexCache           = ref->vertexCache;
         this->indexCache            = ref->indexCache;
+    } else if (this->useCpuSkinning) {
+        // Bind pose vertices are shared, and skinned vertices are written into the dynamic buffers every frame
+        this->verts                 = ref->verts;
+
+        this->vertexCache           = (BufferCache *)Mem_ClearedAlloc(sizeof(BufferCache));
+        this->indexCache            = (BufferCache *)Mem_ClearedAlloc(sizeof(BufferCache));
     } else {
         this->verts                 = (VertexGenericLit *)Mem_Alloc16(sizeof(VertexGenericLit) * ref->numVerts);
 
@@ -159,6 +166,12 @@ void SubMesh::FreeSubMesh() {
         return;
     }
 
+    if (useCpuSkinning) {
+        Mem_Free(vertexCache);
+        Mem_Free(indexCache);
+        return;
+    }
+
     if (type == Mesh::DynamicMesh || (type == Mesh::SkinnedMesh && !useGpuSkinning)) {
         Mem_AlignedFree(verts);
         Mem_Free(vertexCache);
@@ -231,6 +244,27 @@ void SubMesh::CacheDynamicDataToGpu(const Mat3x4 *joints, const Material *materi
     bufferCacheManager.UnmapIndexBuffer(indexCache);
 }
 
+void SubMesh::SkinVerts(const Mat3x4 *skinningJoints, VertexGenericLit *dstVerts) const {
+    assert(useCpuSkinning);
+
+    if (!skinningJoints) {
+        simdProcessor->Memcpy(dstVerts, verts, sizeof(VertexGenericLit) * numVerts);
+        return;
+    }
+
+    simdProcessor->SkinVerts(dstVerts, verts, numVerts, vertWeights, MaxVertexWeights(), skinningJoints);
+}
+
+void SubMesh::WriteIndexes(int baseVertex, TriIndex *dstIndexes) const {
+    const TriIndex *srcIndexes = indexes;
+
+    for (int i = 0; i < numIndexes; i += 3, dstIndexes += 3, srcIndexes += 3) {
+        dstIndexes[0] = baseVertex + srcIndexes[0];
+        dstIndexes[1] = baseVertex + srcIndexes[1];
+        dstIndexes[2] = baseVertex + srcIndexes[2];
+    }
+}
+
 void SubMesh::SplitMirroredVerts() {
     Vec3        tangents[2];
     float       handedness;
@@ -1183,40 +1217,4 @@ const Mat3 SubMesh::ComputeInertiaTensor(const Vec3 &centroid, float mass) const
     return inertia;
 }
 
-void SubMesh::OptimizeIndexedTriangles() {
-#if 0
-    // NOTE: consider if size of the index is greater than 16 bit number or not
-    PrimitiveGroup *srcPrimGroup = new PrimitiveGroup;
-    srcPrimGroup->type = PrimType::PT_LIST;
-    srcPrimGroup->numIndices = numIndexes;
-    srcPrimGroup->indices = new unsigned short [numIndexes];
-
-    for (int i = 0; i < numIndexes; i++) {
-        srcPrimGroup->indices[i] = indexes[i];
-    }
-
-    PrimitiveGroup *dstPrimGroup;
-
-    // remap indices
-    RemapIndices(srcPrimGroup, 1, numVerts, &dstPrimGroup);
-
-    for (int i = 0; i < numIndexes; i++) {
-        indexes[i] = dstPrimGroup->indices[i];
-    }
-
-    // remap vertices
-    VertexGenericLit *remappedVerts = (VertexGenericLit *)Mem_Alloc16(sizeof(verts[0]) * numVerts);
-
-    for (int i = 0; i < numIndexes; i++) {
-        remappedVerts[dstPrimGroup->indices[i]] = verts[srcPrimGroup->indices[i]];
-    }
-
-    Mem_AlignedFree(verts);
-    verts = remappedVerts;
-    
-    delete srcPrimGroup;
-    delete [] dstPrimGroup;
-#endif
-}
-
 BE_NAMESPACE_END
@@ -0,0 +1,398 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Render/Render.h"
+#include "RenderInternal.h"
+#include "Core/Heap.h"
+
+BE_NAMESPACE_BEGIN
+
+static const int    VERTEX_CACHE_SIZE           = 32;       // LRU cache size for vertex score
+static const int    FIFO_CACHE_SIZE             = 16;       // FIFO cache size for ACMR and cluster simulation
+static const float  CACHE_DECAY_POWER           = 1.5f;
+static const float  LAST_TRI_SCORE              = 0.75f;
+static const float  VALENCE_BOOST_SCALE         = 2.0f;
+static const float  VALENCE_BOOST_POWER         = 0.5f;
+static const float  OVERDRAW_ACMR_THRESHOLD     = 1.05f;    // overdraw ordering is rejected if ACMR gets worse more than this ratio
+
+// Simulates FIFO post-transform vertex cache and returns number of cache misses.
+// If clusters is not null, indexes of the triangles that start a new cluster are appended.
+// A new cluster starts at the triangle of which all three vertices are missed.
+static int SimulateFifoCache(const TriIndex *indexes, int numIndexes, int numVerts, int cacheSize, Array<int> *clusters) {
+    int *cacheTimeStamps = (int *)Mem_Alloc(numVerts * sizeof(int));
+    for (int i = 0; i < numVerts; i++) {
+        cacheTimeStamps[i] = -cacheSize - 1;
+    }
+
+    int time = 0;
+    int numMisses = 0;
+
+    for (int i = 0; i < numIndexes; i += 3) {
+        int numTriMisses = 0;
+
+        for (int j = 0; j < 3; j++) {
+            TriIndex index = indexes[i + j];
+
+            if (time - cacheTimeStamps[index] > cacheSize) {
+                cacheTimeStamps[index] = time++;
+                numTriMisses++;
+            }
+        }
+
+        if (clusters && (i == 0 || numTriMisses == 3)) {
+            clusters->Append(i / 3);
+        }
+
+        numMisses += numTriMisses;
+    }
+
+    Mem_Free(cacheTimeStamps);
+
+    return numMisses;
+}
+
+static float ComputeVertexScore(int cachePosition, int numRemainingTris) {
+    if (numRemainingTris == 0) {
+        // No triangle needs this vertex
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // This vertex was used in the last triangle, so it has a fixed score
+            score = LAST_TRI_SCORE;
+        } else {
+            // Points for being high in the cache
+            const float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+            score = Math::Pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Bonus points for having low number of tris still to use the vertex, so we get rid of lone verts quickly
+    score += VALENCE_BOOST_SCALE * Math::Pow((float)numRemainingTris, -VALENCE_BOOST_POWER);
+
+    return score;
+}
+
+// Linear-speed vertex cache optimization (Tom Forsyth).
+// Greedily emits the triangle of which vertices have the highest score with respect to the simulated LRU cache.
+static void OptimizeVertexCache(const TriIndex *indexes, int numIndexes, int numVerts, TriIndex *outIndexes) {
+    const int numTris = numIndexes / 3;
+
+    // Build vertex to triangle adjacency
+    int *numRemainingTris = (int *)Mem_ClearedAlloc(numVerts * sizeof(int));
+    int *adjacencyOffsets = (int *)Mem_Alloc((numVerts + 1) * sizeof(int));
+    int *adjacency = (int *)Mem_Alloc(numIndexes * sizeof(int));
+
+    for (int i = 0; i < numIndexes; i++) {
+        numRemainingTris[indexes[i]]++;
+    }
+
+    adjacencyOffsets[0] = 0;
+    for (int i = 0; i < numVerts; i++) {
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + numRemainingTris[i];
+    }
+
+    int *adjacencyCounts = (int *)Mem_ClearedAlloc(numVerts * sizeof(int));
+    for (int i = 0; i < numIndexes; i++) {
+        TriIndex index = indexes[i];
+        adjacency[adjacencyOffsets[index] + adjacencyCounts[index]++] = i / 3;
+    }
+    Mem_Free(adjacencyCounts);
+
+    float *vertexScores = (float *)Mem_Alloc(numVerts * sizeof(float));
+
+    for (int i = 0; i < numVerts; i++) {
+        vertexScores[i] = ComputeVertexScore(-1, numRemainingTris[i]);
+    }
+
+    float *triScores = (float *)Mem_Alloc(numTris * sizeof(float));
+    bool *emitted = (bool *)Mem_ClearedAlloc(numTris * sizeof(bool));
+
+    for (int i = 0; i < numTris; i++) {
+        triScores[i] = vertexScores[indexes[i * 3 + 0]] + vertexScores[indexes[i * 3 + 1]] + vertexScores[indexes[i * 3 + 2]];
+    }
+
+    // LRU cache with 3 extra entries for newly added vertices
+    TriIndex cache[VERTEX_CACHE_SIZE + 3];
+    int cacheCount = 0;
+
+    int bestTri = -1;
+    float bestScore = -1.0f;
+    for (int i = 0; i < numTris; i++) {
+        if (triScores[i] > bestScore) {
+            bestScore = triScores[i];
+            bestTri = i;
+        }
+    }
+
+    int nextUnemittedTri = 0;
+    int numOutIndexes = 0;
+
+    while (bestTri >= 0) {
+        const TriIndex *triIndexes = &indexes[bestTri * 3];
+
+        emitted[bestTri] = true;
+        outIndexes[numOutIndexes++] = triIndexes[0];
+        outIndexes[numOutIndexes++] = triIndexes[1];
+        outIndexes[numOutIndexes++] = triIndexes[2];
+
+        // Update LRU cache: move the triangle vertices to the front
+        TriIndex newCache[VERTEX_CACHE_SIZE + 3];
+        int newCacheCount = 0;
+
+        for (int i = 0; i < 3; i++) {
+            TriIndex index = triIndexes[i];
+            newCache[newCacheCount++] = index;
+
+            // Remove the emitted triangle from the adjacency of the vertex
+            int *vertTris = &adjacency[adjacencyOffsets[index]];
+            int count = numRemainingTris[index];
+            for (int j = 0; j < count; j++) {
+                if (vertTris[j] == bestTri) {
+                    vertTris[j] = vertTris[count - 1];
+                    break;
+                }
+            }
+            numRemainingTris[index]--;
+        }
+
+        for (int i = 0; i < cacheCount; i++) {
+            TriIndex index = cache[i];
+            if (index != triIndexes[0] && index != triIndexes[1] && index != triIndexes[2]) {
+                newCache[newCacheCount++] = index;
+            }
+        }
+
+        cacheCount = Min(newCacheCount, VERTEX_CACHE_SIZE);
+        memcpy(cache, newCache, newCacheCount * sizeof(cache[0]));
+
+        // Update scores of the vertices that were in the cache and their triangles.
+        // Vertices pushed out of the cache get cache position -1.
+        for (int i = 0; i < newCacheCount; i++) {
+            TriIndex index = newCache[i];
+            int cachePosition = i < VERTEX_CACHE_SIZE ? i : -1;
+
+            float newScore = ComputeVertexScore(cachePosition, numRemainingTris[index]);
+            float deltaScore = newScore - vertexScores[index];
+            vertexScores[index] = newScore;
+
+            const int *vertTris = &adjacency[adjacencyOffsets[index]];
+            for (int j = 0; j < numRemainingTris[index]; j++) {
+                triScores[vertTris[j]] += deltaScore;
+            }
+        }
+
+        // Find the best triangle among the triangles using the cached vertices
+        bestTri = -1;
+        bestScore = -1.0f;
+
+        for (int i = 0; i < cacheCount; i++) {
+            TriIndex index = cache[i];
+
+            const int *vertTris = &adjacency[adjacencyOffsets[index]];
+            for (int j = 0; j < numRemainingTris[index]; j++) {
+                int tri = vertTris[j];
+                if (triScores[tri] > bestScore) {
+                    bestScore = triScores[tri];
+                    bestTri = tri;
+                }
+            }
+        }
+
+        if (bestTri < 0) {
+            // No triangle is adjacent to the cache, pick next one in the input order
+            while (nextUnemittedTri < numTris && emitted[nextUnemittedTri]) {
+                nextUnemittedTri++;
+            }
+            if (nextUnemittedTri < numTris) {
+                bestTri = nextUnemittedTri;
+            }
+        }
+    }
+
+    assert(numOutIndexes == numIndexes);
+
+    Mem_Free(numRemainingTris);
+    Mem_Free(adjacencyOffsets);
+    Mem_Free(adjacency);
+    Mem_Free(vertexScores);
+    Mem_Free(triScores);
+    Mem_Free(emitted);
+}
+
+// Reorders the clusters of the cache optimized triangles so that the clusters facing outward of the mesh
+// are drawn first (Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+static void OptimizeOverdraw(const TriIndex *indexes, int numIndexes, const VertexGenericLit *verts, int numVerts, TriIndex *outIndexes) {
+    const int numTris = numIndexes / 3;
+
+    Array<int> clusters;
+    SimulateFifoCache(indexes, numIndexes, numVerts, FIFO_CACHE_SIZE, &clusters);
+    clusters.Append(numTris);
+
+    const int numClusters = clusters.Count() - 1;
+
+    // Mesh centroid
+    Vec3 meshCentroid = Vec3::zero;
+    for (int i = 0; i < numVerts; i++) {
+        meshCentroid += verts[i].GetPosition();
+    }
+    meshCentroid /= (float)numVerts;
+
+    struct ClusterSort {
+        int     clusterIndex;
+        float   sortValue;
+    };
+    Array<ClusterSort> clusterSorts;
+    clusterSorts.SetCount(numClusters);
+
+    for (int clusterIndex = 0; clusterIndex < numClusters; clusterIndex++) {
+        Vec3 clusterCentroid = Vec3::zero;
+        Vec3 clusterNormal = Vec3::zero;
+        float clusterArea = 0.0f;
+
+        for (int tri = clusters[clusterIndex]; tri < clusters[clusterIndex + 1]; tri++) {
+            const Vec3 p0 = verts[indexes[tri * 3 + 0]].GetPosition();
+            const Vec3 p1 = verts[indexes[tri * 3 + 1]].GetPosition();
+            const Vec3 p2 = verts[indexes[tri * 3 + 2]].GetPosition();
+
+            // Area weighted normal
+            Vec3 n = (p1 - p0).Cross(p2 - p0);
+            float area = n.Length();
+
+            clusterCentroid += (p0 + p1 + p2) * (area / 3.0f);
+            clusterNormal += n;
+            clusterArea += area;
+        }
+
+        if (clusterArea > 0.0f) {
+            clusterCentroid /= clusterArea;
+        }
+        clusterNormal.Normalize();
+
+        clusterSorts[clusterIndex].clusterIndex = clusterIndex;
+        clusterSorts[clusterIndex].sortValue = (clusterCentroid - meshCentroid).Dot(clusterNormal);
+    }
+
+    // Draw the clusters which are likely to occlude others first
+    std::stable_sort(clusterSorts.Ptr(), clusterSorts.Ptr() + numClusters, [](const ClusterSort &a, const ClusterSort &b) {
+        return a.sortValue > b.sortValue;
+    });
+
+    int numOutIndexes = 0;
+    for (int i = 0; i < numClusters; i++) {
+        int clusterIndex = clusterSorts[i].clusterIndex;
+        int firstIndex = clusters[clusterIndex] * 3;
+        int count = (clusters[clusterIndex + 1] - clusters[clusterIndex]) * 3;
+
+        memcpy(&outIndexes[numOutIndexes], &indexes[firstIndex], count * sizeof(indexes[0]));
+        numOutIndexes += count;
+    }
+
+    assert(numOutIndexes == numIndexes);
+}
+
+float SubMesh::ComputeACMR(int cacheSize) const {
+    if (numIndexes < 3) {
+        return 0.0f;
+    }
+
+    int numMisses = SimulateFifoCache(indexes, numIndexes, numVerts, cacheSize, nullptr);
+    return (float)numMisses / (numIndexes / 3);
+}
+
+void SubMesh::OptimizeIndexedTriangles(bool optimizeOverdraw) {
+    if (refSubMesh || numIndexes < 3) {
+        return;
+    }
+
+    // Should be called before computing the data that refers to the vertex indexes
+    if (numMirroredVerts > 0 || dominantTris || edgesCalculated || jointWeights) {
+        BE_WARNLOG(L"SubMesh::OptimizeIndexedTriangles: called after vertex dependent data are computed\n");
+        return;
+    }
+
+    const float oldACMR = ComputeACMR(FIFO_CACHE_SIZE);
+
+    // Reorder triangles for vertex cache
+    TriIndex *optimizedIndexes = (TriIndex *)Mem_Alloc16(numIndexes * sizeof(indexes[0]));
+
+    OptimizeVertexCache(indexes, numIndexes, numVerts, optimizedIndexes);
+
+    Swap(indexes, optimizedIndexes);
+
+    const float cacheACMR = ComputeACMR(FIFO_CACHE_SIZE);
+
+    // Reorder triangle clusters for overdraw
+    if (optimizeOverdraw) {
+        OptimizeOverdraw(indexes, numIndexes, verts, numVerts, optimizedIndexes);
+
+        int numMisses = SimulateFifoCache(optimizedIndexes, numIndexes, numVerts, FIFO_CACHE_SIZE, nullptr);
+        float overdrawACMR = (float)numMisses / (numIndexes / 3);
+
+        if (overdrawACMR <= cacheACMR * OVERDRAW_ACMR_THRESHOLD) {
+            Swap(indexes, optimizedIndexes);
+        }
+    }
+
+    Mem_AlignedFree(optimizedIndexes);
+
+    // Reorder vertices in the order of first use for vertex fetch locality
+    int *vertexRemap = (int *)Mem_Alloc(numVerts * sizeof(int));
+    for (int i = 0; i < numVerts; i++) {
+        vertexRemap[i] = -1;
+    }
+
+    int numRemappedVerts = 0;
+    for (int i = 0; i < numIndexes; i++) {
+        TriIndex index = indexes[i];
+        if (vertexRemap[index] < 0) {
+            vertexRemap[index] = numRemappedVerts++;
+        }
+        indexes[i] = vertexRemap[index];
+    }
+
+    // Unreferenced vertices go to the end
+    for (int i = 0; i < numVerts; i++) {
+        if (vertexRemap[i] < 0) {
+            vertexRemap[i] = numRemappedVerts++;
+        }
+    }
+
+    VertexGenericLit *remappedVerts = (VertexGenericLit *)Mem_Alloc16(numVerts * sizeof(verts[0]));
+    for (int i = 0; i < numVerts; i++) {
+        remappedVerts[vertexRemap[i]] = verts[i];
+    }
+    Mem_AlignedFree(verts);
+    verts = remappedVerts;
+
+    if (vertWeights) {
+        int vertexWeightSize = VertexWeightSize();
+        byte *remappedVertWeights = (byte *)Mem_Alloc16(numVerts * vertexWeightSize);
+        for (int i = 0; i < numVerts; i++) {
+            memcpy(remappedVertWeights + vertexRemap[i] * vertexWeightSize, (const byte *)vertWeights + i * vertexWeightSize, vertexWeightSize);
+        }
+        Mem_AlignedFree(vertWeights);
+        vertWeights = remappedVertWeights;
+    }
+
+    Mem_Free(vertexRemap);
+
+    BE_DLOG(L"SubMesh::OptimizeIndexedTriangles: %i tris, ACMR %.3f -> %.3f\n", numIndexes / 3, oldACMR, ComputeACMR(FIFO_CACHE_SIZE));
+}
+
+BE_NAMESPACE_END
@@ -15,6 +15,9 @@
 #include "Precompiled.h"
 #include "Render/Render.h"
 #include "RenderInternal.h"
+#include "Core/Profiler.h"
+#include "Render/TextureCache.h"
+#include "File/FileMapping.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -28,6 +31,8 @@ int Texture::MemRequired(bool includingMipmaps) const {
 }
 
 void Texture::Create(RHI::TextureType type, const Image &srcImage, int flags) {
+    renderSystem.SyncRenderThread();
+
     Purge();
 
     this->type = type;
@@ -44,6 +49,8 @@ void Texture::Create(RHI::TextureType type, const Image &srcImage, int flags) {
 }
 
 void Texture::CreateEmpty(RHI::TextureType type, int width, int height, int depth, int numSlices, int numMipmaps, Image::Format format, int flags) {
+    renderSystem.SyncRenderThread();
+
     Purge();
 
     this->type = type;
@@ -56,6 +63,8 @@ void Texture::CreateEmpty(RHI::TextureType type, int width, int height, int dept
 }
 
 void Texture::CreateFromBuffer(Image::Format format, RHI::Handle bufferHandle) {
+    renderSystem.SyncRenderThread();
+
     Purge();
 
     this->type = RHI::TextureBuffer;
@@ -492,10 +501,39 @@ static RHI::AddressMode TextureFlagsToAddressMode(int flags) {
     }
 }
 
+void Texture::GetUploadFormatAndSize(RHI::TextureType type, int flags, Image::Format srcFormat, int srcWidth, int srcHeight, int srcDepth,
+    Image::Format &dstFormat, int &dstWidth, int &dstHeight, int &dstDepth) {
+    if (type == RHI::TextureRectangle) {
+        flags |= (NoMipmaps | Clamp | NoScaleDown);
+    }
+
+    bool useNormalMap   = (flags & NormalMap) ? true : false;
+    bool useCompression = !(flags & NoCompression) ? TextureManager::texture_useCompression.GetBool() : false;
+    bool useNPOT        = (flags & NonPowerOfTwo) ? true : false;
+
+    rhi.AdjustTextureFormat(type, useCompression, useNormalMap, srcFormat, &dstFormat);
+
+    // Cooked image is already scaled
+    if (flags & Cooked) {
+        dstWidth = srcWidth;
+        dstHeight = srcHeight;
+        dstDepth = srcDepth;
+        return;
+    }
+
+    rhi.AdjustTextureSize(type, useNPOT, srcWidth, srcHeight, srcDepth, &dstWidth, &dstHeight, &dstDepth);
+
+    // Apply scale down mip level
+    int mipLevel = !(flags & NoScaleDown) ? TextureManager::texture_mipLevel.GetInteger() : 0;
+    if (mipLevel > 0) {
+        dstWidth = Max(dstWidth >> mipLevel, 1);
+        dstHeight = Max(dstHeight >> mipLevel, 1);
+        dstDepth = Max(dstDepth >> mipLevel, 1);
+    }
+}
+
 void Texture::Upload(const Image *srcImage) {
-    Image::Format srcFormat = srcImage->GetFormat();
-    Image::Format forceFormat = Image::Format::UnknownFormat;
-    Image tmpImage;
+    renderSystem.SyncRenderThread();
 
     if (type == RHI::TextureRectangle) {
         flags |= (NoMipmaps | Clamp | NoScaleDown);
@@ -503,35 +541,21 @@ void Texture::Upload(const Image *srcImage) {
 
     if (srcImage->IsEmpty()) {
         flags |= (NoScaleDown | NoCompression);
-        forceFormat = srcImage->GetFormat();
     }
 
-    bool useNormalMap   = (flags & NormalMap) ? true : false;
-    bool useCompression = !(flags & NoCompression) ? TextureManager::texture_useCompression.GetBool() : false;
-    bool useNPOT        = (flags & NonPowerOfTwo) ? true : false;
     bool useSRGB        = ((flags & SRGB) && TextureManager::texture_sRGB.GetBool()) ? true : false;
 
-    Image::Format dstFormat;
-    if (forceFormat != Image::Format::UnknownFormat) {
-        dstFormat = forceFormat;
-    } else {
-        rhi.AdjustTextureFormat(type, useCompression, useNormalMap, srcImage->GetFormat(), &dstFormat);
-    }
-    
     this->srcWidth      = srcImage->GetWidth();
     this->srcHeight     = srcImage->GetHeight();
     this->srcDepth      = srcImage->GetDepth();
     this->numSlices     = srcImage->NumSlices();
-    
+
+    Image::Format dstFormat;
     int dstWidth, dstHeight, dstDepth;
-    rhi.AdjustTextureSize(type, useNPOT, srcWidth, srcHeight, srcDepth, &dstWidth, &dstHeight, &dstDepth);
+    GetUploadFormatAndSize(type, flags, srcImage->GetFormat(), srcWidth, srcHeight, srcDepth, dstFormat, dstWidth, dstHeight, dstDepth);
 
-    // Apply scale down mip level
-    int mipLevel = !(flags & NoScaleDown) ? TextureManager::texture_mipLevel.GetInteger() : 0;
-    if (mipLevel > 0) {
-        dstWidth = Max(dstWidth >> mipLevel, 1);
-        dstHeight = Max(dstHeight >> mipLevel, 1);
-        dstDepth = Max(dstDepth >> mipLevel, 1);
+    if (srcImage->IsEmpty()) {
+        dstFormat = srcImage->GetFormat();
     }
     
     // Can't upload texels for depth texture
@@ -584,18 +608,26 @@ void Texture::Upload(const Image *srcImage) {
 }
 
 void Texture::Update2D(int xoffset, int yoffset, int width, int height, Image::Format format, const byte *data) {
+    renderSystem.SyncRenderThread();
+
     rhi.SetTextureSubImage2D(0, xoffset, yoffset, width, height, format, data);	
 }
 
 void Texture::Update3D(int xoffset, int yoffset, int zoffset, int width, int height, int depth, Image::Format format, const byte *data) {
+    renderSystem.SyncRenderThread();
+
     rhi.SetTextureSubImage3D(0, xoffset, yoffset, zoffset, width, height, depth, format, data);
 }
 
 void Texture::UpdateCubemap(int face, int xoffset, int yoffset, int width, int height, Image::Format format, const byte *data) {
+    renderSystem.SyncRenderThread();
+
     rhi.SetTextureSubImageCube((RHI::CubeMapFace)face, 0, xoffset, yoffset, width, height, format, data);
 }
 
 void Texture::UpdateRect(int xoffset, int yoffset, int width, int height, Image::Format format, const byte *data) {
+    renderSystem.SyncRenderThread();
+
     rhi.SetTextureSubImageRect(xoffset, yoffset, width, height, format, data);
 }
 
@@ -616,6 +648,8 @@ void Texture::GetTexelsRect(Image::Format format, void *pixels) const {
 }
 
 void Texture::Purge() {
+    renderSystem.SyncRenderThread();
+
     if (textureHandle != RHI::NullTexture) {
         rhi.DeleteTexture(textureHandle);
     }
@@ -623,33 +657,41 @@ void Texture::Purge() {
     textureHandle = RHI::NullTexture;
 }
 
-bool Texture::Load(const char *filename, int flags) {
-    flags |= LoadedFromFile;
-
+int Texture::GetSourceFilenames(const char *filename, int flags, Str filenames[6]) {
     if (flags & (CubeMap | CameraCubeMap)) {
         Str name = filename;
         name.StripFileExtension();
-        Image images[6];
 
         for (int i = 0; i < 6; i++) {
-            Str filename2 = name + "_" + ((flags & CameraCubeMap) ? camera_cubemap_postfix[i] : cubemap_postfix[i]);
-            BE_LOG(L"Loading texture '%hs'...\n", filename2.c_str());
+            filenames[i] = name + "_" + ((flags & CameraCubeMap) ? camera_cubemap_postfix[i] : cubemap_postfix[i]);
+        }
+        return 6;
+    }
+
+    filenames[0] = filename;
+    return 1;
+}
+
+bool Texture::LoadTextureImage(const char *filename, int flags, Image &image, RHI::TextureType &textureType) {
+    BE_PROFILE_CPU_SCOPE("Texture::LoadTextureImage");
+
+    if (flags & (CubeMap | CameraCubeMap)) {
+        Str filenames[6];
+        GetSourceFilenames(filename, flags, filenames);
+        Image images[6];
 
-            images[i].Load(filename2.c_str());
+        for (int i = 0; i < 6; i++) {
+            images[i].Load(filenames[i].c_str());
             
             if (images[i].IsEmpty()) {
-                BE_WARNLOG(L"Couldn't load texture \"%hs\"\n", filename2.c_str());
+                BE_WARNLOG(L"Couldn't load texture \"%hs\"\n", filenames[i].c_str());
                 return false;
             }
         }
 
-        Image cubeImage;
-        cubeImage.CreateCubeFrom6Faces(images);
-        Create(RHI::TextureCubeMap, cubeImage, flags);
+        image.CreateCubeFrom6Faces(images);
+        textureType = RHI::TextureCubeMap;
     } else {
-        BE_LOG(L"Loading texture '%hs'...\n", filename);
-
-        Image image;
         image.Load(filename);
         
         if (image.IsEmpty()) {
@@ -657,8 +699,6 @@ bool Texture::Load(const char *filename, int flags) {
             return false;
         }
 
-        RHI::TextureType textureType;
-
         if (image.GetDepth() > 1) {
             textureType = RHI::Texture3D;
         } else if (image.IsCubeMap()) {
@@ -666,13 +706,131 @@ bool Texture::Load(const char *filename, int flags) {
         } else {
             textureType = RHI::Texture2D;
         }
+    }
 
-        Create(textureType, image, flags);
+    return true;
+}
+
+bool Texture::CookImage(RHI::TextureType type, const Image &srcImage, int flags, Image &cookedImage) {
+    BE_PROFILE_CPU_SCOPE("Texture::CookImage");
+
+    if (type == RHI::TextureRectangle) {
+        flags |= (NoMipmaps | Clamp | NoScaleDown);
+    }
+
+    if (srcImage.IsEmpty() || Image::IsDepthFormat(srcImage.GetFormat()) || Image::IsDepthStencilFormat(srcImage.GetFormat())) {
+        return false;
+    }
+
+    Image::Format dstFormat;
+    int dstWidth, dstHeight, dstDepth;
+    GetUploadFormatAndSize(type, flags & ~Cooked, srcImage.GetFormat(), srcImage.GetWidth(), srcImage.GetHeight(), srcImage.GetDepth(), dstFormat, dstWidth, dstHeight, dstDepth);
+
+    const Image *image = &srcImage;
+    Image scaledImage;
+
+    if (image->GetWidth() != dstWidth || image->GetHeight() != dstHeight) {
+        image->Resize(dstWidth, dstHeight, Image::Bicubic, scaledImage);
+        image = &scaledImage;
+    }
+
+    // Build mipmaps in the source format
+    Image mipmappedImage;
+
+    if (!(flags & NoMipmaps) && image->NumMipmaps() == 1) {
+        if (image->IsCompressed()) {
+            if (!image->ConvertFormat(Image::RGBA_8_8_8_8, mipmappedImage, true)) {
+                return false;
+            }
+        } else {
+            mipmappedImage.Create(image->GetWidth(), image->GetHeight(), image->GetDepth(), image->NumSlices(), 
+                Image::MaxMipMapLevels(image->GetWidth(), image->GetHeight(), image->GetDepth()), image->GetFormat(), nullptr, image->GetFlags());
+            mipmappedImage.CopyFrom(*image, 0, 1);
+            mipmappedImage.GenerateMipmaps();
+        }
+        image = &mipmappedImage;
+    }
+
+    if (!Image::IsCompressed(dstFormat)) {
+        // Uncompressed formats are converted by the driver at upload time
+        if (image->IsCompressed()) {
+            return false;
+        }
+        cookedImage = *image;
+        return true;
+    }
+
+    if (image->GetFormat() == dstFormat) {
+        cookedImage = *image;
+        return true;
     }
 
+    if (dstFormat == Image::XGBR_DXT5) {
+        // Encode red channel in alpha for the better quality of normal map
+        Image rgbaImage;
+        if (!image->ConvertFormat(Image::RGBA_8_8_8_8, rgbaImage)) {
+            return false;
+        }
+        rgbaImage.SwapRedAlphaRGBA8888();
+
+        Image dxt5Image;
+        if (!rgbaImage.ConvertFormat(Image::RGBA_DXT5, dxt5Image)) {
+            return false;
+        }
+
+        cookedImage.Create(dxt5Image.GetWidth(), dxt5Image.GetHeight(), dxt5Image.GetDepth(), dxt5Image.NumSlices(), dxt5Image.NumMipmaps(), 
+            Image::XGBR_DXT5, dxt5Image.GetPixels(), dxt5Image.GetFlags());
+        return true;
+    }
+
+    return image->ConvertFormat(dstFormat, cookedImage);
+}
+
+bool Texture::LoadCookedTextureImage(const char *filename, int &flags, Image &image, RHI::TextureType &textureType, FileMapping &fileMapping) {
+    if (!textureCache.IsEnabled()) {
+        return LoadTextureImage(filename, flags, image, textureType);
+    }
+
+    if (textureCache.Load(filename, flags, image, textureType, fileMapping)) {
+        flags |= Cooked;
+        return true;
+    }
+
+    Image srcImage;
+    if (!LoadTextureImage(filename, flags, srcImage, textureType)) {
+        return false;
+    }
+
+    if (!CookImage(textureType, srcImage, flags, image)) {
+        image = std::move(srcImage);
+        return true;
+    }
+
+    textureCache.Write(filename, flags, textureType, srcImage, image);
+
+    flags |= Cooked;
     return true;
 }
 
+bool Texture::Load(const char *filename, int flags) {
+    flags |= LoadedFromFile;
+
+    BE_LOG(L"Loading texture '%hs'...\n", filename);
+
+    Image image;
+    RHI::TextureType textureType;
+    FileMapping fileMapping;
+
+    bool loaded = LoadCookedTextureImage(filename, flags, image, textureType, fileMapping);
+    if (loaded) {
+        Create(textureType, image, flags);
+    }
+
+    fileMapping.Close();
+
+    return loaded;
+}
+
 bool Texture::Reload() {
     if (!(flags & LoadedFromFile)) {
         return false;
@@ -0,0 +1,252 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Precompiled.h"
+#include "Render/Render.h"
+#include "Render/TextureCache.h"
+#include "RenderInternal.h"
+#include "Core/Checksum_CRC32.h"
+#include "Core/Profiler.h"
+#include "File/FileSystem.h"
+#include "File/FileMapping.h"
+#include "Platform/PlatformFile.h"
+
+BE_NAMESPACE_BEGIN
+
+#define BTEX_IDENT          MAKE_FOURCC('B', 'E', 'T', '1')
+#define BTEX_VERSION        2
+
+#define BTEX_DATA_ALIGN     16      // alignment of the pixel data in the file
+
+#pragma pack(1)
+
+struct BTexHeader {
+    int32_t         ident;
+    int32_t         version;
+    uint32_t        sourceStamp;    // CRC32 of the size and modification time of the source files
+    uint32_t        settingsHash;   // CRC32 of the flags and texture settings used to cook
+    int32_t         textureType;
+    int32_t         srcFormat;
+    int32_t         srcWidth;
+    int32_t         srcHeight;
+    int32_t         srcDepth;
+    int32_t         format;
+    int32_t         width;
+    int32_t         height;
+    int32_t         depth;
+    int32_t         numSlices;
+    int32_t         numMipmaps;
+    int32_t         imageFlags;
+    uint32_t        dataOffset;
+    uint32_t        dataSize;
+};
+
+#pragma pack()
+
+// Texture flags that change the cooked image
+static const int cookFlagsMask = Texture::NoMipmaps | Texture::NoScaleDown | Texture::NoCompression | Texture::NonPowerOfTwo |
+    Texture::NormalMap | Texture::CubeMap | Texture::CameraCubeMap;
+
+TextureCache                textureCache;
+
+void TextureCache::Init() {
+    cacheDir = "Cache/TextureCache";
+
+    if (!PlatformFile::DirectoryExists(cacheDir)) {
+        PlatformFile::CreateDirectoryTree(cacheDir);
+    }
+
+    numHits.SetValue(0);
+    numMisses.SetValue(0);
+}
+
+void TextureCache::Shutdown() {
+    cacheDir.Clear();
+}
+
+bool TextureCache::IsEnabled() const {
+    return !cacheDir.IsEmpty() && TextureManager::texture_cache.GetBool();
+}
+
+Str TextureCache::CacheFilename(const char *filename, int flags) const {
+    Str name = filename;
+    name.ToLower();
+    name.BackSlashesToSlashes();
+
+    char hashName[32];
+    Str::snPrintf(hashName, sizeof(hashName), "%08x_%04x.btex", CRC32_BlockChecksum(name.c_str(), name.Length()), flags & cookFlagsMask);
+
+    Str cacheFilename = cacheDir;
+    cacheFilename.AppendPath(hashName);
+    return cacheFilename;
+}
+
+// Returns 0 if any of the source files doesn't exist
+uint32_t TextureCache::SourceStamp(const char *filename, int flags) {
+    Str filenames[6];
+    int numFiles = Texture::GetSourceFilenames(filename, flags, filenames);
+
+    uint32_t hash;
+    CRC32_InitChecksum(hash);
+
+    for (int i = 0; i < numFiles; i++) {
+        if (!fileSystem.FileExists(filenames[i])) {
+            return 0;
+        }
+
+        // Source files are not read, the size and modification time are enough to detect the changes
+        int64_t stamp[2];
+        stamp[0] = (int64_t)fileSystem.FileSize(filenames[i]);
+        stamp[1] = fileSystem.GetTimeStamp(filenames[i]).Ticks();
+
+        CRC32_UpdateChecksum(hash, stamp, sizeof(stamp));
+    }
+
+    CRC32_FinishChecksum(hash);
+    return hash ? hash : 1;
+}
+
+uint32_t TextureCache::SettingsHash(int flags) {
+    int32_t settings[5];
+    settings[0] = BTEX_VERSION;
+    settings[1] = flags & cookFlagsMask;
+    settings[2] = TextureManager::texture_useCompression.GetBool() ? 1 : 0;
+    settings[3] = TextureManager::texture_useNormalCompression.GetBool() ? 1 : 0;
+    settings[4] = TextureManager::texture_mipLevel.GetInteger();
+
+    return CRC32_BlockChecksum(settings, sizeof(settings));
+}
+
+bool TextureCache::Load(const char *filename, int flags, Image &image, RHI::TextureType &textureType, FileMapping &fileMapping) {
+    BE_PROFILE_CPU_SCOPE("TextureCache::Load");
+
+    const Str cacheFilename = CacheFilename(filename, flags);
+
+    if (!fileSystem.MapFile(cacheFilename, false, fileMapping)) {
+        numMisses++;
+        return false;
+    }
+
+    const BTexHeader *header = (const BTexHeader *)fileMapping.GetData();
+    bool valid = false;
+
+    if (fileMapping.GetSize() >= sizeof(BTexHeader) && header->ident == BTEX_IDENT && header->version == BTEX_VERSION &&
+        header->settingsHash == SettingsHash(flags) && (size_t)header->dataOffset + header->dataSize <= fileMapping.GetSize() &&
+        header->dataSize == (uint32_t)Image::MemRequired(header->width, header->height, header->depth, header->numMipmaps, (Image::Format)header->format) * header->numSlices) {
+        RHI::TextureType type = (RHI::TextureType)header->textureType;
+
+        // Check the cooked image against the format and size to upload the source image with the current device
+        Image::Format dstFormat, cookedDstFormat;
+        int dstWidth, dstHeight, dstDepth;
+        int cookedWidth, cookedHeight, cookedDepth;
+        Texture::GetUploadFormatAndSize(type, flags & ~Texture::Cooked, (Image::Format)header->srcFormat, header->srcWidth, header->srcHeight, header->srcDepth,
+            dstFormat, dstWidth, dstHeight, dstDepth);
+        Texture::GetUploadFormatAndSize(type, flags | Texture::Cooked, (Image::Format)header->format, header->width, header->height, header->depth,
+            cookedDstFormat, cookedWidth, cookedHeight, cookedDepth);
+
+        if (dstFormat == cookedDstFormat && dstWidth == header->width && dstHeight == header->height && dstDepth == header->depth) {
+            // Cooked cache is used as it is when the source files are not shipped
+            const uint32_t sourceStamp = SourceStamp(filename, flags);
+            valid = sourceStamp == 0 || header->sourceStamp == sourceStamp;
+        }
+    }
+
+    if (!valid) {
+        fileMapping.Close();
+        numMisses++;
+        return false;
+    }
+
+    textureType = (RHI::TextureType)header->textureType;
+
+    image.InitFromMemory(header->width, header->height, header->depth, header->numSlices, header->numMipmaps, (Image::Format)header->format,
+        (byte *)fileMapping.GetData() + header->dataOffset, header->imageFlags);
+
+    numHits++;
+    return true;
+}
+
+bool TextureCache::Write(const char *filename, int flags, RHI::TextureType textureType, const Image &srcImage, const Image &cookedImage) {
+    BE_PROFILE_CPU_SCOPE("TextureCache::Write");
+
+    BTexHeader header;
+    memset(&header, 0, sizeof(header));
+    header.ident = BTEX_IDENT;
+    header.version = BTEX_VERSION;
+    header.sourceStamp = SourceStamp(filename, flags);
+    header.settingsHash = SettingsHash(flags);
+    header.textureType = textureType;
+    header.srcFormat = srcImage.GetFormat();
+    header.srcWidth = srcImage.GetWidth();
+    header.srcHeight = srcImage.GetHeight();
+    header.srcDepth = srcImage.GetDepth();
+    header.format = cookedImage.GetFormat();
+    header.width = cookedImage.GetWidth();
+    header.height = cookedImage.GetHeight();
+    header.depth = cookedImage.GetDepth();
+    header.numSlices = cookedImage.NumSlices();
+    header.numMipmaps = cookedImage.NumMipmaps();
+    header.imageFlags = cookedImage.GetFlags();
+    header.dataOffset = (sizeof(BTexHeader) + BTEX_DATA_ALIGN - 1) & ~(BTEX_DATA_ALIGN - 1);
+    header.dataSize = cookedImage.GetSize(0, cookedImage.NumMipmaps());
+
+    const Str cacheFilename = CacheFilename(filename, flags);
+
+    // Written to the unique temporary file first and renamed to the cache file, so that
+    // the concurrent writes of the same texture never interleave in the cache file.
+    static PlatformAtomic tempFileCount;
+    char tempExtension[32];
+    Str::snPrintf(tempExtension, sizeof(tempExtension), ".%i.tmp", (int)tempFileCount++);
+
+    Str tempFilename = cacheFilename;
+    tempFilename += tempExtension;
+
+    PlatformFile *file = PlatformFile::OpenFileWrite(tempFilename);
+    if (!file) {
+        BE_WARNLOG(L"TextureCache::Write: failed to open %hs\n", tempFilename.c_str());
+        return false;
+    }
+
+    static const byte padding[BTEX_DATA_ALIGN] = { 0, };
+
+    file->Write(&header, sizeof(header));
+    file->Write(padding, header.dataOffset - sizeof(header));
+    file->Write(cookedImage.GetPixels(), header.dataSize);
+
+    delete file;
+
+    if (!PlatformFile::MoveFile(tempFilename, cacheFilename)) {
+        BE_WARNLOG(L"TextureCache::Write: failed to rename %hs\n", tempFilename.c_str());
+        PlatformFile::RemoveFile(tempFilename);
+        return false;
+    }
+
+    return true;
+}
+
+void TextureCache::Clear() {
+    if (cacheDir.IsEmpty()) {
+        return;
+    }
+
+    if (PlatformFile::DirectoryExists(cacheDir)) {
+        PlatformFile::RemoveDirectoryTree(cacheDir);
+    }
+    PlatformFile::CreateDirectoryTree(cacheDir);
+
+    numHits.SetValue(0);
+    numMisses.SetValue(0);
+}
+
+BE_NAMESPACE_END
@@ -17,6 +17,10 @@
 #include "RenderInternal.h"
 #include "Core/Cmds.h"
 #include "File/FileSystem.h"
+#include "Core/AsyncLoader.h"
+#include "File/FileMapping.h"
+#include "Platform/PlatformTime.h"
+#include "Render/TextureCache.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -41,6 +45,7 @@ CVar TextureManager::texture_sRGB(L"texture_sRGB", L"1", CVar::Archive | CVar::B
 CVar TextureManager::texture_useCompression(L"texture_useCompression", L"1", CVar::Archive | CVar::Bool, L"");
 CVar TextureManager::texture_useNormalCompression(L"texture_useNormalCompression", L"1", CVar::Bool | CVar::Archive, L"normal map compression");
 CVar TextureManager::texture_mipLevel(L"texture_mipLevel", L"0", CVar::Archive | CVar::Integer, L"");
+CVar TextureManager::texture_cache(L"texture_cache", L"1", CVar::Archive | CVar::Bool, L"load textures through the cooked texture cache");
 
 void TextureManager::Init() {
     byte *  data;
@@ -49,6 +54,10 @@ void TextureManager::Init() {
     cmdSystem.AddCommand(L"listTextures", Cmd_ListTextures);
     cmdSystem.AddCommand(L"reloadTexture", Cmd_ReloadTexture);
     cmdSystem.AddCommand(L"convertNormalAR2RGB", Cmd_ConvertNormalAR2RGB);
+    cmdSystem.AddCommand(L"cookTextures", Cmd_CookTextures);
+    cmdSystem.AddCommand(L"clearTextureCache", Cmd_ClearTextureCache);
+
+    textureCache.Init();
 
     textureHashMap.Init(1024, 1024, 1024);
 
@@ -137,8 +146,12 @@ void TextureManager::Shutdown() {
     cmdSystem.RemoveCommand(L"listTextures");
     cmdSystem.RemoveCommand(L"reloadTexture");
     cmdSystem.RemoveCommand(L"convertNormalAR2RGB");
+    cmdSystem.RemoveCommand(L"cookTextures");
+    cmdSystem.RemoveCommand(L"clearTextureCache");
 
     textureHashMap.DeleteContents(true);
+
+    textureCache.Shutdown();
 }
 
 void TextureManager::DestroyUnusedTextures() {
@@ -267,6 +280,76 @@ Texture *TextureManager::GetTexture(const char *hashName, int creationFlags) {
     return texture;
 }
 
+// Loads image on the loader thread, and creates the texture with it on the main thread.
+class TextureLoadRequest : public AsyncLoadRequest {
+public:
+    TextureLoadRequest(Texture *texture, int flags) : texture(texture), filename(texture->GetHashName()), flags(flags) {
+        texture->AddRefCount();
+    }
+    virtual ~TextureLoadRequest() {
+        fileMapping.Close();
+        textureManager.ReleaseTexture(texture);
+    }
+
+    virtual void Load() override {
+        loaded = Texture::LoadCookedTextureImage(filename, flags, image, textureType, fileMapping);
+    }
+
+    virtual void Finalize() override {
+        if (loaded) {
+            texture->Create(textureType, image, flags | Texture::LoadedFromFile);
+        }
+    }
+
+private:
+    Texture *               texture;
+    Str                     filename;
+    int                     flags;
+    Image                   image;
+    RHI::TextureType        textureType;
+    FileMapping             fileMapping;            ///< Cooked image points to the mapped cache file until finalized
+    bool                    loaded = false;
+};
+
+Texture *TextureManager::GetTextureAsync(const char *hashName, int priority, int creationFlags) {
+    if (!asyncLoader.IsEnabled()) {
+        return GetTexture(hashName, creationFlags);
+    }
+
+    if (!hashName || !hashName[0]) {
+        return defaultTexture;
+    }
+
+    Texture *texture = FindTexture(hashName);
+    if (texture) {
+        texture->refCount++;
+        return texture;
+    }
+
+    if (creationFlags == 0) {
+        const Str textureInfoPath = Str(hashName) + ".texinfo";
+        creationFlags = LoadTextureInfo(textureInfoPath);
+    }
+
+    texture = AllocTexture(hashName);
+
+    // Small placeholder of the same kind until the image is loaded
+    if (creationFlags & (Texture::CubeMap | Texture::CameraCubeMap)) {
+        texture->CreateBlackCubeMapTexture(1);
+    } else if (creationFlags & Texture::NormalMap) {
+        texture->CreateFlatNormalTexture(1);
+    } else {
+        Image image;
+        image.Create2D(1, 1, 1, Image::L_8, nullptr, 0);
+        image.GetPixels()[0] = 0x80;
+        texture->Create(RHI::Texture2D, image, Texture::NoMipmaps | Texture::HighQuality);
+    }
+
+    asyncLoader.AddRequest(new TextureLoadRequest(texture, creationFlags), priority);
+
+    return texture;
+}
+
 int TextureManager::LoadTextureInfo(const char *filename) const {
     int flags = 0;
 
@@ -513,4 +596,69 @@ void TextureManager::Cmd_ConvertNormalAR2RGB(const CmdArgs &args) {
     BE_LOG(L"all done\n");
 }
 
+void TextureManager::Cmd_CookTextures(const CmdArgs &args) {
+    char path[MaxAbsolutePath];
+
+    if (args.Argc() != 3) {
+        BE_LOG(L"cookTextures <rootdir> <filter>\n");
+        return;
+    }
+
+    if (!textureCache.IsEnabled()) {
+        BE_WARNLOG(L"texture cache is disabled\n");
+        return;
+    }
+
+    FileArray fileArray;
+    int numFiles = fileSystem.ListFiles(WStr::ToStr(args.Argv(1)), WStr::ToStr(args.Argv(2)), fileArray);
+    if (!numFiles) {
+        BE_WARNLOG(L"no files found\n");
+        return;
+    }
+
+    int numCooked = 0;
+    int numUpToDate = 0;
+    int numFailed = 0;
+
+    uint64_t startTime = PlatformTime::Microseconds();
+
+    for (int i = 0; i < numFiles; i++) {
+        Str::snPrintf(path, sizeof(path), "%ls/%hs", args.Argv(1), fileArray.GetFilename(i));
+
+        const Str textureInfoPath = Str(path) + ".texinfo";
+        int flags = textureManager.LoadTextureInfo(textureInfoPath) | Texture::LoadedFromFile;
+
+        int numHits = textureCache.NumHits();
+
+        Image image;
+        RHI::TextureType textureType;
+        FileMapping fileMapping;
+
+        if (!Texture::LoadCookedTextureImage(path, flags, image, textureType, fileMapping)) {
+            numFailed++;
+        } else if (textureCache.NumHits() != numHits) {
+            numUpToDate++;
+        } else if (flags & Texture::Cooked) {
+            BE_LOG(L"cooked '%hs' (%hs %ix%i)\n", path, image.FormatName(), image.GetWidth(), image.GetHeight());
+            numCooked++;
+        } else {
+            numFailed++;
+        }
+
+        fileMapping.Close();
+    }
+
+    uint64_t endTime = PlatformTime::Microseconds();
+
+    BE_LOG(L"%i cooked, %i up to date, %i failed in %.2f seconds\n", numCooked, numUpToDate, numFailed, (endTime - startTime) * 0.000001f);
+}
+
+void TextureManager::Cmd_ClearTextureCache(const CmdArgs &args) {
+    BE_LOG(L"texture cache: %i hits, %i misses\n", textureCache.NumHits(), textureCache.NumMisses());
+
+    textureCache.Clear();
+
+    BE_LOG(L"texture cache cleared\n");
+}
+
 BE_NAMESPACE_END
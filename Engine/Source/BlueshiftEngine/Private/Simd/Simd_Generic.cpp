@@ -245,6 +245,53 @@ void BE_FASTCALL SIMD_Generic::TransformVerts(VertexGenericLit *verts, const int
     }
 }
 
+// Linear blend skinning. numWeights is the number of weights per vertex (1, 4 or 8).
+// Normals and tangents are transformed with the blended joint matrix, bitangent sign is kept.
+void BE_FASTCALL SIMD_Generic::SkinVerts(VertexGenericLit *dstVerts, const VertexGenericLit *srcVerts, const int numVerts, const void *vertWeights, const int numWeights, const Mat3x4 *joints) {
+    const float weightScale = sizeof(JointWeightType) == sizeof(byte) ? 1.0f / 255.0f : 1.0f;
+    const byte *jointIndexes;
+    const JointWeightType *jointWeights;
+    Mat3x4 blendedMat;
+
+    for (int i = 0; i < numVerts; i++) {
+        if (numWeights == 1) {
+            blendedMat = joints[((const VertexWeight1 *)vertWeights)[i].jointIndex];
+        } else {
+            if (numWeights == 4) {
+                const VertexWeight4 *vw = &((const VertexWeight4 *)vertWeights)[i];
+                jointIndexes = vw->jointIndexes;
+                jointWeights = vw->jointWeights;
+            } else {
+                const VertexWeight8 *vw = &((const VertexWeight8 *)vertWeights)[i];
+                jointIndexes = vw->jointIndexes;
+                jointWeights = vw->jointWeights;
+            }
+
+            blendedMat = joints[jointIndexes[0]] * (jointWeights[0] * weightScale);
+            for (int j = 1; j < numWeights; j++) {
+                if (jointWeights[j] != 0) {
+                    blendedMat += joints[jointIndexes[j]] * (jointWeights[j] * weightScale);
+                }
+            }
+        }
+
+        // Build the vertex on the stack, destination may be write-combined memory
+        VertexGenericLit v = srcVerts[i];
+
+        v.xyz = blendedMat.Transform(srcVerts[i].xyz);
+
+        Vec3 normal = blendedMat.TransformNormal(srcVerts[i].GetNormal());
+        normal.Normalize();
+        v.SetNormal(normal);
+
+        Vec3 tangent = blendedMat.TransformNormal(srcVerts[i].GetTangent());
+        tangent.Normalize();
+        v.SetTangent(tangent);
+
+        dstVerts[i] = v;
+    }
+}
+
 void BE_FASTCALL SIMD_Generic::DeriveTriPlanes(Plane *planes, const VertexGenericLit *verts, const int numVerts, const int *indexes, const int numIndexes) {
     for (int i = 0; i < numIndexes; i += 3) {
         const VertexGenericLit *a, *b, *c;
@@ -14,6 +14,7 @@
 
 #include "Precompiled.h"
 #include "Math/Math.h"
+#include "Core/Vertex.h"
 #include "Core/JointPose.h"
 #include "Simd/Simd.h"
 #include "Simd/Simd_Generic.h"
@@ -442,6 +443,101 @@ void BE_FASTCALL SIMD_SSE4::MatrixMultiply(float *dst, const float *src0, const
     _mm_store_ps(dst + 12, a0);
 }
 
+static BE_INLINE __m128 LoadBytes4(const byte *src) {
+    int32_t packed;
+    memcpy(&packed, src, sizeof(packed));
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+}
+
+static BE_INLINE __m128 LoadJointWeights4(const JointWeightType *jointWeights) {
+    if (sizeof(JointWeightType) == sizeof(byte)) {
+        return _mm_mul_ps(LoadBytes4((const byte *)jointWeights), _mm_set1_ps(1.0f / 255.0f));
+    }
+    return _mm_loadu_ps((const float *)jointWeights);
+}
+
+static BE_INLINE void AddWeightedJointMat(const Mat3x4 &jointMat, const __m128 weight, __m128 &r0, __m128 &r1, __m128 &r2) {
+    const float *m = jointMat;
+    r0 = _mm_add_ps(r0, _mm_mul_ps(_mm_loadu_ps(m), weight));
+    r1 = _mm_add_ps(r1, _mm_mul_ps(_mm_loadu_ps(m + 4), weight));
+    r2 = _mm_add_ps(r2, _mm_mul_ps(_mm_loadu_ps(m + 8), weight));
+}
+
+static BE_INLINE void AddWeightedJointMats4(const Mat3x4 *joints, const byte *jointIndexes, const JointWeightType *jointWeights, __m128 &r0, __m128 &r1, __m128 &r2) {
+    const __m128 w = LoadJointWeights4(jointWeights);
+
+    AddWeightedJointMat(joints[jointIndexes[0]], _mm_shuffle_ps(w, w, _MM_SHUFFLE(0, 0, 0, 0)), r0, r1, r2);
+    AddWeightedJointMat(joints[jointIndexes[1]], _mm_shuffle_ps(w, w, _MM_SHUFFLE(1, 1, 1, 1)), r0, r1, r2);
+    AddWeightedJointMat(joints[jointIndexes[2]], _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 2, 2)), r0, r1, r2);
+    AddWeightedJointMat(joints[jointIndexes[3]], _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 3, 3)), r0, r1, r2);
+}
+
+// Rotates the byte compressed normal (or tangent) by the 3x3 part of the matrix, and compresses it again.
+// The 4th byte (bitangent sign of the tangent) is copied from the source.
+static BE_INLINE void TransformCompressedNormal(const __m128 r0, const __m128 r1, const __m128 r2, const byte *src, byte *dst) {
+    const __m128 n = _mm_sub_ps(_mm_mul_ps(LoadBytes4(src), _mm_set1_ps(2.0f / 255.0f)), _mm_set1_ps(1.0f));
+
+    const __m128 x = _mm_dp_ps(r0, n, 0x71);
+    const __m128 y = _mm_dp_ps(r1, n, 0x71);
+    const __m128 z = _mm_dp_ps(r2, n, 0x71);
+    __m128 t = _mm_movelh_ps(_mm_unpacklo_ps(x, y), z);
+
+    const __m128 lengthSqr = _mm_max_ps(_mm_dp_ps(t, t, 0x7F), _mm_set1_ps(1e-12f));
+    t = _mm_mul_ps(t, _mm_rsqrt_ps(lengthSqr));
+
+    // (t + 1) * 255 / 2 + 0.5
+    const __m128i ti = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(255.0f / 2.0f)), _mm_set1_ps(255.0f / 2.0f + 0.5f)));
+    const __m128i tb = _mm_packus_epi16(_mm_packs_epi32(ti, ti), _mm_setzero_si128());
+
+    dst[0] = (byte)_mm_extract_epi8(tb, 0);
+    dst[1] = (byte)_mm_extract_epi8(tb, 1);
+    dst[2] = (byte)_mm_extract_epi8(tb, 2);
+    dst[3] = src[3];
+}
+
+// Linear blend skinning. numWeights is the number of weights per vertex (1, 4 or 8).
+// Normals and tangents are transformed with the blended joint matrix instead of recomputing tangent frames.
+void BE_FASTCALL SIMD_SSE4::SkinVerts(VertexGenericLit *dstVerts, const VertexGenericLit *srcVerts, const int numVerts, const void *vertWeights, const int numWeights, const Mat3x4 *joints) {
+#ifndef COMPRESSED_VERTEX_NORMAL_TANGENTS
+    SIMD_Generic::SkinVerts(dstVerts, srcVerts, numVerts, vertWeights, numWeights, joints);
+#else
+    for (int i = 0; i < numVerts; i++) {
+        __m128 r0 = _mm_setzero_ps();
+        __m128 r1 = _mm_setzero_ps();
+        __m128 r2 = _mm_setzero_ps();
+
+        if (numWeights == 1) {
+            const float *m = joints[((const VertexWeight1 *)vertWeights)[i].jointIndex];
+            r0 = _mm_loadu_ps(m);
+            r1 = _mm_loadu_ps(m + 4);
+            r2 = _mm_loadu_ps(m + 8);
+        } else if (numWeights == 4) {
+            const VertexWeight4 *vw = &((const VertexWeight4 *)vertWeights)[i];
+            AddWeightedJointMats4(joints, vw->jointIndexes, vw->jointWeights, r0, r1, r2);
+        } else {
+            const VertexWeight8 *vw = &((const VertexWeight8 *)vertWeights)[i];
+            AddWeightedJointMats4(joints, vw->jointIndexes, vw->jointWeights, r0, r1, r2);
+            AddWeightedJointMats4(joints, vw->jointIndexes + 4, vw->jointWeights + 4, r0, r1, r2);
+        }
+
+        const VertexGenericLit &src = srcVerts[i];
+
+        // Build the vertex on the stack, destination may be write-combined memory
+        VertexGenericLit v = src;
+
+        const __m128 p = _mm_setr_ps(src.xyz.x, src.xyz.y, src.xyz.z, 1.0f);
+        _mm_store_ss(&v.xyz.x, _mm_dp_ps(r0, p, 0xF1));
+        _mm_store_ss(&v.xyz.y, _mm_dp_ps(r1, p, 0xF1));
+        _mm_store_ss(&v.xyz.z, _mm_dp_ps(r2, p, 0xF1));
+
+        TransformCompressedNormal(r0, r1, r2, src.normal, v.normal);
+        TransformCompressedNormal(r0, r1, r2, src.tangent, v.tangent);
+
+        dstVerts[i] = v;
+    }
+#endif
+}
+
 #if 0
 
 static void SSE_Memcpy64B(void *dst, const void *src, const int count) {
@@ -18,6 +18,7 @@
 #include "Core/Cmds.h"
 #include "Platform/PlatformTime.h"
 #include "Sound/SoundSystem.h"
+#include "Core/Profiler.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -237,13 +238,27 @@ void Sound::UpdatePosition(const Vec3 &origin) {
     this->origin = origin;
 }
 
+bool Sound::LoadPcm(const char *filename, Pcm &pcm) {
+    if (!pcm.Open(filename)) {
+        return false;
+    }
+
+    // Short sounds are decoded entirely for the static buffer
+    if (pcm.Duration() <= 6.0f) {
+        return pcm.Load(filename);
+    }
+    return true;
+}
+
 bool Sound::Load(const char *filename) {
+    BE_PROFILE_CPU_SCOPE("Sound::Load");
+
     Purge();
 
     BE_LOG(L"Loading sound '%hs'...\n", filename);
 
     Pcm pcm;
-    if (!pcm.Open(filename)) {
+    if (!LoadPcm(filename, pcm)) {
         return false;
     }
 
@@ -261,12 +276,23 @@ bool Sound::Reload() {
     Str _hashName = hashName;
     bool ret = Load(_hashName);
 
-    for (LinkList<Sound> *node = sound->dupNode.NextNode(); node; node = node->NextNode()) {
-        Sound *s = node->Owner();
-        s->DuplicateFrom(sound);
-    }
+    sound->UpdateDuplicatedSounds();
 
     return ret;
 }
 
+void Sound::UpdateDuplicatedSounds() {
+    // DuplicateFrom() unlinks the sound, so collect them first
+    Array<Sound *> duplicatedSounds;
+    for (LinkList<Sound> *node = dupNode.NextNode(); node; node = node->NextNode()) {
+        duplicatedSounds.Append(node->Owner());
+    }
+
+    for (int i = 0; i < duplicatedSounds.Count(); i++) {
+        Sound *s = duplicatedSounds[i];
+        s->DuplicateFrom(this);
+        s->dupNode.AddToEnd(dupNode);
+    }
+}
+
 BE_NAMESPACE_END
@@ -17,6 +17,7 @@
 #include "Core/CVars.h"
 #include "Core/Cmds.h"
 #include "Platform/PlatformTime.h"
+#include "Core/AsyncLoader.h"
 #include "Sound/SoundSystem.h"
 
 BE_NAMESPACE_BEGIN
@@ -255,6 +256,15 @@ Sound *SoundSystem::GetSound(const char *hashName) {
     }
 
     Sound *sound = FindSound(hashName);
+    if (!sound) {
+        // Finish prefetching right now
+        const auto *entry = soundLoadRequests.Get(hashName);
+        if (entry) {
+            asyncLoader.Complete(entry->second);
+            sound = FindSound(hashName);
+        }
+    }
+
     if (sound) {
         sound->refCount++;
         return sound;
@@ -270,6 +280,56 @@ Sound *SoundSystem::GetSound(const char *hashName) {
     return sound;
 }
 
+// Decodes PCM data on the loader thread, and registers the sound created with it to the sound system on the main thread.
+class SoundLoadRequest : public AsyncLoadRequest {
+public:
+    SoundLoadRequest(const char *hashName) : hashName(hashName) {
+        soundSystem.soundLoadRequests.Set(this->hashName, this);
+    }
+    virtual ~SoundLoadRequest() {
+        soundSystem.soundLoadRequests.Remove(hashName);
+    }
+
+    virtual void Load() override {
+        loaded = Sound::LoadPcm(hashName, pcm);
+    }
+
+    virtual void Finalize() override {
+        if (!loaded) {
+            BE_WARNLOG(L"Couldn't load sound '%hs'\n", hashName.c_str());
+            return;
+        }
+
+        if (!soundSystem.FindSound(hashName)) {
+            // Not referenced until GetSound() is called
+            Sound *sound = soundSystem.AllocSound(hashName);
+            sound->refCount = 0;
+            sound->Create(pcm);
+        }
+    }
+
+private:
+    Str                     hashName;
+    Pcm                     pcm;
+    bool                    loaded = false;
+};
+
+void SoundSystem::PrefetchSound(const char *hashName, int priority) {
+    if (!initialized || !asyncLoader.IsEnabled()) {
+        return;
+    }
+
+    if (!hashName || !hashName[0]) {
+        return;
+    }
+
+    if (FindSound(hashName) || soundLoadRequests.Get(hashName)) {
+        return;
+    }
+
+    asyncLoader.AddRequest(new SoundLoadRequest(hashName), priority);
+}
+
 // TODO: SoundSystem::Update 함수를 별도 쓰레드로 바꿀것
 void SoundSystem::Update() {
     static float lastTime = PlatformTime::Milliseconds();
@@ -47,6 +47,7 @@
 #include "Containers/HashMap.h"
 #include "Containers/Hierarchy.h"
 #include "Containers/BinSearch.h"
+#include "Containers/RadixSort.h"
 
 #include "Core/Timespan.h"
 #include "Core/DateTime.h"
@@ -77,6 +78,8 @@
 #include "Core/CVars.h"
 #include "Core/Cmds.h"
 #include "Core/Task.h"
+#include "Core/AsyncLoader.h"
+#include "Core/Profiler.h"
 #include "Core/Vertex.h"
 #include "Core/JointPose.h"
 
@@ -100,7 +103,11 @@
 #include "Sound/SoundSystem.h"
 
 // RHI
+#ifdef USE_NULL_RHI
+#include "RHI/RHINull.h"
+#else
 #include "RHI/RHIOpenGL.h"
+#endif
 
 // Platform
 #include "Platform/Platform.h"
@@ -174,6 +181,7 @@
 #include "Game/Prefab.h"
 #include "Game/MapRenderSettings.h"
 #include "Game/GameWorld.h"
+#include "Game/BinaryMap.h"
 
 #include "Main/Common.h"
 #include "Main/Console.h"
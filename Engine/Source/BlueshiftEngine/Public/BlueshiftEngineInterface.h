@@ -25,6 +25,8 @@ public:
         CmdArgs             args;
         Str                 baseDir;
         Str                 searchPath;
+        streamOutFunc_t     logFunc = nullptr;      // output of the log messages, platform log is used if not set
+        streamOutFunc_t     errorFunc = nullptr;    // called on the fatal error instead of the platform error if set
     };
 
     static void             Init(const InitParms *initParms);
@@ -38,6 +40,8 @@ public:
     static CmdArgs          args;
     static Str              baseDir;
     static Str              searchPath;
+    static streamOutFunc_t  logFunc;
+    static streamOutFunc_t  errorFunc;
 };
 
 BE_NAMESPACE_END
\ No newline at end of file
@@ -27,6 +27,8 @@ public:
 
     virtual void            Purge(bool chainPurge = true) override;
 
+    virtual bool            HasRuntimeState() const override { return true; }
+
     virtual void            Init() override;
 
     virtual void            Awake() override;
@@ -35,6 +35,8 @@ public:
 
     virtual void            Purge(bool chainPurge = true) override;
 
+    virtual bool            HasRuntimeState() const override { return true; }
+
     virtual void            Init() override;
 
     virtual void            Start() override;
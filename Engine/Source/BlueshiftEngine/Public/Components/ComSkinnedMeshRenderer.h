@@ -25,6 +25,8 @@ class AnimAsset;
 class Anim;
 
 class ComSkinnedMeshRenderer : public ComMeshRenderer {
+    friend class GameWorld;
+
 public:
     enum AnimationType {
         AnimationControllerType,
@@ -40,12 +42,24 @@ public:
 
     virtual void            Purge(bool chainPurge = true) override;
 
+    virtual bool            HasRuntimeState() const override { return true; }
+
     virtual void            Init() override;
 
     virtual void            Update() override;
 
     void                    UpdateAnimation(int time);
 
+                            /// Returns the number of frames between animation updates depending on the visibility. 0 means no update.
+                            /// Called once per frame.
+    int                     GetAnimationUpdateInterval();
+
+                            /// Computes joint matrices and AABB of the current time. Safe to call from the worker threads.
+    void                    ComputeAnimation(int currentTime);
+
+                            /// Publishes the result of ComputeAnimation() to the render world.
+    void                    PublishAnimation();
+
     Vec3                    GetTranslation(int currentTime) const;
 
     Vec3                    GetTranslationDelta(int fromTime, int toTime) const;
@@ -101,6 +115,9 @@ protected:
     BE1::Array<AABB>        frameAABBs;
 
     int                     playStartTime;
+
+    int                     lastViewCount;              ///< viewCount of the render entity in the last animation update
+    bool                    animationUpdateQueued;      ///< Queued in GameWorld::UpdateAnimations()
 };
 
 BE_INLINE Vec3 ComSkinnedMeshRenderer::GetTranslation(int currentTime) const { 
@@ -59,6 +59,11 @@ public:
                             /// Can disable ?
     virtual bool            CanDisable() const { return true; }
 
+                            /// Has state that is not serialized to the properties and can't be reset by Init() ?
+                            /// Such components are always respawned when restoring the world snapshot.
+                            /// Components of the other kept entities are purged and initialized again from the properties.
+    virtual bool            HasRuntimeState() const { return false; }
+
                             /// Is enabled ?
     bool                    IsEnabled() const { return enabled; }
 
@@ -0,0 +1,104 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Radix Sort templated functions
+
+    LSD radix sort of unsigned integer keys with 8 bit digits.
+    Values are moved along with the keys, and the sort is stable.
+
+    Histograms of all digits are computed in a single pass, and the passes of
+    the digits which are the same for every key are skipped, so only the
+    populated key bits are sorted.
+
+-------------------------------------------------------------------------------
+*/
+
+BE_NAMESPACE_BEGIN
+
+/// Sorts keys in increasing order and reorders values accordingly.
+/// tempKeys and tempValues must have room for count elements. Sorted result is written in keys and values.
+template <typename Key, typename Value>
+void RadixSort(Key *keys, Value *values, int count, Key *tempKeys, Value *tempValues) {
+    static_assert(std::is_unsigned<Key>::value, "RadixSort key must be unsigned integer type");
+
+    enum { NumDigits = sizeof(Key) };
+
+    if (count < 2) {
+        return;
+    }
+
+    uint32_t histograms[NumDigits][256];
+    memset(histograms, 0, sizeof(histograms));
+
+    // Bits which are different from the first key
+    Key diffBits = 0;
+    const Key firstKey = keys[0];
+
+    for (int i = 0; i < count; i++) {
+        const Key key = keys[i];
+        diffBits |= key ^ firstKey;
+
+        for (int digit = 0; digit < NumDigits; digit++) {
+            histograms[digit][(key >> (digit << 3)) & 0xFF]++;
+        }
+    }
+
+    Key *srcKeys = keys;
+    Value *srcValues = values;
+    Key *dstKeys = tempKeys;
+    Value *dstValues = tempValues;
+
+    for (int digit = 0; digit < NumDigits; digit++) {
+        const int shift = digit << 3;
+
+        // Skip if every key has the same digit
+        if (((diffBits >> shift) & 0xFF) == 0) {
+            continue;
+        }
+
+        // Convert histogram to the starting offsets
+        uint32_t *offsets = histograms[digit];
+        uint32_t sum = 0;
+        for (int i = 0; i < 256; i++) {
+            uint32_t c = offsets[i];
+            offsets[i] = sum;
+            sum += c;
+        }
+
+        for (int i = 0; i < count; i++) {
+            const Key key = srcKeys[i];
+            uint32_t dstIndex = offsets[(key >> shift) & 0xFF]++;
+            dstKeys[dstIndex] = key;
+            dstValues[dstIndex] = srcValues[i];
+        }
+
+        Swap(srcKeys, dstKeys);
+        Swap(srcValues, dstValues);
+    }
+
+    // Odd number of passes leaves the result in the temporary buffers
+    if (srcKeys != keys) {
+        for (int i = 0; i < count; i++) {
+            keys[i] = srcKeys[i];
+            values[i] = srcValues[i];
+        }
+    }
+}
+
+BE_NAMESPACE_END
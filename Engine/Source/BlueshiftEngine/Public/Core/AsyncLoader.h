@@ -0,0 +1,124 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Asynchronous resource loader
+
+    Requests are loaded (file I/O and decoding) on the dedicated loader
+    threads in priority order. They never run in the task scheduler, so the
+    threads waiting for the tasks don't block on file I/O. Loaded requests are
+    finalized (GPU upload etc) on the main thread in Update() within the time
+    budget of a frame.
+
+    Resource managers return placeholder resources or prefetch the resources
+    for the async requests, and fill them in when the requests are finalized.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Core/CVars.h"
+#include "Platform/PlatformThread.h"
+
+BE_NAMESPACE_BEGIN
+
+class BE_API AsyncLoadRequest {
+    friend class AsyncLoader;
+
+public:
+    enum State {
+        Queued,
+        Loading,
+        Loaded
+    };
+
+    AsyncLoadRequest() = default;
+    virtual ~AsyncLoadRequest() {}
+
+                            /// Called on the loader thread. Reads and decodes the resource data.
+    virtual void            Load() = 0;
+
+                            /// Called on the main thread after Load(). Fills the resource in.
+    virtual void            Finalize() = 0;
+
+    int                     GetPriority() const { return priority; }
+    State                   GetState() const { return state; }
+
+private:
+    int                     priority = 0;
+    uint64_t                sequence = 0;       ///< Requests of the same priority are loaded in order
+    volatile State          state = Queued;
+};
+
+class BE_API AsyncLoader {
+public:
+    enum Priority {
+        LowPriority         = 0,
+        NormalPriority      = 50,
+        HighPriority        = 100
+    };
+
+    enum {
+        NumLoaderThreads    = 2
+    };
+
+    void                    Init();
+    void                    Shutdown();
+
+                            /// Returns true if async loading is available. Otherwise the resources should be loaded synchronously.
+    bool                    IsEnabled() const;
+
+                            /// Adds a request to load. The loader takes ownership of the request.
+    void                    AddRequest(AsyncLoadRequest *request, int priority = NormalPriority);
+
+                            /// Loads and finalizes the request right now if it's not finalized yet.
+                            /// Request is deleted after this call.
+    void                    Complete(AsyncLoadRequest *request);
+
+                            /// Finalizes loaded requests within the time budget. Called every frame on the main thread.
+    void                    Update();
+
+                            /// Deletes all the requests without finalizing them.
+    void                    CancelAll();
+
+    static CVar             fs_asyncLoad;
+    static CVar             fs_asyncFinalizeTime;
+
+private:
+    static bool             CompareRequest(const AsyncLoadRequest *a, const AsyncLoadRequest *b);
+    static void             LoaderThreadProc(void *data);
+    AsyncLoadRequest *      PopQueuedRequest();
+    AsyncLoadRequest *      TakeLoadedRequest();
+    void                    RemoveQueuedRequest(AsyncLoadRequest *request);
+    void                    FinalizeRequest(AsyncLoadRequest *request);
+
+    PlatformMutex *         mutex = nullptr;
+    PlatformCondition *     queuedCondition = nullptr;  ///< Signaled when a request is queued or the loader threads should terminate
+    PlatformCondition *     loadedCondition = nullptr;  ///< Signaled when a request is loaded
+    Array<PlatformThread *> threads;                    ///< Loader threads
+    bool                    terminate = false;
+
+    Array<AsyncLoadRequest *> queuedRequests;       ///< Binary heap ordered by priority
+    Array<AsyncLoadRequest *> loadedRequests;       ///< Loaded requests waiting for finalization
+    int                     numLoadingRequests = 0;
+    uint64_t                nextSequence = 0;
+};
+
+extern AsyncLoader          asyncLoader;
+
+BE_NAMESPACE_END
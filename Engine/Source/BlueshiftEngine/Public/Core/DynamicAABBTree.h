@@ -22,6 +22,7 @@
 -------------------------------------------------------------------------------
 */
 
+#include "Containers/Array.h"
 #include "Containers/Stack.h"
 #include "Math/Math.h"
 
@@ -69,16 +70,49 @@ public:
                     /// Build an optimal tree. Very expensive. For testing.
     void            RebuildBottomUp();
 
+                    /// Collapse the binary tree into 4-ary nodes which are used for SIMD frustum query.
+                    /// Only the wide nodes on the paths from the modified leaves to the root are refitted
+                    /// if the tree has been built before. Call this before querying from multiple threads.
+    void            BuildWideNodes();
+
+    template <typename F>
+    void            Query(const Sphere &boundingVolume, F &callback) const { Query(boundingVolume, root, callback); }
+    template <typename F>
+    void            Query(const AABB &boundingVolume, F &callback) const { Query(boundingVolume, root, callback); }
+    template <typename F>
+    void            Query(const OBB &boundingVolume, F &callback) const { Query(boundingVolume, root, callback); }
     template <typename F>
-    void            Query(const Sphere &boundingVolume, F &callback) const;
+    void            Query(const Frustum &boundingVolume, F &callback) const { Query(boundingVolume, root, callback); }
+
+                    /// Query only the sub-tree starting from the given node.
+    template <typename F>
+    void            Query(const Sphere &boundingVolume, int32_t startNodeId, F &callback) const;
     template <typename F>
-    void            Query(const AABB &boundingVolume, F &callback) const;
+    void            Query(const AABB &boundingVolume, int32_t startNodeId, F &callback) const;
     template <typename F>
-    void            Query(const OBB &boundingVolume, F &callback) const;
+    void            Query(const OBB &boundingVolume, int32_t startNodeId, F &callback) const;
     template <typename F>
-    void            Query(const Frustum &boundingVolume, F &callback) const;
+    void            Query(const Frustum &boundingVolume, int32_t startNodeId, F &callback) const;
+
+                    /// Splits the tree into at most maxSubTrees sub-trees which contain all the leaves intersecting with the bounding volume.
+                    /// Sub-trees are independent of each other so they can be queried concurrently.
+                    /// Returns number of sub-tree nodes written to subTrees in deterministic (breadth-first) order.
+    template <typename BV>
+    int             FindSubTrees(const BV &boundingVolume, int maxSubTrees, int32_t *subTrees) const;
 
 private:
+    // 4-ary node which collapses the two levels below the binary node of the same index.
+    // Child AABBs are stored in SoA layout to be tested at once.
+    struct WideNode {
+        float       bounds[6][4];   // minX, minY, minZ, maxX, maxY, maxZ of each child
+        int32_t     children[4];    // grandchild (or child if it is a leaf) node ids, -1 for empty slot
+    };
+
+    struct WideQueryEntry {
+        int32_t     nodeId;
+        int32_t     planeMask;
+    };
+
     int             AllocNode();
     void            FreeNode(int32_t node);
 
@@ -93,6 +127,27 @@ private:
     void            ValidateStructure(int32_t index) const;
     void            ValidateMetrics(int32_t index) const;
 
+    template <typename F>
+    bool            QueryAllLeaves(int32_t startNodeId, F &callback) const;
+
+    void            InvalidateWideNodes() { wideNodesValid = false; }
+    void            MarkWideNodesDirty(int32_t nodeId);
+    void            RefitDirtyWideNodes();
+    void            RefitWideNode(int32_t nodeId);
+
+                    /// Computes world space frustum planes facing outward.
+    static void     FrustumToPlanes(const Frustum &frustum, Plane planes[6]);
+
+                    /// Tests 4 children of the wide node against the planes in planeMask.
+                    /// Returns bit mask of the visible children. childPlaneMasks[i] is set to the planes that still
+                    /// intersect the i'th child, 0 means the child is fully inside of the frustum.
+    static int      CullWideNode(const WideNode &wideNode, const Plane planes[6], int planeMask, int childPlaneMasks[4]);
+
+    static bool     IsIntersect(const Sphere &sphere, const AABB &aabb) { return sphere.IsIntersectAABB(aabb); }
+    static bool     IsIntersect(const AABB &box, const AABB &aabb) { return box.IsIntersectAABB(aabb); }
+    static bool     IsIntersect(const OBB &obb, const AABB &aabb) { return obb.IsIntersectOBB(OBB(aabb)); }
+    static bool     IsIntersect(const Frustum &frustum, const AABB &aabb) { return !frustum.CullAABB(aabb); }
+
     struct Node {
         bool        IsLeaf() const { return child1 == -1; }
         
@@ -114,6 +169,13 @@ private:
     int32_t         freeList;
     Node *          nodes;
     int             insertionCount;
+
+    WideNode *      wideNodes;
+    uint32_t *      wideNodeRefitStamps;
+    uint32_t        wideNodeRefitStamp;
+    int32_t         wideNodeCapacity;
+    bool            wideNodesValid;
+    Array<int32_t>  dirtyWideNodes;     // nodes whose wide node and the wide nodes of the ancestors need to be refitted
 };
 
 BE_INLINE void *DynamicAABBTree::GetUserData(int32_t proxyId) const {
@@ -134,9 +196,9 @@ BE_INLINE const AABB &DynamicAABBTree::GetRootFatAABB() const {
 }
 
 template <typename F>
-BE_INLINE void DynamicAABBTree::Query(const Sphere &sphere, F &callback) const {
+BE_INLINE void DynamicAABBTree::Query(const Sphere &sphere, int32_t startNodeId, F &callback) const {
     Stack<int32_t> stack(256);
-    stack.Push(root);
+    stack.Push(startNodeId);
 
     while (!stack.IsEmpty()) {
         int32_t nodeId = stack.Pop();
@@ -161,9 +223,9 @@ BE_INLINE void DynamicAABBTree::Query(const Sphere &sphere, F &callback) const {
 }
 
 template <typename F>
-BE_INLINE void DynamicAABBTree::Query(const AABB &aabb, F &callback) const {
+BE_INLINE void DynamicAABBTree::Query(const AABB &aabb, int32_t startNodeId, F &callback) const {
     Stack<int32_t> stack(256);
-    stack.Push(root);
+    stack.Push(startNodeId);
 
     while (!stack.IsEmpty()) {
         int32_t nodeId = stack.Pop();
@@ -188,9 +250,9 @@ BE_INLINE void DynamicAABBTree::Query(const AABB &aabb, F &callback) const {
 }
 
 template <typename F>
-BE_INLINE void DynamicAABBTree::Query(const OBB &obb, F &callback) const {
+BE_INLINE void DynamicAABBTree::Query(const OBB &obb, int32_t startNodeId, F &callback) const {
     Stack<int32_t> stack(256);
-    stack.Push(root);
+    stack.Push(startNodeId);
 
     while (!stack.IsEmpty()) {
         int32_t nodeId = stack.Pop();
@@ -215,9 +277,71 @@ BE_INLINE void DynamicAABBTree::Query(const OBB &obb, F &callback) const {
 }
 
 template <typename F>
-BE_INLINE void DynamicAABBTree::Query(const Frustum &frustum, F &callback) const {
+BE_INLINE bool DynamicAABBTree::QueryAllLeaves(int32_t startNodeId, F &callback) const {
     Stack<int32_t> stack(256);
-    stack.Push(root);
+    stack.Push(startNodeId);
+
+    while (!stack.IsEmpty()) {
+        int32_t nodeId = stack.Pop();
+        const Node *node = nodes + nodeId;
+
+        if (node->IsLeaf()) {
+            bool proceed = callback(nodeId);
+            if (proceed == false) {
+                return false;
+            }
+        } else {
+            stack.Push(node->child1);
+            stack.Push(node->child2);
+        }
+    }
+    return true;
+}
+
+template <typename F>
+BE_INLINE void DynamicAABBTree::Query(const Frustum &frustum, int32_t startNodeId, F &callback) const {
+    if (startNodeId != -1 && wideNodesValid && !nodes[startNodeId].IsLeaf()) {
+        // SIMD query with wide nodes. Each entry holds the frustum planes still intersecting the node,
+        // so the plane tests are skipped for the nodes fully inside.
+        Plane planes[6];
+        FrustumToPlanes(frustum, planes);
+
+        Stack<WideQueryEntry> stack(256);
+        stack.Push({ startNodeId, 0x3F });
+
+        while (!stack.IsEmpty()) {
+            const WideQueryEntry entry = stack.Pop();
+            const WideNode &wideNode = wideNodes[entry.nodeId];
+
+            int childPlaneMasks[4];
+            int visibleMask = CullWideNode(wideNode, planes, entry.planeMask, childPlaneMasks);
+
+            for (int i = 0; i < 4; i++) {
+                if (!(visibleMask & BIT(i))) {
+                    continue;
+                }
+
+                int32_t childId = wideNode.children[i];
+
+                if (nodes[childId].IsLeaf()) {
+                    bool proceed = callback(childId);
+                    if (proceed == false) {
+                        return;
+                    }
+                } else if (childPlaneMasks[i] == 0) {
+                    if (!QueryAllLeaves(childId, callback)) {
+                        return;
+                    }
+                } else {
+                    stack.Push({ childId, childPlaneMasks[i] });
+                }
+            }
+        }
+        return;
+    }
+
+    Stack<int32_t> stack(256);
+    stack.Push(startNodeId);
 
     while (!stack.IsEmpty()) {
         int32_t nodeId = stack.Pop();
@@ -241,4 +365,51 @@ BE_INLINE void DynamicAABBTree::Query(const Frustum &frustum, F &callback) const
     }
 }
 
+template <typename BV>
+BE_INLINE int DynamicAABBTree::FindSubTrees(const BV &boundingVolume, int maxSubTrees, int32_t *subTrees) const {
+    if (root == -1 || maxSubTrees <= 0 || !IsIntersect(boundingVolume, nodes[root].aabb)) {
+        return 0;
+    }
+
+    int32_t *nextSubTrees = (int32_t *)_alloca(maxSubTrees * 2 * sizeof(subTrees[0]));
+    int numSubTrees = 1;
+    subTrees[0] = root;
+
+    // Expand the sub-trees level by level while the number of sub-trees fits
+    while (1) {
+        int numNextSubTrees = 0;
+        bool expanded = false;
+
+        for (int i = 0; i < numSubTrees; i++) {
+            const Node *node = nodes + subTrees[i];
+
+            if (node->IsLeaf()) {
+                nextSubTrees[numNextSubTrees++] = subTrees[i];
+                continue;
+            }
+
+            if (IsIntersect(boundingVolume, nodes[node->child1].aabb)) {
+                nextSubTrees[numNextSubTrees++] = node->child1;
+            }
+            if (IsIntersect(boundingVolume, nodes[node->child2].aabb)) {
+                nextSubTrees[numNextSubTrees++] = node->child2;
+            }
+            expanded = true;
+        }
+
+        if (!expanded || numNextSubTrees > maxSubTrees) {
+            break;
+        }
+
+        numSubTrees = numNextSubTrees;
+        memcpy(subTrees, nextSubTrees, numSubTrees * sizeof(subTrees[0]));
+
+        if (numSubTrees == 0) {
+            break;
+        }
+    }
+
+    return numSubTrees;
+}
+
 BE_NAMESPACE_END
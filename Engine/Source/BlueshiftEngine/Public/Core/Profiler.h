@@ -0,0 +1,158 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Hierarchical CPU/GPU frame profiler
+
+    CPU markers are written into the ring buffer of the calling thread without
+    locking. GPU markers are measured with the timestamp queries, and resolved
+    a few frames later to avoid stalls.
+
+    Markers are recorded only while capturing. The captured frames are exported
+    to the Chrome trace event format (chrome://tracing).
+
+    Marker names must be the string literals (only the pointers are stored).
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Platform/PlatformAtomic.h"
+#include "Platform/PlatformThread.h"
+#include "RHI/RHI.h"
+
+BE_NAMESPACE_BEGIN
+
+class CmdArgs;
+class ProfilerThreadInfo;
+
+class BE_API Profiler {
+public:
+    enum {
+        MaxThreads          = 64,
+        MaxCpuEventsPerThread = 16384,          // must be power of two
+        MaxCpuMarkerDepth   = 64,
+        MaxGpuMarkersPerFrame = 256,
+        GpuFrameLatency     = 4                 // number of frames to resolve the GPU queries
+    };
+
+    void                    Init();
+    void                    Shutdown();
+
+                            /// Returns true while capturing.
+    bool                    IsCapturing() const { return capturing; }
+
+                            /// Starts capturing numFrames frames. The capture is written to filename in Chrome trace format.
+    void                    StartCapture(int numFrames, const char *filename);
+
+                            /// Stops capturing and writes the captured frames.
+    void                    StopCapture();
+
+                            /// Marks the beginning of CPU marker on the calling thread.
+    void                    BeginCpuMarker(const char *name);
+                            /// Marks the end of the last CPU marker on the calling thread.
+    void                    EndCpuMarker();
+
+                            /// Marks the beginning of GPU marker. Must be called on the thread which owns the render context.
+    void                    BeginGpuMarker(const char *name);
+                            /// Marks the end of the last GPU marker.
+    void                    EndGpuMarker();
+
+                            /// Collects markers of the last frame. Called once per frame on the main thread.
+    void                    SyncFrame();
+
+                            /// Frees the GPU queries. Must be called before the render context is destroyed.
+    void                    FreeGpuQueries();
+
+private:
+    struct GpuMarker {
+        const char *        name;
+        bool                ended;
+        RHI::Handle         beginQueryHandle;
+        RHI::Handle         endQueryHandle;
+    };
+
+    struct GpuFrame {
+        uint64_t            cpuTime;            ///< CPU time when the first GPU marker of this frame is issued
+        int                 numMarkers;
+        bool                disjoint;           ///< Timestamps of this frame are invalid
+        GpuMarker           markers[MaxGpuMarkersPerFrame];
+    };
+
+    struct CapturedEvent {
+        const char *        name;
+        int                 threadIndex;        ///< Index of the thread, -1 for the GPU
+        uint64_t            startTime;
+        uint64_t            duration;
+    };
+
+    ProfilerThreadInfo *    GetThreadInfo();
+    void                    CollectCpuEvents(ProfilerThreadInfo *threadInfo);
+    void                    CollectGpuMarkers(GpuFrame &gpuFrame);
+    void                    CreateGpuQueries();
+    void                    WriteChromeTrace(const char *filename) const;
+
+    static void             Cmd_ProfileCapture(const CmdArgs &args);
+
+    friend class ProfilerThreadInfo;
+
+    PlatformMutex *         threadMutex = nullptr;
+    ProfilerThreadInfo *    threadInfos[MaxThreads];
+    PlatformAtomic          numThreadInfos;
+
+    volatile bool           capturing = false;
+    int                     captureFramesLeft = 0;
+    Str                     captureFilename;
+    Array<CapturedEvent>    capturedEvents;
+
+    bool                    gpuQueriesCreated = false;
+    GpuFrame *              gpuFrames = nullptr;
+    int                     gpuFrameIndex = 0;
+    int                     gpuMarkerStack[MaxCpuMarkerDepth];
+    int                     gpuMarkerDepth = 0;
+};
+
+extern Profiler             profiler;
+
+/// Records a CPU marker in the scope.
+class ScopedCpuMarker {
+public:
+    explicit ScopedCpuMarker(const char *name) { if (profiler.IsCapturing()) { profiler.BeginCpuMarker(name); began = true; } }
+    ~ScopedCpuMarker() { if (began) profiler.EndCpuMarker(); }
+
+private:
+    bool                    began = false;
+};
+
+/// Records a GPU marker in the scope.
+class ScopedGpuMarker {
+public:
+    explicit ScopedGpuMarker(const char *name) { if (profiler.IsCapturing()) { profiler.BeginGpuMarker(name); began = true; } }
+    ~ScopedGpuMarker() { if (began) profiler.EndGpuMarker(); }
+
+private:
+    bool                    began = false;
+};
+
+#define BE_PROFILE_CONCAT_INTERNAL(a, b)    a##b
+#define BE_PROFILE_CONCAT(a, b)             BE_PROFILE_CONCAT_INTERNAL(a, b)
+
+#define BE_PROFILE_CPU_SCOPE(name)          BE1::ScopedCpuMarker BE_PROFILE_CONCAT(cpuMarker_, __LINE__)(name)
+#define BE_PROFILE_GPU_SCOPE(name)          BE1::ScopedGpuMarker BE_PROFILE_CONCAT(gpuMarker_, __LINE__)(name)
+
+BE_NAMESPACE_END
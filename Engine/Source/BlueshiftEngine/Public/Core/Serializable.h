@@ -111,6 +111,10 @@ public:
 
                             /// Sets property with vargs (name1, variant_ptr1, name2, variant_ptr2, ...)
     bool                    SetVa(const char *name, ...);
+
+                            /// Sets property value as it is without type conversion and change notification.
+                            /// Value should be taken from Get() of the same property.
+    void                    SetRaw(const char *name, const Variant &value, int numElements = 0);
         
                             /// Deserialize to Json::Value
     const Json::Value       Deserialize() const;
@@ -14,65 +14,184 @@
 
 #pragma once
 
+/*
+-------------------------------------------------------------------------------
+
+    Task scheduler
+
+    Work-stealing job system. Every worker thread (and the main thread) owns
+    a task deque. Owner pushes/pops at the bottom, idle threads steal from
+    the top of the other deques. Waiting on a TaskCounter executes pending
+    tasks instead of blocking the thread.
+
+-------------------------------------------------------------------------------
+*/
+
 #include "Containers/Array.h"
 #include "Platform/Intrinsics.h"
+#include "Platform/PlatformAtomic.h"
 #include "Platform/PlatformThread.h"
 
 BE_NAMESPACE_BEGIN
 
+class TaskCounter;
+class TaskDeque;
+
 typedef void (*taskFunction_t)(void *data);
 
 struct Task {
     taskFunction_t          function;
     void *                  data;
+    TaskCounter *           counter;            ///< Counter to decrement when the task is finished (can be nullptr)
+};
+
+/// Counts unfinished tasks. Tasks that depend on the counter are scheduled when it drops to zero.
+class BE_API TaskCounter {
+    friend class TaskScheduler;
+
+public:
+    TaskCounter() = default;
+    TaskCounter(const TaskCounter &) = delete;
+    TaskCounter &operator=(const TaskCounter &) = delete;
+
+                            /// Returns number of unfinished tasks.
+    int                     Value() const { return (int)value; }
+
+                            /// Returns true if all the tasks are finished.
+    bool                    IsDone() const { return value == 0; }
+
+private:
+    PlatformAtomic          value;
+    PlatformAtomic          lock;               ///< Spin lock for dependentTasks
+    Array<Task>             dependentTasks;     ///< Tasks to be scheduled when value drops to zero
 };
 
 class BE_API TaskScheduler {
 public:
     enum {
-        MaxTasks            = 1000000
+        MaxThreads          = 64,
+        MaxTasksPerThread   = 4096              // must be power of two
     };
 
-    explicit TaskScheduler(int numThreads = -1);
-    ~TaskScheduler();
+                            /// Creates worker threads. If numThreads < 0, creates one worker per logical processor except the calling thread.
+    void                    Init(int numThreads = -1);
+    void                    Shutdown();
 
-                            /// Returns number of active threads.
-    size_t                  NumActiveThread() const { return threads.Count(); }
+                            /// Returns number of threads executing tasks including the main thread.
+    int                     NumThreads() const { return numThreads; }
 
-                            /// Returns number of active tasks.
+                            /// Returns index of the calling thread in [0, NumThreads()). 0 is the main thread, -1 for the threads not owned by the scheduler.
+    static int              ThreadIndex();
+
+                            /// Returns number of tasks that are queued or running.
     int64_t                 NumActiveTasks() const { return numActiveTasks; }
 
-                            /// task 추가와 관련된 Lock 
-    void                    LockTask();
+                            /// Adds a task with the given task function.
+                            /// counter is incremented now and decremented when the task is finished.
+    void                    AddTask(taskFunction_t function, void *data, TaskCounter *counter = nullptr);
 
-                            /// task 추가와 관련된 Unlock
-    void                    UnlockTask();
+                            /// Adds multiple tasks. All tasks share the given counter.
+    void                    AddTasks(int numTasks, const Task *tasks, TaskCounter *counter = nullptr);
 
-                            /// Adds a task with the given task function.
-    void                    AddTask(taskFunction_t function, void *data);
+                            /// Adds a task that will be scheduled after all the tasks of dependency are finished.
+    void                    AddTaskAfter(TaskCounter *dependency, taskFunction_t function, void *data, TaskCounter *counter = nullptr);
+
+                            /// Waits until all the tasks of the counter are finished.
+                            /// Calling thread executes pending tasks while waiting.
+    void                    WaitForCounter(const TaskCounter *counter);
 
                             /// Waits until finished all tasks.
     void                    WaitFinish();
 
-                            /// Waits given time (milliseconds) for finishing all tasks.
-                            /// Returns true if it finished in given time.
-    bool                    TimedWaitFinish(int msec);
+                            /// Calls func(rangeBegin, rangeEnd) over the sub-ranges of [begin, end) in parallel and waits for them.
+                            /// Sub-ranges are handed out in grainSize units.
+    template <typename Func>
+    void                    ParallelFor(int begin, int end, int grainSize, const Func &func);
 
 private:
-    std::list<Task>         taskList;           ///< Number of tasks to be run
-    atomic_t                numActiveTasks;     ///< Number of tasks in active state
-                            
-    bool                    terminate;          ///< terminate flag
-                            
-    PlatformMutex *         taskMutex;          ///< task 함수 실행을 위한 동기화 객체
-    PlatformCondition *     taskCondition;      ///< task 함수 실행을 위한 condition
-                            
-    PlatformMutex *         finishMutex;        ///< task list 를 모두 마쳤을 때 사용할 동기화 객체
-    PlatformCondition *     finishCondition;    ///< task list 를 모두 마쳤을 때 사용할 condition
-
-    Array<PlatformThread *> threads;
+    template <typename Func>
+    struct ParallelForData {
+        const Func *        func;
+        PlatformAtomic      next;
+        int                 end;
+        int                 grainSize;
+    };
+
+    template <typename Func>
+    static void             ParallelForTask(void *data);
+
+    void                    PushTask(const Task &task);
+    bool                    PopTask(int threadIndex, Task &task);
+    void                    ExecuteTask(const Task &task);
+    void                    DecrementCounter(TaskCounter *counter);
+    void                    WakeUpWorkers(int numTasks);
+
+    int                     numThreads = 0;
+    TaskDeque *             deques = nullptr;   ///< Task deque per thread
+    Array<PlatformThread *> threads;            ///< Worker threads
+
+    PlatformMutex *         sharedTaskMutex = nullptr;
+    Array<Task>             sharedTasks;        ///< Tasks added from the threads not owned by the scheduler, or overflowed tasks
+
+    PlatformAtomic          numActiveTasks;     ///< Number of tasks in queued or running state
+    PlatformAtomic          numQueuedTasks;     ///< Number of tasks in queued state
+    PlatformAtomic          numSleepingThreads;
+    PlatformAtomic          wakeUpCount;        ///< Incremented whenever tasks are pushed
+    volatile bool           terminate = false;
+
+    PlatformMutex *         sleepMutex = nullptr;
+    PlatformCondition *     sleepCondition = nullptr;
 
     friend void             TaskScheduler_ThreadProc(void *param);
 };
 
+template <typename Func>
+void TaskScheduler::ParallelForTask(void *data) {
+    ParallelForData<Func> *pf = (ParallelForData<Func> *)data;
+
+    while (1) {
+        int rangeBegin = (int)pf->next.Add(pf->grainSize) - pf->grainSize;
+        if (rangeBegin >= pf->end) {
+            break;
+        }
+        int rangeEnd = Min(rangeBegin + pf->grainSize, pf->end);
+        (*pf->func)(rangeBegin, rangeEnd);
+    }
+}
+
+template <typename Func>
+void TaskScheduler::ParallelFor(int begin, int end, int grainSize, const Func &func) {
+    if (begin >= end) {
+        return;
+    }
+
+    grainSize = Max(grainSize, 1);
+
+    int numRanges = (end - begin + grainSize - 1) / grainSize;
+    int numTasks = Min(numRanges, numThreads);
+
+    if (numTasks <= 1 || ThreadIndex() < 0) {
+        func(begin, end);
+        return;
+    }
+
+    ParallelForData<Func> pf;
+    pf.func = &func;
+    pf.next = begin;
+    pf.end = end;
+    pf.grainSize = grainSize;
+
+    Task *tasks = (Task *)_alloca(numTasks * sizeof(Task));
+    for (int i = 0; i < numTasks; i++) {
+        tasks[i].function = ParallelForTask<Func>;
+        tasks[i].data = &pf;
+    }
+
+    TaskCounter counter;
+    AddTasks(numTasks, tasks, &counter);
+    WaitForCounter(&counter);
+}
+
+extern TaskScheduler        taskScheduler;
+
 BE_NAMESPACE_END
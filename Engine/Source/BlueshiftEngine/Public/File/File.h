@@ -19,6 +19,7 @@
 BE_NAMESPACE_BEGIN
 
 class Guid;
+struct ZipArchive;
 
 class BE_API File {
     friend class FileSystem;
@@ -112,7 +113,7 @@ class BE_API FileInZip : public File {
     friend class FileSystem;
     
 public:
-    FileInZip(const char *filename, void *pointer);
+    FileInZip(const char *filename, ZipArchive *archive, void *pointer);
     virtual ~FileInZip();
     
     virtual const char *    GetFilePath() const { return filename; }
@@ -132,7 +133,8 @@ public:
     
 protected:
     char                    filename[MaxAbsolutePath];
-    void *                  pointer;
+    ZipArchive *            archive;
+    void *                  pointer;            ///< unzFile handle owned by this file until closed
     size_t                  size;
 };
 
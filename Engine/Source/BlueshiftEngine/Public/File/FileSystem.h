@@ -28,6 +28,7 @@
 BE_NAMESPACE_BEGIN
 
 class CmdArgs;
+class FileMapping;
 struct ZipArchive;
 
 struct ProgressCallback {
@@ -50,7 +51,10 @@ private:
     Array<FileInfo>     array;
 };
 
+/// Reading files (OpenFileRead, LoadFile, MapFile) is thread-safe. Changing the search path is not.
 class BE_API FileSystem {
+    friend class FileInZip;
+
 public:
     void                Init(const char *baseDir);
     void                Shutdown();
@@ -94,6 +98,9 @@ public:
 
     size_t              LoadFile(const char *filename, bool searchDirs, void **buffer);
     void                FreeFile(void *buffer) const;
+
+                        /// Maps a file to memory instead of loading it. Returns false if the file is not found or is in a ZIP archive.
+    bool                MapFile(const char *filename, bool searchDirs, FileMapping &fileMapping);
     
     void                WriteFile(const char *filename, const void *buffer, int size);
 
@@ -114,6 +121,13 @@ private:
     void                ClearSearchPath();
     void                AddSearchPath(const char *path);
     void                AddSearchPath_ZIP(const char *path, const char *filename);
+
+                        /// Returns index of the entry in the archive, -1 if not found.
+    static int          FindZipEntry(const ZipArchive *archive, const char *filename);
+                        /// Gets unused unzFile handle of the archive.
+    static void *       AcquireZipHandle(ZipArchive *archive);
+                        /// Returns handle to the archive when the file in archive is closed.
+    static void         ReleaseZipHandle(ZipArchive *archive, void *handle);
     
     static void         Cmd_Dir(const CmdArgs &args);
     static void         Cmd_Path(const CmdArgs &args);
@@ -0,0 +1,125 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Binary map
+
+    Cooked form of the JSON map file (.bmap). All the strings are stored in
+    the string table, and objects of the same class with the same property
+    specs share a layout (property names and types), so each object is
+    stored as the layout index, GUID and the property values in binary.
+
+    Entities are stored in batches, which are read one by one while spawning,
+    so the whole map is never in memory at once. Properties not found in the
+    current specs are skipped, and missing properties get the default values.
+
+    Offsets, counts and indices read from the file are bounds-checked, and
+    a corrupt file fails the load instead of spawning broken entities.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Core/CVars.h"
+#include "Entity.h"
+
+BE_NAMESPACE_BEGIN
+
+class File;
+class CmdArgs;
+class BinaryMapReader;
+
+class BinaryMap {
+public:
+    BinaryMap() = default;
+    ~BinaryMap() { Close(); }
+
+    static void                 Init();
+    static void                 Shutdown();
+
+                                /// Returns the cooked filename of the JSON map file.
+    static Str                  CookedFilename(const char *filename);
+
+                                /// Converts the JSON map file to the binary map file.
+    static bool                 Cook(const char *filename, const char *cookedFilename);
+
+                                /// Opens the binary map file. If sourceFilename is given, fails if the size or the time stamp of the source JSON map file
+                                /// is different from the ones recorded when cooking.
+                                /// Fails if the header, the tables or the batch chain is corrupt.
+    bool                        Open(const char *filename, const char *sourceFilename = nullptr);
+    void                        Close();
+
+    int                         NumEntities() const { return numEntities; }
+
+                                /// Returns mesh GUIDs referenced by the entities to prefetch.
+    const Array<Guid> &         GetMeshGuids() const { return meshGuids; }
+
+                                /// Returns audio clip GUIDs referenced by the entities to prefetch.
+    const Array<Guid> &         GetAudioClipGuids() const { return audioClipGuids; }
+
+                                /// Reads properties of the settings object. Settings object should be initialized again.
+                                /// Returns false if the settings are corrupt.
+    bool                        ReadSettings(Object *settings);
+
+                                /// Reads the next batch of entities. Entities are not initialized yet like Entity::CreateEntity().
+                                /// Entity number to spawn of each entity is appended to spawnEntityNums (-1 if not specified).
+                                /// Returns false if there are no more entities, or the batch is corrupt (see IsCorrupt()).
+    bool                        ReadEntityBatch(EntityPtrArray &entities, Array<int> &spawnEntityNums);
+
+                                /// Returns true if corrupt data has been found while reading.
+    bool                        IsCorrupt() const { return corrupt; }
+
+    static CVar                 map_useCooked;
+
+private:
+    struct LayoutProperty {
+        const char *            name;
+        PropertySpec::Type      type;
+        bool                    isArray;
+        const PropertySpec *    spec;           ///< Current property spec. nullptr if not found or the type is changed.
+    };
+
+    struct Layout {
+        MetaObject *            metaObject;     ///< nullptr if the class is not found
+        Guid                    scriptGuid;     ///< Script of ComScript layout
+        int                     firstProperty;
+        int                     numProperties;
+    };
+
+    Object *                    ReadObject(BinaryMapReader &reader) const;
+    void                        ReadProperties(BinaryMapReader &reader, const Layout &layout, Object *object) const;
+
+    static void                 Cmd_CookMap(const CmdArgs &args);
+
+    File *                      file = nullptr;
+    Array<char>                 stringData;
+    Array<const char *>         strings;
+    Array<Layout>               layouts;
+    Array<LayoutProperty>       layoutProperties;
+    Array<Guid>                 meshGuids;
+    Array<Guid>                 audioClipGuids;
+    uint32_t                    settingsOffset = 0;
+    uint32_t                    settingsSize = 0;
+    int                         numEntities = 0;
+    int                         numBatches = 0;
+    int                         batchIndex = 0;
+    uint32_t                    batchOffset = 0;
+    Array<byte>                 batchData;
+    bool                        corrupt = false;
+};
+
+BE_NAMESPACE_END
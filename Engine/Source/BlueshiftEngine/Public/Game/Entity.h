@@ -42,6 +42,9 @@ class Entity : public Object {
     friend class GameWorld;
     friend class GameEdit;
     friend class Prefab;
+    friend class PrefabTemplate;
+    friend class WorldSnapshot;
+    friend class BinaryMap;
     friend class Component;
 
 public:
@@ -124,6 +127,9 @@ public:
 
     static void                 RemapGuids(EntityPtrArray &entities, const HashTable<Guid, Guid> &guidMap);
 
+                                // Create copies of the entities through JSON values with the new GUIDs
+    static void                 CloneEntities(const EntityPtrArray &originalEntities, EntityPtrArray &clonedEntities);
+
     void                        InitHierarchy();
 
                                 // entity 초기화 함수, 언제나 부모 entity 초기화가 먼저 실행된다.
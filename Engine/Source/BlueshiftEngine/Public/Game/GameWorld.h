@@ -23,6 +23,7 @@
 */
 
 #include "Entity.h"
+#include "WorldSnapshot.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -33,6 +34,8 @@ class Prefab;
 class TagLayerSettings;
 class PhysicsSettings;
 class MapRenderSettings;
+class ComSkinnedMeshRenderer;
+class BinaryMap;
 
 class GameWorld : public Object {
     friend class GameEdit;
@@ -68,6 +71,10 @@ public:
                                 // Simulate physics system and update all registered entities 
     void                        Update(int elapsedTime);
 
+                                // Queues skinned mesh renderer to compute animation in UpdateAnimations()
+    void                        QueueAnimationUpdate(ComSkinnedMeshRenderer *skinnedMeshRenderer);
+    void                        CancelAnimationUpdate(ComSkinnedMeshRenderer *skinnedMeshRenderer);
+
                                 // Process mouse (touch) input feedback for all responsive entities
     void                        ProcessPointerInput();
 
@@ -89,6 +96,8 @@ public:
 
     void                        OnEntityNameChanged(Entity *ent);
     void                        OnEntityTagChanged(Entity *ent);
+                                // Called by the components whenever they add a render entity for the entity
+    void                        OnRenderEntityAdded(const Entity *ent, int renderEntityHandle);
 
     bool                        IsRegisteredEntity(const Entity *ent) const;
     void                        RegisterEntity(Entity *ent, int spawn_entnum = -1);
@@ -102,7 +111,9 @@ public:
 
     static void                 SerializeEntityHierarchy(const Hierarchy<Entity> &entityHierarchy, Json::Value &entitiesValue);
 
+                                // Saves all entities to the binary snapshot
     void                        SaveSnapshot();
+                                // Restores entities from the snapshot. Unchanged entities are kept unless snapshot_deltaRestore is 0
     void                        RestoreSnapshot();
 
     void                        BeginMapLoading();
@@ -137,20 +148,29 @@ public:
 private:
     void                        Event_RestartGame(const char *mapName);
 
+    bool                        LoadJsonMap(const char *filename);
+    bool                        LoadBinaryMap(BinaryMap &binaryMap);
+
     Entity *                    CloneEntity(const Entity *originalEntity);
     void                        SaveObject(const char *filename, const Object *object) const;
     void                        ClearAllEntities();
     void                        UpdateEntities();   
+    void                        UpdateAnimations();
 
     Entity *                    entities[MaxEntities];
     HashIndex                   entityHash;
     HashIndex                   entityTagHash;
+    HashTable<int, Guid>        renderEntityOwners;     // render entity handle to the GUID of the owner entity
     int                         firstFreeIndex;
     int                         spawnIds[MaxEntities];
     int                         spawnCount;
     Hierarchy<Entity>           entityHierarchy;
 
-    Json::Value                 snapshotValues;
+    Array<ComSkinnedMeshRenderer *> animationUpdates;   // skinned mesh renderers queued in this frame
+    Array<ComSkinnedMeshRenderer *> computingAnimations;
+    int                         animationFrameCount;
+
+    WorldSnapshot               snapshot;
 
     Str                         mapName;
 
@@ -44,6 +44,14 @@ public:
     bool                        Reload();
 
 private:
+    void                        ConnectSignals(Entity *entity);
+                                /// Frees compiled templates of the entities, they are compiled again with the changes.
+    void                        InvalidateTemplates();
+
+    void                        PropertyChanged(const char *classname, const char *propName);
+    void                        ComponentInserted(const Component *component, int index);
+    void                        ComponentRemoved(const Component *component);
+
     Str                         hashName;
     Str                         name;
     EntityPtrArray              entities;
@@ -77,6 +85,52 @@ private:
     Array<Guid>                 removedComponents;
 };*/
 
+/// Compiled entity hierarchy to instantiate without JSON round-trips.
+/// Property values are kept as the converted Variants. References to the entities and components
+/// in the hierarchy are kept as GUID slots, which are filled with the new GUIDs on instantiation.
+class PrefabTemplate {
+public:
+    void                        Clear();
+
+    int                         NumEntities() const { return entities.Count(); }
+
+                                /// Compiles the entity and all of its children.
+    void                        Compile(const Entity *rootEntity);
+
+                                /// Creates entities and their components with the new GUIDs in depth first order.
+                                /// Like Entity::CreateEntity(), entities are not initialized yet.
+    void                        Instantiate(EntityPtrArray &instantiatedEntities) const;
+
+private:
+    struct TemplateProperty {
+        Str                     name;
+        Variant                 value;
+        int                     numElements;    ///< Number of elements of the array property
+        int                     guidSlot;       ///< GUID slot of the referenced object, -1 if the object is not in the template
+    };
+
+    struct TemplateObject {
+        const MetaObject *      metaObject;
+        int                     guidSlot;
+        int                     firstProperty;
+        int                     numProperties;
+        Guid                    scriptGuid;     ///< Script GUID to initialize property specs of the script component
+    };
+
+    struct TemplateEntity {
+        int                     firstObject;    ///< Entity object followed by its component objects
+        int                     numComponents;
+    };
+
+    void                        CompileObject(const Object *object, const HashTable<Guid, int> &guidSlotTable);
+    void                        InitObjectProperties(Object *object, const TemplateObject &templateObject, const Array<Guid> &newGuids) const;
+
+    int                         numGuidSlots = 0;
+    Array<TemplateEntity>       entities;
+    Array<TemplateObject>       objects;
+    Array<TemplateProperty>     properties;
+};
+
 class PrefabManager {
 public:
     void                        Init();
@@ -90,8 +144,17 @@ public:
 
     static Json::Value          CreatePrefabValue(const Entity *entity);
 
+                                /// Returns compiled template of the prefab entity. Compiles it at the first call.
+    const PrefabTemplate *      GetPrefabTemplate(const Entity *prefabEntity);
+
+                                /// Frees compiled template of the prefab entity.
+    void                        FreePrefabTemplate(const Entity *prefabEntity);
+
 private:
+    static void                 Cmd_BenchmarkPrefab(const CmdArgs &args);
+
     StrIHashMap<Prefab *>       prefabHashMap;
+    HashTable<Guid, PrefabTemplate *> prefabTemplateHash;
 };
 
 extern PrefabManager            prefabManager;
@@ -0,0 +1,88 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Binary property codec
+
+    Binary encoding of the property values shared by the binary map and the
+    world snapshot. Values of the fixed size types are stored as they are in
+    memory. Strings are stored as the length followed by the characters, and
+    the derived classes may store them differently (the binary map stores
+    the index of the string table).
+
+    Reading is bounds-checked. Reading past the end of the data fails the
+    reader instead of reading garbage, so corrupt data can be rejected.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/Array.h"
+#include "Core/Object.h"
+
+BE_NAMESPACE_BEGIN
+
+class PropertyWriter {
+public:
+    virtual ~PropertyWriter() = default;
+
+    static void                 WriteBytes(Array<byte> &out, const void *src, int size);
+
+    template <typename T>
+    static void                 Write(Array<byte> &out, const T &value) { WriteBytes(out, &value, sizeof(T)); }
+
+                                /// Writes the string as the length followed by the characters.
+    virtual void                WriteString(Array<byte> &out, const char *str);
+
+                                /// Writes the value of the property type.
+    void                        WriteValue(Array<byte> &out, PropertySpec::Type type, const Variant &value);
+};
+
+class PropertyReader {
+public:
+    PropertyReader(const byte *data, size_t size) : ptr(data), end(data + size) {}
+    virtual ~PropertyReader() = default;
+
+                                /// Returns true if reading has failed by the corrupt data.
+    bool                        IsFailed() const { return failed; }
+                                /// Returns true if all the data is read.
+    bool                        IsAtEnd() const { return ptr == end; }
+                                /// Returns the number of bytes left to read.
+    size_t                      Remaining() const { return end - ptr; }
+
+                                /// Marks the data as corrupt. All the following reads fail.
+    void                        Fail() { failed = true; ptr = end; }
+
+                                /// Reads size bytes to dst. Fills dst with zeros and fails if the data is not enough.
+    bool                        ReadBytes(void *dst, size_t size);
+
+    template <typename T>
+    T                           Read() { T value; ReadBytes(&value, sizeof(T)); return value; }
+
+                                /// Reads the string written by PropertyWriter::WriteString().
+    virtual bool                ReadString(Str &str);
+
+                                /// Reads the value of the property type written by PropertyWriter::WriteValue().
+    bool                        ReadValue(PropertySpec::Type type, Variant &value);
+
+protected:
+    const byte *                ptr;
+    const byte *                end;
+    bool                        failed = false;
+};
+
+BE_NAMESPACE_END
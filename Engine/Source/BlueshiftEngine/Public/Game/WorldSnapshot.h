@@ -0,0 +1,93 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    World snapshot
+
+    Binary snapshot of the game world, which is saved before playing the game
+    and restored after. Property values are written in the order of the
+    property specs without names, so the snapshot is only valid in the same
+    session.
+
+    Each entity is written with its components into a separate record with
+    the hash of the bytes. Restoring compares the records against the current
+    entities to find the entities to keep.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Containers/HashTable.h"
+#include "Entity.h"
+
+BE_NAMESPACE_BEGIN
+
+class PropertyReader;
+
+class WorldSnapshot {
+public:
+    void                        Clear();
+
+    bool                        IsEmpty() const { return data.Count() == 0; }
+
+                                /// Returns size of the snapshot in bytes.
+    size_t                      Size() const;
+
+    int                         NumEntities() const { return entityRecords.Count(); }
+
+                                /// Returns index of the entity record. Returns -1 if not found.
+    int                         FindEntity(const Guid &entityGuid) const;
+
+                                /// Writes properties of the settings object.
+    void                        WriteSettings(const Object *settings);
+                                /// Reads properties of the settings object written by WriteSettings(). Settings object should be initialized again.
+    void                        ReadSettings(Object *settings) const;
+
+                                /// Writes the entity and its components. Entities should be written in depth-first order.
+    void                        WriteEntity(const Entity *entity);
+                                /// Creates the entity of the record. Like Entity::CreateEntity(), entity is not initialized yet.
+    Entity *                    ReadEntity(int recordIndex) const;
+
+                                /// Finds the entities which are not changed since the snapshot.
+                                /// unchangedEntities will be filled with the entity for each record, or nullptr if it should be respawned.
+    void                        FindUnchangedEntities(const EntityPtrArray &entities, EntityPtrArray &unchangedEntities) const;
+
+private:
+    struct EntityRecord {
+        Guid                    guid;
+        int                     offset;
+        int                     size;
+        uint32_t                hash;           ///< CRC32 of the bytes
+        int                     firstReference;
+        int                     numReferences;  ///< Object references of the entity and its components
+    };
+
+    static void                 WriteObject(const Object *object, Array<byte> &out, Array<Guid> *references);
+    static Object *             ReadObject(PropertyReader &reader);
+    static void                 ReadProperties(PropertyReader &reader, Object *object);
+
+    bool                        IsUnchanged(int recordIndex, const Entity *entity) const;
+
+    Array<byte>                 data;
+    int                         settingsOffset = 0;
+    int                         settingsSize = 0;
+    Array<EntityRecord>         entityRecords;
+    Array<Guid>                 references;
+    HashTable<Guid, int>        objectRecordHash;   ///< GUID of the entity or component to the entity record index
+};
+
+BE_NAMESPACE_END
@@ -315,6 +315,9 @@ public:
         int                 maxGeometryTextureImageUnits;
         int                 maxGeometryOutputVertices;
 
+        int                 maxUniformBlockSize;
+        int                 uniformBufferOffsetAlignment;
+
         int                 maxRenderBufferSize;
         int                 maxColorAttachments;
         int                 maxDrawBuffers;
@@ -323,6 +326,14 @@ public:
         int                 nvFragmentProgramVersion;
     };
 
+    struct Counter {
+        unsigned int        drawCalls;              ///< Number of draw calls
+        unsigned int        stateChanges;           ///< Number of render state bits changes
+        unsigned int        textureBinds;           ///< Number of texture bindings
+        unsigned int        shaderConstantCalls;    ///< Number of shader constant updates
+        unsigned int        constantBlockBinds;     ///< Number of constant block buffer bindings
+    };
+
     struct Settings {       
         int                 colorBits;
         int                 alphaBits;
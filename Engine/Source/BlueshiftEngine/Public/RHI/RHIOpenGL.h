@@ -67,10 +67,15 @@ public:
     bool                    SupportsTextureCompressionLATC() const;
     bool                    SupportsTextureCompressionETC2() const;
     bool                    SupportsDebugLabel() const;
+    bool                    SupportsTimestampQuery() const;
+    bool                    SupportsUniformBuffer() const;
+    bool                    SupportsBufferStorage() const;
 
     Handle                  CreateContext(WindowHandle windowHandle, bool useSharedContext);
     void                    DestroyContext(Handle ctxHandle);
     void                    SetContext(Handle ctxHandle);
+                            /// Makes no context current on the calling thread, so that the other thread can make it current.
+    void                    ReleaseContext();
     void                    SetContextDisplayFunc(Handle ctxHandle, DisplayContextFunc displayFunc, void *dataPtr, bool onDemandDrawing);
     void                    DisplayContext(Handle ctxHandle);
     WindowHandle            GetWindowHandleFromContext(Handle ctxHandle);
@@ -195,6 +200,11 @@ public:
     void                    SetShaderConstantArray3x3f(int index, bool rowmajor, int count, const Mat3 *constant) const;
     void                    SetShaderConstantArray4x4f(int index, bool rowmajor, int count, const Mat4 *constant) const;
 
+                            // Returns index of the uniform block. Returns -1 if not found
+    int                     GetShaderConstantBlockIndex(int shaderHandle, const char *name) const;
+                            // Binds the uniform buffer range starting at the offset to the block of the current shader
+    void                    SetShaderConstantBlock(int index, Handle bufferHandle, int offset);
+
     Handle                  CreateBuffer(BufferType type, BufferUsage usage, int size, int pitch = 0, const void *data = nullptr);
     void                    DeleteBuffer(Handle bufferHandle);
     void                    BindBuffer(BufferType type, Handle bufferHandle);
@@ -235,11 +245,20 @@ public:
     void                    EndQuery();
     bool                    QueryResultAvailable(Handle queryHandle) const;
     unsigned int            QueryResult(Handle queryHandle) const;
+                            // Records the GPU time when all the previous commands are completed
+    void                    QueryTimestamp(Handle queryHandle);
+                            // Returns the recorded GPU time in nanoseconds
+    uint64_t                QueryTimestampResult(Handle queryHandle) const;
+                            // Returns true if the GPU timer was disjoint since the last call, the timestamps recorded meanwhile are invalid
+    bool                    QueryTimerDisjoint();
 
     void                    CheckError(const char *fmt, ...) const;
 
     const HWLimit &         HWLimit() const { return hwLimit; }
 
+    const Counter &         GetCounter() const { return counter; }
+    void                    ResetCounter() { memset(&counter, 0, sizeof(counter)); }
+
 protected:
     void                    InitMainContext(const Settings *settings);
     void                    FreeMainContext();
@@ -268,6 +287,7 @@ protected:
     int                     multiSamples;
 
     RHI::HWLimit            hwLimit;
+    mutable RHI::Counter    counter;
 
     GLContext *             mainContext;
     Array<GLContext *>      contextList;
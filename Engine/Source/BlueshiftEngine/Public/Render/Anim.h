@@ -27,6 +27,7 @@
 #include "Containers/StrArray.h"
 #include "Containers/HashIndex.h"
 #include "Containers/HashMap.h"
+#include "Core/CVars.h"
 #include "Core/JointPose.h"
 
 class AnimImporter;
@@ -60,6 +61,7 @@ public:
         int32_t             parentNum;
         int32_t             animBits;
         int32_t             firstComponent;
+        int32_t             firstTrack;     // index of the first compressed track (-1 if not compressed)
     };
 
     struct FrameInterpolation {
@@ -97,6 +99,9 @@ public:
                             /// Returns movement delta of root joint
     const Vec3 &            TotalMovementDelta() const { return totalDelta; }
 
+                            /// Returns true if frames are stored in the compressed tracks
+    bool                    IsCompressed() const { return isCompressed; }
+
                             /// Returns total size of allocated memory
     size_t                  Allocated() const;
                             /// Returns total size of allocated memory including size of this type
@@ -113,6 +118,14 @@ public:
                             // IMPLEMENT THIS
     Anim *                  CreateMirroredAnim(const int *jointMirrorTable);
 
+                            /// Compresses frames into the quantized tracks with reduced keys.
+                            /// Error of each track is measured at the farthest descendant joint of the joint hierarchy of this anim, and bounded by maxError.
+                            /// Anims are shared by skeletons with the same hierarchy (see CheckHierarchy), so no skeleton is needed.
+    bool                    Compress(float maxError);
+
+                            /// Restores raw frames from the compressed tracks
+    void                    Decompress();
+
     bool                    Load(const char *filename);
     bool                    Reload();
     void                    Write(const char *filename);
@@ -141,12 +154,23 @@ public:
                             // frameInterpolation 의 JointPose 를 얻는다.
     void                    GetInterpolatedFrame(FrameInterpolation &frameInterpolation, int numJointIndexes, const int *jointIndexes, JointPose *joints) const;
 
+    static CVar             anim_compress;
+    static CVar             anim_compressMaxError;
+
 private:
+    struct CompressedTrack {
+        int32_t             firstKey;           // index of the first key in compressedKeyFrames
+        int32_t             numKeys;
+        float               rangeMin[3];        // dequantization range of translation and scaling
+        float               rangeExtent[3];
+    };
+
     Anim &                  Copy(const Anim &other);
     void                    CreateDefaultAnim(const Skeleton *skeleton);
     Anim *                  CreateAdditiveAnim(const char *name, const JointPose *firstFrame, int numJointIndexes, const int *jointIndexes);
 
     bool                    LoadBinaryAnim(const char *filename);
+    const byte *            ReadBinaryAnimCompressedTracks(const byte *data, size_t size, const byte *ptr);
     void                    WriteBinaryAnim(const char *filename);
 
     void                    ComputeTotalDelta();
@@ -157,6 +181,16 @@ private:
     void                    RemoveFrames(int numRemoveFrames, const int *removeFramenums);
     void                    OptimizeFrames(float epsilonT = CentiToUnit(0.01f), float epsilonQ = 0.0015f, float epsilonS = 0.0001f);
 
+    void                    ApplyRootMotionFlags(JointPose *joints) const;
+
+    void                    DecodeRawFrame(int frameNum, JointPose *joints) const;
+                            // Returns false if the number of the tracks doesn't match the animated joints
+    bool                    LinkCompressedTracks();
+    float                   FindCompressedKeys(const CompressedTrack &track, int frameNum, float sampleTime, const uint16_t **key1, const uint16_t **key2) const;
+                            // frameNum 과 frameNum + 1 사이 backlerp 위치의 JointPose 를 compressed track 에서 얻는다.
+    void                    DecompressFrame(int frameNum, float backlerp, int numJointIndexes, const int *jointIndexes, JointPose *joints) const;
+    JointPose               DecompressRootJoint(const FrameInterpolation &frameInterpolation) const;
+
     Str                     hashName;
     Str                     name;
     mutable int             refCount;
@@ -172,10 +206,14 @@ private:
     bool                    rootTranslationZ;
     bool                    isDefaultAnim;
     bool                    isAdditiveAnim;
+    bool                    isCompressed;
 
     Array<JointInfo>        jointInfo;
     Array<JointPose>        baseFrame;              // local transform for the first frame
     Array<float>            frameComponents;
+    Array<CompressedTrack>  compressedTracks;       // T, Q, S tracks of each animated joint in order
+    Array<uint16_t>         compressedKeyFrames;    // frame number of each key
+    Array<uint16_t>         compressedKeyValues;    // 3 quantized values of each key
     Array<int>              frameToTimeMap;         // times for each frame
     Array<int>              timeToFrameMap;         // frames for each 100 milliseconds
     Vec3                    totalDelta;             // 전체 animation 에서 root 가 이동한 offset
@@ -187,6 +225,7 @@ BE_INLINE Anim::Anim() {
     numFrames               = 0;
     numAnimatedComponents   = 0;
     animLength              = 0;
+    isCompressed            = false;
     totalDelta.SetFromScalar(0);
 }
 
@@ -224,6 +263,7 @@ public:
     const char *            JointNameByIndex(int index) const;
 
     static void             Cmd_ListAnims(const CmdArgs &args);
+    static void             Cmd_CompressAnim(const CmdArgs &args);
 
 private:
     StrIHashMap<Anim *>     animHashMap;
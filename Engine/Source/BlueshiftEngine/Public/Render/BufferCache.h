@@ -47,9 +47,15 @@ public:
                             /// Allocates texel buffer in the local device memory
     void                    AllocStaticTexel(int bytes, const void *data, BufferCache *vc);
 
+                            /// Dynamic allocations reserve the range of this frame with an atomic operation and write to the mapped memory directly,
+                            /// so the tasks of the task scheduler may call them concurrently.
     bool                    AllocVertex(int numVertexes, int vertexSize, const void *data, BufferCache *vc);
     bool                    AllocIndex(int numIndexes, int indexSize, const void *data, BufferCache *vc);
     bool                    AllocTexel(int bytes, const void *data, BufferCache *vc);
+                            /// Allocates uniform buffer range for the shader constant block
+    bool                    AllocUniform(int bytes, const void *data, BufferCache *vc);
+                            /// Returns true if the uniform buffer has room for the allocation of the given bytes in this frame
+    bool                    CanAllocUniform(int bytes) const;
 
     byte *                  MapVertexBuffer(BufferCache *bc) const;
     byte *                  MapIndexBuffer(BufferCache *bc) const;
@@ -76,18 +82,24 @@ private:
         RHI::Handle         vertexBuffer;
         RHI::Handle         indexBuffer;
         RHI::Handle         texelBuffer;
+        RHI::Handle         uniformBuffer;
         RHI::BufferType     texelBufferType;
         Texture *           texture;
         RHI::Handle         sync;
         void *              mappedVertexBase;
         void *              mappedIndexBase;
         void *              mappedTexelBase;
+        void *              mappedUniformBase;
         PlatformAtomic      vertexMemUsed;
         PlatformAtomic      indexMemUsed;
         PlatformAtomic      texelMemUsed;
-        int                 allocations;
+        PlatformAtomic      uniformMemUsed;
+        PlatformAtomic      allocations;
     };
 
+                            /// Reserves the range of the given bytes in the buffer. Returns -1 if there is no room.
+    static int              ReserveRange(PlatformAtomic &memUsed, int bufferSize, int alignSize, int pitch, int bytes);
+
     void                    MapBufferSet(FrameDataBufferSet &bufferSet);
     void                    UnmapBufferSet(FrameDataBufferSet &bufferSet);
 
@@ -99,8 +111,13 @@ private:
     int                     mostUsedVertexMem;
     int                     mostUsedIndexMem;
     int                     mostUsedTexelMem;
+    int                     mostUsedUniformMem;
+
+    int                     vertexBytes;
+    int                     indexBytes;
+    int                     uniformBytes;       ///< Allocatable size of the uniform buffer. Actual buffer has the extra space for the block size.
 
-    int                     pboWriteOffset;
+    bool                    persistentMap;      ///< Buffers of all frames are mapped once and never unmapped
 };
 
 extern BufferCacheManager   bufferCacheManager;
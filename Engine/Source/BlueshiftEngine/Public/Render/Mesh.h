@@ -31,6 +31,7 @@ class MeshImporter;
 BE_NAMESPACE_BEGIN
 
 class CmdArgs;
+class AsyncLoadRequest;
 class Skeleton;
 class Joint;
 class Mat3x4;
@@ -48,6 +49,8 @@ public:
 
 class Mesh {
     friend class MeshManager;
+    friend class MeshLoadRequest;
+    friend class RenderWorld;
     friend class RBSurf;
     friend class ::MeshImporter;
 
@@ -77,7 +80,8 @@ public:
         ComputeTangentsFlag = BIT(2),
         UseUnsmoothedTangentsFlag = BIT(3),
         SortAndMergeFlag    = BIT(4),
-        OptimizeIndicesFlag = BIT(5)
+        OptimizeIndicesFlag = BIT(5),
+        OptimizeOverdrawFlag = BIT(6)   ///< Used with OptimizeIndicesFlag
     };
 
     Mesh();
@@ -109,11 +113,12 @@ public:
     void                    Reinstantiate();
 
     MeshSurf *              AllocSurface(int numVerts, int numIndexes) const;
+    void                    FreeSurface(MeshSurf *surf) const;
     void                    FinishSurfaces(int finishFlags = 0);
 
     void                    TransformVerts(const Mat3 &rotation, const Vec3 &translation);
 
-    void                    OptimizeIndexedTriangles();
+    void                    OptimizeIndexedTriangles(bool optimizeOverdraw = false);
 
     void                    Voxelize();
 
@@ -141,7 +146,6 @@ public:
     const Mesh *            AddRefCount() const { refCount++; return this; }
 
 private:
-    void                    FreeSurface(MeshSurf *surf) const;
     MeshSurf *              AllocInstantiatedSurface(const MeshSurf *refSurf, int meshType) const;
 
     void                    Instantiate(int meshType);
@@ -157,6 +161,8 @@ private:
     bool                    CapableGPUJointSkinning(SkinningMethod skinningMethod, int numJoints) const;
 
     bool                    LoadBinaryMesh(const char *filename);
+    const byte *            ReadBinaryMeshSurfV1(const byte *ptr);
+    const byte *            ReadBinaryMeshSurf(const byte *data, size_t size, const byte *ptr);
     void                    WriteBinaryMesh(const char *filename);
 
     Str                     hashName;
@@ -174,7 +180,7 @@ private:
     Array<MeshSurf *>       surfaces;
 
     bool                    useGpuSkinning;
-    SkinningJointCache *    skinningJointCache;     // joint cache for HW skinning
+    SkinningJointCache *    skinningJointCache;     // joint cache for skinning
 
     int32_t                 numJoints;
     Joint *                 joints;                 // joint information array
@@ -201,6 +207,7 @@ BE_INLINE Mesh::~Mesh() {
 
 class MeshManager {
     friend class Mesh;
+    friend class MeshLoadRequest;
 
 public:
     void                    Init();
@@ -211,6 +218,10 @@ public:
     Mesh *                  FindMesh(const char *name) const;
     Mesh *                  GetMesh(const char *name);
 
+                            /// Starts loading mesh asynchronously. GetMesh() with the same name waits for it if it's not loaded yet.
+                            /// Does nothing if async loading is disabled.
+    void                    PrefetchMesh(const char *name, int priority);
+
     void                    RenameMesh(Mesh *mesh, const Str &newName);
 
     void                    ReleaseMesh(Mesh *mesh, bool immediateDestroy = false);
@@ -235,6 +246,7 @@ private:
     static void             Cmd_ReloadMesh(const CmdArgs &args);
 
     StrIHashMap<Mesh *>     meshHashMap;
+    StrIHashMap<AsyncLoadRequest *> meshLoadRequests;   ///< Prefetching meshes
 
     Array<Mesh *>           instantiatedMeshList;
 };
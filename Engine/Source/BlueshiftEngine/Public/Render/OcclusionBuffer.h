@@ -0,0 +1,80 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Software Occlusion Buffer
+
+    Low resolution depth buffer rasterized on the CPU from occluder meshes
+    in the render front end. Each pixel stores 1/w of the nearest occluder
+    (0 is infinitely far), so depth is linear in screen space and doesn't
+    depend on the projection near/far planes. Per-tile minimum depths are
+    kept for hierarchical rejection of occludee bounds.
+
+    Rasterization is conservative. Only the pixels fully covered by a
+    triangle are written, with the farthest depth of the triangle over the
+    pixel, and triangles crossing the near plane are skipped. Pixels on the
+    edges shared by the triangles of an occluder are left empty as well.
+
+-------------------------------------------------------------------------------
+*/
+
+BE_NAMESPACE_BEGIN
+
+class OcclusionBuffer {
+public:
+    enum {
+        Width                   = 320,
+        Height                  = 192,
+        TileWidth               = 8,
+        TileHeight              = 8,
+        NumTilesX               = Width / TileWidth,
+        NumTilesY               = Height / TileHeight
+    };
+
+    OcclusionBuffer();
+    ~OcclusionBuffer();
+
+                                /// Clears depth buffer for the new view. Geometry nearer than zNear is not rasterized.
+    void                        Clear(float zNear);
+
+                                /// Rasterizes occluder triangles transformed by the given model-view-projection matrix
+    void                        RasterizeMesh(const Mat4 &modelViewProjMatrix, const VertexGenericLit *verts, int numVerts, const TriIndex *indexes, int numIndexes);
+
+                                /// Updates per-tile depths. Must be called after all occluders are rasterized.
+    void                        BuildHierarchy();
+
+                                /// Returns true if the world space AABB is completely hidden behind the occluders.
+                                /// Thread-safe, can be called in parallel after BuildHierarchy().
+    bool                        IsAABBOccluded(const Mat4 &viewProjMatrix, const AABB &aabb) const;
+
+    bool                        HasOccluders() const { return numRasterizedTris > 0; }
+
+    int                         NumRasterizedTris() const { return numRasterizedTris; }
+
+private:
+    void                        TransformVerts(const Mat4 &modelViewProjMatrix, const VertexGenericLit *verts, int numVerts);
+    void                        RasterizeTriangle(const Vec4 &v0, const Vec4 &v1, const Vec4 &v2);
+
+    float *                     depthBuffer;        ///< Width * Height 1/w depths, 16 bytes aligned rows
+    float                       tileMinDepths[NumTilesX * NumTilesY];   ///< Farthest depth in each tile
+    Array<Vec4>                 screenVerts;        ///< Temporary screen space verts (x, y, 1/w, w)
+    float                       minClipW;           ///< Near plane distance in clip w
+    int                         numRasterizedTris;
+};
+
+BE_NAMESPACE_END
@@ -14,7 +14,11 @@
 
 #pragma once
 
+#ifdef USE_NULL_RHI
+#include "RHI/RHINull.h"
+#else
 #include "RHI/RHIOpenGL.h"
+#endif
 #include "Render/BufferCache.h"
 #include "Render/Texture.h"
 #include "Render/Shader.h"
@@ -24,6 +28,7 @@
 #include "Render/Skeleton.h"
 #include "Render/SubMesh.h"
 #include "Render/Mesh.h"
+#include "Render/OcclusionBuffer.h"
 #include "Render/ParticleMesh.h"
 #include "Render/GuiMesh.h"
 #include "Render/Anim.h"
@@ -69,6 +69,16 @@ struct RenderCounter {
 
     unsigned int            numShadowMapDraw;
     unsigned int            numSkinningEntities;
+
+    unsigned int            occluderTris;
+    unsigned int            occlusionCulledSurfs;
+    unsigned int            occlusionCulledShadowCasters;
+
+    unsigned int            rhiDrawCalls;
+    unsigned int            stateChanges;
+    unsigned int            textureBinds;
+    unsigned int            shaderConstantCalls;
+    unsigned int            constantBlockBinds;
 };
 
 class Image;
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include "Platform/PlatformThread.h"
+
 BE_NAMESPACE_BEGIN
 
 /*
@@ -21,6 +23,12 @@ BE_NAMESPACE_BEGIN
 
     Render System
 
+    In SMP mode (r_smp), the back end commands of a frame are executed on
+    the render thread while the game and the front end run the next frame.
+    The rendering context is owned by the render thread during execution,
+    so any RHI calls on the main thread should be preceded by
+    SyncRenderThread(). RHI calls are not allowed on the other threads.
+
 -------------------------------------------------------------------------------
 */
 
@@ -60,7 +68,17 @@ public:
 
     void                    CheckModifiedCVars();
 
+                            /// Returns true if the back end is executed on the render thread.
+    bool                    IsRenderThreadEnabled() const { return renderThread != nullptr; }
+
+                            /// Waits until the render thread finishes the issued commands, and takes the rendering context back to the calling thread.
+                            /// Does nothing in serial mode or on the render thread. Must be called on the main thread.
+    void                    SyncRenderThread();
+
 private:
+    void                    ApplyModifiedCVars();
+    void                    StartRenderThread();
+    void                    StopRenderThread();
     void                    RecreateScreenMapRT();
     void                    RecreateHDRMapRT();
     void                    RecreateShadowMapRT();
@@ -79,11 +97,22 @@ private:
     RenderContext *         currentContext;
     RenderContext *         mainContext;
 
+    PlatformThread *        renderThread;
+    PlatformMutex *         renderThreadMutex;
+    PlatformCondition *     renderThreadCondition;      ///< Signaled when the commands are issued or executed
+    const void *            renderThreadCommands;       ///< Commands being executed on the render thread. nullptr if idle.
+    RHI::Handle             renderThreadContextHandle;
+    bool                    renderThreadOwnsContext;
+    bool                    renderThreadTerminate;
+
+    friend void             RenderSystem_ThreadProc(void *param);
+
     static void             Cmd_ScreenShot(const CmdArgs &args);    
 };
 
 BE_INLINE RenderSystem::RenderSystem() {
     initialized = false;
+    renderThread = nullptr;
 }
 
 extern RenderSystem         renderSystem;
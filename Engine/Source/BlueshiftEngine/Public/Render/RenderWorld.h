@@ -27,7 +27,10 @@ BE_NAMESPACE_BEGIN
 */
 
 class DrawSurf;
+class OcclusionBuffer;
 struct view_t;
+struct drawSurfNode_t;
+struct instanceData_t;
 
 // Proxy node in the dynamic bounding volume tree
 struct DbvtProxy {
@@ -102,9 +105,15 @@ public:
     void                        DebugJoints(const SceneEntity *ent, bool showJointsNames, const Mat3 &viewAxis);
 
 private:
+    enum { MaxCullSubTrees = 64 };
+
+    template <typename Func>
+    int                         CullProxies(const DynamicAABBTree &dbvt, const view_t *view, const Func &isVisible);
+
     viewEntity_t *              RegisterViewEntity(view_t *view, SceneEntity *sceneEntity);
     viewLight_t *               RegisterViewLight(view_t *view, SceneLight *sceneLight);
     void                        FindViewLightsAndEntities(view_t *view);
+    void                        RenderOccluders(view_t *view);
     void                        AddStaticMeshes(view_t *view);
     void                        AddSkinnedMeshes(view_t *view);
     void                        AddParticleMeshes(view_t *view);
@@ -113,8 +122,13 @@ private:
     void                        AddStaticMeshesForLights(view_t *view);
     void                        AddSkinnedMeshesForLights(view_t *view);
     void                        OptimizeLights(view_t *view);
+    void                        UpdateSkinningJointCache(viewEntity_t *viewEntity);
     void                        AddDrawSurf(view_t *view, viewEntity_t *entity, const Material *material, SubMesh *subMesh, int flags);
+    void                        SkinCpuSkinnedSurfs();
     void                        SortDrawSurfs(view_t *view);
+    void                        BuildInstancedDrawSurfs(view_t *view);
+    static bool                 IsSameInstance(const DrawSurf *a, const DrawSurf *b);
+    static void                 InstanceDrawSurfNodes(const view_t *view, drawSurfNode_t **nodes, const DrawSurf *const *surfs, int numNodes, bool shadowCaster, Array<instanceData_t> &instanceData);
 
     void                        RenderView(view_t *view);
     void                        RenderSubView(viewEntity_t *viewEntity, const DrawSurf *drawSurf, const Material *material);
@@ -145,6 +159,22 @@ private:
     DynamicAABBTree             entityDbvt;         ///< Dynamic bounding volume tree for entities
     DynamicAABBTree             staticMeshDbvt;     ///< Dynamic bounding volume tree for static meshes
     DynamicAABBTree             lightDbvt;          ///< Dynamic bounding volume tree for lights and reflection probes
+
+    Array<int32_t>              culledProxyIds[MaxCullSubTrees];    ///< Visible proxy ids found in each DBVT sub-tree by CullProxies()
+
+    OcclusionBuffer *           occlusionBuffer;    ///< Software depth buffer of occluders rasterized by RenderOccluders()
+
+    Array<uint64_t>             drawSurfSortKeys;   ///< Sort keys and temporary keys used by SortDrawSurfs()
+    Array<DrawSurf *>           tempDrawSurfs;      ///< Temporary drawSurfs used by SortDrawSurfs()
+    Array<drawSurfNode_t *>     tempDrawSurfNodes;  ///< Shadow caster nodes and temporary nodes sorted by BuildInstancedDrawSurfs()
+
+    struct CpuSkinningSurf {
+        SubMesh *               subMesh;
+        const Mat3x4 *          skinningJoints;
+        int                     firstVert;          ///< Offset in the vertex block allocated by SkinCpuSkinnedSurfs()
+        int                     firstIndex;         ///< Offset in the index block allocated by SkinCpuSkinnedSurfs()
+    };
+    Array<CpuSkinningSurf>      cpuSkinningSurfs;   ///< CPU skinned sub meshes collected by AddDrawSurf()
 };
 
 BE_NAMESPACE_END
@@ -142,6 +142,7 @@ public:
     Mat4                    modelMatrix;
     Mat4                    motionBlurModelMatrix[2];
     int                     viewCount;
+    float                   viewDistance;               // distance from the origin of the view registered last
     viewEntity_t *          viewEntity;
     DbvtProxy *             proxy;
     int                     numMeshSurfProxies;
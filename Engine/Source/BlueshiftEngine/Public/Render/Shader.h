@@ -27,6 +27,7 @@
 #include "Core/Property.h"
 #include "Core/CmdArgs.h"
 #include "RHI/RHI.h"
+#include "Platform/PlatformThread.h"
 
 BE_NAMESPACE_BEGIN
 
@@ -40,6 +41,7 @@ public:
     enum Flag {
         LitSurface              = BIT(0),
         SkySurface              = BIT(1),
+        Instancing              = BIT(2),
         LoadedFromFile          = BIT(8)
     };
 
@@ -66,12 +68,57 @@ public:
         LocalViewOriginConst,
         LocalLightOriginConst,
         LocalLightAxisConst,
+        PrevModelViewProjectionMatrixConst,
+        ShutterSpeedConst,
+        PerforatedAlphaConst,
+        AmbientScaleConst,
+        AmbientLerpConst,
+        JointsConst,
+        TcBaseConst,
+        InvJointsMapSizeConst,
+        JointIndexOffsetCurrConst,
+        JointIndexOffsetPrevConst,
+        LightInvRadiusConst,
+        LightFallOffExponentConst,
+        LightTextureMatrixConst,
+        LightColorConst,
+        RemoveBackProjectionConst,
+        ShadowProjectionDepthConst,
+        VscmBiasedScaleConst,
+        ShadowProjMatrixConst,
+        ShadowCascadeProjMatrixConst,
+        ShadowSplitFarConst,
+        CascadeBlendSizeConst,
+        ShadowMapFilterSizeConst,
+        ShadowMapTexelSizeConst,
+        FogColorConst,
+        BlendColorConst,
         MaxBuiltInConstants
     };
 
+    enum BuiltInConstantBlock {
+        JointsBlock,
+        InstanceDataBlock,
+        MaxBuiltInConstantBlocks
+    };
+
     enum BuiltInSampler {
         AlbedoMapSampler,
         NormalMapSampler,
+        DepthMapSampler,
+        JointsMapSampler,
+        EnvCubeMapSampler,
+        IntegrationLUTMapSampler,
+        IrradianceEnvCubeMap0Sampler,
+        IrradianceEnvCubeMap1Sampler,
+        PrefilteredEnvCubeMap0Sampler,
+        PrefilteredEnvCubeMap1Sampler,
+        CubicNormalCubeMapSampler,
+        IndirectionCubeMapSampler,
+        ShadowMapSampler,
+        ShadowArrayMapSampler,
+        RandomRotMatMapSampler,
+        LightProjectionMapSampler,
         MaxBuiltInSamplers
     };
 
@@ -118,6 +165,7 @@ public:
     Shader *                GetSpotShadowVersion();
     Shader *                GetPointShadowVersion();
     Shader *                GetGPUSkinningVersion(int index);
+    Shader *                GetInstancingVersion();
 
     void                    Bind() const;
 
@@ -185,8 +233,11 @@ public:
     void                    SetConstantArray3x3f(const char *name, bool rowmajor, int num, const Mat3 *constant) const;
     void                    SetConstantArray4x4f(const char *name, bool rowmajor, int num, const Mat4 *constant) const;
 
-    void                    SetConstantBuffer(int index, RHI::Handle bufferHandle) const;
-    void                    SetConstantBuffer(const char *name, RHI::Handle bufferHandle) const;
+    int                     GetConstantBlockIndex(const char *name) const;
+
+                            /// Binds the uniform buffer range starting at the offset to the constant block. Shader should be bound first.
+    void                    SetConstantBuffer(int index, RHI::Handle bufferHandle, int offset) const;
+    void                    SetConstantBuffer(const char *name, RHI::Handle bufferHandle, int offset) const;
 
     int                     GetSamplerUnit(const char *name) const;
 
@@ -205,14 +256,18 @@ public:
     const StrHashMap<PropertySpec> &GetSpecHashMap() const;
 
 private:
+    Shader *                InstantiateVersion(Shader *&version, Shader *originalVersion);
     bool                    ParseProperties(Lexer &lexer);
     Shader *                GenerateSubShader(const Str &shaderNamePostfix, const Str &vsHeaderText, const Str &fsHeaderText, int skinning);
     bool                    GenerateGpuSkinningVersion(Shader *shader, const Str &shaderNamePrefix, const Str &vpText, const Str &fpText);
     bool                    GeneratePerforatedVersion(Shader *shader, const Str &shaderNamePrefix, const Str &vpText, const Str &fpText, bool generateGpuSkinningVersion);
     bool                    GeneratePremulAlphaVersion(Shader *shader, const Str &shaderNamePrefix, const Str &vpText, const Str &fpText, bool generateGpuSkinningVersion);
+    bool                    GenerateInstancingVersion(Shader *shader, const Str &shaderNamePrefix, const Str &vpText, const Str &fpText, bool generatePerforatedVersion);
     bool                    Instantiate(const Array<Define> &defineArray);  // internal function of instantiate
+                            /// Compiles the instantiated shader with the define list. Called on the first bind if compiling is deferred.
+    bool                    Compile();
 
-    bool                    Finish(bool generatePerforatedVersion, bool genereatePremulAlphaVersion, bool genereateGpuSkinningVersion, bool generateParallelShadowVersion, bool generateSpotShadowVersion, bool generatePointShadowVersion, const char *baseDir);
+    bool                    Finish(bool generatePerforatedVersion, bool genereatePremulAlphaVersion, bool genereateGpuSkinningVersion, bool generateParallelShadowVersion, bool generateSpotShadowVersion, bool generatePointShadowVersion, bool generateInstancingVersion, const char *baseDir);
     bool                    ProcessShaderText(const char *text, const char *baseDir, const Array<Define> &defineArray, Str &outStr) const;
     bool                    ProcessIncludeRecursive(const char *baseDir, Str &text) const;
 
@@ -231,9 +286,12 @@ private:
     Str                     fsText;                 ///< Fragment shader source code text
     bool                    hasVertexShader;
     bool                    hasFragmentShader;
+    bool                    needsCompile;           ///< Instantiated shader is not compiled yet
     //int                   interactionParms[MaxInteractionParms];
     int                     builtInConstantLocations[MaxBuiltInConstants];
+    int                     builtInConstantBlockIndexes[MaxBuiltInConstantBlocks];
     int                     builtInSamplerUnits[MaxBuiltInSamplers];
+    Array<int>              propertyLocations;      ///< Constant location or sampler unit of each property spec in the order of GetSpecHashMap()
 
     Array<Define>           defineArray;            ///< Define list for instantiated shader
 
@@ -249,6 +307,7 @@ private:
     Shader *                spotShadowVersion;
     Shader *                pointShadowVersion;
     Shader *                gpuSkinningVersion[3];
+    Shader *                instancingVersion;
 
     StrHashMap<PropertySpec> specHashMap;
 };
@@ -261,6 +320,7 @@ BE_INLINE Shader::Shader() {
     shaderHandle            = RHI::NullShader;
     hasVertexShader         = false;
     hasFragmentShader       = false;
+    needsCompile            = false;
     perforatedVersion       = nullptr;
     premulAlphaVersion      = nullptr;
     ambientLitVersion       = nullptr;
@@ -272,6 +332,7 @@ BE_INLINE Shader::Shader() {
     gpuSkinningVersion[0]   = nullptr;
     gpuSkinningVersion[1]   = nullptr;
     gpuSkinningVersion[2]   = nullptr;
+    instancingVersion       = nullptr;
     originalShader          = nullptr;
 }
 
@@ -283,6 +344,13 @@ class ShaderManager {
     friend class Shader;
 
 public:
+                            /// Locks the shader manager while in scope. Shaders are instantiated lazily in the render thread as well.
+    class ScopedLock {
+    public:
+        ScopedLock();
+        ~ScopedLock();
+    };
+
     enum PredefinedOriginalShader {
         DrawArrayTextureShader,
         SimpleShader,
@@ -351,6 +419,10 @@ public:
     void                    ReloadShaders();
     void                    ReloadLitSurfaceShaders();
 
+                            /// Waits for the render thread before locking, so the game thread never waits for the render thread holding the lock.
+    void                    Lock() const;
+    void                    Unlock() const;
+
     bool                    FindGlobalHeader(const char *text) const;
     void                    AddGlobalHeader(const char *text);
     void                    RemoveGlobalHeader(const char *text);
@@ -361,6 +433,7 @@ public:
     static Shader *         simpleShader;
     static Shader *         selectionIdShader;
     static Shader *         depthShader;
+    static Shader *         shadowDepthShader;
     static Shader *         constantColorShader;
     static Shader *         vertexColorShader;
     static Shader *         objectMotionBlurShader;
@@ -420,8 +493,20 @@ private:
     StrIHashMap<Shader *>   shaderHashMap;
 
     StrArray                globalHeaderList;
+
+    StrHashMap<Str>         includeTextCache;       ///< Include file path to the text with nested includes expanded
+
+    PlatformMutex *         mutex = nullptr;        ///< Guards shaderHashMap, instantiatedShaders and includeTextCache
 };
 
 extern ShaderManager        shaderManager;
 
+BE_INLINE ShaderManager::ScopedLock::ScopedLock() {
+    shaderManager.Lock();
+}
+
+BE_INLINE ShaderManager::ScopedLock::~ScopedLock() {
+    shaderManager.Unlock();
+}
+
 BE_NAMESPACE_END
@@ -57,6 +57,7 @@ class SubMesh {
     friend class MeshManager;
     friend class RenderWorld;
     friend class RBSurf;
+    friend class DrawSurf;
     friend class ::MeshImporter;
     
 public:
@@ -104,16 +105,32 @@ public:
     const Vec3              ComputeCentroid() const;
     const Mat3              ComputeInertiaTensor(const Vec3 &centroid, float mass) const;
 
-    void                    OptimizeIndexedTriangles();
+                            /// Reorders triangles for post-transform vertex cache and vertices for vertex fetch.
+                            /// If optimizeOverdraw is true, triangle clusters are reordered to reduce overdraw as well.
+                            /// Must be called before computing tangents and edges.
+    void                    OptimizeIndexedTriangles(bool optimizeOverdraw = false);
+
+                            /// Returns average cache miss ratio (transformed vertices per triangle) with FIFO vertex cache of the given size
+    float                   ComputeACMR(int cacheSize) const;
 
     bool                    IsGpuSkinning() const { return useGpuSkinning; }
+    bool                    IsCpuSkinning() const { return useCpuSkinning; }
 
     void                    CacheStaticDataToGpu();
     void                    CacheDynamicDataToGpu(const Mat3x4 *joints, const Material *material);
 
+                            /// Writes skinned vertices into dstVerts for CPU skinning.
+                            /// Normals and tangents are skinned with positions, so tangents are not recomputed.
+                            /// If skinningJoints is nullptr, vertices in the bind pose are written.
+                            /// Safe to call from the worker threads.
+    void                    SkinVerts(const Mat3x4 *skinningJoints, VertexGenericLit *dstVerts) const;
+
+                            /// Writes indexes offset by baseVertex into dstIndexes.
+    void                    WriteIndexes(int baseVertex, TriIndex *dstIndexes) const;
+
 private:
     void                    AllocSubMesh(int numVerts, int numIndexes);
-    void                    AllocInstantiatedSubMesh(const SubMesh *refMesh, int meshType);
+    void                    AllocInstantiatedSubMesh(const SubMesh *refMesh, int meshType, bool gpuSkinning);
     void                    FreeSubMesh();
 
     void                    SplitMirroredVerts();
@@ -152,7 +169,9 @@ private:
 
     void *                  vertWeights;                // GPU skinning 용 vertex weights (numVerts * sizeof(VertexWeightX))
     bool                    useGpuSkinning;
+    bool                    useCpuSkinning;             // vertWeights 로 CPU 에서 skinning 해서 dynamic buffer 에 쓴다
     int                     gpuSkinningVersionIndex;    // 0: VertexWeight1, 1: VertexWeight4, 2: VertexWeight8
+    int                     cpuSkinningViewCount;       // viewCount of the view that collected this sub mesh for CPU skinning
 
     AABB                    aabb;
 
@@ -162,6 +181,7 @@ private:
 
 BE_INLINE SubMesh::SubMesh() {
     alloced = false;
+    cpuSkinningViewCount = 0;
 }
 
 BE_INLINE SubMesh::~SubMesh() {
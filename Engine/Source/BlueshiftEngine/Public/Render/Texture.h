@@ -30,6 +30,8 @@
 
 BE_NAMESPACE_BEGIN
 
+class FileMapping;
+
 class Texture {
     friend class TextureManager;
     friend class RenderTarget;
@@ -53,6 +55,7 @@ public:
         LowPriority         = BIT(13),
         SRGB                = BIT(14),      ///< generally color image is encoded in sRGB
         Trilinear           = BIT(15),
+        Cooked              = BIT(16),      ///< image is already cooked by CookImage, so upload it as it is
         HighQuality         = NoScaleDown | NoCompression,
         CubeMap             = BIT(28),      ///< cube map
         CameraCubeMap       = BIT(29),
@@ -113,6 +116,25 @@ public:
     bool                    Load(const char *filename, int flags);
     bool                    Reload();
 
+                            /// Loads image of the texture file without creating texture. Can be called from any thread.
+    static bool             LoadTextureImage(const char *filename, int flags, Image &image, RHI::TextureType &textureType);
+
+                            /// Loads image of the texture file through the texture cache. Can be called from any thread.
+                            /// Cooked flag is added to flags if the image is cooked. Cooked image may point to fileMapping,
+                            /// so keep fileMapping opened until the image is uploaded.
+    static bool             LoadCookedTextureImage(const char *filename, int &flags, Image &image, RHI::TextureType &textureType, FileMapping &fileMapping);
+
+                            /// Cooks image into the final form to upload with the current texture settings.
+                            /// Returns false if the image can't be cooked.
+    static bool             CookImage(RHI::TextureType type, const Image &srcImage, int flags, Image &cookedImage);
+
+                            /// Computes format and size of the texture to upload the image with the current texture settings.
+    static void             GetUploadFormatAndSize(RHI::TextureType type, int flags, Image::Format srcFormat, int srcWidth, int srcHeight, int srcDepth,
+                                Image::Format &dstFormat, int &dstWidth, int &dstHeight, int &dstDepth);
+
+                            /// Returns source filenames of the texture file. Cube map may be loaded from 6 face files.
+    static int              GetSourceFilenames(const char *filename, int flags, Str filenames[6]);
+
     const Texture *         AddRefCount() const { refCount++; return this; }
 
     void                    Bind() const;
@@ -191,6 +213,9 @@ public:
     Texture *               AllocTexture(const char *name);
     Texture *               FindTexture(const char *name) const;
     Texture *               GetTexture(const char *name, int creationFlags = 0);
+                            /// Returns placeholder texture immediately, and fills it in when the async loading is finished.
+                            /// Loads synchronously if async loading is disabled.
+    Texture *               GetTextureAsync(const char *name, int priority, int creationFlags = 0);
 
     Texture *               TextureFromGenerator(const char *name, const TextureGeneratorBase &generator);
 
@@ -231,6 +256,7 @@ public:
     static CVar             texture_useCompression;
     static CVar             texture_useNormalCompression;
     static CVar             texture_mipLevel;
+    static CVar             texture_cache;
 
 private:
     int                     LoadTextureInfo(const char *filename) const;
@@ -238,6 +264,8 @@ private:
     static void             Cmd_ListTextures(const CmdArgs &args);
     static void             Cmd_ReloadTexture(const CmdArgs &args);
     static void             Cmd_ConvertNormalAR2RGB(const CmdArgs &args);
+    static void             Cmd_CookTextures(const CmdArgs &args);
+    static void             Cmd_ClearTextureCache(const CmdArgs &args);
 
     friend void             RB_DrawDebugTextures();
 
@@ -0,0 +1,78 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/*
+-------------------------------------------------------------------------------
+
+    Cooked texture cache
+
+    Texture images are cooked into the final form to upload (scaled down,
+    mipmapped and compressed to the GPU format) and written to the cache
+    directory. The cache file is named after the texture name and load flags,
+    and its header records the size and modification time of the source files
+    and the texture settings. Out of date cache files are cooked again on load.
+    Cache files are used as they are if the source files are not shipped.
+
+    Pixel data is stored in the same layout as Image (all the mipmaps of each
+    slice), so the cooked image is uploaded from the mapped file directly.
+
+-------------------------------------------------------------------------------
+*/
+
+#include "Platform/PlatformAtomic.h"
+#include "Image/Image.h"
+#include "RHI/RHI.h"
+
+BE_NAMESPACE_BEGIN
+
+class FileMapping;
+
+class TextureCache {
+public:
+    void                    Init();
+    void                    Shutdown();
+
+                            /// Returns true if the texture cache is enabled.
+    bool                    IsEnabled() const;
+
+                            /// Maps the cooked image of the texture file. Returns false if the cache file is missing or out of date.
+                            /// Pixels of the image point to the mapped file, so keep fileMapping opened until the image is uploaded.
+                            /// Can be called from any thread.
+    bool                    Load(const char *filename, int flags, Image &image, RHI::TextureType &textureType, FileMapping &fileMapping);
+
+                            /// Writes the cooked image of the texture file. Can be called from any thread.
+    bool                    Write(const char *filename, int flags, RHI::TextureType textureType, const Image &srcImage, const Image &cookedImage);
+
+                            /// Removes all the cache files.
+    void                    Clear();
+
+    int                     NumHits() const { return numHits.GetValue(); }
+    int                     NumMisses() const { return numMisses.GetValue(); }
+
+private:
+    Str                     CacheFilename(const char *filename, int flags) const;
+
+    static uint32_t         SourceStamp(const char *filename, int flags);
+    static uint32_t         SettingsHash(int flags);
+
+    Str                     cacheDir;
+    PlatformAtomic          numHits;
+    PlatformAtomic          numMisses;
+};
+
+extern TextureCache         textureCache;
+
+BE_NAMESPACE_END
@@ -83,7 +83,7 @@ BE_FORCE_INLINE const sseb unpackhi(const sseb &a, const sseb &b) { return _mm_u
 
 // 한개의 4 packed 32 bit operand 에 대한 shuffle. 4 개의 2 bit index 를 이용한다.
 template <size_t i0, size_t i1, size_t i2, size_t i3> BE_FORCE_INLINE const sseb shuffle(const sseb &a) {
-    return _mm_shuffle_epi32(a, _MM_SHUFFLE(i3, i2, i1, i0));
+    return _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(a), _MM_SHUFFLE(i3, i2, i1, i0)));
 }
 
 // 두개의 4 packed 32 bit operand 에 대한 shuffle. 4 개의 2 bit index 를 이용한다.
@@ -42,6 +42,8 @@ public:
     virtual void BE_FASTCALL            MatrixTranspose(float *dst, const float *src);
     virtual void BE_FASTCALL            MatrixMultiply(float *dst, const float *src0, const float *src1);
 
+    virtual void BE_FASTCALL            SkinVerts(VertexGenericLit *dstVerts, const VertexGenericLit *srcVerts, const int numVerts, const void *vertWeights, const int numWeights, const Mat3x4 *joints);
+
     /*virtual void BE_FASTCALL            BlendJoints(JointPose *joints, const JointPose *blendJoints, const float fraction, const int *index, const int numJoints);
     virtual void BE_FASTCALL            BlendJointsFast(JointPose *joints, const JointPose *blendJoints, const float fraction, const int *index, const int numJoints);
     virtual void BE_FASTCALL            ConvertJointPosesToJointMats(Mat3x4 *jointMats, const JointPose *jointPoses, const int numJoints);
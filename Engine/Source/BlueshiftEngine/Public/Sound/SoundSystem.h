@@ -41,6 +41,7 @@
 BE_NAMESPACE_BEGIN
 
 class CmdArgs;
+class AsyncLoadRequest;
 class SoundBuffer;
 class SoundSource;
 class Sound;
@@ -132,6 +133,7 @@ public:
 class Sound {
     friend class SoundSource;
     friend class SoundSystem;
+    friend class SoundLoadRequest;
 
 public:
     Sound();
@@ -176,10 +178,16 @@ public:
 
     bool                    Reload();
 
+                            /// Opens PCM file, and decodes it entirely if it's short enough for the static buffer.
+                            /// Thread-safe, shared by the synchronous loading and the prefetching.
+    static bool             LoadPcm(const char *filename, Pcm &pcm);
+
 private:
     void                    CreateStatic(Pcm &pcm);
     void                    CreateStream(Pcm &pcm);
     void                    DuplicateFrom(Sound *sound);
+                            /// Duplicates this sound again to the duplicated sounds
+    void                    UpdateDuplicatedSounds();
 
     Str                     hashName;
     Str                     name;
@@ -213,6 +221,7 @@ private:
 
 class SoundSystem {
     friend class Sound;
+    friend class SoundLoadRequest;
     friend class SoundBuffer;
     friend class SoundSource;
 
@@ -228,6 +237,9 @@ public:
     Sound *                 AllocSound(const char *name);
     Sound *                 FindSound(const char *name) const;
     Sound *                 GetSound(const char *name);
+                            /// Starts loading the sound asynchronously. GetSound() completes the loading if it's not finished yet.
+                            /// Sounds are prefetched instead of replaced by placeholders, because the sound buffers can't be replaced while playing.
+    void                    PrefetchSound(const char *name, int priority);
 
     void                    RenameSound(Sound *sound, const Str &newName);
 
@@ -262,6 +274,7 @@ private:
     bool                    initialized;
 
     StrIHashMap<Sound *>    soundHashMap;
+    StrIHashMap<AsyncLoadRequest *> soundLoadRequests;  ///< Prefetching sounds
     LinkList<Sound>         soundPlayLinkList;
 
     Array<SoundSource *>    sources;
@@ -16,6 +16,10 @@
 #include "TestContainer.h"
 #include "TestMath.h"
 #include "TestSIMD.h"
+#include "TestTask.h"
+#include "TestImage.h"
+#include "TestMesh.h"
+#include "TestOcclusion.h"
 #include "TestCUDA.h"
 #include "TestLua.h"
 
@@ -45,6 +49,14 @@ int main(int argc, char *argv[]) {
     
     TestSIMD();
 
+    TestTask();
+
+    TestImage();
+
+    TestMesh();
+
+    TestOcclusion();
+
 #if TEST_CUDA
     bool cudaSupported = MyCuda::Init();
     
@@ -64,6 +64,39 @@ static void TestHashLinkMap() {
     }
 }
 
+static void TestRadixSort() {
+    const int count = 10000;
+    BE1::Array<uint64_t> keys;
+    BE1::Array<int> values;
+    keys.SetCount(count);
+    values.SetCount(count);
+
+    // Only some of the key bits are populated
+    for (int i = 0; i < count; i++) {
+        keys[i] = ((uint64_t)(rand() & 0xFF) << 40) | (uint64_t)(rand() & 0xF);
+        values[i] = i;
+    }
+
+    BE1::Array<uint64_t> sortedKeys = keys;
+    BE1::Array<int> sortedValues = values;
+    BE1::Array<uint64_t> tempKeys;
+    BE1::Array<int> tempValues;
+    tempKeys.SetCount(count);
+    tempValues.SetCount(count);
+
+    BE1::RadixSort(sortedKeys.Ptr(), sortedValues.Ptr(), count, tempKeys.Ptr(), tempValues.Ptr());
+
+    for (int i = 0; i < count; i++) {
+        assert(sortedKeys[i] == keys[sortedValues[i]]);
+        if (i > 0) {
+            assert(sortedKeys[i - 1] <= sortedKeys[i]);
+            // stable
+            assert(sortedKeys[i - 1] != sortedKeys[i] || sortedValues[i - 1] < sortedValues[i]);
+        }
+    }
+}
+
 void TestContainer() {
     TestHashLinkMap();
+    TestRadixSort();
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestImage.h"
+
+#define TEST_IMAGE_SIZE     512
+
+static void GenerateTestImage(BE1::Image &image) {
+    int numMipmaps = BE1::Image::MaxMipMapLevels(TEST_IMAGE_SIZE, TEST_IMAGE_SIZE, 1);
+    image.Create2D(TEST_IMAGE_SIZE, TEST_IMAGE_SIZE, numMipmaps, BE1::Image::RGBA_8_8_8_8, nullptr, 0);
+
+    // Gradients with noise to keep the encoders busy
+    byte *dst = image.GetPixels();
+    for (int y = 0; y < TEST_IMAGE_SIZE; y++) {
+        for (int x = 0; x < TEST_IMAGE_SIZE; x++) {
+            int noise = (int)BE1::Math::Random(0.0f, 32.0f);
+            dst[0] = (byte)BE1::Min(x * 255 / TEST_IMAGE_SIZE + noise, 255);
+            dst[1] = (byte)BE1::Min(y * 255 / TEST_IMAGE_SIZE + noise, 255);
+            dst[2] = (byte)(((x >> 4) ^ (y >> 4)) & 1 ? 224 : 32);
+            dst[3] = (byte)((x + y) & 255);
+            dst += 4;
+        }
+    }
+
+    image.GenerateMipmaps();
+}
+
+static void BenchmarkCompression(const BE1::Image &srcImage, BE1::Image::Format format, BE1::Image::CompressionQuality quality) {
+    static const wchar_t *qualityNames[] = { L"Fast", L"Normal", L"HighQuality" };
+
+    BE1::Image dstImage;
+
+    uint64_t startTime = BE1::PlatformTime::Microseconds();
+    srcImage.ConvertFormat(format, dstImage, false, quality);
+    uint64_t endTime = BE1::PlatformTime::Microseconds();
+
+    int numPixels = 0;
+    for (int mipLevel = 0; mipLevel < srcImage.NumMipmaps(); mipLevel++) {
+        numPixels += srcImage.GetWidth(mipLevel) * srcImage.GetHeight(mipLevel);
+    }
+
+    double seconds = BE1::Max(endTime - startTime, (uint64_t)1) / 1000000.0;
+    BE_LOG(L"%hs %ls: %.2f MPixels/s\n", BE1::Image::FormatName(format), qualityNames[quality], numPixels / seconds / 1000000.0);
+
+    // Output should not depend on the scheduling of the compression tasks
+    if (quality == BE1::Image::Fast) {
+        BE1::Image dstImage2;
+        srcImage.ConvertFormat(format, dstImage2, false, quality);
+
+        const int size = dstImage.GetSize(0, dstImage.NumMipmaps());
+        assert(size == dstImage2.GetSize(0, dstImage2.NumMipmaps()));
+        assert(memcmp(dstImage.GetPixels(), dstImage2.GetPixels(), size) == 0);
+    }
+}
+
+void TestImage() {
+    BE_LOG(L"Benchmarking texture compression..\n");
+
+    BE1::Image srcImage;
+    GenerateTestImage(srcImage);
+
+    static const BE1::Image::Format formats[] = {
+        BE1::Image::RGBA_DXT1,
+        BE1::Image::RGBA_DXT3,
+        BE1::Image::RGBA_DXT5,
+        BE1::Image::DXN2,
+        BE1::Image::RGB_8_ETC1,
+        BE1::Image::RGB_8_ETC2,
+        BE1::Image::RGBA_8_8_ETC2,
+        BE1::Image::RGBA_8_1_ETC2
+    };
+
+    for (int i = 0; i < COUNT_OF(formats); i++) {
+        BenchmarkCompression(srcImage, formats[i], BE1::Image::Fast);
+        BenchmarkCompression(srcImage, formats[i], BE1::Image::Normal);
+        BenchmarkCompression(srcImage, formats[i], BE1::Image::HighQuality);
+    }
+}
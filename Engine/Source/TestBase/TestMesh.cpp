@@ -0,0 +1,108 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "BlueshiftEngine.h"
+#include "TestMesh.h"
+
+#define TEST_GRID_SIZE      100
+#define TEST_CACHE_SIZE     16
+
+// Grid of quads with the triangles in random order
+static void GenerateShuffledGrid(BE1::SubMesh *subMesh) {
+    BE1::VertexGenericLit *v = subMesh->Verts();
+    for (int y = 0; y <= TEST_GRID_SIZE; y++) {
+        for (int x = 0; x <= TEST_GRID_SIZE; x++) {
+            v->Clear();
+            v->SetPosition(BE1::Vec3((float)x, (float)y, 0.0f));
+            v++;
+        }
+    }
+
+    BE1::TriIndex *idx = subMesh->Indexes();
+    for (int y = 0; y < TEST_GRID_SIZE; y++) {
+        for (int x = 0; x < TEST_GRID_SIZE; x++) {
+            int v0 = y * (TEST_GRID_SIZE + 1) + x;
+            int v1 = v0 + 1;
+            int v2 = v0 + TEST_GRID_SIZE + 1;
+            int v3 = v2 + 1;
+
+            *idx++ = v0; *idx++ = v1; *idx++ = v3;
+            *idx++ = v0; *idx++ = v3; *idx++ = v2;
+        }
+    }
+
+    BE1::Random random(1);
+    BE1::TriIndex *indexes = subMesh->Indexes();
+    int numTris = subMesh->NumIndexes() / 3;
+    for (int i = numTris - 1; i > 0; i--) {
+        int j = random.RandomInt(i + 1);
+        for (int k = 0; k < 3; k++) {
+            BE1::Swap(indexes[i * 3 + k], indexes[j * 3 + k]);
+        }
+    }
+}
+
+// Sum of the triangle vertex positions, which doesn't depend on the order of the triangles and vertices.
+// Positions are integers, so the sum is exact in double precision.
+static void SumTrianglePositions(const BE1::SubMesh *subMesh, double sum[2]) {
+    const BE1::VertexGenericLit *verts = subMesh->Verts();
+    const BE1::TriIndex *indexes = subMesh->Indexes();
+
+    sum[0] = 0.0;
+    sum[1] = 0.0;
+    for (int i = 0; i < subMesh->NumIndexes(); i++) {
+        const BE1::Vec3 p = verts[indexes[i]].GetPosition();
+        sum[0] += p.x;
+        sum[1] += p.y;
+    }
+}
+
+void TestMesh() {
+    BE_LOG(L"Testing vertex cache optimization..\n");
+
+    const int numVerts = (TEST_GRID_SIZE + 1) * (TEST_GRID_SIZE + 1);
+    const int numIndexes = TEST_GRID_SIZE * TEST_GRID_SIZE * 6;
+
+    BE1::Mesh mesh;
+    BE1::MeshSurf *surf = mesh.AllocSurface(numVerts, numIndexes);
+    BE1::SubMesh *subMesh = surf->subMesh;
+
+    GenerateShuffledGrid(subMesh);
+
+    const float oldACMR = subMesh->ComputeACMR(TEST_CACHE_SIZE);
+    double oldSum[2];
+    SumTrianglePositions(subMesh, oldSum);
+
+    subMesh->OptimizeIndexedTriangles();
+
+    const float newACMR = subMesh->ComputeACMR(TEST_CACHE_SIZE);
+    double newSum[2];
+    SumTrianglePositions(subMesh, newSum);
+
+    BE_LOG(L"ACMR %.3f -> %.3f (%i tris, FIFO cache size %i)\n", oldACMR, newACMR, numIndexes / 3, TEST_CACHE_SIZE);
+
+    assert(subMesh->NumVerts() == numVerts && subMesh->NumIndexes() == numIndexes);
+    for (int i = 0; i < subMesh->NumIndexes(); i++) {
+        assert(subMesh->Indexes()[i] < (BE1::TriIndex)numVerts);
+    }
+
+    // Optimized mesh must have the same triangles
+    assert(newSum[0] == oldSum[0] && newSum[1] == oldSum[1]);
+
+    // A regular grid should get well below one vertex per triangle
+    assert(newACMR < oldACMR && newACMR <= 1.0f);
+
+    mesh.FreeSurface(surf);
+}
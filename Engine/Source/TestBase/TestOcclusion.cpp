@@ -0,0 +1,71 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "BlueshiftEngine.h"
+#include "TestOcclusion.h"
+
+#define TEST_OCCLUDER_DIST  10.0f
+#define TEST_OCCLUDER_SIZE  5.0375f  // right edge at 240.6 pixels
+
+static void CheckOccluded(const BE1::OcclusionBuffer &occlusionBuffer, const BE1::Mat4 &viewProjMatrix, const BE1::AABB &aabb, bool expected, const wchar_t *name) {
+    bool occluded = occlusionBuffer.IsAABBOccluded(viewProjMatrix, aabb);
+    BE_LOG(L"%ls box is %ls\n", name, occluded ? L"occluded" : L"visible");
+    assert(occluded == expected);
+}
+
+void TestOcclusion() {
+    BE_LOG(L"Testing software occlusion buffer..\n");
+
+    // View looks down the -z axis. The near plane is at 1 unit.
+    BE1::Mat4 viewProjMatrix;
+    viewProjMatrix.SetFrustum(-1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 1000.0f);
+
+    // Quad facing the view, covering the center half of the screen
+    BE1::VertexGenericLit verts[4];
+    for (int i = 0; i < 4; i++) {
+        verts[i].Clear();
+    }
+    verts[0].SetPosition(-TEST_OCCLUDER_SIZE, -TEST_OCCLUDER_SIZE, -TEST_OCCLUDER_DIST);
+    verts[1].SetPosition(+TEST_OCCLUDER_SIZE, -TEST_OCCLUDER_SIZE, -TEST_OCCLUDER_DIST);
+    verts[2].SetPosition(+TEST_OCCLUDER_SIZE, +TEST_OCCLUDER_SIZE, -TEST_OCCLUDER_DIST);
+    verts[3].SetPosition(-TEST_OCCLUDER_SIZE, +TEST_OCCLUDER_SIZE, -TEST_OCCLUDER_DIST);
+
+    const BE1::TriIndex indexes[6] = { 0, 1, 2, 0, 2, 3 };
+
+    BE1::OcclusionBuffer *occlusionBuffer = new BE1::OcclusionBuffer;
+    occlusionBuffer->Clear(1.0f);
+    occlusionBuffer->RasterizeMesh(viewProjMatrix, verts, COUNT_OF(verts), indexes, COUNT_OF(indexes));
+    occlusionBuffer->BuildHierarchy();
+
+    assert(occlusionBuffer->NumRasterizedTris() == 2);
+
+    // Behind the occluder, away from the diagonal the two triangles share
+    CheckOccluded(*occlusionBuffer, viewProjMatrix, BE1::AABB(BE1::Vec3(-4, 1, -22), BE1::Vec3(-2, 3, -20)), true, L"Fully occluded");
+
+    // Behind the occluder, sticking out of the right edge
+    CheckOccluded(*occlusionBuffer, viewProjMatrix, BE1::AABB(BE1::Vec3(6, -1, -22), BE1::Vec3(14, 1, -20)), false, L"Partially visible");
+
+    // Behind the occluder, sticking out of the right edge at 240.9 pixels, within the pixel the occluder edge passes.
+    // The center of that pixel is covered, but not the whole pixel.
+    CheckOccluded(*occlusionBuffer, viewProjMatrix, BE1::AABB(BE1::Vec3(8, -1, -20), BE1::Vec3(10.1125f, 1, -20)), false, L"Edge pixel");
+
+    // In front of the occluder
+    CheckOccluded(*occlusionBuffer, viewProjMatrix, BE1::AABB(BE1::Vec3(-1, -1, -6), BE1::Vec3(1, 1, -5)), false, L"Front");
+
+    // Crossing the near plane, in front of the occluder
+    CheckOccluded(*occlusionBuffer, viewProjMatrix, BE1::AABB(BE1::Vec3(-1, -1, -15), BE1::Vec3(1, 1, -0.5f)), false, L"Near plane crossing");
+
+    delete occlusionBuffer;
+}
@@ -446,6 +446,102 @@ static void TestMatrixTranspose() {
     PrintClocksSIMD(L"MatrixTranspose", bestClocksGeneric, bestClocksSIMD);
 }
 
+static void RandomVertexWeightsInit(BE1::VertexWeight8 *dst, int count, int numWeights, int numJoints) {
+    for (int i = 0; i < count; i++) {
+        // Weights are normalized to sum up to 255
+        int weightLeft = 255;
+        for (int j = 0; j < numWeights; j++) {
+            dst[i].jointIndexes[j] = rand() % numJoints;
+            dst[i].jointWeights[j] = j == numWeights - 1 ? weightLeft : rand() % (weightLeft + 1);
+            weightLeft -= dst[i].jointWeights[j];
+        }
+    }
+}
+
+static void TestSkinVerts() {
+    const int numVerts = 1024;
+    const int numJoints = 64;
+    const int testCount = 64;
+    uint64_t bestClocksGeneric;
+    uint64_t bestClocksSIMD;
+
+    BE1::Mat3x4 *joints = new BE1::Mat3x4[numJoints];
+    for (int i = 0; i < numJoints; i++) {
+        BE1::Angles angles(BE1::Math::Random(-180.0f, 180.0f), BE1::Math::Random(-180.0f, 180.0f), BE1::Math::Random(-180.0f, 180.0f));
+        BE1::Vec3 origin(BE1::Math::Random(-100.0f, 100.0f), BE1::Math::Random(-100.0f, 100.0f), BE1::Math::Random(-100.0f, 100.0f));
+        joints[i] = BE1::Mat3x4(BE1::Vec3::one, angles.ToMat3(), origin);
+    }
+
+    BE1::VertexGenericLit *srcVerts = new BE1::VertexGenericLit[numVerts];
+    BE1::VertexGenericLit *dstVertsGeneric = new BE1::VertexGenericLit[numVerts];
+    BE1::VertexGenericLit *dstVertsSIMD = new BE1::VertexGenericLit[numVerts];
+    for (int i = 0; i < numVerts; i++) {
+        srcVerts[i].xyz.Set(BE1::Math::Random(-100.0f, 100.0f), BE1::Math::Random(-100.0f, 100.0f), BE1::Math::Random(-100.0f, 100.0f));
+
+        BE1::Vec3 normal(BE1::Math::Random(-1.0f, 1.0f), BE1::Math::Random(-1.0f, 1.0f), 1.0f);
+        normal.Normalize();
+        srcVerts[i].SetNormal(normal);
+
+        BE1::Vec3 tangent = normal.Cross(BE1::Vec3::unitY);
+        tangent.Normalize();
+        srcVerts[i].SetTangent(tangent);
+    }
+
+    BE1::VertexWeight4 *vertWeights4 = new BE1::VertexWeight4[numVerts];
+    BE1::VertexWeight8 *vertWeights8 = new BE1::VertexWeight8[numVerts];
+    RandomVertexWeightsInit(vertWeights8, numVerts, 8, numJoints);
+    for (int i = 0; i < numVerts; i++) {
+        // 4 weights are made from the first half of 8 weights, putting the rest to the last weight
+        for (int j = 0; j < 4; j++) {
+            vertWeights4[i].jointIndexes[j] = vertWeights8[i].jointIndexes[j];
+            vertWeights4[i].jointWeights[j] = vertWeights8[i].jointWeights[j];
+        }
+        vertWeights4[i].jointWeights[3] = 255 - vertWeights8[i].jointWeights[0] - vertWeights8[i].jointWeights[1] - vertWeights8[i].jointWeights[2];
+    }
+
+    static const int numWeightsList[] = { 4, 8 };
+    for (int n = 0; n < COUNT_OF(numWeightsList); n++) {
+        const int numWeights = numWeightsList[n];
+        const void *vertWeights = numWeights == 4 ? (const void *)vertWeights4 : (const void *)vertWeights8;
+
+        const wchar_t *name = numWeights == 4 ? L"SkinVerts( 4 weights )" : L"SkinVerts( 8 weights )";
+
+        bestClocksGeneric = 0;
+        for (int i = 0; i < testCount; i++) {
+            uint64_t startClocks = rdtsc();
+            BE1::simdGeneric->SkinVerts(dstVertsGeneric, srcVerts, numVerts, vertWeights, numWeights, joints);
+            uint64_t endClocks = rdtsc();
+            GetBest(startClocks, endClocks, bestClocksGeneric);
+        }
+
+        PrintClocksGeneric(name, bestClocksGeneric);
+
+        bestClocksSIMD = 0;
+        for (int i = 0; i < testCount; i++) {
+            uint64_t startClocks = rdtsc();
+            BE1::simdProcessor->SkinVerts(dstVertsSIMD, srcVerts, numVerts, vertWeights, numWeights, joints);
+            uint64_t endClocks = rdtsc();
+            GetBest(startClocks, endClocks, bestClocksSIMD);
+        }
+
+        PrintClocksSIMD(name, bestClocksGeneric, bestClocksSIMD);
+
+        // SIMD version should match the generic one up to the rounding errors and the quantization of the normals
+        for (int i = 0; i < numVerts; i++) {
+            assert(dstVertsGeneric[i].xyz.Distance(dstVertsSIMD[i].xyz) <= 0.01f);
+            assert(1.0f - dstVertsGeneric[i].GetNormal().Dot(dstVertsSIMD[i].GetNormal()) <= 0.001f);
+            assert(1.0f - dstVertsGeneric[i].GetTangent().Dot(dstVertsSIMD[i].GetTangent()) <= 0.001f);
+        }
+    }
+
+    delete [] vertWeights8;
+    delete [] vertWeights4;
+    delete [] dstVertsSIMD;
+    delete [] dstVertsGeneric;
+    delete [] srcVerts;
+    delete [] joints;
+}
+
 void TestSIMD() {
     BE_LOG(L"Testing SIMD processors..\n");
 
@@ -458,4 +554,5 @@ void TestSIMD() {
     TestMemset();
     TestMatrixMultiply();
     TestMatrixTranspose();
+    TestSkinVerts();
 }
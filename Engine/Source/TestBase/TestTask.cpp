@@ -0,0 +1,64 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlueshiftEngine.h"
+#include "TestTask.h"
+
+static BE1::PlatformAtomic counterValue;
+
+static void IncrementTask(void *data) {
+    counterValue++;
+}
+
+static void CheckOrderTask(void *data) {
+    int *stage = (int *)data;
+    assert(counterValue == stage[0]);
+    counterValue++;
+}
+
+void TestTask() {
+    const int count = 100000;
+    int *values = new int[count];
+
+    BE1::taskScheduler.ParallelFor(0, count, 256, [values](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            values[i] = i * 3;
+        }
+    });
+
+    for (int i = 0; i < count; i++) {
+        assert(values[i] == i * 3);
+    }
+
+    delete[] values;
+
+    counterValue = 0;
+    BE1::TaskCounter counter;
+    for (int i = 0; i < 1000; i++) {
+        BE1::taskScheduler.AddTask(IncrementTask, nullptr, &counter);
+    }
+    BE1::taskScheduler.WaitForCounter(&counter);
+    assert(counterValue == 1000);
+
+    counterValue = 0;
+    int stages[3] = { 0, 1, 2 };
+    BE1::TaskCounter counter0, counter1, counter2;
+    BE1::taskScheduler.AddTask(CheckOrderTask, &stages[0], &counter0);
+    BE1::taskScheduler.AddTaskAfter(&counter0, CheckOrderTask, &stages[1], &counter1);
+    BE1::taskScheduler.AddTaskAfter(&counter1, CheckOrderTask, &stages[2], &counter2);
+    BE1::taskScheduler.WaitForCounter(&counter2);
+    assert(counterValue == 3);
+
+    BE_LOG(L"TestTask: %i threads\n", BE1::taskScheduler.NumThreads());
+}
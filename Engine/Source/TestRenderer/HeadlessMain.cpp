@@ -0,0 +1,220 @@
+// Copyright(c) 2017 POLYGONTEK
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http ://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Headless benchmark entry point used with the null RHI (USE_NULL_RHI).
+// Runs a fixed number of frames of the game world through the render context without a window,
+// and reports CPU frame time and RHI call counts. The scene is loaded from the given map,
+// or built from a grid of boxes lit by a few lights if no map is given.
+// usage: TestRenderer [numFrames] [mapName]
+
+#include "Precompiled.h"
+
+static const int                defaultNumFrames = 1000;
+static const int                frameMsec = 16;
+
+static const int                sceneGridSize = 16;
+static const float              sceneGridSpacing = 150.0f;
+static const int                sceneNumLights = 4;
+
+static const int                renderWidth = 1280;
+static const int                renderHeight = 720;
+
+static void SystemLog(int logLevel, const wchar_t *msg) {
+    wprintf(L"%ls", msg);
+}
+
+static void SystemError(int errLevel, const wchar_t *msg) {
+    fwprintf(stderr, L"%ls", msg);
+    if (errLevel == BE1::FatalErr) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+static Json::Value CreateEntityValue(const char *name, const BE1::Vec3 &origin, const BE1::Angles &angles) {
+    Json::Value transformValue;
+    transformValue["classname"] = BE1::ComTransform::metaObject.ClassName();
+    transformValue["origin"] = origin.ToString();
+    transformValue["angles"] = angles.ToString();
+
+    Json::Value entityValue;
+    entityValue["classname"] = BE1::Entity::metaObject.ClassName();
+    entityValue["name"] = name;
+    entityValue["components"].append(transformValue);
+
+    return entityValue;
+}
+
+static void SpawnScene(BE1::GameWorld *gameWorld) {
+    // Camera looking down at the center of the grid
+    Json::Value cameraEntityValue = CreateEntityValue("Camera", BE1::Vec3(-1200.0f, 0.0f, 900.0f), BE1::Angles(0.0f, 30.0f, 0.0f));
+
+    Json::Value cameraValue;
+    cameraValue["classname"] = BE1::ComCamera::metaObject.ClassName();
+    cameraValue["far"] = 8192.0f;
+    cameraValue["clear"] = 2;
+    cameraEntityValue["components"].append(cameraValue);
+
+    gameWorld->SpawnEntityFromJson(cameraEntityValue);
+
+    // Directional light for the primary light
+    Json::Value sunEntityValue = CreateEntityValue("Sun", BE1::Vec3(0.0f, 0.0f, 1000.0f), BE1::Angles(45.0f, 60.0f, 0.0f));
+
+    Json::Value sunValue;
+    sunValue["classname"] = BE1::ComLight::metaObject.ClassName();
+    sunValue["lightType"] = 2;
+    sunValue["primaryLight"] = true;
+    sunValue["castShadows"] = true;
+    sunValue["material"] = BE1::GuidMapper::whiteLightMaterialGuid.ToString();
+    sunEntityValue["components"].append(sunValue);
+
+    gameWorld->SpawnEntityFromJson(sunEntityValue);
+
+    const float halfExtent = (sceneGridSize - 1) * sceneGridSpacing * 0.5f;
+
+    // Point lights over the grid
+    for (int i = 0; i < sceneNumLights; i++) {
+        const float angle = BE1::Math::TwoPi * i / sceneNumLights;
+        const BE1::Vec3 origin(BE1::Math::Cos(angle) * halfExtent * 0.5f, BE1::Math::Sin(angle) * halfExtent * 0.5f, 300.0f);
+
+        Json::Value lightEntityValue = CreateEntityValue(BE1::va("Light%i", i), origin, BE1::Angles(0.0f, 0.0f, 0.0f));
+
+        Json::Value lightValue;
+        lightValue["classname"] = BE1::ComLight::metaObject.ClassName();
+        lightValue["lightType"] = 0;
+        lightValue["castShadows"] = true;
+        lightValue["lightSize"] = BE1::Vec3(800.0f, 800.0f, 800.0f).ToString();
+        lightEntityValue["components"].append(lightValue);
+
+        gameWorld->SpawnEntityFromJson(lightEntityValue);
+    }
+
+    // Grid of boxes
+    for (int y = 0; y < sceneGridSize; y++) {
+        for (int x = 0; x < sceneGridSize; x++) {
+            const BE1::Vec3 origin(x * sceneGridSpacing - halfExtent, y * sceneGridSpacing - halfExtent, 50.0f);
+
+            Json::Value boxEntityValue = CreateEntityValue(BE1::va("Box%i_%i", x, y), origin, BE1::Angles(0.0f, 0.0f, 0.0f));
+
+            Json::Value meshRendererValue;
+            meshRendererValue["classname"] = BE1::ComStaticMeshRenderer::metaObject.ClassName();
+            meshRendererValue["mesh"] = BE1::GuidMapper::boxMeshGuid.ToString();
+            boxEntityValue["components"].append(meshRendererValue);
+
+            gameWorld->SpawnEntityFromJson(boxEntityValue);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int numFrames = argc > 1 ? BE1::Max(atoi(argv[1]), 1) : defaultNumFrames;
+    const char *mapName = argc > 2 ? argv[2] : nullptr;
+
+    BE1::Str path = BE1::PlatformFile::ExecutablePath();
+    path.AppendPath("../../..");
+
+    BE1::Engine::InitParms initParms;
+    initParms.baseDir = path;
+    initParms.searchPath = path + "/Data";
+    initParms.logFunc = SystemLog;
+    initParms.errorFunc = SystemError;
+
+    BE1::Engine::Init(&initParms);
+
+    // No sound device is needed for benchmarking
+    BE1::cvarSystem.SetCVarBool(L"s_nosound", true);
+
+    BE1::gameClient.Init(nullptr, false);
+
+    BE1::RenderContext *renderContext = BE1::renderSystem.AllocRenderContext(true);
+    renderContext->Init(nullptr, renderWidth, renderHeight, nullptr, nullptr);
+
+    BE1::GameWorld *gameWorld = (BE1::GameWorld *)BE1::GameWorld::CreateInstance();
+
+    BE1::LuaVM::InitEngineModule(gameWorld);
+
+    gameWorld->LoadSettings();
+
+    if (mapName) {
+        if (!BE1::resourceGuidMapper.Read("Data/guidmap")) {
+            BE_FATALERROR(L"Couldn't open guidmap !");
+        }
+        if (!gameWorld->LoadMap(mapName)) {
+            BE_FATALERROR(L"Couldn't load map '%hs'\n", mapName);
+        }
+    } else {
+        gameWorld->NewMap();
+
+        SpawnScene(gameWorld);
+    }
+
+    gameWorld->StartGame();
+
+    uint64_t totalDrawCalls = 0;
+    uint64_t totalStateChanges = 0;
+    uint64_t totalTextureBinds = 0;
+    uint64_t totalShaderConstantCalls = 0;
+    uint64_t totalRenderTime = 0;
+
+    uint64_t startTime = BE1::PlatformTime::Microseconds();
+
+    for (int frame = 0; frame < numFrames; frame++) {
+        BE1::Engine::RunFrame(frameMsec);
+
+        BE1::gameClient.RunFrame();
+
+        gameWorld->Update(frameMsec);
+
+        uint64_t renderStartTime = BE1::PlatformTime::Microseconds();
+
+        renderContext->BeginFrame();
+
+        gameWorld->RenderCamera();
+
+        renderContext->EndFrame();
+
+        totalRenderTime += BE1::PlatformTime::Microseconds() - renderStartTime;
+
+        BE1::gameClient.EndFrame();
+
+        const BE1::RenderCounter &counter = renderContext->renderCounter;
+        totalDrawCalls += counter.rhiDrawCalls;
+        totalStateChanges += counter.stateChanges;
+        totalTextureBinds += counter.textureBinds;
+        totalShaderConstantCalls += counter.shaderConstantCalls;
+    }
+
+    // Waits for the back end of the last frame
+    BE1::renderSystem.SyncRenderThread();
+
+    uint64_t elapsedTime = BE1::PlatformTime::Microseconds() - startTime;
+
+    BE_LOG(L"%i frames in %.2f ms (%.3f ms/frame, render %.3f ms/frame)\n", numFrames,
+        elapsedTime / 1000.0, elapsedTime / 1000.0 / numFrames, totalRenderTime / 1000.0 / numFrames);
+    BE_LOG(L"per frame - draws:%.1f states:%.1f textures:%.1f constants:%.1f\n",
+        (double)totalDrawCalls / numFrames, (double)totalStateChanges / numFrames,
+        (double)totalTextureBinds / numFrames, (double)totalShaderConstantCalls / numFrames);
+
+    gameWorld->StopGame();
+
+    BE1::GameWorld::DestroyInstance(gameWorld, true);
+
+    renderContext->Shutdown();
+    BE1::renderSystem.FreeRenderContext(renderContext);
+
+    BE1::gameClient.Shutdown();
+
+    BE1::Engine::Shutdown();
+
+    return EXIT_SUCCESS;
+}